@@ -8,12 +8,21 @@
 #include "shader_types.h"
 #include "input.h"
 #include "camera.h"
+#include "light_clusters.h"
+#include "meshlets.h"
+#include "hlod.h"
+#include "impostors.h"
+#include "texture_loader.h"
+#include "texture_streaming.h"
+#include "residency.h"
+#include "world_streaming.h"
 
 struct App
 {
 public:
     f32  deltaTime;                                                     // Loop
     bool isRunning;                                                     // ----
+    bool isHeadless;                                                    // No GL context (cooker.h): no uploads, no texture jobs.
 
     Input input;                                                        // Input
 
@@ -30,12 +39,20 @@ public:                                                                 // OpenG
     RENDER_MODE  renderMode;
     RENDER_LAYER renderLayer;
     SHADER_MODE  shaderMode;                                             // Shader mode.
+    LIGHTING_MODE lightingMode;                                          // Deferred lighting technique.
+    LIGHT_VOLUME_MODE lightVolumeMode;                                   // Per-light scissored draws, one instanced draw or stencil-masked draws.
 
     u32          texQuadProgramIdx;                                      // Index of a given geometry program.
     u32          texMeshProgramIdx;                                      // Index of a given mesh program.
     u32          forwardRenderingProgramIdx;                             // Index of a given entity program.
     u32          deferredGeometryProgramIdx;
     u32          deferredLightingProgramIdx;
+    u32          clusteredLightingProgramIdx;
+    u32          tiledLightingProgramIdx;
+    u32          instancedLightingProgramIdx;
+    u32          lightStencilProgramIdx;
+    u32          impostorBakeProgramIdx;
+    u32          impostorProgramIdx;
                  
     u32          quadTexIdx;                                             // Buffer index of the quad texture.
                  
@@ -54,6 +71,7 @@ public:                                                                 // OpenG
     GLuint       texEntityProgramUniformTexture;
                  
     GLuint       vaoQuad;                                                // VAO object to link our screen filling quad with our textured quad shader
+    GLuint       vaoLightInstances;                                      // Light sphere + per-instance light data from the light buffer.
                  
     Buffer       cbuffer;
     GLint        maxUniformBufferSize;
@@ -61,6 +79,9 @@ public:                                                                 // OpenG
                  
     u32          globalParamsOffset;
     u32          globalParamsSize;
+
+    u32          clusterParamsOffset;
+    u32          clusterParamsSize;
                  
 public:          
     GLuint       framebufferHandle;
@@ -83,12 +104,36 @@ public:                                                                 // Conta
     std::vector<Entity>     entities;                                   // Will store all active entities.
     std::vector<Light>      lights;                                     // Will store all active lights.
     std::vector<Texture>    textures;                                   // Will store all active textures.
+    IdMap                   textureIdMap;                               // Interned file path -> texture index.
+    TextureLoadQueue        textureLoads;                               // Textures still being decoded by the job system.
+    TextureStreamer         textureStreamer;                            // Mip residency of the large textures, see texture_streaming.h.
+    WorldStreamer           worldStreamer;                              // The cells of world.scene around the camera, see world_streaming.h.
     std::vector<Material>   materials;                                  // Will store all active materials.
     std::vector<Mesh>       meshes;                                     // Will store all active meshes.
     std::vector<Model>      models;                                     // Will store all active models.
+    IdMap                   modelIdMap;                                 // Interned file path -> model index.
     std::vector<Program>    programs;                                   // Will store all active programs.
 
     u32 activeLights;
+    u32 visibleLights;                                                  // Lights that survived the frustum culling this frame.
+    bool cullLightVolumes;                                              // Frustum, scissor and depth bounds rejection of point lights.
+    ClusterGrid clusterGrid;                                            // Per-cluster light lists used by the forward and clustered passes.
+
+    bool enableLods;                                                    // Screen-space error driven mesh LOD selection.
+    f32  lodErrorThreshold;                                             // Max projected LOD error, in pixels.
+    u32  drawnTriangles;                                                // Triangles submitted by the last geometry pass.
+
+    bool cullMeshlets;                                                  // Per-meshlet frustum and normal-cone culling of the LOD0 submeshes.
+    MeshletDrawList meshletDraws;                                       // Indirect draws of the meshlets that survived the culling.
+
+    bool enableHlod;                                                    // Swap distant entity groups for their merged proxies.
+    f32  hlodDistance;                                                  // Min camera distance to a cluster before its proxy is used.
+    std::vector<HlodCluster> hlodClusters;
+
+    bool enableImpostors;                                               // Draw far entities of baked models as impostor quads.
+    f32  impostorDistance;                                              // Min camera distance before an entity becomes an impostor.
+    ImpostorSet impostorSet;
+    ResidencyManager residency;                                         // Mesh memory policies and the RAM / VRAM budgets.
 
     u32 defaultMaterialIdx;
     
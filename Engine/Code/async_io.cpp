@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "globals.h"
+#include "file_manager.h"
+#include "pack_file.h"
+#include "job_system.h"
+
+#include "async_io.h"
+
+std::mutex					GlobalAsyncMutex;
+std::deque<AsyncRead*>		GlobalAsyncQueue;														// Waiting for a slot in the ring.
+std::atomic<u32>			GlobalAsyncPending(0);
+bool						GlobalAsyncUsingUring = false;
+
+#ifdef __linux__
+struct Uring
+{
+	int					fd;
+	u32					depth;
+	u32					inFlight;
+	u32					unsubmitted;																// In the SQ ring, not consumed by the kernel yet.
+
+	u32*				sqHead;
+	u32*				sqTail;
+	u32*				sqMask;
+	u32*				sqArray;
+	io_uring_sqe*		sqes;
+	u32*				cqHead;
+	u32*				cqTail;
+	u32*				cqMask;
+	io_uring_cqe*		cqes;
+
+	void*				sqRing;
+	size_t				sqRingSize;
+	void*				cqRing;
+	size_t				cqRingSize;
+	size_t				sqesSize;
+
+	u8*					buffers;																	// ASYNC_IO_BUFFER_COUNT registered buffers, back to back.
+	std::vector<i32>	freeBuffers;
+	std::thread			completionThread;
+	bool				isRunning;
+};
+
+Uring GlobalUring = {};
+
+static int UringSetup(u32 entries, io_uring_params* params)				{ return (int)syscall(__NR_io_uring_setup, entries, params); }
+static int UringEnter(int fd, u32 toSubmit, u32 minComplete, u32 flags)	{ return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0); }
+static int UringRegister(int fd, u32 opcode, void* arg, u32 count)		{ return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count); }
+
+// Hands the SQEs written since the last call to the kernel, with GlobalAsyncMutex held. EBUSY (completions not reaped
+// yet) and EAGAIN leave them in the ring: the completion thread submits them again once it has reaped.
+static void UringSubmit(Uring& ring)
+{
+	while (ring.unsubmitted > 0)
+	{
+		const int consumed = UringEnter(ring.fd, ring.unsubmitted, 0, 0);
+		if (consumed >= 0)
+		{
+			ring.unsubmitted -= (u32)consumed;
+			if (consumed == 0)
+			{
+				return;
+			}
+		}
+		else if (errno != EINTR)
+		{
+			if (errno != EBUSY && errno != EAGAIN)
+			{
+				ELOG("io_uring_enter() failed (%d) submitting %u reads, retried on the next submit", errno, ring.unsubmitted);
+			}
+			return;
+		}
+	}
+}
+#endif
+
+void AsyncIO::Init()
+{
+	GlobalAsyncUsingUring = Utils::InitUring();
+	ILOG("Async file reads: %s", (GlobalAsyncUsingUring) ? "io_uring" : "blocking reads on the job system");
+}
+
+void AsyncIO::CleanUp()
+{
+	while (GlobalAsyncPending > 0)
+	{
+		Submit();
+		std::this_thread::yield();
+	}
+
+	if (GlobalAsyncUsingUring)
+	{
+		Utils::CleanUpUring();
+		GlobalAsyncUsingUring = false;
+	}
+}
+
+void AsyncIO::Read(const char* filepath, u64 offset, u32 size, const ReadCallback& onComplete)
+{
+	AsyncRead* read		= new AsyncRead();
+	read->filepath		= filepath;
+	read->offset		= offset;
+	read->size			= size;
+	read->onComplete	= onComplete;
+	read->fd			= -1;
+	read->bufferIdx		= -1;
+	++GlobalAsyncPending;
+
+#ifdef __linux__
+	// The ring only reads loose files, with the same precedence as FileManager::MapFile().
+	const bool isPackedFirst = !FILE_MANAGER_LOOSE_FILES_FIRST && PackFile::Find(filepath) != nullptr;
+	read->fd = (GlobalAsyncUsingUring && !isPackedFirst) ? open(filepath, O_RDONLY | O_CLOEXEC) : -1;
+	if (read->fd >= 0)
+	{
+		std::lock_guard<std::mutex> lock(GlobalAsyncMutex);
+		GlobalAsyncQueue.push_back(read);
+		return;
+	}
+#endif
+
+	JobSystem::Submit([read]() { Utils::ReadMapped(read); }, nullptr);
+}
+
+void AsyncIO::Submit()
+{
+	if (GlobalAsyncUsingUring)
+	{
+		std::lock_guard<std::mutex> lock(GlobalAsyncMutex);
+		Utils::SubmitQueued();
+	}
+}
+
+bool AsyncIO::IsUsingUring()
+{
+	return GlobalAsyncUsingUring;
+}
+
+u32 AsyncIO::GetPendingCount()
+{
+	return GlobalAsyncPending;
+}
+
+// UTILS -------------------------------------------------------------------
+bool AsyncIO::Utils::InitUring()
+{
+#ifdef __linux__
+	Uring& ring				= GlobalUring;
+	io_uring_params params	= {};
+	ring.fd = UringSetup(ASYNC_IO_QUEUE_DEPTH, &params);
+	if (ring.fd < 0)
+	{
+		return false;																				// ENOSYS, or EPERM under seccomp.
+	}
+
+	ring.depth		= params.sq_entries;
+	ring.sqRingSize	= params.sq_off.array + params.sq_entries * sizeof(u32);
+	ring.cqRingSize	= params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	ring.sqesSize	= params.sq_entries * sizeof(io_uring_sqe);
+
+	const bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (isSingleMmap)
+	{
+		ring.sqRingSize = ring.cqRingSize = (ring.sqRingSize > ring.cqRingSize) ? ring.sqRingSize : ring.cqRingSize;
+	}
+
+	ring.sqRing	= mmap(NULL, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	ring.cqRing	= (isSingleMmap) ? ring.sqRing : mmap(NULL, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+	ring.sqes	= (io_uring_sqe*)mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+	if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED)
+	{
+		ring.cqRing	= (ring.cqRing == MAP_FAILED) ? nullptr : ring.cqRing;
+		ring.sqRing	= (ring.sqRing == MAP_FAILED) ? nullptr : ring.sqRing;
+		ring.sqes	= (ring.sqes == MAP_FAILED) ? nullptr : ring.sqes;
+		CleanUpUring();
+		return false;
+	}
+
+	u8* sq			= (u8*)ring.sqRing;
+	u8* cq			= (u8*)ring.cqRing;
+	ring.sqHead		= (u32*)(sq + params.sq_off.head);
+	ring.sqTail		= (u32*)(sq + params.sq_off.tail);
+	ring.sqMask		= (u32*)(sq + params.sq_off.ring_mask);
+	ring.sqArray	= (u32*)(sq + params.sq_off.array);
+	ring.cqHead		= (u32*)(cq + params.cq_off.head);
+	ring.cqTail		= (u32*)(cq + params.cq_off.tail);
+	ring.cqMask		= (u32*)(cq + params.cq_off.ring_mask);
+	ring.cqes		= (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	// Registered buffers: pinned once, so the kernel skips mapping the pages on every read. Optional (RLIMIT_MEMLOCK).
+	iovec iovecs[ASYNC_IO_BUFFER_COUNT];
+	ring.buffers = (u8*)aligned_alloc(4096, (size_t)ASYNC_IO_BUFFER_COUNT * ASYNC_IO_BUFFER_SIZE);
+	for (u32 i = 0; i < ASYNC_IO_BUFFER_COUNT && ring.buffers != nullptr; ++i)
+	{
+		iovecs[i].iov_base	= ring.buffers + (size_t)i * ASYNC_IO_BUFFER_SIZE;
+		iovecs[i].iov_len	= ASYNC_IO_BUFFER_SIZE;
+	}
+	if (ring.buffers != nullptr && UringRegister(ring.fd, IORING_REGISTER_BUFFERS, iovecs, ASYNC_IO_BUFFER_COUNT) == 0)
+	{
+		for (i32 i = ASYNC_IO_BUFFER_COUNT - 1; i >= 0; --i)
+		{
+			ring.freeBuffers.push_back(i);
+		}
+	}
+
+	ring.isRunning			= true;
+	ring.completionThread	= std::thread(CompletionLoop);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AsyncIO::Utils::CleanUpUring()
+{
+#ifdef __linux__
+	Uring& ring = GlobalUring;
+	if (ring.completionThread.joinable())
+	{
+		std::lock_guard<std::mutex> lock(GlobalAsyncMutex);
+		ring.isRunning = false;
+
+		const u32 tail		= *ring.sqTail;																// A NOP wakes the completion thread up.
+		const u32 index		= tail & *ring.sqMask;
+		io_uring_sqe* sqe	= &ring.sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode			= IORING_OP_NOP;
+		ring.sqArray[index]	= index;
+		__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+		++ring.unsubmitted;
+		UringSubmit(ring);
+	}
+	if (ring.completionThread.joinable())
+	{
+		ring.completionThread.join();
+	}
+
+	if (ring.sqes != nullptr)								{ munmap(ring.sqes, ring.sqesSize); }
+	if (ring.cqRing != nullptr && ring.cqRing != ring.sqRing)	{ munmap(ring.cqRing, ring.cqRingSize); }
+	if (ring.sqRing != nullptr)								{ munmap(ring.sqRing, ring.sqRingSize); }
+	close(ring.fd);																						// Unregisters the buffers too.
+	free(ring.buffers);
+
+	ring = Uring();
+#endif
+}
+
+void AsyncIO::Utils::CompletionLoop()
+{
+#ifdef __linux__
+	Uring& ring = GlobalUring;
+	while (true)
+	{
+		if (UringEnter(ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EBUSY)			// EBUSY: reap first.
+		{
+			ELOG("io_uring_enter() failed (%d), the async reads stop", errno);
+			return;
+		}
+
+		std::vector<AsyncRead*> completed;
+		{
+			std::lock_guard<std::mutex> lock(GlobalAsyncMutex);
+
+			u32 head = *ring.cqHead;
+			while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE))
+			{
+				const io_uring_cqe& cqe	= ring.cqes[head & *ring.cqMask];
+				AsyncRead* read			= (AsyncRead*)(uintptr_t)cqe.user_data;
+				++head;
+
+				if (read == nullptr)																		// The NOP of CleanUpUring().
+				{
+					continue;
+				}
+
+				read->succeeded = (cqe.res == (i32)read->size);											// Short: the file is smaller than asked.
+				close(read->fd);
+				--ring.inFlight;
+				completed.push_back(read);
+			}
+			__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+			if (!ring.isRunning)
+			{
+				return;
+			}
+
+			SubmitQueued();																				// Slots were freed.
+		}
+
+		for (u32 i = 0; i < completed.size(); ++i)
+		{
+			Complete(completed[i]);
+		}
+	}
+#endif
+}
+
+void AsyncIO::Utils::SubmitQueued()
+{
+#ifdef __linux__
+	Uring& ring = GlobalUring;
+
+	u32 submitted = 0;
+	while (!GlobalAsyncQueue.empty() && ring.inFlight < ring.depth)
+	{
+		AsyncRead* read = GlobalAsyncQueue.front();
+		GlobalAsyncQueue.pop_front();
+
+		const bool isFixed	= (read->size <= ASYNC_IO_BUFFER_SIZE && !ring.freeBuffers.empty());
+		read->bufferIdx		= (isFixed) ? ring.freeBuffers.back() : -1;
+		read->buffer		= (isFixed) ? ring.buffers + (size_t)read->bufferIdx * ASYNC_IO_BUFFER_SIZE : (u8*)malloc(read->size > 0 ? read->size : 1);
+		if (isFixed)
+		{
+			ring.freeBuffers.pop_back();
+		}
+
+		const u32 tail		= *ring.sqTail;
+		const u32 index		= tail & *ring.sqMask;
+		io_uring_sqe* sqe	= &ring.sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode			= (isFixed) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+		sqe->fd				= read->fd;
+		sqe->off			= read->offset;
+		sqe->addr			= (u64)(uintptr_t)read->buffer;
+		sqe->len			= read->size;
+		sqe->buf_index		= (u16)((isFixed) ? read->bufferIdx : 0);
+		sqe->user_data		= (u64)(uintptr_t)read;
+		ring.sqArray[index]	= index;
+		__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+
+		++ring.inFlight;
+		++submitted;
+	}
+
+	ring.unsubmitted += submitted;
+	UringSubmit(ring);
+#endif
+}
+
+void AsyncIO::Utils::Complete(AsyncRead* read)
+{
+	JobSystem::Submit([read]()
+	{
+		read->onComplete((read->succeeded) ? read->buffer : nullptr, read->size);
+
+#ifdef __linux__
+		{
+			std::lock_guard<std::mutex> lock(GlobalAsyncMutex);
+			if (read->bufferIdx >= 0)
+			{
+				GlobalUring.freeBuffers.push_back(read->bufferIdx);
+			}
+			else
+			{
+				free(read->buffer);
+			}
+		}
+#endif
+
+		delete read;
+		--GlobalAsyncPending;
+		Submit();																						// What the callback queued.
+	}, nullptr);
+}
+
+void AsyncIO::Utils::ReadMapped(AsyncRead* read)
+{
+	MappedFile file = {};
+	const bool isMapped = FileManager::MapFile(read->filepath.c_str(), file);
+	const bool isInside = isMapped && read->offset + read->size <= file.size;
+
+	read->onComplete((isInside) ? file.data + read->offset : nullptr, read->size);
+
+	FileManager::UnmapFile(file);
+	delete read;
+	--GlobalAsyncPending;
+}
\ No newline at end of file
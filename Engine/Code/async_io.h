@@ -0,0 +1,59 @@
+#ifndef __ASYNC_IO_H__
+#define __ASYNC_IO_H__
+
+// async_io.h:
+// Asynchronous file reads. Read() queues a request and Submit() sends all the queued ones at once. On Linux they go
+// through io_uring: one io_uring_enter() per batch, no thread blocked per read, and the reads that fit land in a
+// pool of registered buffers, pinned once at Init(). A single completion thread reaps the ring and hands every
+// finished read to the job system, where its callback runs. The callbacks may queue more reads, they are submitted
+// as soon as the callback returns. Where io_uring is missing (other platforms, old kernels, sandboxes that forbid it)
+// every read becomes a job that maps the file with FileManager. The packed files (pack_file.h) always take that path.
+
+#include <functional>
+#include <string>
+
+#include "base_types.h"
+
+#define ASYNC_IO_QUEUE_DEPTH	64																	// Reads in flight, the rest wait in the queue.
+#define ASYNC_IO_BUFFER_COUNT	16
+#define ASYNC_IO_BUFFER_SIZE	(1024 * 1024)														// Larger reads get a heap buffer.
+
+typedef std::function<void(const u8* data, u32 size)> ReadCallback;								// data is nullptr if the read failed, and only valid during the call.
+
+struct AsyncRead
+{
+	std::string		filepath;
+	u64				offset;
+	u32				size;
+	ReadCallback	onComplete;
+
+	int				fd;																				// io_uring only.
+	u8*				buffer;
+	i32				bufferIdx;																		// Registered buffer, -1 for a heap one.
+	bool			succeeded;
+};
+
+namespace AsyncIO
+{
+	void Init			();																			// After JobSystem::Init().
+	void CleanUp		();																			// Waits for the reads in flight.
+
+	void Read			(const char* filepath, u64 offset, u32 size, const ReadCallback& onComplete);	// Thread safe.
+	void Submit			();																			// Thread safe. A no-op for the fallback.
+
+	bool IsUsingUring	();
+	u32  GetPendingCount();																			// Queued, in flight or in their callback.
+
+	namespace Utils
+	{
+		bool InitUring			();
+		void CleanUpUring		();
+		void CompletionLoop		();																	// The completion thread.
+		void SubmitQueued		();																	// With GlobalAsyncMutex held.
+
+		void Complete			(AsyncRead* read);													// Runs the callback on the job system.
+		void ReadMapped			(AsyncRead* read);													// Fallback and packed files. Job.
+	}
+}
+
+#endif // !__ASYNC_IO_H__
\ No newline at end of file
@@ -1,3 +1,6 @@
+#include <string.h>
+
+#include "globals.h"
 #include "shader_types.h"
 
 #include "buffer_manager.h"
@@ -39,6 +42,24 @@ void BufferManager::UnmapBuffer(Buffer& buffer)
 	glBindBuffer(buffer.type, 0);
 }
 
+void BufferManager::UploadData(Buffer& buffer, const void* data, u32 size)
+{
+	glBindBuffer(buffer.type, buffer.handle);
+
+	if (size > buffer.size)
+	{
+		buffer.size = size;
+		glBufferData(buffer.type, buffer.size, data, GL_STREAM_DRAW);
+	}
+	else
+	{
+		glBufferData(buffer.type, buffer.size, NULL, GL_STREAM_DRAW);
+		glBufferSubData(buffer.type, 0, size, data);
+	}
+
+	glBindBuffer(buffer.type, 0);
+}
+
 bool BufferManager::IsPowerOfTwo(u32 value)
 {
 	return (value && !(value & (value - 1)));
@@ -51,14 +72,15 @@ u32 BufferManager::Align(u32 value, u32 alignment)
 
 void BufferManager::AlignHead(Buffer& buffer, u32 alignment)
 {
-	assert(IsPowerOfTwo(alignment), "Alignment must be a power of 2!");
+	ASSERT(IsPowerOfTwo(alignment), "Alignment must be a power of 2!");
 	buffer.head = Align(buffer.head, alignment);
 }
 
 void BufferManager::PushAlignedData(Buffer& buffer, const void* data, u32 size, u32 alignment)
 {
-	assert((buffer.data != NULL), "Buffer must be mapped first!");
+	ASSERT((buffer.data != NULL), "Buffer must be mapped first!");
 	AlignHead(buffer, alignment);
+	ASSERT((buffer.head + size <= buffer.size), "Buffer overflow!");
 	memcpy((u8*)buffer.data + buffer.head, data, size);
 	buffer.head += size;
 }
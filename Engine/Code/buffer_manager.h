@@ -11,6 +11,7 @@ namespace BufferManager
 	void	UnbindBuffer	(const Buffer& buffer);
 	void	MapBuffer		(Buffer& buffer, GLenum access);
 	void	UnmapBuffer		(Buffer& buffer);
+	void	UploadData		(Buffer& buffer, const void* data, u32 size);						// Orphans the buffer's storage, growing it if needed.
 
 	bool	IsPowerOfTwo	(u32 value);
 	
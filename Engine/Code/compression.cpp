@@ -0,0 +1,173 @@
+#include <string.h>
+
+#include "compression.h"
+
+u32 Compression::GetMaxCompressedSize(u32 size)
+{
+	return size + size / 255 + 16;
+}
+
+u32 Compression::Compress(const u8* src, u32 srcSize, u8* dst)
+{
+	u32 table[1 << COMPRESSION_HASH_BITS] = {};															// Position + 1 of the last sequence with that hash, 0 if none.
+	u8* out		= dst;
+	u32 anchor	= 0;																					// First byte not emitted yet.
+	u32 pos		= 0;
+
+	const u32 matchEnd = (srcSize > COMPRESSION_LAST_LITERALS) ? srcSize - COMPRESSION_LAST_LITERALS : 0;
+	while (srcSize > COMPRESSION_MATCH_LIMIT && pos < srcSize - COMPRESSION_MATCH_LIMIT)
+	{
+		u32 sequence;
+		memcpy(&sequence, src + pos, sizeof(sequence));
+		const u32 hash		= (sequence * 2654435761u) >> (32 - COMPRESSION_HASH_BITS);
+		const u32 candidate	= table[hash];
+		table[hash]			= pos + 1;
+
+		const u32 matchPos	= candidate - 1;
+		u32 matchSequence	= ~sequence;
+		if (candidate != 0 && pos - matchPos <= COMPRESSION_MAX_OFFSET)
+		{
+			memcpy(&matchSequence, src + matchPos, sizeof(matchSequence));
+		}
+		if (matchSequence != sequence)
+		{
+			++pos;
+			continue;
+		}
+
+		u32 matchLength		= COMPRESSION_MIN_MATCH;
+		while (pos + matchLength < matchEnd && src[matchPos + matchLength] == src[pos + matchLength])
+		{
+			++matchLength;
+		}
+
+		// Token, literals, offset and match length.
+		const u32 literalCount	= pos - anchor;
+		const u32 matchCode		= matchLength - COMPRESSION_MIN_MATCH;
+		u8* token				= out++;
+		*token					= (u8)(((literalCount < 15) ? literalCount : 15) << 4);
+		if (literalCount >= 15)
+		{
+			out = Utils::WriteLength(out, literalCount - 15);
+		}
+		memcpy(out, src + anchor, literalCount);
+		out += literalCount;
+
+		const u32 offset = pos - matchPos;
+		*out++ = (u8)(offset & 0xFF);
+		*out++ = (u8)(offset >> 8);
+
+		*token |= (u8)((matchCode < 15) ? matchCode : 15);
+		if (matchCode >= 15)
+		{
+			out = Utils::WriteLength(out, matchCode - 15);
+		}
+
+		pos		+= matchLength;
+		anchor	= pos;
+	}
+
+	// Last literals
+	const u32 literalCount = srcSize - anchor;
+	*out++ = (u8)(((literalCount < 15) ? literalCount : 15) << 4);
+	if (literalCount >= 15)
+	{
+		out = Utils::WriteLength(out, literalCount - 15);
+	}
+	memcpy(out, src + anchor, literalCount);
+	out += literalCount;
+
+	return (u32)(out - dst);
+}
+
+bool Compression::Decompress(const u8* src, u32 srcSize, u8* dst, u32 dstSize)
+{
+	const u8* in		= src;
+	const u8* inEnd		= src + srcSize;
+	u8* out				= dst;
+	u8* const outEnd	= dst + dstSize;
+
+	while (in < inEnd)
+	{
+		const u8 token = *in++;
+
+		u32 literalCount = token >> 4;
+		if (literalCount == 15 && !Utils::ReadLength(in, inEnd, literalCount))
+		{
+			return false;
+		}
+		if ((u64)(inEnd - in) < literalCount || (u64)(outEnd - out) < literalCount)
+		{
+			return false;
+		}
+		memcpy(out, in, literalCount);
+		in	+= literalCount;
+		out	+= literalCount;
+
+		if (in == inEnd)																				// The last sequence has no match.
+		{
+			break;
+		}
+
+		if (inEnd - in < 2)
+		{
+			return false;
+		}
+		const u32 offset = (u32)in[0] | ((u32)in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (u32)(out - dst))
+		{
+			return false;
+		}
+
+		u32 matchLength = token & 15;
+		if (matchLength == 15 && !Utils::ReadLength(in, inEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += COMPRESSION_MIN_MATCH;
+		if ((u64)(outEnd - out) < matchLength)
+		{
+			return false;
+		}
+
+		const u8* match = out - offset;
+		for (u32 i = 0; i < matchLength; ++i)															// Byte by byte, the match may overlap what it writes.
+		{
+			out[i] = match[i];
+		}
+		out += matchLength;
+	}
+
+	return out == outEnd;
+}
+
+// UTILS -------------------------------------------------------------------
+u8* Compression::Utils::WriteLength(u8* dst, u32 length)
+{
+	while (length >= 255)
+	{
+		*dst++	= 255;
+		length	-= 255;
+	}
+	*dst++ = (u8)length;
+
+	return dst;
+}
+
+bool Compression::Utils::ReadLength(const u8*& src, const u8* srcEnd, u32& length)
+{
+	u8 byte = 255;
+	while (byte == 255)
+	{
+		if (src == srcEnd)
+		{
+			return false;
+		}
+
+		byte	= *src++;
+		length	+= byte;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef __COMPRESSION_H__
+#define __COMPRESSION_H__
+
+// compression.h:
+// LZ4 block format codec (no frame, no checksum) for the pack file entries (pack_file.h). The compressor is the greedy
+// single-probe one: a 4K-entry hash table of the last position of every 4-byte sequence, matches up to 64KB back.
+// It trades ratio for speed, the point is decoding at memory speed. Streams written here decode with any LZ4 decoder.
+
+#include "base_types.h"
+
+#define COMPRESSION_HASH_BITS		12
+#define COMPRESSION_MIN_MATCH		4
+#define COMPRESSION_MAX_OFFSET		65535
+#define COMPRESSION_LAST_LITERALS	5																	// The format ends every block with literals...
+#define COMPRESSION_MATCH_LIMIT		12																	// ...and no match starts in its last 12 bytes.
+
+namespace Compression
+{
+	u32  GetMaxCompressedSize	(u32 size);
+	u32  Compress				(const u8* src, u32 srcSize, u8* dst);										// dst holds GetMaxCompressedSize(srcSize). Returns the compressed size.
+	bool Decompress				(const u8* src, u32 srcSize, u8* dst, u32 dstSize);						// False on a malformed stream or a size mismatch.
+
+	namespace Utils
+	{
+		u8*  WriteLength		(u8* dst, u32 length);														// The 255-byte continuation of a length past 15.
+		bool ReadLength			(const u8*& src, const u8* srcEnd, u32& length);
+	}
+}
+
+#endif // !__COMPRESSION_H__
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "string_table.h"
+#include "job_system.h"
+#include "importer.h"
+#include "mesh_optimizer.h"
+#include "mesh_cache.h"
+#include "texture_cooker.h"
+#include "scene_cooker.h"
+#include "pack_file.h"
+
+#include "cooker.h"
+
+int main(int argc, char** argv)
+{
+	bool force				= false;
+	bool pack				= false;
+	bool check				= false;
+	const char* workingDir	= ".";
+	for (int i = 1; i < argc; ++i)
+	{
+		if		(strcmp(argv[i], "-force") == 0)	{ force = true; }
+		else if (strcmp(argv[i], "-pack") == 0)		{ pack = true; }
+		else if (strcmp(argv[i], "-check") == 0)	{ check = true; }
+		else										{ workingDir = argv[i]; }
+	}
+
+	if (check)
+	{
+		const bool passed = MeshOptimizer::SelfCheck();
+		printf("Mesh optimizer check %s\n", (passed) ? "passed" : "FAILED");
+		return (passed) ? 0 : 1;
+	}
+
+	return Cooker::Run(workingDir, force, pack);
+}
+
+int Cooker::Run(const char* workingDir, bool force, bool pack)
+{
+	if (chdir(workingDir) != 0)																				// The engine loads the assets relative to it.
+	{
+		printf("Cannot open the working directory %s\n", workingDir);
+		return 1;
+	}
+
+	FileManager::Init();
+	StringTable::Init();
+	JobSystem::Init(0);
+
+	CookerDatabase previous;
+	if (!force)
+	{
+		LoadDatabase(COOKER_DATABASE_FILE, previous);
+	}
+
+	std::vector<std::string> files;
+	FileManager::ListFiles(".", files);
+
+	std::vector<std::string> models;
+	std::vector<std::string> images;
+	std::vector<std::string> scenes;
+	for (u32 i = 0; i < files.size(); ++i)
+	{
+		std::string path = files[i].substr(2);																	// Without the "./".
+		std::replace(path.begin(), path.end(), '\\', '/');
+
+		if		(Utils::IsModelFile(path))	{ models.push_back(path); }
+		else if (Utils::IsImageFile(path))	{ images.push_back(path); }
+		else if (Utils::IsSceneFile(path))	{ scenes.push_back(path); }
+	}
+
+	// MODELS (first, the textures take the usage their materials give them)
+	std::vector<CookerEntry> modelEntries(models.size());
+	JobSystem::ParallelFor((u32)models.size(), 1, [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			Utils::CookAsset(previous, models[i], true, TEXTURE_USAGE::COLOR, modelEntries[i]);
+		}
+	});
+
+	// TEXTURES
+	std::map<std::string, TEXTURE_USAGE> textureUsages;
+	for (u32 i = 0; i < modelEntries.size(); ++i)
+	{
+		for (const CookerDependency& dependency : modelEntries[i].dependencies)
+		{
+			textureUsages.insert({ dependency.path, dependency.usage });											// A texture shared with another usage keeps the first one.
+		}
+	}
+	for (u32 i = 0; i < images.size(); ++i)
+	{
+		textureUsages.insert({ images[i], Utils::GuessUsage(images[i]) });
+	}
+
+	std::vector<std::pair<std::string, TEXTURE_USAGE>> textures(textureUsages.begin(), textureUsages.end());
+	std::vector<CookerEntry> textureEntries(textures.size());
+	JobSystem::ParallelFor((u32)textures.size(), 1, [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			Utils::CookAsset(previous, textures[i].first, false, textures[i].second, textureEntries[i]);
+		}
+	});
+
+	// DATABASE & REPORT
+	CookerDatabase database;
+	u32 counts[3] = {};
+	for (u32 i = 0; i < models.size() + textures.size(); ++i)
+	{
+		const bool isModel			= (i < models.size());
+		const std::string& path		= (isModel) ? models[i] : textures[i - models.size()].first;
+		const CookerEntry& entry	= (isModel) ? modelEntries[i] : textureEntries[i - models.size()];
+
+		++counts[(u32)entry.result];
+		if (entry.result == COOK_RESULT::FAILED)
+		{
+			printf("FAILED  %s\n", path.c_str());
+			continue;
+		}
+
+		printf("%s  %s\n", (entry.result == COOK_RESULT::COOKED) ? "cooked " : "skipped", path.c_str());
+		database.entries[path] = entry;
+	}
+
+	// SCENES (their .cscene holds the source hash, they are not in the database)
+	for (u32 i = 0; i < scenes.size(); ++i)
+	{
+		const COOK_RESULT result = Utils::CookScene(scenes[i], force);
+		++counts[(u32)result];
+		printf("%s  %s\n", (result == COOK_RESULT::FAILED) ? "FAILED " : (result == COOK_RESULT::COOKED) ? "cooked " : "skipped", scenes[i].c_str());
+	}
+
+	SaveDatabase(COOKER_DATABASE_FILE, database);
+	printf("%u cooked, %u up to date, %u failed\n", counts[(u32)COOK_RESULT::COOKED], counts[(u32)COOK_RESULT::UP_TO_DATE], counts[(u32)COOK_RESULT::FAILED]);
+
+	// PACK
+	bool packed = true;
+	if (pack)
+	{
+		std::vector<std::string> packedFiles;
+		files.clear();
+		FileManager::ListFiles(".", files);																	// With the new cooked files.
+		for (u32 i = 0; i < files.size(); ++i)
+		{
+			if (Utils::IsPackedFile(files[i]))
+			{
+				packedFiles.push_back(files[i]);
+			}
+		}
+
+		std::vector<PackSource> sources;																	// What the packed cooked files were cooked from.
+		for (const auto& pair : database.entries)
+		{
+			sources.push_back({ pair.first, pair.second.sourceHash });
+		}
+		for (u32 i = 0; i < scenes.size(); ++i)
+		{
+			u64 sourceHash = 0;
+			if (FileManager::HashFile(scenes[i].c_str(), sourceHash))
+			{
+				sources.push_back({ scenes[i], sourceHash });
+			}
+		}
+
+		packed = PackFile::Build(PACK_FILE_NAME, packedFiles, sources);
+		if (packed)	{ printf("%u files packed in %s\n", (u32)packedFiles.size(), PACK_FILE_NAME); }
+		else		{ printf("Could not write %s\n", PACK_FILE_NAME); }
+	}
+
+	JobSystem::CleanUp();
+	StringTable::CleanUp();
+	FileManager::CleanUp();
+
+	return (counts[(u32)COOK_RESULT::FAILED] > 0 || !packed) ? 1 : 0;
+}
+
+// One entry per line, the paths last as they may hold spaces:
+//	model <source hash> <source timestamp> <settings hash> <path>
+//	dep <usage> <path>																						(textures of the model above)
+//	texture <source hash> <source timestamp> <settings hash> <path>
+bool Cooker::LoadDatabase(const char* filepath, CookerDatabase& database)
+{
+	FILE* file = fopen(filepath, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	char line[1024];
+	u32 version = 0;
+	if (!fgets(line, sizeof(line), file) || sscanf(line, "cooker %u", &version) != 1 || version != COOKER_DATABASE_VERSION)
+	{
+		fclose(file);
+		return false;																							// Everything is cooked again.
+	}
+
+	CookerEntry* model = nullptr;
+	while (fgets(line, sizeof(line), file))
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+
+		char type[16]		= {};
+		CookerEntry entry	= {};
+		u32 usage			= 0;
+		int pathStart		= 0;
+		if (sscanf(line, "%15s %llx %llx %llx %n", type, &entry.sourceHash, &entry.sourceTimestamp, &entry.settingsHash, &pathStart) == 4 && pathStart > 0)
+		{
+			entry.isModel		= (strcmp(type, "model") == 0);
+			CookerEntry& added	= database.entries[line + pathStart];
+			added				= entry;
+			model				= (entry.isModel) ? &added : nullptr;
+		}
+		else if (sscanf(line, "dep %u %n", &usage, &pathStart) == 1 && pathStart > 0 && model != nullptr)
+		{
+			model->dependencies.push_back({ line + pathStart, (TEXTURE_USAGE)usage });
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool Cooker::SaveDatabase(const char* filepath, const CookerDatabase& database)
+{
+	FILE* file = fopen(filepath, "wb");
+	if (!file)
+	{
+		printf("Cannot write %s, the next run will cook everything again\n", filepath);
+		return false;
+	}
+
+	fprintf(file, "cooker %u\n", COOKER_DATABASE_VERSION);
+	for (const auto& pair : database.entries)
+	{
+		const CookerEntry& entry = pair.second;
+		fprintf(file, "%s %llx %llx %llx %s\n", (entry.isModel) ? "model" : "texture", entry.sourceHash, entry.sourceTimestamp, entry.settingsHash, pair.first.c_str());
+		for (const CookerDependency& dependency : entry.dependencies)
+		{
+			fprintf(file, "dep %u %s\n", (u32)dependency.usage, dependency.path.c_str());
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+// UTILS -------------------------------------------------------------------
+void Cooker::Utils::CookAsset(const CookerDatabase& previous, const std::string& path, bool isModel, TEXTURE_USAGE usage, CookerEntry& entry)
+{
+	FileManager::ResetFrameAllocator();																		// Nothing made by the previous asset of this thread is still used.
+
+	entry					= {};
+	entry.isModel			= isModel;
+	entry.result			= COOK_RESULT::FAILED;
+	entry.sourceTimestamp	= FileManager::GetFileLastWriteTimestamp(path.c_str());
+	entry.settingsHash		= (isModel) ? Importer::Utils::GetImportSettingsHash() : GetTextureSettingsHash(usage);
+
+	if (IsUpToDate(previous, path, entry, GetOutputPath(path, isModel)))
+	{
+		entry.sourceHash	= previous.entries.at(path).sourceHash;
+		entry.dependencies	= previous.entries.at(path).dependencies;
+		entry.result		= COOK_RESULT::UP_TO_DATE;
+		return;
+	}
+
+	// A touched source is cooked again even if its content did not change, the cooked file gets its new timestamp.
+	if (!FileManager::HashFile(path.c_str(), entry.sourceHash))
+	{
+		return;
+	}
+
+	const bool cooked	= (isModel) ? CookModel(path, entry) : CookTexture(path, usage, entry);
+	entry.result		= (cooked) ? COOK_RESULT::COOKED : COOK_RESULT::FAILED;
+}
+
+bool Cooker::Utils::CookModel(const std::string& path, CookerEntry& entry)
+{
+	std::unique_ptr<App> app(new App());
+	app->isHeadless = true;
+
+	if (!Importer::CookModel(app.get(), path.c_str()))
+	{
+		return false;
+	}
+
+	for (const TextureLoad& load : app->textureLoads.loads)
+	{
+		entry.dependencies.push_back({ load.filepath, load.usage });
+	}
+
+	return FileManager::GetFileLastWriteTimestamp(GetOutputPath(path, true).c_str()) != 0;					// MeshCache::Save() does not report its errors.
+}
+
+bool Cooker::Utils::CookTexture(const std::string& path, TEXTURE_USAGE usage, const CookerEntry& entry)
+{
+	Image image = Importer::Utils::LoadImage(path.c_str());
+	if (!image.pixels)
+	{
+		return false;
+	}
+
+	std::vector<u8> cookedFile;
+	const bool cooked = TextureCooker::Cook(image, usage, entry.sourceHash, entry.sourceTimestamp, cookedFile)
+					 && FileManager::WriteBinaryFile(GetOutputPath(path, false).c_str(), cookedFile.data(), cookedFile.size());
+
+	Importer::Utils::FreeImage(image);
+	return cooked;
+}
+
+COOK_RESULT Cooker::Utils::CookScene(const std::string& path, bool force)
+{
+	MappedFile cookedFile = {};
+	const bool isUpToDate = !force && FileManager::MapFile(SceneCooker::Utils::GetCookedPath(path.c_str()).c_str(), cookedFile)
+						 && SceneCooker::Utils::IsUpToDate(cookedFile.data, cookedFile.size, path.c_str());
+	FileManager::UnmapFile(cookedFile);
+	if (isUpToDate)
+	{
+		return COOK_RESULT::UP_TO_DATE;
+	}
+
+	return (SceneCooker::CookFile(path.c_str())) ? COOK_RESULT::COOKED : COOK_RESULT::FAILED;
+}
+
+bool Cooker::Utils::IsUpToDate(const CookerDatabase& database, const std::string& path, const CookerEntry& entry, const std::string& outputPath)
+{
+	auto item = database.entries.find(path);
+	return item != database.entries.end() && item->second.isModel == entry.isModel
+		&& item->second.sourceTimestamp == entry.sourceTimestamp && item->second.settingsHash == entry.settingsHash
+		&& FileManager::GetFileLastWriteTimestamp(outputPath.c_str()) != 0;									// Deleted outputs are cooked again.
+}
+
+static bool HasExtension(const std::string& path, const char* const* extensions, u32 count)
+{
+	const size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (extension == extensions[i])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Cooker::Utils::IsModelFile(const std::string& path)
+{
+	static const char* const extensions[] = { "obj", "fbx", "gltf", "glb", "dae", "3ds", "ply", "blend" };
+	return HasExtension(path, extensions, ARRAY_COUNT(extensions));
+}
+
+bool Cooker::Utils::IsImageFile(const std::string& path)
+{
+	static const char* const extensions[] = { "png", "jpg", "jpeg", "tga", "bmp", "psd" };
+	return HasExtension(path, extensions, ARRAY_COUNT(extensions));
+}
+
+bool Cooker::Utils::IsSceneFile(const std::string& path)
+{
+	static const char* const extensions[] = { "scene" };
+	return HasExtension(path, extensions, ARRAY_COUNT(extensions));
+}
+
+bool Cooker::Utils::IsPackedFile(const std::string& path)
+{
+	static const char* const extensions[] = { "exe", "dll", "pdb", "ilk", "exp", "lib", "ini", "rdbg", "db", "pack", "mtl" };	// .mtl: in the mesh caches.
+	const size_t nameStart = path.find_last_of('/');
+	const bool hasExtension = path.find('.', (nameStart != std::string::npos) ? nameStart : 0) != std::string::npos;
+
+	return hasExtension && !HasExtension(path, extensions, ARRAY_COUNT(extensions)) && !IsModelFile(path) && !IsImageFile(path) && !IsSceneFile(path);
+}
+
+TEXTURE_USAGE Cooker::Utils::GuessUsage(const std::string& path)
+{
+	std::string name = path.substr(0, path.find_last_of('.'));
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)tolower(c); });
+
+	auto EndsWith = [&name](const char* suffix) { const size_t length = strlen(suffix); return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0; };
+	if (EndsWith("_normal"))											{ return TEXTURE_USAGE::NORMAL; }
+	if (EndsWith("_disp") || EndsWith("_height") || EndsWith("_bump"))	{ return TEXTURE_USAGE::HEIGHT; }
+
+	return TEXTURE_USAGE::COLOR;
+}
+
+std::string Cooker::Utils::GetOutputPath(const std::string& path, bool isModel)
+{
+	return (isModel) ? MeshCache::Utils::GetCachePath(path.c_str()) : TextureCooker::Utils::GetCookedPath(path.c_str());
+}
+
+// Everything TextureCooker::Cook() output depends on besides the image.
+u64 Cooker::Utils::GetTextureSettingsHash(TEXTURE_USAGE usage)
+{
+	const u32 settings[] = { COOKED_TEXTURE_VERSION, (u32)usage, COOKED_TEXTURE_USE_BC7 };
+	return FileManager::HashBytes(settings, sizeof(settings));
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef __COOKER_H__
+#define __COOKER_H__
+
+// cooker.h:
+// Offline asset cooker. A console tool built from the engine sources (Cooker.vcxproj) that turns every asset under the
+// working directory into the formats the engine loads without any processing: the mesh caches of the models
+// (mesh_cache.h), the block compressed .ctex of the images (texture_cooker.h) and the compiled scenes (scene_cooker.h).
+// The models are imported on the job system, each one in its own headless App (no GL context), and the textures they
+// reference are cooked afterwards with the usage their materials gave them. Images no model references are cooked as
+// COLOR, unless their name ends in _normal (NORMAL) or _disp / _height / _bump (HEIGHT), as the ones the engine loads
+// itself do.
+// COOKER_DATABASE_FILE keeps the source hash, timestamp and settings hash every output was cooked with, and the textures
+// of each model, so only what changed is cooked again. A source whose timestamp did not move is not even read. Build the engine with REQUIRE_COOKED_ASSETS to load nothing else.
+// Shader binaries are not cooked: glGetProgramBinary() needs a context and its output only fits the driver that made it.
+// -pack then archives the working directory into PACK_FILE_NAME (pack_file.h): the cooked files and what is loaded as
+// is (shaders), not the source assets. The pack only records the hash of every source its cooked files came from.
+// -check only runs the deterministic checks of the mesh optimizer (MeshOptimizer::SelfCheck()) and exits.
+//
+// Usage:	Cooker [-force] [-pack] [-check] [working directory]
+// Linux:	g++ -std=c++17 -O2 -DNDEBUG -ICode -IThirdParty/glad/include -IThirdParty/glm/include -IThirdParty/stb
+//			-IThirdParty/Assimp/include Code/cooker.cpp Code/importer.cpp Code/obj_loader.cpp Code/mesh_*.cpp Code/meshlets.cpp
+//			Code/culling.cpp Code/vertex_format.cpp Code/buffer_manager.cpp Code/texture_*.cpp Code/scene_cooker.cpp Code/transform.cpp
+//			Code/camera.cpp Code/job_system.cpp Code/string_table.cpp Code/file_manager.cpp Code/pack_file.cpp
+//			Code/compression.cpp Code/async_io.cpp Code/globals.cpp ThirdParty/glad/include/glad/glad.c
+//			ThirdParty/stb/stb.cpp -lassimp -lpthread -lm -o Cooker
+//		(run it from the working directory, or pass it: ./Cooker WorkingDir)
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "shader_types.h"
+
+#define COOKER_DATABASE_FILE		"cooker.db"
+#define COOKER_DATABASE_VERSION		2
+
+enum class COOK_RESULT
+{
+	FAILED,
+	COOKED,
+	UP_TO_DATE
+};
+
+struct CookerDependency
+{
+	std::string		path;																			// Texture file, as the material refers to it.
+	TEXTURE_USAGE	usage;
+};
+
+struct CookerEntry
+{
+	bool							isModel;
+	u64								sourceHash;
+	u64								sourceTimestamp;												// Also in the cooked file, see FileManager::IsSourceUnchanged().
+	u64								settingsHash;
+	std::vector<CookerDependency>	dependencies;													// Models only.
+
+	COOK_RESULT						result;															// This run. The failed ones are not saved.
+};
+
+struct CookerDatabase
+{
+	std::map<std::string, CookerEntry>	entries;													// Source path -> entry.
+};
+
+namespace Cooker
+{
+	int  Run				(const char* workingDir, bool force, bool pack);							// Exit code: 0 when every asset cooked (and packed).
+
+	bool LoadDatabase		(const char* filepath, CookerDatabase& database);
+	bool SaveDatabase		(const char* filepath, const CookerDatabase& database);
+
+	namespace Utils
+	{
+		void CookAsset				(const CookerDatabase& previous, const std::string& path, bool isModel, TEXTURE_USAGE usage, CookerEntry& entry);	// Worker thread.
+		bool CookModel				(const std::string& path, CookerEntry& entry);
+		bool CookTexture			(const std::string& path, TEXTURE_USAGE usage, const CookerEntry& entry);
+		COOK_RESULT CookScene		(const std::string& path, bool force);
+		bool IsUpToDate				(const CookerDatabase& database, const std::string& path, const CookerEntry& entry, const std::string& outputPath);
+
+		bool IsModelFile			(const std::string& path);
+		bool IsImageFile			(const std::string& path);
+		bool IsSceneFile			(const std::string& path);
+		bool IsPackedFile			(const std::string& path);											// Everything but the sources, the binaries (no extension on Linux) and the tool files.
+		TEXTURE_USAGE GuessUsage	(const std::string& path);											// For the images no model references.
+
+		std::string GetOutputPath	(const std::string& path, bool isModel);
+		u64  GetTextureSettingsHash	(TEXTURE_USAGE usage);
+	}
+}
+
+#endif // !__COOKER_H__
\ No newline at end of file
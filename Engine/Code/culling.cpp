@@ -0,0 +1,81 @@
+#include "culling.h"
+
+Culling::Frustum Culling::ExtractFrustum(const mat4& viewProjMatrix)
+{
+	const mat4& m = viewProjMatrix;																// glm matrices are column-major: m[col][row].
+	vec4 row0 = vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+	vec4 row1 = vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+	vec4 row2 = vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+	vec4 row3 = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum frustum = {};
+	frustum.planes[0] = row3 + row0;															// Left
+	frustum.planes[1] = row3 - row0;															// Right
+	frustum.planes[2] = row3 + row1;															// Bottom
+	frustum.planes[3] = row3 - row1;															// Top
+	frustum.planes[4] = row3 + row2;															// Near
+	frustum.planes[5] = row3 - row2;															// Far
+
+	for (u32 i = 0; i < 6; ++i)
+	{
+		f32 length = glm::length(vec3(frustum.planes[i]));
+		frustum.planes[i] /= length;
+	}
+
+	return frustum;
+}
+
+bool Culling::SphereInFrustum(const Frustum& frustum, const vec3& center, f32 radius)
+{
+	for (u32 i = 0; i < 6; ++i)
+	{
+		if (glm::dot(vec3(frustum.planes[i]), center) + frustum.planes[i].w < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Projects the view-space bounding box of the sphere and returns its pixel rect (x, y, width, height).
+// Spheres that cross the near plane cannot be projected safely, so they get the whole viewport.
+bool Culling::ComputeScissorRect(const mat4& viewMatrix, const mat4& projMatrix, ivec2 viewportSize, f32 nearPlane, const vec3& center, f32 radius, ivec4& scissorRect)
+{
+	vec3 viewCenter = vec3(viewMatrix * vec4(center, 1.0f));
+
+	if (-viewCenter.z - radius < nearPlane)
+	{
+		scissorRect = ivec4(0, 0, viewportSize.x, viewportSize.y);
+		return true;
+	}
+
+	vec2 ndcMin = vec2( 1.0f,  1.0f);
+	vec2 ndcMax = vec2(-1.0f, -1.0f);
+	for (u32 i = 0; i < 8; ++i)
+	{
+		vec3 corner = viewCenter + vec3((i & 1) ? radius : -radius, (i & 2) ? radius : -radius, (i & 4) ? radius : -radius);
+		vec4 clip	= projMatrix * vec4(corner, 1.0f);
+		vec2 ndc	= vec2(clip) / clip.w;
+
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	ndcMin = glm::clamp(ndcMin, vec2(-1.0f), vec2(1.0f));
+	ndcMax = glm::clamp(ndcMax, vec2(-1.0f), vec2(1.0f));
+
+	ivec2 pixelMin = ivec2(glm::floor((ndcMin * 0.5f + 0.5f) * vec2(viewportSize)));
+	ivec2 pixelMax = ivec2(glm::ceil ((ndcMax * 0.5f + 0.5f) * vec2(viewportSize)));
+
+	scissorRect = ivec4(pixelMin.x, pixelMin.y, pixelMax.x - pixelMin.x, pixelMax.y - pixelMin.y);
+
+	return (scissorRect.z > 0 && scissorRect.w > 0);
+}
+
+// Min/Max distance along the camera's forward axis covered by the sphere.
+vec2 Culling::ComputeDepthBounds(const mat4& viewMatrix, f32 nearPlane, const vec3& center, f32 radius)
+{
+	f32 viewDepth = -(viewMatrix * vec4(center, 1.0f)).z;
+	return vec2(glm::max(viewDepth - radius, nearPlane), viewDepth + radius);
+}
\ No newline at end of file
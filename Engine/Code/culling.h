@@ -0,0 +1,24 @@
+#ifndef __CULLING_H__
+#define __CULLING_H__
+
+// culling.h:
+// Camera-space visibility helpers (frustum planes, bounding sphere tests and screen-space projections).
+
+#include "base_types.h"
+#include "math_types.h"
+
+namespace Culling
+{
+	struct Frustum
+	{
+		vec4 planes[6];																	// Left, Right, Bottom, Top, Near, Far. Normals point inwards.
+	};
+
+	Frustum ExtractFrustum		(const mat4& viewProjMatrix);
+	bool	SphereInFrustum		(const Frustum& frustum, const vec3& center, f32 radius);
+
+	bool	ComputeScissorRect	(const mat4& viewMatrix, const mat4& projMatrix, ivec2 viewportSize, f32 nearPlane, const vec3& center, f32 radius, ivec4& scissorRect);
+	vec2	ComputeDepthBounds	(const mat4& viewMatrix, f32 nearPlane, const vec3& center, f32 radius);
+}
+
+#endif // !__CULLING_H__
\ No newline at end of file
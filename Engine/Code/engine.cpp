@@ -5,6 +5,8 @@
 // graphics related GUI options, and so on.
 //
 
+#include <float.h>
+
 #include "imgui_includes.h"
 
 #include "globals.h"
@@ -15,9 +17,23 @@
 #include "transform.h"
 #include "camera.h"
 #include "primitives.h"
+#include "culling.h"
+#include "light_clusters.h"
+#include "texture_loader.h"
+#include "texture_streaming.h"
+#include "vertex_format.h"
+#include "residency.h"
+#include "scene.h"
+#include "world_streaming.h"
 
 #include "engine.h"
 
+#define LIGHT_VOLUME_SCALE      1.05f                                   // The light icosphere is inscribed in the unit sphere.
+#define LIGHT_CUTOFF_INTENSITY  (5.0f / 256.0f)                         // Intensity below which a point light no longer contributes.
+#define LIGHT_PARAMS_SIZE       (2 * 64 + 6 * 16)                       // Upper bound of a light's local params in the constant buffer (std140).
+#define LIGHT_TILE_SIZE         16                                      // Work group size of TILED_LIGHTING in shader_final.glsl.
+#define LOD_HYSTERESIS          0.75f                                   // A coarser LOD is only picked once its error is well below the threshold.
+
 void Engine::Init(App* app)
 {
     app->enableDebugGroups  = false;
@@ -27,6 +43,26 @@ void Engine::Init(App* app)
     app->useBumpMap     = false;
     app->bumpiness      = 1.0f;
 
+    app->cullLightVolumes = true;
+    app->lightingMode     = LIGHTING_MODE::LIGHT_VOLUMES;
+    app->lightVolumeMode  = LIGHT_VOLUME_MODE::SCISSOR;
+
+    app->enableLods         = true;
+    app->lodErrorThreshold  = 1.0f;
+    app->drawnTriangles     = 0;
+    app->cullMeshlets       = true;
+    app->enableHlod         = true;
+    app->hlodDistance       = 60.0f;
+    app->enableImpostors    = true;
+    app->impostorDistance   = 40.0f;
+    app->residency.ramBudget    = RESIDENCY_DEFAULT_RAM_BUDGET;
+    app->residency.vramBudget   = RESIDENCY_DEFAULT_VRAM_BUDGET;
+    app->textureStreamer.budget     = TEXTURE_STREAMING_DEFAULT_BUDGET;
+    app->textureStreamer.mipBias    = 0.0f;
+    app->worldStreamer.loadDistance = WORLD_STREAMING_LOAD_DISTANCE;
+    app->worldStreamer.unloadMargin = WORLD_STREAMING_UNLOAD_MARGIN;
+    app->worldStreamer.maxInstances = WORLD_STREAMING_MAX_INSTANCES;
+
     app->renderMode  = RENDER_MODE::DEFERRED;
     app->renderLayer = RENDER_LAYER::SHADED;
     app->shaderMode  = SHADER_MODE::ENTITIES;
@@ -57,6 +93,8 @@ void Engine::Init(App* app)
 void Engine::Update(App* app)
 {   
     Input::GetInput(app);
+
+    TextureLoader::ProcessUploads(app);
     
     if (app->refreshFramebuffer)
     {
@@ -68,9 +106,35 @@ void Engine::Update(App* app)
 
     if (app->shaderMode == SHADER_MODE::ENTITIES)
     {
+        Lights::CullLights(app);
+
+        bool volumesFromLightBuffer = (app->lightingMode == LIGHTING_MODE::LIGHT_VOLUMES && app->lightVolumeMode == LIGHT_VOLUME_MODE::INSTANCED);
+        if (!Renderer::InDeferredMode(app) || app->lightingMode != LIGHTING_MODE::LIGHT_VOLUMES || volumesFromLightBuffer)
+        {
+            LightClusters::UpdateLightBuffer(app);
+        }
+
+        if (!Renderer::InDeferredMode(app) || app->lightingMode == LIGHTING_MODE::CLUSTERED)
+        {
+            LightClusters::BinLights(app);
+        }
+
+        WorldStreaming::Update(app);                                                        // Reveals the new entities before they are selected.
+        Hlod::SelectProxies(app);
+        Impostors::SelectImpostors(app);
+        Residency::Update(app);
+        Renderer::SelectLods(app);
+
+        if (app->cullMeshlets)
+        {
+            Meshlets::CullMeshlets(app);
+        }
+
         (!Renderer::InDeferredMode(app)) ? Shaders::ForwardUniformBlockBuffer(app) : Shaders::DeferredUniformBlockBuffer(app);
     }
 
+    TextureStreaming::Update(app);                                                          // Needs the HLOD and impostor selection.
+
     Shaders::HotReloading(app);
 }
 
@@ -215,6 +279,72 @@ u32 Engine::LoadProgram(App* app, const char* filepath, const char* programName)
     return app->programs.size() - 1;
 }
 
+GLuint Engine::CreateComputeProgramFromSource(String programSource, const char* shaderName)
+{
+    GLchar  infoLogBuffer[1024] = {};
+    GLsizei infoLogBufferSize = sizeof(infoLogBuffer);
+    GLsizei infoLogSize;
+    GLint   success;
+
+    char versionString[] = "#version 430\n";
+    char shaderNameDefine[128];
+    sprintf(shaderNameDefine, "#define %s\n", shaderName);
+    char computeShaderDefine[] = "#define COMPUTE\n";
+
+    const GLchar* computeShaderSource[] = {
+        versionString,
+        shaderNameDefine,
+        computeShaderDefine,
+        programSource.str
+    };
+    const GLint computeShaderLengths[] = {
+        (GLint)strlen(versionString),
+        (GLint)strlen(shaderNameDefine),
+        (GLint)strlen(computeShaderDefine),
+        (GLint)programSource.len
+    };
+
+    GLuint cshader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(cshader, ARRAY_COUNT(computeShaderSource), computeShaderSource, computeShaderLengths);
+    glCompileShader(cshader);
+    glGetShaderiv(cshader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(cshader, infoLogBufferSize, &infoLogSize, infoLogBuffer);
+        ELOG("glCompileShader() failed with compute shader %s\nReported message:\n%s\n", shaderName, infoLogBuffer);
+    }
+
+    GLuint programHandle = glCreateProgram();
+    glAttachShader(programHandle, cshader);
+    glLinkProgram(programHandle);
+    glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(programHandle, infoLogBufferSize, &infoLogSize, infoLogBuffer);
+        ELOG("glLinkProgram() failed with program %s\nReported message:\n%s\n", shaderName, infoLogBuffer);
+    }
+
+    glDetachShader(programHandle, cshader);
+    glDeleteShader(cshader);
+
+    return programHandle;
+}
+
+u32 Engine::LoadComputeProgram(App* app, const char* filepath, const char* programName)
+{
+    String programSource = FileManager::ReadTextFile(filepath);
+
+    Program program = {};
+    program.handle = CreateComputeProgramFromSource(programSource, programName);
+    program.filepath = filepath;
+    program.programName = programName;
+    program.lastWriteTimestamp = FileManager::GetFileLastWriteTimestamp(filepath);
+    program.isCompute = true;
+    app->programs.push_back(program);
+
+    return app->programs.size() - 1;
+}
+
 bool Engine::UniformIsInvalid(GLuint uniformHandle)
 {
     return (uniformHandle == GL_INVALID_VALUE || uniformHandle == GL_INVALID_OPERATION);
@@ -232,16 +362,18 @@ GLuint Engine::CreateVAO(Mesh& mesh, Submesh& submesh, const Program& program)
     for (u32 i = 0; i < program.VIL.attributes.size(); ++i)
     {
         bool attributeWasLinked = false;
-        for (u32 j = 0; j < submesh.VBL.attributes.size(); ++j)
+        const VertexBufferLayout& layout = VertexFormat::GetGpuLayout(submesh);
+        for (u32 j = 0; j < layout.attributes.size(); ++j)
         {
-            if (program.VIL.attributes[i].location == submesh.VBL.attributes[j].location)
+            if (program.VIL.attributes[i].location == layout.attributes[j].location)
             {
-                const u32 index     = submesh.VBL.attributes[j].location;
-                const u32 ncomp     = submesh.VBL.attributes[j].componentCount;
-                const u32 offset    = submesh.VBL.attributes[j].offset + submesh.vertexOffset;
-                const u32 stride    = submesh.VBL.stride;
+                const u32 index     = layout.attributes[j].location;
+                const u32 ncomp     = layout.attributes[j].componentCount;
+                const u32 offset    = layout.attributes[j].offset + submesh.vertexOffset;
+                const u32 stride    = layout.stride;
+                const GLenum type   = layout.attributes[j].type;
 
-                glVertexAttribPointer(index, ncomp, GL_FLOAT, GL_FALSE, stride, (void*)(u64)offset);
+                glVertexAttribPointer(index, ncomp, type, layout.attributes[j].normalized, stride, (void*)(u64)offset);
                 glEnableVertexAttribArray(index);
 
                 attributeWasLinked = true;
@@ -258,6 +390,17 @@ GLuint Engine::CreateVAO(Mesh& mesh, Submesh& submesh, const Program& program)
     return vaoHandle;
 }
 
+// Quantized submeshes store their positions relative to their AABB. Float ones go through unchanged.
+void Engine::SetPositionDequantization(const Program& program, const Submesh& submesh)
+{
+    const bool isPacked = !submesh.packedVBL.attributes.empty();
+    const vec3 scale    = (isPacked) ? submesh.positionScale  : vec3(1.0f);
+    const vec3 offset   = (isPacked) ? submesh.positionOffset : vec3(0.0f);
+
+    glUniform3fv(glGetUniformLocation(program.handle, "uPositionScale"),  1, glm::value_ptr(scale));
+    glUniform3fv(glGetUniformLocation(program.handle, "uPositionOffset"), 1, glm::value_ptr(offset));
+}
+
 GLuint Engine::FindVAO(Mesh& mesh, u32 submeshIndex, const Program& program)
 {
     Submesh& submesh = mesh.submeshes[submeshIndex];
@@ -333,8 +476,11 @@ void Engine::Shaders::LoadBaseTextures(App* app)
     app->diceTexIdx     = Importer::LoadTexture2D(app, "dice.png");
     app->whiteTexIdx    = Importer::LoadTexture2D(app, "color_white.png");
     app->blackTexIdx    = Importer::LoadTexture2D(app, "color_black.png");
-    app->normalTexIdx   = Importer::LoadTexture2D(app, "color_normal.png");
+    app->normalTexIdx   = Importer::LoadTexture2D(app, "color_normal.png", TEXTURE_USAGE::NORMAL);
     app->magentaTexIdx  = Importer::LoadTexture2D(app, "color_magenta.png");
+
+    TextureLoader::WaitAll(app);                                                            // Every later load uses these as placeholders.
+    app->textureLoads.placeholdersReady = true;
 }
 
 void Engine::Shaders::CreateDefaultMaterial(App* app)
@@ -343,7 +489,7 @@ void Engine::Shaders::CreateDefaultMaterial(App* app)
     Material& material = app->materials.back();
     app->defaultMaterialIdx = app->materials.size() - 1u;
 
-    material.name       = "Default";
+    material.name       = StringTable::Intern("Default");
     material.albedo     = vec3(1.0f, 1.0f, 1.0f);
     material.emissive   = vec3(1.0f, 1.0f, 1.0f);
     material.smoothness = 1.0f;
@@ -376,7 +522,7 @@ void Engine::Shaders::GetProgramAttributes(App* app, GLuint programHandle, GLuin
         attributeLocation = glGetAttribLocation(program.handle, attributeName);
         glVertexAttribPointer(attributeLocation, attributeSize, attributeType, GL_FALSE, sizeof(float) * 5, (void*)0);          // Is this necessary?
 
-        program.VIL.attributes.push_back({ (u8)attributeLocation, (u8)attributeSize });
+        program.VIL.attributes.push_back({ (u8)attributeLocation, (u8)attributeSize, 0, GL_FALSE, GL_FLOAT });               // Only the location and size are matched.
     }
 }
 
@@ -391,22 +537,13 @@ void Engine::Shaders::ForwardUniformBlockBuffer(App* app)
     BufferManager::MapBuffer(app->cbuffer, GL_WRITE_ONLY);
     app->globalParamsOffset = app->cbuffer.head;
 
-    PushVec3(app->cbuffer, app->camera.position);
+    PushVec3(app->cbuffer, app->camera.position);                                          // Lights are read from the cluster SSBOs.
     PushUInt(app->cbuffer, (u32)app->renderLayer);
-    PushUInt(app->cbuffer, (u32)app->activeLights);
-    for (u32 i = 0; i < app->activeLights; ++i)
-    {
-        BufferManager::AlignHead(app->cbuffer, sizeof(vec4));
-
-        Light& light = app->lights[i];
-        PushUInt(app->cbuffer, light.type);
-        PushVec3(app->cbuffer, light.color);
-        PushVec3(app->cbuffer, light.direction);
-        PushVec3(app->cbuffer, light.position);
-    }
 
     app->globalParamsSize = app->cbuffer.head - app->globalParamsOffset;
 
+    LightClusters::PushClusterParams(app);
+
     for (u32 i = 0; i < app->entities.size(); ++i)
     {
         BufferManager::AlignHead(app->cbuffer, app->uniformBlockAlignment);
@@ -431,9 +568,12 @@ void Engine::Shaders::DeferredUniformBlockBuffer(App* app)
 
     PushVec3(app->cbuffer, app->camera.position);
     PushUInt(app->cbuffer, (u32)app->renderLayer);
+    PushVec3(app->cbuffer, glm::normalize(app->camera.target - app->camera.position));
 
     app->globalParamsSize = app->cbuffer.head - app->globalParamsOffset;
 
+    LightClusters::PushClusterParams(app);
+
     for (u32 i = 0; i < app->entities.size(); ++i)
     {
         BufferManager::AlignHead(app->cbuffer, app->uniformBlockAlignment);
@@ -450,9 +590,13 @@ void Engine::Shaders::DeferredUniformBlockBuffer(App* app)
 
     for (u32 i = 0; i < app->activeLights; ++i)
     {
-        BufferManager::AlignHead(app->cbuffer, app->uniformBlockAlignment);
-
         Light& light = app->lights[i];
+        if (!light.isVisible)
+        {
+            continue;
+        }
+
+        BufferManager::AlignHead(app->cbuffer, app->uniformBlockAlignment);
         light.localParamsOffset = app->cbuffer.head;
 
         PushMat4(app->cbuffer, light.worldMatrix);
@@ -462,6 +606,9 @@ void Engine::Shaders::DeferredUniformBlockBuffer(App* app)
         PushVec3(app->cbuffer, light.color);
         PushVec3(app->cbuffer, light.direction);
         PushVec3(app->cbuffer, light.position);
+        PushFloat(app->cbuffer, light.radius);
+        PushVec3(app->cbuffer, light.attenuation);
+        PushVec2(app->cbuffer, light.depthBounds);
 
         light.localParamsSize = app->cbuffer.head - light.localParamsOffset;
     }
@@ -481,41 +628,138 @@ void Engine::Shaders::HotReloading(App* app)
             glDeleteProgram(program.handle);
             String programSource = FileManager::ReadTextFile(program.filepath.c_str());
             const char* programName = program.programName.c_str();
-            program.handle = CreateProgramFromSource(programSource, programName);
+            program.handle = (program.isCompute) ? CreateComputeProgramFromSource(programSource, programName) : CreateProgramFromSource(programSource, programName);
             program.lastWriteTimestamp = currentTimestamp;
         }
     }
 }
 
 // ENTITIES --------------------------------------------------------------------
-void Engine::Lights::AddLight(App* app, LIGHT_TYPE type, vec3 color, vec3 direction, vec3 position, mat4 worldMatrix)
+void Engine::Lights::AddLight(App* app, LIGHT_TYPE type, vec3 color, vec3 direction, vec3 position, vec3 attenuation, mat4 worldMatrix)
 {
     Light light         = {};
     light.type          = type;
     light.color         = color;
     light.direction     = direction;
     light.position      = position;
+    light.attenuation   = attenuation;
+    light.radius        = ComputeLightRadius(color, attenuation);
     light.worldMatrix   = worldMatrix;
+    light.isVisible     = true;
+
+    if (type == LT_POINT)
+    {
+        light.worldMatrix = worldMatrix * Transform::Scale(vec3(light.radius * LIGHT_VOLUME_SCALE));      // The volume sphere must enclose the whole radius.
+    }
 
     app->lights.push_back(light);
     ++app->activeLights;
 }
 
+void Engine::Lights::AddRandomPointLights(App* app, u32 count)
+{
+    const u32 maxLights     = GetMaxLights(app);
+    const u32 freeLights    = (maxLights > (u32)app->lights.size()) ? maxLights - (u32)app->lights.size() : 0;
+    if (count > freeLights)
+    {
+        ELOG("Only %u of the %u requested point lights fit in the constant buffer (%u lights at most)", freeLights, count, maxLights);
+        count = freeLights;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        vec3 position   = vec3(((f32)rand() / RAND_MAX) * 50.0f - 25.0f, ((f32)rand() / RAND_MAX) * 5.0f + 0.5f, ((f32)rand() / RAND_MAX) * 50.0f - 25.0f);
+        vec3 color      = vec3((f32)rand() / RAND_MAX, (f32)rand() / RAND_MAX, (f32)rand() / RAND_MAX);
+
+        AddLight(app, LT_POINT, color, vec3(0.0f), position, smallAttenuation, Transform::PositionScale(position, Transform::defaultScale));
+    }
+}
+
+// Frustum culls the point lights and computes the scissor rect and depth range each surviving light can touch.
+void Engine::Lights::CullLights(App* app)
+{
+    const mat4 viewMatrix   = app->camera.GetViewMatrix();
+    const mat4 projMatrix   = app->camera.GetProjMatrix();
+    const f32  nearPlane    = app->camera.GetNearPlane();
+
+    Culling::Frustum frustum = Culling::ExtractFrustum(projMatrix * viewMatrix);
+
+    app->visibleLights = 0;
+    for (u32 i = 0; i < app->activeLights; ++i)
+    {
+        Light& light = app->lights[i];
+
+        light.isVisible     = true;
+        light.scissorRect   = ivec4(0, 0, app->displaySize.x, app->displaySize.y);
+        light.depthBounds   = vec2(0.0f, app->camera.GetFarPlane());
+
+        if (light.type == LT_POINT && light.radius <= 0.0f)
+        {
+            light.isVisible = false;                                                            // Too dim to ever reach the cutoff.
+        }
+        else if (light.type == LT_POINT && app->cullLightVolumes)
+        {
+            light.isVisible = Culling::SphereInFrustum(frustum, light.position, light.radius)
+                           && Culling::ComputeScissorRect(viewMatrix, projMatrix, app->displaySize, nearPlane, light.position, light.radius, light.scissorRect);
+
+            light.depthBounds = Culling::ComputeDepthBounds(viewMatrix, nearPlane, light.position, light.radius);
+        }
+
+        if (light.isVisible)
+        {
+            ++app->visibleLights;
+        }
+    }
+}
+
+// Distance at which the attenuated intensity of the brightest channel falls below LIGHT_CUTOFF_INTENSITY.
+// Solves: maxChannel / (constant + linear * d + quadratic * d^2) = cutoff.
+f32 Engine::Lights::ComputeLightRadius(vec3 color, vec3 attenuation)
+{
+    const f32 maxChannel    = glm::max(glm::max(color.r, color.g), color.b);
+    const f32 constant      = attenuation.x - (maxChannel / LIGHT_CUTOFF_INTENSITY);
+    const f32 linear        = attenuation.y;
+    const f32 quadratic     = attenuation.z;
+
+    if (quadratic <= 0.0f)
+    {
+        return (linear > 0.0f) ? glm::max(-constant / linear, 0.0f) : FLT_MAX;
+    }
+
+    const f32 discriminant = linear * linear - 4.0f * quadratic * constant;                     // Negative when even d = 0 is below the cutoff.
+    if (discriminant < 0.0f)
+    {
+        return 0.0f;
+    }
+
+    return glm::max((-linear + sqrtf(discriminant)) / (2.0f * quadratic), 0.0f);
+}
+
+// Every light, entity and the global and cluster params take an aligned block of the constant buffer each frame
+// (DeferredUniformBlockBuffer()), the lights get what the others leave.
+u32 Engine::Lights::GetMaxLights(const App* app)
+{
+    const u32 blockSize = BufferManager::Align(LIGHT_PARAMS_SIZE, (u32)glm::max(app->uniformBlockAlignment, 1));
+    const u32 reserved  = ((u32)app->entities.size() + 2u) * blockSize;
+
+    return (app->cbuffer.size > reserved) ? (app->cbuffer.size - reserved) / blockSize : 0;
+}
+
 // RENDERER --------------------------------------------------------------------
 void Engine::Renderer::InitFramebuffer(App* app)
 {
     // GENERATING TEXTURES
-    GenerateFramebufferTexture(app->GShadedTex,    app->displaySize,   GL_UNSIGNED_BYTE);
-    GenerateFramebufferTexture(app->GAlbedoTex,    app->displaySize,   GL_UNSIGNED_BYTE);
-    GenerateFramebufferTexture(app->GNormalTex,    app->displaySize,   GL_UNSIGNED_BYTE);
-    GenerateFramebufferTexture(app->GDepthTex,     app->displaySize,   GL_UNSIGNED_BYTE);
-    GenerateFramebufferTexture(app->GPositionTex,  app->displaySize,   GL_FLOAT);
+    GenerateFramebufferTexture(app->GShadedTex,    app->displaySize,   GL_RGBA8,       GL_UNSIGNED_BYTE);
+    GenerateFramebufferTexture(app->GAlbedoTex,    app->displaySize,   GL_RGBA8,       GL_UNSIGNED_BYTE);
+    GenerateFramebufferTexture(app->GNormalTex,    app->displaySize,   GL_RGBA8,       GL_UNSIGNED_BYTE);
+    GenerateFramebufferTexture(app->GDepthTex,     app->displaySize,   GL_RGBA8,       GL_UNSIGNED_BYTE);
+    GenerateFramebufferTexture(app->GPositionTex,  app->displaySize,   GL_RGBA32F,     GL_FLOAT);          // World units: an 8-bit target would clamp them to [0, 1].
 
     // DEPTH BUFFER ATTACHMENT
     glGenTextures(1, &app->depthBufferHandle);
     glBindTexture(GL_TEXTURE_2D, app->depthBufferHandle);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, app->displaySize.x, app->displaySize.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, app->displaySize.x, app->displaySize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);   // Stencil used by the light volumes.
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -533,7 +777,7 @@ void Engine::Renderer::InitFramebuffer(App* app)
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2,  app->GNormalTex,        0);
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3,  app->GDepthTex,         0);
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4,  app->GPositionTex,      0);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,   app->depthBufferHandle, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, app->depthBufferHandle, 0);
 
     CheckFramebufferStatus();
 
@@ -571,12 +815,12 @@ void Engine::Renderer::FreeFramebuffer(App* app)
     glDeleteFramebuffers(1, &app->framebufferHandle);
 }
 
-void Engine::Renderer::GenerateFramebufferTexture(GLuint& texHandle, ivec2 size, GLint type)
+void Engine::Renderer::GenerateFramebufferTexture(GLuint& texHandle, ivec2 size, GLint internalFormat, GLint type)
 {
     glGenTextures(1, &texHandle);
     glBindTexture(GL_TEXTURE_2D, texHandle);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, type, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size.x, size.y, 0, GL_RGBA, type, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -692,7 +936,7 @@ void Engine::Renderer::InitMesh(App* app, const char* meshPath)
         attributeLocation = glGetAttribLocation(texMeshProgram.handle, attributeName);
         glVertexAttribPointer(attributeLocation, attributeSize, attributeType, GL_FALSE, sizeof(float) * 5, (void*)0);
 
-        texMeshProgram.VIL.attributes.push_back({ (u8)attributeLocation, (u8)attributeSize });
+        texMeshProgram.VIL.attributes.push_back({ (u8)attributeLocation, (u8)attributeSize, 0, GL_FALSE, GL_FLOAT });
     }
 }
 
@@ -702,31 +946,18 @@ void Engine::Renderer::InitEntities(App* app)
     InitLightingQuad(app);
     InitFramebufferQuad(app);
     
-    // MODEL LOADING
-    u32 patrickModelIdx = Importer::LoadModel(app, "Patrick/Patrick.obj");
-    u32 reliefCubeIdx   = Importer::LoadModel(app, "Cube/Cube.fbx");
-    u32 sphereIdx       = Importer::LoadModel(app, "Sphere/Sphere.fbx");
-    u32 planeIdx        = Primitives::GetPlaneIdx();
-    Primitives::SetSphereIdx(sphereIdx);
-
     // TEXTURE LOADING
-    app->reliefTexIdx   = Importer::LoadTexture2D(app, "Cube/toy_box_disp.png");
+    app->reliefTexIdx   = Importer::LoadTexture2D(app, "Cube/toy_box_disp.png", TEXTURE_USAGE::HEIGHT);
     
-    // ENTITIES
-    //                        NAME          WORLD MATRIX                                                                MODEL IDX           PRMS OFFSET PRMS SIZE
-    app->entities.push_back({ "Patrick_1",  Transform::PositionScale({ 5.0f, 3.5f, -5.0f }, Transform::defaultScale),   patrickModelIdx,    0,          0       });
-    app->entities.push_back({ "Patrick_2",  Transform::PositionScale({ 0.0f, 3.5f,  0.0f }, Transform::defaultScale),   patrickModelIdx,    0,          0       });
-    app->entities.push_back({ "Patrick_3",  Transform::PositionScale({-5.0f, 3.5f, -5.0f }, Transform::defaultScale),   patrickModelIdx,    0,          0       });
-    app->entities.push_back({ "ReliefCube", Transform::PositionScale({ 0.0f, 5.0f,  0.0f }, Transform::defaultScale),   reliefCubeIdx,      0,          0       });
-    app->entities.push_back({ "Plane_1",    Transform::PositionScale({ 0.0f, 0.0f,  0.0f }, { 25.0f, 25.0f, 25.0f }),   planeIdx,           0,          0       });
-    app->entities.push_back({ "Sphere_1",   Transform::PositionScale({ 2.0f, 2.0f,  0.0f }, Transform::defaultScale),   sphereIdx,          0,          0       });
-
-    // LIGHTS
-    //                    LIGHT TYPE        COLOR                 DIRECTION             POSITION 
-    Lights::AddLight(app, LT_DIRECTIONAL, { 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f,  1.0f }, Transform::PositionScale({ 1.0f, 1.0f,  1.0f }, Transform::defaultScale));
-    Lights::AddLight(app, LT_POINT,       { 0.5f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 3.0f, -2.0f }, Transform::PositionScale({ 0.0f, 3.0f, -2.0f }, Transform::defaultScale));
-    //app->lights.push_back({ LT_DIRECTIONAL, { 1.0f, 1.0f, 1.0f }, { -1.0f, -1.0f, -1.0f },  { 1.0f, 1.0f,  1.0f } });
-    //app->lights.push_back({ LT_POINT,       { 0.5f, 0.0f, 0.0f }, {  0.0f,  0.0f,  0.0f },  { 0.0f, 3.0f, -2.0f } });
+    // SCENE (entities and lights, see default.scene)
+    LoadedScene scene = {};
+    Scene::Load(app, SCENE_DEFAULT_FILE, scene);
+
+    const std::string worldCookedPath = SceneCooker::Utils::GetCookedPath(WORLD_STREAMING_DEFAULT_FILE);       // Optional, its cells are streamed in by Update().
+    if (FileManager::GetFileLastWriteTimestamp(WORLD_STREAMING_DEFAULT_FILE) != 0 || FileManager::GetFileLastWriteTimestamp(worldCookedPath.c_str()) != 0)
+    {
+        WorldStreaming::Load(app, WORLD_STREAMING_DEFAULT_FILE);
+    }
 
     // SHADER
     app->forwardRenderingProgramIdx = LoadProgram(app, "shader_final.glsl", "FORWARD_RENDERING");
@@ -737,9 +968,35 @@ void Engine::Renderer::InitEntities(App* app)
     Shaders::GetProgramAttributes(app, app->deferredGeometryProgramIdx, a);
     app->deferredLightingProgramIdx = LoadProgram(app, "shader_final.glsl", "LIGHTING_PASS");
     Shaders::GetProgramAttributes(app, app->deferredLightingProgramIdx, a);
+    app->clusteredLightingProgramIdx = LoadProgram(app, "shader_final.glsl", "CLUSTERED_LIGHTING");
+    Shaders::GetProgramAttributes(app, app->clusteredLightingProgramIdx, a);
+    app->tiledLightingProgramIdx = LoadComputeProgram(app, "shader_final.glsl", "TILED_LIGHTING");
+    app->instancedLightingProgramIdx = LoadProgram(app, "shader_final.glsl", "INSTANCED_LIGHTING_PASS");
+    Shaders::GetProgramAttributes(app, app->instancedLightingProgramIdx, a);
+    app->lightStencilProgramIdx = LoadProgram(app, "shader_final.glsl", "LIGHT_STENCIL_PASS");
+    Shaders::GetProgramAttributes(app, app->lightStencilProgramIdx, a);
+    app->impostorBakeProgramIdx = LoadProgram(app, "shader_final.glsl", "IMPOSTOR_BAKE");
+    Shaders::GetProgramAttributes(app, app->impostorBakeProgramIdx, a);
+    app->impostorProgramIdx = LoadProgram(app, "shader_final.glsl", "IMPOSTOR_PASS");
 
     Shaders::InitUniformBlockBuffer(app);
-    app->cbuffer = CreateConstantBuffer(app->maxUniformBufferSize);
+    app->cbuffer = CreateConstantBuffer(MB(4));                                             // Every bound range still has to fit in maxUniformBufferSize.
+
+    LightClusters::Init(app);
+    Meshlets::Init(app);
+    InitLightInstances(app);
+
+    TextureLoader::WaitAll(app);                                                            // The impostor bake samples the real albedo.
+
+    Impostors::Init(app);
+    for (u32 i = 0; i < scene.impostorModels.size(); ++i)
+    {
+        Impostors::BakeImpostor(app, scene.impostorModels[i]);
+    }
+
+    Hlod::BuildClusters(app);
+
+    Residency::Init(app);                                                                   // The bakes above were the last readers of the CPU copies.
 }
 
 void Engine::Renderer::InitLightingQuad(App* app)
@@ -845,6 +1102,43 @@ void Engine::Renderer::InitFramebufferQuad(App* app)
     }
 }
 
+// The light sphere's positions plus the packed light buffer as per-instance data (one GpuLight per instance).
+void Engine::Renderer::InitLightInstances(App* app)
+{
+    Model& model        = app->models[Primitives::GetLightSphereIdx()];
+    Mesh& mesh          = app->meshes[model.meshIdx];
+    Submesh& submesh    = mesh.submeshes[0];                                                                    // The light sphere is a single submesh.
+
+    glGenVertexArrays(1, &app->vaoLightInstances);
+    glBindVertexArray(app->vaoLightInstances);
+
+    const VertexBufferLayout& layout        = VertexFormat::GetGpuLayout(submesh);                              // Positions only, see primitives.h.
+    const VertexBufferAttribute& position   = layout.attributes[0];
+    const u64 positionOffset                = submesh.vertexOffset + position.offset;
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);                                                     // --------------------------------------
+    glVertexAttribPointer(0, 3, position.type, position.normalized, layout.stride, (void*)positionOffset);      // Positions
+    glEnableVertexAttribArray(0);                                                                               // --------------------------------------
+
+    const GLsizei stride = sizeof(GpuLight);
+
+    glBindBuffer(GL_ARRAY_BUFFER, app->clusterGrid.lightBuffer.handle);                                         // --------------------------------------
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuLight, positionRadius));         // Position & Radius
+    glVertexAttribDivisor(5, 1);                                                                                //
+    glEnableVertexAttribArray(5);                                                                               //
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuLight, colorType));              // Color & Type
+    glVertexAttribDivisor(6, 1);                                                                                //
+    glEnableVertexAttribArray(6);                                                                               //
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuLight, attenuation));            // Attenuation
+    glVertexAttribDivisor(7, 1);                                                                                //
+    glEnableVertexAttribArray(7);                                                                               // --------------------------------------
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Engine::Renderer::RenderLightingQuad(App* app)
 {
     glBindVertexArray(app->vaoFramebufferQuad);
@@ -854,22 +1148,76 @@ void Engine::Renderer::RenderLightingQuad(App* app)
     glBindVertexArray(0);
 }
 
-void Engine::Renderer::RenderLightingSphere(App* app)
+// program is the one in use. The light sphere is the position-only icosphere of Primitives.
+void Engine::Renderer::RenderLightingSphere(App* app, const Program& program)
 {
-    Model& model = app->models[Primitives::GetSphereIdx()];
+    Model& model = app->models[Primitives::GetLightSphereIdx()];
     Mesh& mesh   = app->meshes[model.meshIdx];
     for (u32 i = 0; i < mesh.submeshes.size(); ++i)
     {
         GLuint VAO = FindVAO(mesh, i, app->programs[app->deferredLightingProgramIdx]);
         glBindVertexArray(VAO);
+        SetPositionDequantization(program, mesh.submeshes[i]);
 
         Submesh& submesh = mesh.submeshes[i];
-        glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
+        glDrawElements(GL_TRIANGLES, submesh.lods[0].indexCount, submesh.indexType, (void*)(u64)submesh.indexOffset);
     }
 
     glBindVertexArray(0);
 }
 
+void Engine::Renderer::BindGBufferTextures(App* app, const Program& program)
+{
+    glUniform1i(glGetUniformLocation(program.handle, "oAlbedo"),    0);
+    glUniform1i(glGetUniformLocation(program.handle, "oNormals"),   1);
+    glUniform1i(glGetUniformLocation(program.handle, "oDepth"),     2);
+    glUniform1i(glGetUniformLocation(program.handle, "oPosition"),  3);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, app->GAlbedoTex);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, app->GNormalTex);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, app->GDepthTex);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, app->GPositionTex);
+}
+
+// Two-pass stencil light volume. The marking pass counts, per pixel, the back faces behind the G-buffer surface minus
+// the front faces behind it: only surfaces inside the sphere end up != 0, and only those get shaded.
+// Expects the light's LightParams range to be bound and the scissor rect to be set.
+void Engine::Renderer::RenderStencilLightVolume(App* app)
+{
+    glClear(GL_STENCIL_BUFFER_BIT);                                                         // Clipped to the light's scissor rect.
+    glEnable(GL_STENCIL_TEST);
+
+    // MARKING PASS
+    glUseProgram(app->programs[app->lightStencilProgramIdx].handle);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glStencilFunc(GL_ALWAYS, 0, 0xFF);
+    glStencilOpSeparate(GL_BACK,  GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+    glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+
+    RenderLightingSphere(app, app->programs[app->lightStencilProgramIdx]);
+
+    // SHADING PASS
+    glUseProgram(app->programs[app->deferredLightingProgramIdx].handle);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+    RenderLightingSphere(app, app->programs[app->deferredLightingProgramIdx]);
+
+    glDisable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glDisable(GL_STENCIL_TEST);
+}
+
 void Engine::Renderer::RenderQuad(App* app)
 {
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -912,6 +1260,7 @@ void Engine::Renderer::RenderMesh(App* app)
     {
         GLuint VAO = FindVAO(mesh, i, texturedMeshProgram);
         glBindVertexArray(VAO);
+        SetPositionDequantization(texturedMeshProgram, mesh.submeshes[i]);
 
         u32 submeshMaterialIdx = model.materialIndices[i];
         Material& submeshMaterial = app->materials[submeshMaterialIdx];
@@ -921,7 +1270,7 @@ void Engine::Renderer::RenderMesh(App* app)
         glUniform1i(app->texMeshProgramUniformTexture, 0);
 
         Submesh& submesh = mesh.submeshes[i];
-        glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
+        glDrawElements(GL_TRIANGLES, submesh.lods[0].indexCount, submesh.indexType, (void*)(u64)submesh.indexOffset);
     }
 
     glBindVertexArray(0);
@@ -933,14 +1282,26 @@ void Engine::Renderer::RenderEntities(App* app)
     BindFramebufferForRender(app);
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     glViewport(0, 0, app->displaySize.x, app->displaySize.y);
 
     GeometryPass(app);
 
     if (InDeferredMode(app))
     {
-        LightingPass(app);
+        ImpostorPass(app);
+
+        switch (app->lightingMode)
+        {
+        case LIGHTING_MODE::LIGHT_VOLUMES:
+        {
+            (app->lightVolumeMode == LIGHT_VOLUME_MODE::INSTANCED) ? InstancedLightingPass(app) : LightingPass(app);
+        }
+        break;
+
+        case LIGHTING_MODE::CLUSTERED:      { ClusteredLightingPass(app); } break;
+        case LIGHTING_MODE::TILED_COMPUTE:  { TiledLightingPass(app); }     break;
+        }
     }
 
     glBindVertexArray(0);
@@ -961,16 +1322,38 @@ void Engine::Renderer::GeometryPass(App* app)
 
     glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
 
+    if (!InDeferredMode(app))
+    {
+        LightClusters::BindBuffers(app);
+    }
+
+    app->drawnTriangles = 0;
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, app->meshletDraws.indirectBuffer.handle);
+
     for (u32 i = 0; i < app->entities.size(); ++i)
     {
+        if (app->entities[i].isHidden || app->entities[i].isImpostor)
+        {
+            continue;
+        }
+
         glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(1), app->cbuffer.handle, app->entities[i].localParamsOffset, app->entities[i].localParamsSize);
 
-        Model& model = app->models[app->entities[i].modelIndex];
-        Mesh& mesh   = app->meshes[model.meshIdx];
+        Model& model    = app->models[app->entities[i].modelIndex];
+        Mesh& mesh      = app->meshes[model.meshIdx];
+        u32 lodLevel    = app->entities[i].lodLevel;
+        if (!Residency::IsResident(app, model.meshIdx))                                     // Evicted and its reload failed.
+        {
+            continue;
+        }
+
+        u32 entityIdx   = i;
         for (u32 i = 0; i < mesh.submeshes.size(); ++i)
         {
             GLuint VAO = FindVAO(mesh, i, renderProgram);
             glBindVertexArray(VAO);
+            SetPositionDequantization(renderProgram, mesh.submeshes[i]);
 
             u32 submeshMaterialIdx      = model.materialIndices[i];
             Material& submeshMaterial   = app->materials[submeshMaterialIdx];
@@ -996,9 +1379,123 @@ void Engine::Renderer::GeometryPass(App* app)
                 glUniform1f(glGetUniformLocation(renderProgram.handle, "uBumpiness"), app->bumpiness);
             }
 
-            Submesh& submesh = mesh.submeshes[i];
-            glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
+            Submesh& submesh        = mesh.submeshes[i];
+            if (app->cullMeshlets && Meshlets::GetDrawRange(app, entityIdx, i).culled)
+            {
+                const MeshletDrawRange& range = Meshlets::GetDrawRange(app, entityIdx, i);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, submesh.indexType, (void*)(u64)(range.firstCommand * sizeof(DrawElementsIndirectCommand)), range.commandCount, 0);
+
+                app->drawnTriangles += range.triangleCount;
+                continue;
+            }
+
+            const SubmeshLod& lod   = submesh.lods[glm::min(lodLevel, (u32)submesh.lods.size() - 1)];
+            glDrawElements(GL_TRIANGLES, lod.indexCount, submesh.indexType, (void*)(u64)(submesh.indexOffset + lod.firstIndex * submesh.GetIndexSize()));
+
+            app->drawnTriangles += lod.indexCount / 3;
+        }
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// Picks, per entity, the coarsest LOD whose geometric error projects to less than lodErrorThreshold pixels.
+void Engine::Renderer::SelectLods(App* app)
+{
+    const mat4 viewMatrix       = app->camera.GetViewMatrix();
+    const f32  pixelsPerUnitAt1 = app->camera.GetProjMatrix()[1][1] * 0.5f * (f32)app->displaySize.y;      // Pixels covered by 1 unit at distance 1.
+
+    for (u32 i = 0; i < app->entities.size(); ++i)
+    {
+        Entity& entity  = app->entities[i];
+        Mesh& mesh      = app->meshes[app->models[entity.modelIndex].meshIdx];
+
+        u32 lodCount = 1;
+        for (u32 s = 0; s < mesh.submeshes.size(); ++s)
+        {
+            lodCount = glm::max(lodCount, (u32)mesh.submeshes[s].lods.size());
+        }
+
+        if (!app->enableLods || lodCount == 1)
+        {
+            entity.lodLevel = 0;
+            continue;
+        }
+
+        const f32 worldScale    = glm::max(glm::length(vec3(entity.worldMatrix[0])), glm::max(glm::length(vec3(entity.worldMatrix[1])), glm::length(vec3(entity.worldMatrix[2]))));
+        const vec3 viewCenter   = vec3(viewMatrix * entity.worldMatrix * vec4(mesh.boundsCenter, 1.0f));
+        const f32 distance      = glm::max(glm::length(viewCenter) - mesh.boundsRadius * worldScale, app->camera.GetNearPlane());
+        const f32 pixelsPerUnit = pixelsPerUnitAt1 * worldScale / distance;
+
+        u32 lodLevel = glm::min(entity.lodLevel, lodCount - 1);
+        while (lodLevel > 0 && GetMeshLodError(mesh, lodLevel) * pixelsPerUnit > app->lodErrorThreshold)
+        {
+            --lodLevel;
+        }
+        while (lodLevel + 1 < lodCount && GetMeshLodError(mesh, lodLevel + 1) * pixelsPerUnit < app->lodErrorThreshold * LOD_HYSTERESIS)
+        {
+            ++lodLevel;
+        }
+
+        entity.lodLevel = lodLevel;
+    }
+}
+
+f32 Engine::Renderer::GetMeshLodError(const Mesh& mesh, u32 lodLevel)
+{
+    f32 error = 0.0f;
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        const std::vector<SubmeshLod>& lods = mesh.submeshes[i].lods;
+        error = glm::max(error, lods[glm::min(lodLevel, (u32)lods.size() - 1)].error);
+    }
+
+    return error;
+}
+
+// Far entities of the baked models, one instanced quad draw per impostor. Writes the same G-Buffer targets as the
+// geometry pass, with the depth of the baked views, so the lighting passes do not tell them apart.
+void Engine::Renderer::ImpostorPass(App* app)
+{
+    ImpostorSet& set = app->impostorSet;
+    if (set.instances.empty())
+    {
+        return;
+    }
+
+    Program& impostorProgram = app->programs[app->impostorProgramIdx];
+    glUseProgram(impostorProgram.handle);
+    glEnable(GL_DEPTH_TEST);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, IMPOSTOR_INSTANCE_BINDING, set.instanceBuffer.handle);
+
+    const mat4 viewProjectionMatrix = app->camera.GetProjMatrix() * app->camera.GetViewMatrix();
+    glUniformMatrix4fv(glGetUniformLocation(impostorProgram.handle, "uViewProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjectionMatrix));
+    glUniform1i(glGetUniformLocation(impostorProgram.handle, "uFrames"), IMPOSTOR_FRAMES);
+    glUniform1i(glGetUniformLocation(impostorProgram.handle, "uAlbedoAtlas"), 0);
+    glUniform1i(glGetUniformLocation(impostorProgram.handle, "uNormalDepthAtlas"), 1);
+
+    glBindVertexArray(set.vao);
+    for (u32 i = 0; i < set.impostors.size(); ++i)
+    {
+        const Impostor& impostor = set.impostors[i];
+        if (impostor.instanceCount == 0)
+        {
+            continue;
         }
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, impostor.albedoTexHandle);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, impostor.normalDepthTexHandle);
+
+        glUniform1ui(glGetUniformLocation(impostorProgram.handle, "uFirstInstance"), impostor.firstInstance);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, impostor.instanceCount);
+
+        app->drawnTriangles += impostor.instanceCount * 2;
     }
 
     glBindVertexArray(0);
@@ -1014,6 +1511,7 @@ void Engine::Renderer::LightingPass(App* app)
     glDepthMask(GL_FALSE);
     glEnable(GL_BLEND);
     glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);                                                            // Accumulate the contribution of every light.
     glClear(GL_COLOR_BUFFER_BIT);
     
     Program& deferredLightingProgram = app->programs[app->deferredLightingProgramIdx];
@@ -1021,40 +1519,179 @@ void Engine::Renderer::LightingPass(App* app)
 
     glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
 
+    BindGBufferTextures(app, deferredLightingProgram);
+
     for (u32 i = 0; i < app->activeLights; ++i)
     {
-        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(2), app->cbuffer.handle, app->lights[i].localParamsOffset, app->lights[i].localParamsSize);
-
         Light& light = app->lights[i];
+        if (!light.isVisible)
+        {
+            continue;
+        }
 
-        glUniform1i(glGetUniformLocation(deferredLightingProgram.handle, "oAlbedo"),    0);
-        glUniform1i(glGetUniformLocation(deferredLightingProgram.handle, "oNormals"),   1);
-        glUniform1i(glGetUniformLocation(deferredLightingProgram.handle, "oDepth"),     2);
-        glUniform1i(glGetUniformLocation(deferredLightingProgram.handle, "oPosition"),  3);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, app->GAlbedoTex);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, app->GNormalTex);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, app->GDepthTex);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, app->GPositionTex);
+        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(2), app->cbuffer.handle, light.localParamsOffset, light.localParamsSize);
 
         switch (light.type)
         {
-        case LIGHT_TYPE::LT_DIRECTIONAL: { RenderLightingQuad(app); }   break;
-        case LIGHT_TYPE::LT_POINT:       { RenderLightingSphere(app); } break;
+        case LIGHT_TYPE::LT_DIRECTIONAL: 
+        { 
+            RenderLightingQuad(app); 
+        }
+        break;
+
+        case LIGHT_TYPE::LT_POINT:
+        {
+            glEnable(GL_SCISSOR_TEST);                                                      // Only the pixels the light can reach.
+            glScissor(light.scissorRect.x, light.scissorRect.y, light.scissorRect.z, light.scissorRect.w);
+
+            const f32  volumeRadius = light.radius * LIGHT_VOLUME_SCALE + app->camera.GetNearPlane();
+            const bool cameraInside = (glm::length(app->camera.GetPosition() - light.position) < volumeRadius);
+
+            if (app->lightVolumeMode == LIGHT_VOLUME_MODE::STENCIL && !cameraInside)        // Near-plane clipping breaks the front-face count, so
+            {                                                                               // cameras inside the volume use the plain back-face draw.
+                RenderStencilLightVolume(app);
+                glUseProgram(deferredLightingProgram.handle);
+            }
+            else
+            {
+                glEnable(GL_CULL_FACE);                                                     // Back faces only: every covered pixel is shaded once,
+                glCullFace(GL_FRONT);                                                       // even when the camera is inside the volume.
+
+                RenderLightingSphere(app, deferredLightingProgram);
+
+                glDisable(GL_CULL_FACE);
+                glCullFace(GL_BACK);
+            }
+
+            glDisable(GL_SCISSOR_TEST);
+        }
+        break;
         }
     }
 
     glBindVertexArray(0);
     glUseProgram(0);
 
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+// Constant draw count: one full-screen pass for every directional light and one instanced draw for every point light.
+void Engine::Renderer::InstancedLightingPass(App* app)
+{
+    GLuint drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
+    glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    Program& instancedLightingProgram = app->programs[app->instancedLightingProgramIdx];
+    glUseProgram(instancedLightingProgram.handle);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+    LightClusters::BindBuffers(app);
+
+    BindGBufferTextures(app, instancedLightingProgram);
+
+    const mat4  viewProjMatrix      = app->camera.GetProjMatrix() * app->camera.GetViewMatrix();
+    const GLint directionalPassLoc  = glGetUniformLocation(instancedLightingProgram.handle, "uDirectionalPass");
+    glUniformMatrix4fv(glGetUniformLocation(instancedLightingProgram.handle, "uViewProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjMatrix));
+
+    // DIRECTIONAL LIGHTS
+    glUniform1i(directionalPassLoc, 1);
+    RenderLightingQuad(app);
+
+    // POINT LIGHTS
+    const ClusterGrid& grid = app->clusterGrid;
+    const u32 pointLights   = (u32)grid.gpuLights.size() - grid.directionalLightCount;
+    if (pointLights > 0)
+    {
+        Model& model        = app->models[Primitives::GetLightSphereIdx()];
+        Submesh& submesh    = app->meshes[model.meshIdx].submeshes[0];
+
+        glUniform1i(directionalPassLoc, 0);
+        glEnable(GL_CULL_FACE);                                                                 // Back faces only, as in LightingPass().
+        glCullFace(GL_FRONT);
+
+        glBindVertexArray(app->vaoLightInstances);
+        SetPositionDequantization(instancedLightingProgram, submesh);
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, submesh.lods[0].indexCount, submesh.indexType, (void*)(u64)submesh.indexOffset, pointLights, grid.directionalLightCount);
+
+        glDisable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+// Single full-screen pass: every pixel only loops over the lights binned into its cluster.
+void Engine::Renderer::ClusteredLightingPass(App* app)
+{
+    GLuint drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
+    glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    Program& clusteredLightingProgram = app->programs[app->clusteredLightingProgramIdx];
+    glUseProgram(clusteredLightingProgram.handle);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+    LightClusters::BindBuffers(app);
+
+    BindGBufferTextures(app, clusteredLightingProgram);
+
+    RenderLightingQuad(app);
+
+    glUseProgram(0);
+
     glEnable(GL_DEPTH_TEST);
     glDepthMask(GL_TRUE);
 }
 
+// One dispatch for all lights: each 16x16 tile culls the light list against its depth range and
+// shades its pixels once, writing straight into GShadedTex.
+void Engine::Renderer::TiledLightingPass(App* app)
+{
+    Program& tiledLightingProgram = app->programs[app->tiledLightingProgramIdx];
+    glUseProgram(tiledLightingProgram.handle);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+    LightClusters::BindBuffers(app);
+
+    const mat4 projMatrix   = app->camera.GetProjMatrix();
+    const mat4 invViewProj  = glm::inverse(projMatrix * app->camera.GetViewMatrix());
+    glUniformMatrix4fv(glGetUniformLocation(tiledLightingProgram.handle, "uInvViewProjMatrix"), 1, GL_FALSE, glm::value_ptr(invViewProj));
+    glUniform2f(glGetUniformLocation(tiledLightingProgram.handle, "uProjScale"), projMatrix[0][0], projMatrix[1][1]);
+
+    BindGBufferTextures(app, tiledLightingProgram);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, app->depthBufferHandle);
+    glUniform1i(glGetUniformLocation(tiledLightingProgram.handle, "uDepthBuffer"), 4);
+
+    glBindImageTexture(0, app->GShadedTex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    GLuint groupsX = (app->displaySize.x + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+    GLuint groupsY = (app->displaySize.y + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+    glDispatchCompute(groupsX, groupsY, 1);
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);        // FramebufferPass samples GShadedTex next.
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glUseProgram(0);
+}
+
 void Engine::Renderer::FramebufferPass(App* app)                                          // THIS-HERE
 {
     glUseProgram(app->programs[app->framebufferQuadProgramIdx].handle);
@@ -1156,6 +1793,85 @@ void Engine::Gui::GeneralTab(App* app)
     ImGui::Checkbox("Normal Map", &app->useNormalMap);
     ImGui::Checkbox("Bump Map", &app->useBumpMap);
 
+    ImGui::Separator();
+
+    ImGui::TextColored(cyan,    "Lights:");
+    ImGui::TextColored(yellow,  "Active:");     ImGui::SameLine(); ImGui::Text("   %u", app->activeLights);
+    ImGui::TextColored(yellow,  "Visible:");    ImGui::SameLine(); ImGui::Text("  %u", app->visibleLights);
+    ImGui::TextColored(yellow,  "Dropped:");    ImGui::SameLine(); ImGui::Text("  %u (past %u per cluster)", app->clusterGrid.droppedLights, MAX_LIGHTS_PER_CLUSTER);
+    ImGui::Checkbox("Light Volume Culling", &app->cullLightVolumes);
+
+    const char* items3[] = { "LIGHT VOLUMES", "CLUSTERED", "TILED COMPUTE" };
+    static int item_current3 = 0;
+    ImGui::Combo("Lighting Pass", &item_current3, items3, IM_ARRAYSIZE(items3));
+    app->lightingMode = (LIGHTING_MODE)item_current3;
+
+    const char* items4[] = { "SCISSOR", "INSTANCED", "STENCIL" };
+    static int item_current4 = 0;
+    ImGui::Combo("Light Volumes", &item_current4, items4, IM_ARRAYSIZE(items4));
+    app->lightVolumeMode = (LIGHT_VOLUME_MODE)item_current4;
+
+    static int spawnCount = 100;
+    ImGui::InputInt("##SpawnCount", &spawnCount); ImGui::SameLine();
+    if (ImGui::Button("Spawn Point Lights")) { Lights::AddRandomPointLights(app, (u32)glm::max(spawnCount, 0)); }
+
+    ImGui::Separator();
+
+    ImGui::TextColored(cyan,    "Level of Detail:");
+    ImGui::TextColored(yellow,  "Triangles:");  ImGui::SameLine(); ImGui::Text("%u", app->drawnTriangles);
+    ImGui::Checkbox("Mesh LODs", &app->enableLods);
+    ImGui::SliderFloat("Max Error (px)", &app->lodErrorThreshold, 0.1f, 16.0f, "%.1f");
+    ImGui::Checkbox("Meshlet Culling", &app->cullMeshlets);
+    ImGui::TextColored(yellow,  "Meshlets:");   ImGui::SameLine(); ImGui::Text(" %u / %u", app->meshletDraws.visibleMeshlets, app->meshletDraws.totalMeshlets);
+
+    u32 activeProxies = 0;
+    for (u32 i = 0; i < app->hlodClusters.size(); ++i) { activeProxies += (app->hlodClusters[i].proxyActive) ? 1 : 0; }
+    ImGui::Checkbox("HLOD Proxies", &app->enableHlod);
+    ImGui::SliderFloat("HLOD Distance", &app->hlodDistance, 10.0f, 200.0f, "%.0f");
+    ImGui::TextColored(yellow,  "Proxies:");    ImGui::SameLine(); ImGui::Text("  %u / %u", activeProxies, (u32)app->hlodClusters.size());
+    ImGui::Checkbox("Impostors", &app->enableImpostors);
+    ImGui::SliderFloat("Impostor Distance", &app->impostorDistance, 5.0f, 200.0f, "%.0f");
+    ImGui::TextColored(yellow,  "Impostors:");  ImGui::SameLine(); ImGui::Text("%u", (u32)app->impostorSet.instances.size());
+
+    ImGui::Separator();
+
+    ResidencyManager& residency = app->residency;
+    static int ramBudgetMB      = (int)(residency.ramBudget / MB(1));
+    static int vramBudgetMB     = (int)(residency.vramBudget / MB(1));
+    ImGui::TextColored(cyan,    "Mesh Residency:");
+    ImGui::TextColored(yellow,  "RAM:");        ImGui::SameLine(); ImGui::Text("      %.1f / %d MB", (f32)residency.ramUsed / MB(1), ramBudgetMB);
+    ImGui::TextColored(yellow,  "VRAM:");       ImGui::SameLine(); ImGui::Text("     %.1f / %d MB", (f32)residency.vramUsed / MB(1), vramBudgetMB);
+    ImGui::TextColored(yellow,  "Evicted:");    ImGui::SameLine(); ImGui::Text("  %u (%u reloads)", residency.evictions, residency.reloads);
+    if (ImGui::SliderInt("RAM Budget (MB)", &ramBudgetMB, 0, 1024))     { residency.ramBudget = (u64)ramBudgetMB * MB(1); }
+    if (ImGui::SliderInt("VRAM Budget (MB)", &vramBudgetMB, 0, 2048))   { residency.vramBudget = (u64)vramBudgetMB * MB(1); }
+
+    ImGui::Separator();
+
+    TextureStreamer& streamer   = app->textureStreamer;
+    static int textureBudgetMB  = (int)(streamer.budget / MB(1));
+    ImGui::TextColored(cyan,    "Texture Streaming:");
+    ImGui::TextColored(yellow,  "Resident:");   ImGui::SameLine(); ImGui::Text(" %.1f / %d MB (%u textures)", (f32)streamer.residentBytes / MB(1), textureBudgetMB, (u32)streamer.textures.size());
+    ImGui::TextColored(yellow,  "Mips:");       ImGui::SameLine(); ImGui::Text("     %u in, %u out, %u loading", streamer.streamedIn, streamer.streamedOut, (u32)streamer.loads.size());
+    if (ImGui::SliderInt("Texture Budget (MB)", &textureBudgetMB, 1, 1024)) { streamer.budget = (u64)textureBudgetMB * MB(1); }
+    ImGui::SliderFloat("Mip Bias", &streamer.mipBias, -1.0f, 4.0f, "%.1f");
+
+    WorldStreamer& world = app->worldStreamer;
+    if (!world.cells.empty())
+    {
+        ImGui::Separator();
+
+        u32 readingCells = 0;
+        for (const StreamedCell& cell : world.activeCells) { readingCells += (cell.state == CELL_STATE::READING) ? 1 : 0; }
+        ImGui::TextColored(cyan,    "World Streaming:");
+        ImGui::TextColored(yellow,  "Cells:");      ImGui::SameLine(); ImGui::Text("    %u / %u active, %u reading", (u32)world.activeCells.size(), (u32)world.cells.size(), readingCells);
+        ImGui::TextColored(yellow,  "Entities:");   ImGui::SameLine(); ImGui::Text(" %u streamed", WorldStreaming::GetStreamedEntityCount(app));
+        ImGui::TextColored(yellow,  "Total:");      ImGui::SameLine(); ImGui::Text("    %u in, %u out", world.cellsLoaded, world.cellsUnloaded);
+        ImGui::SliderFloat("Load Distance", &world.loadDistance, world.cellSize, 1000.0f, "%.0f");
+        ImGui::SliderFloat("Unload Margin", &world.unloadMargin, 0.0f, 200.0f, "%.0f");
+        static int maxInstances = (int)world.maxInstances;
+        if (ImGui::SliderInt("Entities / Frame", &maxInstances, 1, 8192)) { world.maxInstances = (u32)maxInstances; }
+    }
+
     ImGui::End();
 }
 
@@ -18,11 +18,14 @@ namespace Engine
 
 	GLuint	CreateProgramFromSource		(String programSource, const char* shaderName);
 	u32		LoadProgram					(App* app, const char* filepath, const char* programName);
+	GLuint	CreateComputeProgramFromSource	(String programSource, const char* shaderName);
+	u32		LoadComputeProgram			(App* app, const char* filepath, const char* programName);
 	
 	bool	UniformIsInvalid			(GLuint uniformHandle);
 
 	GLuint	CreateVAO					(Mesh& mesh, Submesh& submesh, const Program& program);
 	GLuint	FindVAO						(Mesh& mesh, u32 submeshIndex, const Program& program);
+	void	SetPositionDequantization	(const Program& program, const Submesh& submesh);				// Sets uPositionScale & uPositionOffset.
 
 	namespace Camera
 	{
@@ -51,7 +54,15 @@ namespace Engine
 
 	namespace Lights
 	{
-		void AddLight(App* app, LIGHT_TYPE type, vec3 color, vec3 direction, vec3 position, mat4 worldMatrix);
+		void AddLight				(App* app, LIGHT_TYPE type, vec3 color, vec3 direction, vec3 position, vec3 attenuation, mat4 worldMatrix);
+		void AddRandomPointLights	(App* app, u32 count);
+		void CullLights				(App* app);
+
+		f32	 ComputeLightRadius		(vec3 color, vec3 attenuation);										// 0 if the light never reaches the cutoff.
+		u32	 GetMaxLights			(const App* app);
+
+		static const vec3 defaultAttenuation	= vec3(1.0f, 0.05f, 0.01f);		// Constant, Linear, Quadratic.
+		static const vec3 smallAttenuation		= vec3(1.0f, 0.7f, 1.8f);		// Used by the randomly spawned point lights.
 	}
 
 	namespace Renderer
@@ -59,7 +70,7 @@ namespace Engine
 		void InitFramebuffer			(App* app);
 		void ClearFramebuffer			(App* app);
 		void FreeFramebuffer			(App* app);
-		void GenerateFramebufferTexture	(GLuint& texHandle, ivec2 size, GLint type);
+		void GenerateFramebufferTexture	(GLuint& texHandle, ivec2 size, GLint internalFormat, GLint type);
 		void CheckFramebufferStatus		();
 		
 		void InitQuad					(App* app, const char* texPath);
@@ -68,21 +79,31 @@ namespace Engine
 		
 		void InitLightingQuad			(App* app);
 		void InitFramebufferQuad		(App* app);
+		void InitLightInstances			(App* app);
 		void RenderLightingQuad			(App* app);
-		void RenderLightingSphere		(App* app);
+		void RenderLightingSphere		(App* app, const Program& program);
+		void RenderStencilLightVolume	(App* app);
+		void BindGBufferTextures		(App* app, const Program& program);
 
 		void RenderQuad					(App* app);
 		void RenderMesh					(App* app);
 		void RenderEntities				(App* app);
 
 		void GeometryPass				(App* app);
+		void ImpostorPass				(App* app);
 		void LightingPass				(App* app);
+		void InstancedLightingPass		(App* app);
+		void ClusteredLightingPass		(App* app);
+		void TiledLightingPass			(App* app);
 		void FramebufferPass			(App* app);
 
 		void BindFramebufferForRender	(App* app);
 		void RefreshFramebuffer			(App* app);
 
 		bool InDeferredMode				(App* app);
+
+		void SelectLods					(App* app);
+		f32	 GetMeshLodError			(const Mesh& mesh, u32 lodLevel);
 	}
 
 	namespace Gui
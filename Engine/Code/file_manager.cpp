@@ -3,12 +3,13 @@
 
 #include "windows_includes.h"
 #include "globals.h"
+#include "pack_file.h"
 
 #include "file_manager.h"
 
 #define GLOBAL_FRAME_ARENA_SIZE MB(16)
-u8* GlobalFrameArenaMemory = nullptr;
-u32 GlobalFrameArenaHead = 0;
+thread_local u8* GlobalFrameArenaMemory = nullptr;                    // The cooker imports models on several threads at once.
+thread_local u32 GlobalFrameArenaHead = 0;
 
 void FileManager::Init()
 {
@@ -18,6 +19,17 @@ void FileManager::Init()
 void FileManager::CleanUp()
 {
     free(GlobalFrameArenaMemory);
+    GlobalFrameArenaMemory = nullptr;
+}
+
+bool FileManager::MountPack(const char* filepath)
+{
+    return PackFile::Mount(filepath);
+}
+
+void FileManager::UnmountPack()
+{
+    PackFile::Unmount();
 }
 
 void FileManager::ResetFrameAllocator()
@@ -66,7 +78,9 @@ String FileManager::ReadTextFile(const char* filepath)
 {
     String fileText = {};
 
-    FILE* file = fopen(filepath, "rb");
+    const PackEntry* entry  = PackFile::Find(filepath);
+    FILE* file              = (FILE_MANAGER_LOOSE_FILES_FIRST || entry == nullptr) ? fopen(filepath, "rb") : nullptr;
+    MappedFile packed       = {};
 
     if (file)
     {
@@ -80,6 +94,14 @@ String FileManager::ReadTextFile(const char* filepath)
 
         fclose(file);
     }
+    else if (entry != nullptr && PackFile::Read(*entry, packed))
+    {
+        fileText.len = (u32)packed.size;
+        fileText.str = (char*)Utils::PushBytes(packed.data, fileText.len);
+        Utils::PushChar(0);
+
+        UnmapFile(packed);
+    }
     else
     {
         ELOG("fopen() failed reading file %s", filepath);
@@ -90,7 +112,251 @@ String FileManager::ReadTextFile(const char* filepath)
 
 // It retrieves a timestamp indicating the last time the file was modified. 
 // Can be useful in order to check for file modifications to implement hot reloads.
+// Packed files all have the timestamp of the pack.
 u64 FileManager::GetFileLastWriteTimestamp(const char* filepath)
+{
+    const bool isPackedFirst = !FILE_MANAGER_LOOSE_FILES_FIRST && PackFile::Find(filepath) != nullptr;
+    const u64 looseTimestamp = (isPackedFirst) ? 0 : Utils::GetLooseFileTimestamp(filepath);
+    if (looseTimestamp != 0)
+    {
+        return looseTimestamp;
+    }
+
+    return (isPackedFirst || PackFile::Find(filepath) != nullptr) ? PackFile::GetTimestamp() : 0;
+}
+
+// Maps the file instead of reading it, so large binary assets go from the page cache to the GPU without a copy.
+// Packed files are a view of the pack mapping, or a copy if they are compressed.
+bool FileManager::MapFile(const char* filepath, MappedFile& mappedFile)
+{
+    if (FILE_MANAGER_LOOSE_FILES_FIRST && Utils::MapLooseFile(filepath, mappedFile))
+    {
+        return true;
+    }
+
+    const PackEntry* entry = PackFile::Find(filepath);
+    if (entry != nullptr && PackFile::Read(*entry, mappedFile))
+    {
+        return true;
+    }
+
+    return !FILE_MANAGER_LOOSE_FILES_FIRST && Utils::MapLooseFile(filepath, mappedFile);
+}
+
+void FileManager::UnmapFile(MappedFile& mappedFile)
+{
+    if (mappedFile.data == nullptr)
+    {
+        return;
+    }
+
+    if (mappedFile.isPackView || mappedFile.ownedData != nullptr)
+    {
+        free(mappedFile.ownedData);
+        mappedFile = {};
+        return;
+    }
+
+    #ifdef _WIN32
+        UnmapViewOfFile(mappedFile.data);
+        CloseHandle((HANDLE)mappedFile.mappingHandle);
+        CloseHandle((HANDLE)mappedFile.fileHandle);
+    #else
+        munmap((void*)mappedFile.data, (size_t)mappedFile.size);
+    #endif
+
+    mappedFile = {};
+}
+
+bool FileManager::WriteBinaryFile(const char* filepath, const void* data, u64 size)
+{
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+    {
+        ELOG("fopen() failed writing file %s", filepath);
+        return false;
+    }
+
+    bool written = (fwrite(data, 1, (size_t)size, file) == (size_t)size);
+    fclose(file);
+
+    return written;
+}
+
+void FileManager::ListFiles(const char* directory, std::vector<std::string>& filepaths)
+{
+    #ifdef _WIN32
+        WIN32_FIND_DATAA findData;
+        HANDLE find = FindFirstFileA((std::string(directory) + "/*").c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        do
+        {
+            const std::string name = findData.cFileName;
+            if (name == "." || name == "..")
+            {
+                continue;
+            }
+
+            const std::string path = std::string(directory) + "/" + name;
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                ListFiles(path.c_str(), filepaths);
+            }
+            else
+            {
+                filepaths.push_back(path);
+            }
+        } while (FindNextFileA(find, &findData));
+
+        FindClose(find);
+    #else
+        DIR* dir = opendir(directory);
+        if (dir == NULL)
+        {
+            return;
+        }
+
+        while (struct dirent* entry = readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (name == "." || name == "..")
+            {
+                continue;
+            }
+
+            const std::string path = std::string(directory) + "/" + name;
+            struct stat attrib;
+            if (stat(path.c_str(), &attrib) != 0)
+            {
+                continue;
+            }
+
+            if (S_ISDIR(attrib.st_mode))
+            {
+                ListFiles(path.c_str(), filepaths);
+            }
+            else
+            {
+                filepaths.push_back(path);
+            }
+        }
+
+        closedir(dir);
+    #endif
+}
+
+u64 FileManager::HashBytes(const void* data, u64 size, u64 seed)
+{
+    const u8* bytes = (const u8*)data;
+    u64 hash        = seed;
+    for (u64 i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+bool FileManager::HashFile(const char* filepath, u64& hash)
+{
+    MappedFile file = {};
+    if (!MapFile(filepath, file))
+    {
+        return false;
+    }
+
+    hash = HashBytes(file.data, file.size);
+    UnmapFile(file);
+
+    return true;
+}
+
+// hash and timestamp are the ones the source had when it was cooked. The source is only hashed again when its
+// timestamp moved, so an up to date cooked load does not read the whole asset. Sources are not packed: without the
+// file, the cooked one must match the source record of the mounted pack (pack_file.h), or is trusted if it has none.
+bool FileManager::IsSourceUnchanged(const char* filepath, u64 hash, u64 timestamp)
+{
+    const u64 currentTimestamp = Utils::GetLooseFileTimestamp(filepath);
+    if (currentTimestamp == 0)
+    {
+        const PackEntry* record = PackFile::FindSource(filepath);
+        return record == nullptr || record->sourceHash == hash;
+    }
+
+    if (currentTimestamp == timestamp)
+    {
+        return true;
+    }
+
+    u64 currentHash = 0;
+    return HashFile(filepath, currentHash) && currentHash == hash;
+}
+
+// UTILS -------------------------------------------------------------------
+bool FileManager::Utils::MapLooseFile(const char* filepath, MappedFile& mappedFile)
+{
+    mappedFile = {};
+
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        const void* view = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (view == NULL)
+        {
+            if (mapping != NULL) { CloseHandle(mapping); }
+            CloseHandle(file);
+            return false;
+        }
+
+        mappedFile.data             = (const u8*)view;
+        mappedFile.size             = (u64)fileSize.QuadPart;
+        mappedFile.fileHandle       = file;
+        mappedFile.mappingHandle    = mapping;
+    #else
+        int file = open(filepath, O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat attrib;
+        if (fstat(file, &attrib) != 0 || attrib.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+
+        void* view = mmap(NULL, (size_t)attrib.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);                                                                    // The mapping keeps its own reference.
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        mappedFile.data = (const u8*)view;
+        mappedFile.size = (u64)attrib.st_size;
+    #endif
+
+    return true;
+}
+
+u64 FileManager::Utils::GetLooseFileTimestamp(const char* filepath)
 {
     #ifdef _WIN32
         union Filetime2u64
@@ -114,7 +380,6 @@ u64 FileManager::GetFileLastWriteTimestamp(const char* filepath)
     return 0;
 }
 
-// UTILS -------------------------------------------------------------------
 u32 FileManager::Utils::Strlen(const char* string)
 {
     u32 len = 0;
@@ -124,6 +389,8 @@ u32 FileManager::Utils::Strlen(const char* string)
 
 void* FileManager::Utils::PushSize(u32 byteCount)
 {
+    if (GlobalFrameArenaMemory == nullptr) { Init(); }                   // First string made on this thread.
+
     ASSERT(GlobalFrameArenaHead + byteCount <= GLOBAL_FRAME_ARENA_SIZE,
         "Trying to allocate more temp memory than available");
 
@@ -134,6 +401,8 @@ void* FileManager::Utils::PushSize(u32 byteCount)
 
 void* FileManager::Utils::PushBytes(const void* bytes, u32 byteCount)
 {
+    if (GlobalFrameArenaMemory == nullptr) { Init(); }
+
     ASSERT(GlobalFrameArenaHead + byteCount <= GLOBAL_FRAME_ARENA_SIZE,
         "Trying to allocate more temp memory than available");
 
@@ -147,6 +416,8 @@ void* FileManager::Utils::PushBytes(const void* bytes, u32 byteCount)
 
 u8* FileManager::Utils::PushChar(u8 c)
 {
+    if (GlobalFrameArenaMemory == nullptr) { Init(); }
+
     ASSERT(GlobalFrameArenaHead + 1 <= GLOBAL_FRAME_ARENA_SIZE,
         "Trying to allocate more temp memory than available");
     u8* ptr = GlobalFrameArenaMemory + GlobalFrameArenaHead;
@@ -1,14 +1,36 @@
 #ifndef __FILE_MANAGER_H__
 #define __FILE_MANAGER_H__
 
+#include <string>
+#include <vector>
+
 #include "base_types.h"
 
+#ifndef NDEBUG
+#define FILE_MANAGER_LOOSE_FILES_FIRST 1                            // Loose files override the packed ones (pack_file.h) while developing...
+#else
+#define FILE_MANAGER_LOOSE_FILES_FIRST 0                            // ...the pack is looked up first in release, loose files only fill in.
+#endif
+
+struct MappedFile
+{
+    const u8*   data;                                               // Read-only view of the whole file.
+    u64         size;
+    void*       fileHandle;
+    void*       mappingHandle;
+    bool        isPackView;                                         // Points into the mounted pack, nothing to release.
+    u8*         ownedData;                                          // Decompressed pack entry.
+};
+
 namespace FileManager
 {
     void    Init();
     void    CleanUp();
     
-    void    ResetFrameAllocator();
+    bool    MountPack(const char* filepath);                        // See pack_file.h. Every read below falls back to it.
+    void    UnmountPack();
+
+    void    ResetFrameAllocator();                                  // Per thread: every thread that makes strings gets its own arena.
 
     String  MakeString(const char* cstr);
     String  MakePath(String dir, String filename);
@@ -17,8 +39,20 @@ namespace FileManager
     String  ReadTextFile(const char* filepath);                     // Reads a whole file and returns a string with its contents.
     u64     GetFileLastWriteTimestamp(const char* filepath);        // It retrieves a timestamp indicating the last time the file was modified.
 
+    bool    MapFile(const char* filepath, MappedFile& mappedFile);     // Memory maps a whole file for reading.
+    void    UnmapFile(MappedFile& mappedFile);
+    bool    WriteBinaryFile(const char* filepath, const void* data, u64 size);
+    void    ListFiles(const char* directory, std::vector<std::string>& filepaths);    // Recursive, appends "<directory>/<subdirs>/<file>".
+
+    u64     HashBytes(const void* data, u64 size, u64 seed = 14695981039346656037ull);  // 64-bit FNV-1a.
+    bool    HashFile(const char* filepath, u64& hash);              // HashBytes() of the whole file contents.
+    bool    IsSourceUnchanged(const char* filepath, u64 hash, u64 timestamp);     // Checks a cooked file against its source.
+
     namespace Utils
     {
+        bool    MapLooseFile(const char* filepath, MappedFile& mappedFile);
+        u64     GetLooseFileTimestamp(const char* filepath);
+
         u32     Strlen(const char* string);
         void*   PushSize(u32 byteCount);
         void*   PushBytes(const void* bytes, u32 byteCount);
@@ -22,6 +22,8 @@ void LogString(const char* str);
 #define MB(count) (1024*KB(count))
 #define GB(count) (1024*MB(count))
 
+#define REQUIRE_COOKED_ASSETS 0         // 1: the engine only loads what the cooker (cooker.h) produced, no Assimp / stb fallback.
+
 #define PI  3.14159265359f
 #define TAU 6.28318530718f
 
@@ -0,0 +1,309 @@
+#include <float.h>
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "globals.h"
+#include "app.h"
+#include "importer.h"
+#include "mesh_simplifier.h"
+#include "meshlets.h"
+#include "vertex_format.h"
+
+#include "hlod.h"
+
+#define HLOD_HYSTERESIS		0.9f																	// Active proxies are kept until the camera is clearly closer.
+#define PROXY_STRIDE		12																		// Position, normal, UV, tangent + bitangent sign.
+
+void Hlod::BuildClusters(App* app)
+{
+	app->hlodClusters.clear();
+
+	std::map<std::pair<i32, i32>, std::vector<u32>> cells;
+	for (u32 i = 0; i < app->entities.size(); ++i)
+	{
+		const Entity& entity	= app->entities[i];
+		const Mesh& mesh		= app->meshes[app->models[entity.modelIndex].meshIdx];
+
+		const f32  worldScale	= glm::max(glm::length(vec3(entity.worldMatrix[0])), glm::max(glm::length(vec3(entity.worldMatrix[1])), glm::length(vec3(entity.worldMatrix[2]))));
+		const vec3 worldCenter	= vec3(entity.worldMatrix * vec4(mesh.boundsCenter, 1.0f));
+		if (mesh.boundsRadius * worldScale > HLOD_CELL_SIZE * 0.5f)									// Large entities (floors, terrain) stay on their own.
+		{
+			continue;
+		}
+
+		cells[{ (i32)floorf(worldCenter.x / HLOD_CELL_SIZE), (i32)floorf(worldCenter.z / HLOD_CELL_SIZE) }].push_back(i);
+	}
+
+	for (std::pair<const std::pair<i32, i32>, std::vector<u32>>& cell : cells)
+	{
+		if (cell.second.size() < HLOD_MIN_ENTITIES)
+		{
+			continue;
+		}
+
+		HlodCluster cluster		= {};
+		cluster.entityIndices	= cell.second;
+		cluster.proxyEntityIdx	= Utils::CreateProxy(app, cluster);
+		cluster.proxyActive		= false;
+
+		app->hlodClusters.push_back(cluster);
+	}
+}
+
+void Hlod::SelectProxies(App* app)
+{
+	const vec3 cameraPos		= app->camera.GetPosition();
+	const f32  pixelsPerUnitAt1	= app->camera.GetProjMatrix()[1][1] * 0.5f * (f32)app->displaySize.y;
+
+	for (u32 i = 0; i < app->hlodClusters.size(); ++i)
+	{
+		HlodCluster& cluster = app->hlodClusters[i];
+
+		const f32 distance		= glm::length(cameraPos - cluster.center) - cluster.radius;
+		const f32 errorDistance	= cluster.error * pixelsPerUnitAt1 / glm::max(app->lodErrorThreshold, 0.01f);	// Where the proxy error drops under the LOD threshold.
+		const f32 switchDistance	= glm::max(app->hlodDistance, errorDistance) * (cluster.proxyActive ? HLOD_HYSTERESIS : 1.0f);
+
+		cluster.proxyActive = (app->enableHlod && distance > switchDistance);
+
+		for (u32 e = 0; e < cluster.entityIndices.size(); ++e)
+		{
+			app->entities[cluster.entityIndices[e]].isHidden = cluster.proxyActive;
+		}
+
+		app->entities[cluster.proxyEntityIdx].isHidden = !cluster.proxyActive;
+	}
+}
+
+// UTILS -------------------------------------------------------------------
+// Every source albedo map is box-filtered into its own tile. Tiles are scaled into their inner area and their border
+// texels are extended into the padding, so bilinear filtering and mips do not bleed between neighbours.
+u32 Hlod::Utils::BakeAtlas(App* app, const std::vector<u32>& albedoTexIndices, u32& tilesPerSide)
+{
+	tilesPerSide		= (u32)ceilf(sqrtf((f32)albedoTexIndices.size()));
+	const u32 atlasSize	= tilesPerSide * HLOD_ATLAS_TILE;
+	const i32 inner		= HLOD_ATLAS_TILE - 2 * HLOD_ATLAS_PADDING;
+
+	std::vector<u8> pixels(atlasSize * atlasSize * 4, 255);
+	for (u32 t = 0; t < albedoTexIndices.size(); ++t)
+	{
+		Image image = Importer::Utils::LoadImage(StringTable::GetString(app->textures[albedoTexIndices[t]].filepath));
+		if (!image.pixels)
+		{
+			continue;																				// Stays white.
+		}
+
+		const u8* source	= (const u8*)image.pixels;
+		const u32 tileX		= (t % tilesPerSide) * HLOD_ATLAS_TILE;
+		const u32 tileY		= (t / tilesPerSide) * HLOD_ATLAS_TILE;
+
+		for (i32 y = 0; y < HLOD_ATLAS_TILE; ++y)
+		{
+			const i32 innerY	= glm::clamp(y - HLOD_ATLAS_PADDING, 0, inner - 1);
+			const i32 y0		= innerY * image.size.y / inner;
+			const i32 y1		= glm::max((innerY + 1) * image.size.y / inner, y0 + 1);
+
+			for (i32 x = 0; x < HLOD_ATLAS_TILE; ++x)
+			{
+				const i32 innerX	= glm::clamp(x - HLOD_ATLAS_PADDING, 0, inner - 1);
+				const i32 x0		= innerX * image.size.x / inner;
+				const i32 x1		= glm::max((innerX + 1) * image.size.x / inner, x0 + 1);
+
+				u32 sum[4] = { 0, 0, 0, 0 };
+				for (i32 sy = y0; sy < y1; ++sy)
+				{
+					for (i32 sx = x0; sx < x1; ++sx)
+					{
+						const u8* texel = &source[sy * image.stride + sx * image.nchannels];
+						for (i32 c = 0; c < 4; ++c)
+						{
+							sum[c] += (c < image.nchannels) ? texel[c] : 255;
+						}
+					}
+				}
+
+				const u32 count	= (u32)((x1 - x0) * (y1 - y0));
+				u8* dest		= &pixels[((tileY + y) * atlasSize + tileX + x) * 4];
+				for (u32 c = 0; c < 4; ++c)
+				{
+					dest[c] = (u8)(sum[c] / count);
+				}
+			}
+		}
+
+		Importer::Utils::FreeImage(image);
+	}
+
+	Image atlas		= {};
+	atlas.pixels	= pixels.data();
+	atlas.size		= ivec2(atlasSize, atlasSize);
+	atlas.nchannels	= 4;
+	atlas.stride	= atlasSize * 4;
+
+	Texture texture		= {};
+	texture.handle		= Importer::Utils::CreateTexture2DFromImage(atlas);
+	texture.filepath	= StringTable::Intern(("<hlod_atlas_" + std::to_string(app->hlodClusters.size()) + ">").c_str());	// Not in textureIdMap.
+
+	app->textures.push_back(texture);
+	return (u32)app->textures.size() - 1u;
+}
+
+// Appends the LOD0 of every submesh of the entity, in world space and with its UVs moved into its atlas tile.
+void Hlod::Utils::MergeEntity(App* app, const Entity& entity, const std::vector<u32>& albedoTexIndices, u32 tilesPerSide, std::vector<f32>& vertices, std::vector<u32>& indices)
+{
+	const Model& model			= app->models[entity.modelIndex];
+	const Mesh& mesh			= app->meshes[model.meshIdx];
+	const mat3 normalMatrix		= glm::transpose(glm::inverse(mat3(entity.worldMatrix)));
+	const f32  atlasSize		= (f32)(tilesPerSide * HLOD_ATLAS_TILE);
+	const f32  inner			= (f32)(HLOD_ATLAS_TILE - 2 * HLOD_ATLAS_PADDING);
+
+	for (u32 s = 0; s < mesh.submeshes.size(); ++s)
+	{
+		const Submesh& submesh	= mesh.submeshes[s];
+		const u32 stride		= submesh.VBL.stride / sizeof(float);
+		const u32 vertexCount	= (u32)submesh.vertices.size() / stride;
+		const u32 baseVertex	= (u32)vertices.size() / PROXY_STRIDE;
+
+		u32 albedoTexIdx = app->materials[model.materialIndices[s]].albedoTexIdx;
+		albedoTexIdx	 = (albedoTexIdx < app->textures.size()) ? albedoTexIdx : app->whiteTexIdx;
+		const u32 tile	 = (u32)(std::find(albedoTexIndices.begin(), albedoTexIndices.end(), albedoTexIdx) - albedoTexIndices.begin());
+		const vec2 tileOrigin = vec2((f32)((tile % tilesPerSide) * HLOD_ATLAS_TILE + HLOD_ATLAS_PADDING), (f32)((tile / tilesPerSide) * HLOD_ATLAS_TILE + HLOD_ATLAS_PADDING));
+
+		i32 attributeOffsets[5] = { -1, -1, -1, -1, -1 };											// In floats, by location.
+		for (u32 a = 0; a < submesh.VBL.attributes.size(); ++a)
+		{
+			if (submesh.VBL.attributes[a].location < 5)
+			{
+				attributeOffsets[submesh.VBL.attributes[a].location] = submesh.VBL.attributes[a].offset / sizeof(float);
+			}
+		}
+
+		const i32 tangentAttribute	= VertexFormat::Utils::FindAttribute(submesh.VBL, VERTEX_LOCATION_TANGENT);
+		const bool hasTangentSign	= tangentAttribute >= 0 && submesh.VBL.attributes[tangentAttribute].componentCount == 4;
+		const f32 mirrorSign		= (glm::determinant(mat3(entity.worldMatrix)) < 0.0f) ? -1.0f : 1.0f;	// Mirroring flips the handedness.
+
+		for (u32 v = 0; v < vertexCount; ++v)
+		{
+			const f32* source = &submesh.vertices[v * stride];
+			auto ReadVec3 = [&](u32 location) { return (attributeOffsets[location] < 0) ? vec3(0.0f) : vec3(source[attributeOffsets[location]], source[attributeOffsets[location] + 1], source[attributeOffsets[location] + 2]); };
+
+			vec3 position	= vec3(entity.worldMatrix * vec4(ReadVec3(0), 1.0f));
+			vec3 normal		= normalMatrix * ReadVec3(1);
+			vec3 tangent	= mat3(entity.worldMatrix) * ReadVec3(3);
+
+			f32 sign = 1.0f;
+			if (hasTangentSign)
+			{
+				sign = source[attributeOffsets[3] + 3];
+			}
+			else if (attributeOffsets[4] >= 0)
+			{
+				sign = VertexFormat::Utils::GetBitangentSign(ReadVec3(1), ReadVec3(3), ReadVec3(4));
+			}
+			sign *= mirrorSign;
+
+			normal		= (glm::length(normal) > 0.0f)		? glm::normalize(normal)	: normal;
+			tangent		= (glm::length(tangent) > 0.0f)		? glm::normalize(tangent)	: tangent;
+
+			vec2 uv = (attributeOffsets[2] < 0) ? vec2(0.5f) : vec2(source[attributeOffsets[2]], source[attributeOffsets[2] + 1]);
+			uv.x	= (uv.x < 0.0f || uv.x > 1.0f) ? glm::fract(uv.x) : uv.x;						// Tiled UVs are wrapped per vertex, which is
+			uv.y	= (uv.y < 0.0f || uv.y > 1.0f) ? glm::fract(uv.y) : uv.y;						// good enough at proxy distances.
+			uv		= (tileOrigin + uv * inner) / atlasSize;
+
+			const f32 proxyVertex[PROXY_STRIDE] = { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y,
+													tangent.x, tangent.y, tangent.z, sign };
+			vertices.insert(vertices.end(), proxyVertex, proxyVertex + PROXY_STRIDE);
+		}
+
+		const SubmeshLod& lod = submesh.lods[0];
+		for (u32 i = 0; i < lod.indexCount; ++i)
+		{
+			indices.push_back(baseVertex + submesh.indices[lod.firstIndex + i]);
+		}
+	}
+}
+
+u32 Hlod::Utils::CreateProxy(App* app, HlodCluster& cluster)
+{
+	// ATLAS
+	std::vector<u32> albedoTexIndices;
+	for (u32 e = 0; e < cluster.entityIndices.size(); ++e)
+	{
+		const Model& model = app->models[app->entities[cluster.entityIndices[e]].modelIndex];
+		for (u32 s = 0; s < model.materialIndices.size(); ++s)
+		{
+			u32 albedoTexIdx = app->materials[model.materialIndices[s]].albedoTexIdx;
+			albedoTexIdx	 = (albedoTexIdx < app->textures.size()) ? albedoTexIdx : app->whiteTexIdx;
+			if (std::find(albedoTexIndices.begin(), albedoTexIndices.end(), albedoTexIdx) == albedoTexIndices.end())
+			{
+				albedoTexIndices.push_back(albedoTexIdx);
+			}
+		}
+	}
+
+	u32 tilesPerSide	= 1;
+	u32 atlasTexIdx		= BakeAtlas(app, albedoTexIndices, tilesPerSide);
+
+	// GEOMETRY
+	std::vector<f32> vertices;
+	std::vector<u32> indices;
+	for (u32 e = 0; e < cluster.entityIndices.size(); ++e)
+	{
+		MergeEntity(app, app->entities[cluster.entityIndices[e]], albedoTexIndices, tilesPerSide, vertices, indices);
+	}
+
+	const u32 vertexCount		= (u32)vertices.size() / PROXY_STRIDE;
+	const u32 targetIndexCount	= ((u32)(indices.size() * HLOD_TRIANGLE_RATIO) / 3) * 3;
+
+	std::vector<u32> simplified;
+	cluster.error = MeshSimplifier::Simplify(vertices.data(), vertexCount, PROXY_STRIDE, indices.data(), (u32)indices.size(), targetIndexCount, FLT_MAX, simplified);
+
+	// COMPACTING (drops the vertices the simplification left unreferenced)
+	std::vector<u32> vertexRemap(vertexCount, UINT32_MAX);
+	Submesh submesh = {};
+	submesh.VBL.AddAttribute(0, 3, sizeof(float));
+	submesh.VBL.AddAttribute(1, 3, sizeof(float));
+	submesh.VBL.AddAttribute(2, 2, sizeof(float));
+	submesh.VBL.AddAttribute(3, 4, sizeof(float));
+	submesh.packedVBL = VertexFormat::GetQuantizedLayout(submesh.VBL);
+
+	for (u32 i = 0; i < simplified.size(); ++i)
+	{
+		u32& remapped = vertexRemap[simplified[i]];
+		if (remapped == UINT32_MAX)
+		{
+			remapped = (u32)submesh.vertices.size() / PROXY_STRIDE;
+			submesh.vertices.insert(submesh.vertices.end(), &vertices[simplified[i] * PROXY_STRIDE], &vertices[simplified[i] * PROXY_STRIDE] + PROXY_STRIDE);
+		}
+
+		submesh.indices.push_back(remapped);
+	}
+
+	Meshlets::BuildMeshlets(submesh);
+	submesh.lods.push_back({ 0, (u32)submesh.indices.size(), 0.0f });
+
+	// MATERIAL, MESH, MODEL & ENTITY
+	Material material		= app->materials[app->defaultMaterialIdx];
+	material.name			= StringTable::Intern(("HLOD_" + std::to_string(app->hlodClusters.size())).c_str());
+	material.albedoTexIdx	= atlasTexIdx;
+	app->materials.push_back(material);
+
+	app->meshes.push_back(Mesh{});
+	Mesh& mesh = app->meshes.back();
+	mesh.submeshes.push_back(submesh);
+	Importer::Utils::ComputeMeshBounds(mesh);
+	Importer::Utils::CreateMeshBuffers(mesh);
+
+	cluster.center = mesh.boundsCenter;
+	cluster.radius = mesh.boundsRadius;
+
+	app->models.push_back(Model{});
+	Model& model	= app->models.back();
+	model.meshIdx	= (u32)app->meshes.size() - 1u;
+	model.materialIndices.push_back((u32)app->materials.size() - 1u);
+
+	Entity proxy		= { material.name, mat4(1.0f), (u32)app->models.size() - 1u, 0, 0, 0, true, false };		// Hidden until selected.
+	app->entities.push_back(proxy);
+
+	return (u32)app->entities.size() - 1u;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __HLOD_H__
+#define __HLOD_H__
+
+// hlod.h:
+// Hierarchical LOD. At load, the entities are grouped by a uniform grid on the XZ plane and the geometry of every
+// group is merged (in world space) into one simplified proxy mesh, textured with an atlas baked from the albedo maps of
+// its sources. The proxy is added as a hidden entity and swapped in for the whole group once it is far enough from the
+// camera, so a distant region costs a single draw.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+struct App;
+
+#define HLOD_CELL_SIZE			20.0f																// World units covered by a cluster.
+#define HLOD_MIN_ENTITIES		2																	// Lone entities are not worth a proxy.
+#define HLOD_TRIANGLE_RATIO		0.125f																// Proxy triangles / source triangles.
+#define HLOD_ATLAS_TILE			128																	// Texels per side of each source's atlas tile.
+#define HLOD_ATLAS_PADDING		2																	// Texels kept clear around each tile.
+
+struct HlodCluster
+{
+	std::vector<u32>	entityIndices;
+	u32					proxyEntityIdx;
+	vec3				center;																		// World-space bounding sphere of the sources.
+	f32					radius;
+	f32					error;																		// Proxy simplification error, in world units.
+	bool				proxyActive;
+};
+
+namespace Hlod
+{
+	void BuildClusters		(App* app);																// Call once the scene entities are created.
+	void SelectProxies		(App* app);																// Shows the proxies of the distant clusters.
+
+	namespace Utils
+	{
+		u32  BakeAtlas		(App* app, const std::vector<u32>& albedoTexIndices, u32& tilesPerSide);
+		void MergeEntity	(App* app, const Entity& entity, const std::vector<u32>& albedoTexIndices, u32 tilesPerSide, std::vector<f32>& vertices, std::vector<u32>& indices);
+		u32  CreateProxy	(App* app, HlodCluster& cluster);
+	}
+}
+
+#endif // !__HLOD_H__
\ No newline at end of file
@@ -1,128 +1,253 @@
 #include "globals.h"
 #include "file_manager.h"
+#include "buffer_manager.h"
+#include "mesh_simplifier.h"
+#include "meshlets.h"
+#include "mesh_optimizer.h"
+#include "vertex_format.h"
+#include "mesh_cache.h"
+#include "texture_cooker.h"
+#include "texture_loader.h"
+#include "obj_loader.h"
 
 #include "importer.h"
 
-u32 Importer::LoadTexture2D(App* app, const char* filepath)
-{
-    for (u32 texIdx = 0; texIdx < app->textures.size(); ++texIdx)
-    {
-        if (app->textures[texIdx].filepath == filepath)
-        {
-            return texIdx;
-        }
-    }
-
-    Image image = Utils::LoadImage(filepath);
+#define MAX_MESH_LODS           5                                                       // Full resolution + 4 simplified levels.
+#define LOD_MIN_TRIANGLES       64                                                      // Submeshes below this are not simplified any further.
+#define LOD_MIN_REDUCTION       0.85f                                                   // Stop when locked seams keep a LOD from shrinking.
 
-    if (image.pixels)
-    {
-        Texture tex = {};
-        tex.handle = Utils::CreateTexture2DFromImage(image);
-        tex.filepath = filepath;
+#define IMPORTER_QUANTIZE_VERTICES 1                                                    // Packed GPU vertices (see vertex_format.h).
 
-        u32 texIdx = app->textures.size();
-        app->textures.push_back(tex);
+#define IMPORTER_POSTPROCESS_FLAGS (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | \
+                                    aiProcess_PreTransformVertices | aiProcess_OptimizeMeshes | aiProcess_SortByPType)
 
-        Utils::FreeImage(image);
-        return texIdx;
+u32 Importer::LoadTexture2D(App* app, const char* filepath, TEXTURE_USAGE usage)
+{
+    const StringId pathId = StringTable::Intern(filepath);
+    const u32 loadedTexIdx = StringTable::MapFind(app->textureIdMap, pathId);             // Returning the already existing texture if the file was previously loaded.
+    if (loadedTexIdx != UINT32_MAX)
+    {
+        return loadedTexIdx;
     }
-    else
+
+    const std::string cookedPath = TextureCooker::Utils::GetCookedPath(filepath);        // A cooked file is enough, it is trusted without its source.
+    if (FileManager::GetFileLastWriteTimestamp(filepath) == 0 && FileManager::GetFileLastWriteTimestamp(cookedPath.c_str()) == 0)
     {
+        ELOG("Could not open file %s", filepath);
         return UINT32_MAX;
     }
+
+    // The slot is handed out right away with a placeholder, the real texture replaces it once a worker has decoded it.
+    Texture tex     = {};
+    tex.handle      = TextureLoader::GetPlaceholder(app, usage);
+    tex.filepath    = pathId;
+
+    u32 texIdx = app->textures.size();
+    app->textures.push_back(tex);
+    StringTable::MapInsert(app->textureIdMap, pathId, texIdx);
+
+    TextureLoader::Request(app, texIdx, usage);
+
+    return texIdx;
 }
 
 u32 Importer::LoadModel(App* app, const char* filename)
 {   
-    for (u32 i = 0; i < app->models.size(); ++i)                                        // Returning an already existing model if the model file was previously loaded.
+    const StringId fileNameId = StringTable::Intern(filename);
+    const u32 loadedModelIdx  = StringTable::MapFind(app->modelIdMap, fileNameId);       // Returning an already existing model if the model file was previously loaded.
+    if (loadedModelIdx != UINT32_MAX)
     {
-        if (app->models[i].fileName == filename)
-        {
-            return i;
-        }
+        return loadedModelIdx;
     }
     
-    const aiScene* scene = aiImportFile(filename,
-        aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals |
-        aiProcess_CalcTangentSpace |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_PreTransformVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_OptimizeMeshes |
-        aiProcess_SortByPType);
+    app->meshes.push_back(Mesh{});
+    u32 meshIdx     = (u32)app->meshes.size() - 1u;
 
-    if (!scene)
+    app->models.push_back(Model{});
+    Model& model    = app->models.back();
+    model.fileName  = fileNameId;
+    model.meshIdx   = meshIdx;
+    u32 modelIdx    = (u32)app->models.size() - 1u;
+
+    const u64 settingsHash = Utils::GetImportSettingsHash();
+    if (MeshCache::Load(app, filename, settingsHash, modelIdx))                         // Skipping Assimp and the processing if the cache is up to date.
     {
-        ELOG("Error loading mesh %s: %s", filename, aiGetErrorString());
+        StringTable::MapInsert(app->modelIdMap, fileNameId, modelIdx);
+        return modelIdx;
+    }
+
+#if REQUIRE_COOKED_ASSETS
+    ELOG("Model %s is not cooked or its cache is stale, run the cooker", filename);
+    const bool imported = false;
+#else
+    const bool imported = Utils::ImportModel(app, filename, modelIdx);
+#endif
+    if (!imported)
+    {
+        app->models.pop_back();
+        app->meshes.pop_back();
         return UINT32_MAX;
     }
 
-    app->meshes.push_back(Mesh{});
-    Mesh& mesh      = app->meshes.back();
-    u32 meshIdx     = (u32)app->meshes.size() - 1u;
+    StringTable::MapInsert(app->modelIdMap, fileNameId, modelIdx);
+
+    return modelIdx;
+}
+
+// Offline counterpart of LoadModel() for the cooker (cooker.h): imports into a headless app and writes the mesh cache.
+// The textures only get their slots, app->textureLoads lists them with their usage.
+bool Importer::CookModel(App* app, const char* filename)
+{
+    ASSERT(app->isHeadless, "CookModel() needs a headless app");
 
+    app->meshes.push_back(Mesh{});
     app->models.push_back(Model{});
     Model& model    = app->models.back();
-    model.fileName  = filename;
-    model.meshIdx   = meshIdx;
-    u32 modelIdx    = (u32)app->models.size() - 1u;
+    model.fileName  = StringTable::Intern(filename);
+    model.meshIdx   = (u32)app->meshes.size() - 1u;
 
-    String directory = FileManager::GetDirectoryPart(FileManager::MakeString(filename));
+    return Utils::ImportModel(app, filename, (u32)app->models.size() - 1u);
+}
+
+// Import (the native OBJ loader, or Assimp for the other formats and the OBJ files it cannot read) and the whole
+// processing of a model, then the mesh cache. Headless apps only lay out the buffers.
+bool Importer::Utils::ImportModel(App* app, const char* filename, u32 modelIdx)
+{
+    Model& model = app->models[modelIdx];
+    Mesh& mesh   = app->meshes[model.meshIdx];
 
-    // Create a list of materials
     u32 baseMeshMaterialIndex = (u32)app->materials.size();
-    for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+    u32 materialCount = 0;
+
+    bool imported = ObjLoader::IsObjFile(filename) && ImportObj(app, filename, modelIdx, materialCount);
+    if (!imported)
     {
-        app->materials.push_back(Material{});
-        Material& material = app->materials.back();
-        Utils::ProcessAssimpMaterial(app, scene->mMaterials[i], material, directory);
+        imported = ImportAssimp(app, filename, modelIdx, materialCount);
+    }
+    if (!imported)
+    {
+        return false;
     }
 
-    Utils::ProcessAssimpNode(scene, scene->mRootNode, &mesh, baseMeshMaterialIndex, model.materialIndices);
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        GenerateSubmeshLods(mesh.submeshes[i]);
+    }
 
-    aiReleaseImport(scene);
+    ComputeMeshBounds(mesh);
 
-    u32 vertexBufferSize = 0;
-    u32 indexBufferSize = 0;
+    if (app->isHeadless)
+    {
+        std::vector<std::vector<u8>> packedVertices;
+        LayoutMeshBuffers(mesh, packedVertices);
+    }
+    else
+    {
+        CreateMeshBuffers(mesh);
+    }
 
-    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    MeshCache::Save(app, filename, GetImportSettingsHash(), modelIdx, baseMeshMaterialIndex, materialCount);
+
+    return true;
+}
+
+// Leaves the app untouched if the file cannot be loaded.
+bool Importer::Utils::ImportObj(App* app, const char* filename, u32 modelIdx, u32& materialCount)
+{
+    ObjModel objModel = {};
+    if (!ObjLoader::Load(filename, objModel))
     {
-        vertexBufferSize += mesh.submeshes[i].vertices.size() * sizeof(float);
-        indexBufferSize  += mesh.submeshes[i].indices.size() * sizeof(u32);
+        ILOG("Falling back to Assimp for %s", filename);
+        return false;
     }
 
-    glGenBuffers(1, &mesh.vertexBufferHandle);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-    glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+    Model& model = app->models[modelIdx];
+    Mesh& mesh   = app->meshes[model.meshIdx];
 
-    glGenBuffers(1, &mesh.indexBufferHandle);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
+    String directory = FileManager::GetDirectoryPart(FileManager::MakeString(filename));
 
-    u32 indicesOffset = 0;
-    u32 verticesOffset = 0;
+    // Same conversion as ProcessAssimpMaterial()
+    u32 baseMeshMaterialIndex = (u32)app->materials.size();
+    for (u32 i = 0; i < objModel.materials.size(); ++i)
+    {
+        const ObjMaterial& objMaterial = objModel.materials[i];
 
-    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+        app->materials.push_back(Material{});
+        Material& material  = app->materials.back();
+        material.name       = StringTable::Intern(objMaterial.name.c_str());
+        material.albedo     = objMaterial.diffuse;
+        material.emissive   = objMaterial.emissive;
+        material.smoothness = objMaterial.shininess / 256.0f;
+
+        auto LoadMap = [&](const std::string& map, TEXTURE_USAGE usage)
+        {
+            String filepath = FileManager::MakePath(directory, FileManager::MakeString(map.c_str()));
+            return LoadTexture2D(app, filepath.str, usage);
+        };
+
+        if (!objMaterial.diffuseMap.empty())    { material.albedoTexIdx     = LoadMap(objMaterial.diffuseMap, TEXTURE_USAGE::COLOR); }
+        if (!objMaterial.emissiveMap.empty())   { material.emissiveTexIdx   = LoadMap(objMaterial.emissiveMap, TEXTURE_USAGE::COLOR); }
+        if (!objMaterial.specularMap.empty())   { material.specularTexIdx   = LoadMap(objMaterial.specularMap, TEXTURE_USAGE::COLOR); }
+        if (!objMaterial.normalMap.empty())     { material.normalTexIdx     = LoadMap(objMaterial.normalMap, TEXTURE_USAGE::NORMAL); }
+        if (!objMaterial.bumpMap.empty())       { material.bumpTexIdx       = LoadMap(objMaterial.bumpMap, TEXTURE_USAGE::HEIGHT); }
+    }
+
+    for (u32 i = 0; i < objModel.submeshes.size(); ++i)
     {
-        const void* verticesData = mesh.submeshes[i].vertices.data();
-        const u32   verticesSize = mesh.submeshes[i].vertices.size() * sizeof(float);
-        glBufferSubData(GL_ARRAY_BUFFER, verticesOffset, verticesSize, verticesData);
-        mesh.submeshes[i].vertexOffset = verticesOffset;
-        verticesOffset += verticesSize;
+        model.materialIndices.push_back(baseMeshMaterialIndex + objModel.submeshMaterials[i]);
+        ProcessSubmesh(&mesh, objModel.submeshes[i], objModel.materials[objModel.submeshMaterials[i]].name.c_str());
+    }
 
-        const void* indicesData = mesh.submeshes[i].indices.data();
-        const u32   indicesSize = mesh.submeshes[i].indices.size() * sizeof(u32);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indicesOffset, indicesSize, indicesData);
-        mesh.submeshes[i].indexOffset = indicesOffset;
-        indicesOffset += indicesSize;
+    materialCount = (u32)objModel.materials.size();
+    return true;
+}
+
+bool Importer::Utils::ImportAssimp(App* app, const char* filename, u32 modelIdx, u32& materialCount)
+{
+    Model& model = app->models[modelIdx];
+    Mesh& mesh   = app->meshes[model.meshIdx];
+
+    const aiScene* scene = aiImportFile(filename, IMPORTER_POSTPROCESS_FLAGS);
+    if (!scene)
+    {
+        ELOG("Error loading mesh %s: %s", filename, aiGetErrorString());
+        return false;
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    String directory = FileManager::GetDirectoryPart(FileManager::MakeString(filename));
 
-    return modelIdx;
+    // Create a list of materials
+    u32 baseMeshMaterialIndex = (u32)app->materials.size();
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+    {
+        app->materials.push_back(Material{});
+        Material& material = app->materials.back();
+        ProcessAssimpMaterial(app, scene->mMaterials[i], material, directory);
+    }
+
+    ProcessAssimpNode(scene, scene->mRootNode, &mesh, baseMeshMaterialIndex, model.materialIndices);
+
+    materialCount = scene->mNumMaterials;
+    aiReleaseImport(scene);
+
+    return true;
+}
+
+// Optimize the buffers (replaces aiProcess_ImproveCacheLocality) and keep the cache order through meshlet building.
+void Importer::Utils::ProcessSubmesh(Mesh* myMesh, Submesh& submesh, const char* name)
+{
+    submesh.packedVBL = (IMPORTER_QUANTIZE_VERTICES) ? VertexFormat::GetQuantizedLayout(submesh.VBL) : VertexBufferLayout();
+
+    const MeshOptimizerStats before = MeshOptimizer::AnalyzeSubmesh(submesh);
+    MeshOptimizer::OptimizeSubmesh(submesh);
+    Meshlets::BuildMeshlets(submesh);
+    MeshOptimizer::OptimizeMeshlets(submesh);
+    const MeshOptimizerStats after = MeshOptimizer::AnalyzeSubmesh(submesh);
+
+    ILOG("Optimized submesh %s: ACMR %.3f -> %.3f | ATVR %.3f -> %.3f | overdraw %.3f -> %.3f | overfetch %.3f -> %.3f", name,
+         before.acmr, after.acmr, before.atvr, after.atvr, before.overdraw, after.overdraw, before.overfetch, after.overfetch);
+
+    myMesh->submeshes.push_back( submesh );
 }
 
 // 2D TEXTURE IMPORTER METHODS ----------------------------------------
@@ -156,10 +281,16 @@ GLuint Importer::Utils::CreateTexture2DFromImage(Image image)
 
 Image Importer::Utils::LoadImage(const char* filename)
 {
-    stbi_set_flip_vertically_on_load(true);
+    stbi_set_flip_vertically_on_load_thread(true);                                      // Images are decoded on the job system workers.
 
     Image img = {};
-    img.pixels = stbi_load(filename, &img.size.x, &img.size.y, &img.nchannels, 0);
+    MappedFile file = {};
+    if (FileManager::MapFile(filename, file))                                           // Loose or packed (pack_file.h).
+    {
+        img.pixels = stbi_load_from_memory(file.data, (int)file.size, &img.size.x, &img.size.y, &img.nchannels, 0);
+        FileManager::UnmapFile(file);
+    }
+
     if (img.pixels)
     {
         img.stride = img.size.x * img.nchannels;
@@ -234,9 +365,11 @@ void Importer::Utils::ProcessAssimpMesh(const aiScene* scene, aiMesh* mesh, Mesh
             // I think that (even if the documentation says the opposite)
             // it returns a left-handed tangent space matrix.
             // SOLUTION: I invert the components of the bitangent here.
-            vertices.push_back(-mesh->mBitangents[i].x);
-            vertices.push_back(-mesh->mBitangents[i].y);
-            vertices.push_back(-mesh->mBitangents[i].z);
+            // Only its handedness is stored, the shaders rebuild it as cross(normal, tangent) * sign.
+            const vec3 normal       = vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            const vec3 tangent      = vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            const vec3 bitangent    = -vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+            vertices.push_back(VertexFormat::Utils::GetBitangentSign(normal, tangent, bitangent));
         }
     }
 
@@ -255,21 +388,15 @@ void Importer::Utils::ProcessAssimpMesh(const aiScene* scene, aiMesh* mesh, Mesh
 
     // create the vertex format
     VertexBufferLayout vertexBufferLayout = {};
-    vertexBufferLayout.attributes.push_back( VertexBufferAttribute{ 0, 3, 0 } );
-    vertexBufferLayout.attributes.push_back( VertexBufferAttribute{ 1, 3, 3*sizeof(float) } );
-    vertexBufferLayout.stride = 6 * sizeof(float);
+    vertexBufferLayout.AddAttribute(0, 3, sizeof(float));
+    vertexBufferLayout.AddAttribute(1, 3, sizeof(float));
     if (hasTexCoords)
     {
-        vertexBufferLayout.attributes.push_back( VertexBufferAttribute{ 2, 2, vertexBufferLayout.stride } );
-        vertexBufferLayout.stride += 2 * sizeof(float);
+        vertexBufferLayout.AddAttribute(2, 2, sizeof(float));
     }
     if (hasTangentSpace)
     {
-        vertexBufferLayout.attributes.push_back( VertexBufferAttribute{ 3, 3, vertexBufferLayout.stride } );
-        vertexBufferLayout.stride += 3 * sizeof(float);
-
-        vertexBufferLayout.attributes.push_back( VertexBufferAttribute{ 4, 3, vertexBufferLayout.stride } );
-        vertexBufferLayout.stride += 3 * sizeof(float);
+        vertexBufferLayout.AddAttribute(3, 4, sizeof(float));                                  // Tangent + bitangent sign.
     }
 
     // add the submesh into the mesh
@@ -277,7 +404,8 @@ void Importer::Utils::ProcessAssimpMesh(const aiScene* scene, aiMesh* mesh, Mesh
     submesh.VBL = vertexBufferLayout;
     submesh.vertices.swap(vertices);
     submesh.indices.swap(indices);
-    myMesh->submeshes.push_back( submesh );
+
+    ProcessSubmesh(myMesh, submesh, mesh->mName.C_Str());
 }
 
 void Importer::Utils::ProcessAssimpMaterial(App* app, aiMaterial *material, Material& myMaterial, String directory)
@@ -293,7 +421,7 @@ void Importer::Utils::ProcessAssimpMaterial(App* app, aiMaterial *material, Mate
     material->Get(AI_MATKEY_COLOR_SPECULAR, specularColor);
     material->Get(AI_MATKEY_SHININESS, shininess);
 
-    myMaterial.name = name.C_Str();
+    myMaterial.name = StringTable::Intern(name.C_Str());
     myMaterial.albedo = vec3(diffuseColor.r, diffuseColor.g, diffuseColor.b);
     myMaterial.emissive = vec3(emissiveColor.r, emissiveColor.g, emissiveColor.b);
     myMaterial.smoothness = shininess / 256.0f;
@@ -325,15 +453,173 @@ void Importer::Utils::ProcessAssimpMaterial(App* app, aiMaterial *material, Mate
         material->GetTexture(aiTextureType_NORMALS, 0, &aiFilename);
         String filename             = FileManager::MakeString(aiFilename.C_Str());
         String filepath             = FileManager::MakePath(directory, filename);
-        myMaterial.normalTexIdx     = LoadTexture2D(app, filepath.str);
+        myMaterial.normalTexIdx     = LoadTexture2D(app, filepath.str, TEXTURE_USAGE::NORMAL);
     }
     if (material->GetTextureCount(aiTextureType_HEIGHT) > 0)
     {
         material->GetTexture(aiTextureType_HEIGHT, 0, &aiFilename);
         String filename             = FileManager::MakeString(aiFilename.C_Str());
         String filepath             = FileManager::MakePath(directory, filename);
-        myMaterial.bumpTexIdx       = LoadTexture2D(app, filepath.str);
+        myMaterial.bumpTexIdx       = LoadTexture2D(app, filepath.str, TEXTURE_USAGE::HEIGHT);
     }
 
     //myMaterial.createNormalFromBump();
+}
+
+// MESH BUFFERS -----------------------------------------------------
+// Decides how every submesh is stored in the mesh's buffers and records its offsets, without any GL call.
+// Quantized submeshes are packed here, the float vertices stay on the CPU. Submeshes with less than 64K vertices get
+// 16-bit indices, every submesh starts 4-byte aligned so the 32-bit ones can follow.
+void Importer::Utils::LayoutMeshBuffers(Mesh& mesh, std::vector<std::vector<u8>>& packedVertices)
+{
+    u32 indicesOffset = 0;
+    u32 verticesOffset = 0;
+
+    packedVertices.assign(mesh.submeshes.size(), std::vector<u8>());
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        Submesh& submesh = mesh.submeshes[i];
+        if (!submesh.packedVBL.attributes.empty())
+        {
+            VertexFormat::ComputeDequantization(submesh);
+            VertexFormat::PackVertices(submesh, packedVertices[i]);
+        }
+
+        const u32 vertexCount   = (u32)(submesh.vertices.size() / (submesh.VBL.stride / sizeof(float)));
+        submesh.indexType       = (vertexCount <= 0x10000) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        submesh.vertexOffset    = verticesOffset;
+        submesh.indexOffset     = indicesOffset;
+        verticesOffset += (submesh.packedVBL.attributes.empty()) ? (u32)(submesh.vertices.size() * sizeof(float)) : (u32)packedVertices[i].size();
+        indicesOffset  += BufferManager::Align((u32)submesh.indices.size() * submesh.GetIndexSize(), sizeof(u32));
+    }
+}
+
+// Uploads the vertices and indices of every submesh to the mesh's buffers, as laid out by LayoutMeshBuffers().
+void Importer::Utils::CreateMeshBuffers(Mesh& mesh)
+{
+    std::vector<std::vector<u8>> packedVertices;
+    LayoutMeshBuffers(mesh, packedVertices);
+
+    u32 vertexBufferSize = 0;
+    u32 indexBufferSize = 0;
+    if (!mesh.submeshes.empty())
+    {
+        const Submesh& last = mesh.submeshes.back();
+        vertexBufferSize    = last.vertexOffset + ((last.packedVBL.attributes.empty()) ? (u32)(last.vertices.size() * sizeof(float)) : (u32)packedVertices.back().size());
+        indexBufferSize     = last.indexOffset + BufferManager::Align((u32)last.indices.size() * last.GetIndexSize(), sizeof(u32));
+    }
+
+    glGenBuffers(1, &mesh.vertexBufferHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
+    glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &mesh.indexBufferHandle);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
+
+    std::vector<u16> shortIndices;
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        const Submesh& submesh   = mesh.submeshes[i];
+        const bool  isPacked     = !submesh.packedVBL.attributes.empty();
+        const void* verticesData = (isPacked) ? (const void*)packedVertices[i].data() : (const void*)submesh.vertices.data();
+        const u32   verticesSize = (isPacked) ? (u32)packedVertices[i].size() : (u32)(submesh.vertices.size() * sizeof(float));
+        glBufferSubData(GL_ARRAY_BUFFER, submesh.vertexOffset, verticesSize, verticesData);
+
+        const void* indicesData = submesh.indices.data();
+        const u32   indicesSize = (u32)submesh.indices.size() * submesh.GetIndexSize();
+        if (submesh.indexType == GL_UNSIGNED_SHORT)
+        {
+            shortIndices.assign(submesh.indices.begin(), submesh.indices.end());
+            indicesData = shortIndices.data();
+        }
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, submesh.indexOffset, indicesSize, indicesData);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// MESH LODS --------------------------------------------------------
+// Each level halves the triangle count of the previous one. All levels are simplified from the source indices,
+// so their error is measured against the original surface.
+void Importer::Utils::GenerateSubmeshLods(Submesh& submesh)
+{
+    const u32 sourceIndexCount  = (u32)submesh.indices.size();
+    const u32 vertexStride      = submesh.VBL.stride / sizeof(float);
+    const u32 vertexCount       = (u32)submesh.vertices.size() / vertexStride;
+
+    submesh.lods.clear();
+    submesh.lods.push_back({ 0, sourceIndexCount, 0.0f });
+
+    std::vector<u32> lodIndices;
+    for (u32 level = 1; level < MAX_MESH_LODS; ++level)
+    {
+        const SubmeshLod& previous = submesh.lods.back();
+        const u32 targetIndexCount = (previous.indexCount / 6) * 3;
+        if (targetIndexCount < LOD_MIN_TRIANGLES * 3)
+        {
+            break;
+        }
+
+        f32 error = MeshSimplifier::Simplify(submesh.vertices.data(), vertexCount, vertexStride, submesh.indices.data(), sourceIndexCount, targetIndexCount, FLT_MAX, lodIndices);
+        if (lodIndices.size() > previous.indexCount * LOD_MIN_REDUCTION)
+        {
+            break;
+        }
+
+        MeshOptimizer::OptimizeVertexCache(lodIndices, vertexCount);                   // The vertices are the source mesh's, only the triangle order can change.
+
+        SubmeshLod lod  = {};
+        lod.firstIndex  = (u32)submesh.indices.size();
+        lod.indexCount  = (u32)lodIndices.size();
+        lod.error       = glm::max(error, previous.error);
+
+        submesh.indices.insert(submesh.indices.end(), lodIndices.begin(), lodIndices.end());
+        submesh.lods.push_back(lod);
+    }
+}
+
+void Importer::Utils::ComputeMeshBounds(Mesh& mesh)
+{
+    vec3 aabbMin = vec3( FLT_MAX);
+    vec3 aabbMax = vec3(-FLT_MAX);
+
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        const Submesh& submesh  = mesh.submeshes[i];
+        const u32 vertexStride  = submesh.VBL.stride / sizeof(float);
+        for (u32 v = 0; v + 2 < submesh.vertices.size(); v += vertexStride)
+        {
+            vec3 position = vec3(submesh.vertices[v], submesh.vertices[v + 1], submesh.vertices[v + 2]);
+            aabbMin = glm::min(aabbMin, position);
+            aabbMax = glm::max(aabbMax, position);
+        }
+    }
+
+    mesh.boundsCenter = (aabbMin + aabbMax) * 0.5f;
+    mesh.boundsRadius = 0.0f;
+
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        const Submesh& submesh  = mesh.submeshes[i];
+        const u32 vertexStride  = submesh.VBL.stride / sizeof(float);
+        for (u32 v = 0; v + 2 < submesh.vertices.size(); v += vertexStride)
+        {
+            vec3 position = vec3(submesh.vertices[v], submesh.vertices[v + 1], submesh.vertices[v + 2]);
+            mesh.boundsRadius = glm::max(mesh.boundsRadius, glm::length(position - mesh.boundsCenter));
+        }
+    }
+}
+
+// Everything that changes the processed output goes in, so a cache built with other settings is never picked up.
+u64 Importer::Utils::GetImportSettingsHash()
+{
+    const u32 settings[]   = { (u32)IMPORTER_POSTPROCESS_FLAGS, MAX_MESH_LODS, LOD_MIN_TRIANGLES, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, MESH_CACHE_VERSION,
+                               OPTIMIZER_VERSION, OPTIMIZER_CACHE_SIZE, IMPORTER_QUANTIZE_VERTICES, OBJ_LOADER_VERSION };
+    const f32 factors[]    = { LOD_MIN_REDUCTION, OPTIMIZER_OVERDRAW_THRESHOLD };
+
+    u64 hash = FileManager::HashBytes(settings, sizeof(settings));
+    return FileManager::HashBytes(factors, sizeof(factors), hash);
 }
\ No newline at end of file
@@ -14,8 +14,9 @@
 
 namespace Importer
 {
-	u32	 LoadTexture2D	(App* app, const char* filepath);
+	u32	 LoadTexture2D	(App* app, const char* filepath, TEXTURE_USAGE usage = TEXTURE_USAGE::COLOR);
 	u32  LoadModel		(App* app, const char* filename);
+	bool CookModel		(App* app, const char* filename);												// Headless app only, see cooker.h.
 
 	namespace Utils
 	{
@@ -23,9 +24,19 @@ namespace Importer
 		void	FreeImage					(Image image);
 		Image	LoadImage					(const char* filename);
 		
+		bool ImportModel					(App* app, const char* filename, u32 modelIdx);
+		bool ImportObj						(App* app, const char* filename, u32 modelIdx, u32& materialCount);	// Native, see obj_loader.h.
+		bool ImportAssimp					(App* app, const char* filename, u32 modelIdx, u32& materialCount);
+		void ProcessSubmesh					(Mesh* myMesh, Submesh& submesh, const char* name);					// Optimizes it and builds its meshlets.
 		void ProcessAssimpNode				(const aiScene* scene, aiNode* node, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices);
 		void ProcessAssimpMesh				(const aiScene* scene, aiMesh* mesh, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices);
 		void ProcessAssimpMaterial			(App* app, aiMaterial* material, Material& myMaterial, String directory);
+
+		void GenerateSubmeshLods			(Submesh& submesh);											// Appends the simplified LODs to submesh.indices.
+		void ComputeMeshBounds				(Mesh& mesh);
+		void LayoutMeshBuffers				(Mesh& mesh, std::vector<std::vector<u8>>& packedVertices);		// Offsets and packing, no GL.
+		void CreateMeshBuffers				(Mesh& mesh);
+		u64	 GetImportSettingsHash			();															// Key of the processed-mesh cache (see mesh_cache.h).
 	}
 }
 
@@ -0,0 +1,169 @@
+#include "globals.h"
+#include "app.h"
+#include "engine.h"
+#include "buffer_manager.h"
+
+#include "impostors.h"
+
+void Impostors::Init(App* app)
+{
+	ImpostorSet& set = app->impostorSet;
+
+	set.instanceBuffer = BufferManager::CreateBuffer(sizeof(vec4) * 256, GL_SHADER_STORAGE_BUFFER, GL_STREAM_DRAW);
+	glGenVertexArrays(1, &set.vao);
+}
+
+// Every view is an orthographic render framing the model's bounding sphere, looking at its center from direction * 2r.
+// Depth is stored linearly between r and 3r, so 0.5 is the plane through the center.
+u32 Impostors::BakeImpostor(App* app, u32 modelIdx)
+{
+	const Model& model	= app->models[modelIdx];
+	Mesh& mesh			= app->meshes[model.meshIdx];
+	const u32 atlasSize	= IMPOSTOR_FRAMES * IMPOSTOR_FRAME_SIZE;
+
+	Impostor impostor	= {};
+	impostor.modelIdx	= modelIdx;
+	impostor.center		= mesh.boundsCenter;
+	impostor.radius		= mesh.boundsRadius;
+
+	GLuint textures[2] = { 0, 0 };
+	glGenTextures(2, textures);
+	for (u32 i = 0; i < 2; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);						// No mips: they would bleed between views.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	impostor.albedoTexHandle		= textures[0];
+	impostor.normalDepthTexHandle	= textures[1];
+
+	GLuint depthRenderbuffer = 0;
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize, atlasSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, impostor.albedoTexHandle, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, impostor.normalDepthTexHandle, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	Engine::Renderer::CheckFramebufferStatus();
+
+	GLuint drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+
+	Program& bakeProgram = app->programs[app->impostorBakeProgramIdx];
+	glUseProgram(bakeProgram.handle);
+
+	const f32  r			= impostor.radius;
+	const mat4 projMatrix	= glm::ortho(-r, r, -r, r, r, 3.0f * r);
+	for (u32 y = 0; y < IMPOSTOR_FRAMES; ++y)
+	{
+		for (u32 x = 0; x < IMPOSTOR_FRAMES; ++x)
+		{
+			vec3 direction = Utils::DecodeHemiOctahedral(vec2((f32)x, (f32)y) / (f32)(IMPOSTOR_FRAMES - 1) * 2.0f - 1.0f);
+			vec3 right, up;
+			Utils::BuildViewBasis(direction, right, up);
+
+			mat4 viewMatrix = glm::lookAt(impostor.center + direction * 2.0f * r, impostor.center, up);
+			glUniformMatrix4fv(glGetUniformLocation(bakeProgram.handle, "uViewProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(projMatrix * viewMatrix));
+
+			glViewport(x * IMPOSTOR_FRAME_SIZE, y * IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE);
+			for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+			{
+				glBindVertexArray(Engine::FindVAO(mesh, i, bakeProgram));
+				Engine::SetPositionDequantization(bakeProgram, mesh.submeshes[i]);
+
+				const Material& material = app->materials[model.materialIndices[i]];
+				const u32 albedoTexIdx	 = (material.albedoTexIdx < app->textures.size()) ? material.albedoTexIdx : app->whiteTexIdx;
+
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, app->textures[albedoTexIdx].handle);
+				glUniform1i(glGetUniformLocation(bakeProgram.handle, "uTexture"), 0);
+
+				const Submesh& submesh = mesh.submeshes[i];
+				glDrawElements(GL_TRIANGLES, submesh.lods[0].indexCount, submesh.indexType, (void*)(u64)submesh.indexOffset);
+			}
+		}
+	}
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+
+	app->impostorSet.impostors.push_back(impostor);
+	return (u32)app->impostorSet.impostors.size() - 1u;
+}
+
+void Impostors::SelectImpostors(App* app)
+{
+	ImpostorSet& set	= app->impostorSet;
+	const vec3 cameraPos	= app->camera.GetPosition();
+	const bool useImpostors	= (app->enableImpostors && Engine::Renderer::InDeferredMode(app));
+
+	set.instances.clear();
+	for (u32 i = 0; i < set.impostors.size(); ++i)
+	{
+		Impostor& impostor		= set.impostors[i];
+		impostor.firstInstance	= (u32)set.instances.size();
+
+		for (u32 e = 0; e < app->entities.size(); ++e)
+		{
+			Entity& entity = app->entities[e];
+			if (entity.modelIndex != impostor.modelIdx)
+			{
+				continue;
+			}
+
+			// Instances are placed by the world center and scale only: impostors do not follow the entity's rotation.
+			const f32  worldScale	= glm::max(glm::length(vec3(entity.worldMatrix[0])), glm::max(glm::length(vec3(entity.worldMatrix[1])), glm::length(vec3(entity.worldMatrix[2]))));
+			const vec3 worldCenter	= vec3(entity.worldMatrix * vec4(impostor.center, 1.0f));
+			const f32  worldRadius	= impostor.radius * worldScale;
+
+			entity.isImpostor = (useImpostors && !entity.isHidden && glm::length(cameraPos - worldCenter) - worldRadius > app->impostorDistance);
+			if (entity.isImpostor)
+			{
+				set.instances.push_back(vec4(worldCenter, worldRadius));
+			}
+		}
+
+		impostor.instanceCount = (u32)set.instances.size() - impostor.firstInstance;
+	}
+
+	if (!set.instances.empty())
+	{
+		BufferManager::UploadData(set.instanceBuffer, set.instances.data(), (u32)(set.instances.size() * sizeof(vec4)));
+	}
+}
+
+// UTILS -------------------------------------------------------------------
+// Upper hemisphere folded onto the [-1, 1] square: the encoding rotates the octahedron's top face by 45 degrees.
+vec3 Impostors::Utils::DecodeHemiOctahedral(vec2 encoded)
+{
+	const f32 x = (encoded.x + encoded.y) * 0.5f;
+	const f32 z = (encoded.x - encoded.y) * 0.5f;
+
+	return glm::normalize(vec3(x, 1.0f - glm::abs(x) - glm::abs(z), z));
+}
+
+void Impostors::Utils::BuildViewBasis(vec3 direction, vec3& right, vec3& up)
+{
+	const vec3 reference = (glm::abs(direction.y) > 0.999f) ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+
+	right	= glm::normalize(glm::cross(reference, direction));
+	up		= glm::cross(direction, right);
+}
\ No newline at end of file
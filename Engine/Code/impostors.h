@@ -0,0 +1,55 @@
+#ifndef __IMPOSTORS_H__
+#define __IMPOSTORS_H__
+
+// impostors.h:
+// Hemi-octahedral impostors. A model is rendered offscreen at load from IMPOSTOR_FRAMES * IMPOSTOR_FRAMES directions of
+// the upper hemisphere into an albedo atlas and a normal + depth atlas. Entities of that model that are farther than the
+// impostor distance are then drawn as instanced camera-facing quads that blend the three closest baked views and write
+// the G-Buffer like any other geometry, so the deferred lighting passes light them as usual.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+struct App;
+
+#define IMPOSTOR_FRAMES				8																// Views per side of the atlas.
+#define IMPOSTOR_FRAME_SIZE			128																// Texels per side of each view.
+#define IMPOSTOR_INSTANCE_BINDING	6																// SSBO binding shared with shader_final.glsl.
+
+struct Impostor
+{
+	u32		modelIdx;
+	GLuint	albedoTexHandle;																		// RGB albedo, alpha marks the covered texels.
+	GLuint	normalDepthTexHandle;																	// Model-space normal (RGB) and ortho depth (A).
+	vec3	center;																					// Model-space bounding sphere the views were framed with.
+	f32		radius;
+
+	u32		firstInstance;																			// This frame's range in the instance buffer.
+	u32		instanceCount;
+};
+
+struct ImpostorSet
+{
+	std::vector<Impostor>	impostors;
+	std::vector<vec4>		instances;																// World-space center and radius, grouped by impostor.
+	Buffer					instanceBuffer;
+	GLuint					vao;																	// Empty: the quads are built from gl_VertexID.
+};
+
+namespace Impostors
+{
+	void Init				(App* app);
+	u32	 BakeImpostor		(App* app, u32 modelIdx);												// Needs the IMPOSTOR_BAKE program to be loaded.
+	void SelectImpostors	(App* app);																// Flags the far entities and uploads their instances.
+
+	namespace Utils
+	{
+		vec3 DecodeHemiOctahedral	(vec2 encoded);													// Same mapping as the IMPOSTOR_PASS shader.
+		void BuildViewBasis			(vec3 direction, vec3& right, vec3& up);
+	}
+}
+
+#endif // !__IMPOSTORS_H__
\ No newline at end of file
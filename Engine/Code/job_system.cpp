@@ -0,0 +1,168 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+#include "globals.h"
+
+#include "job_system.h"
+
+struct QueuedJob
+{
+	JobSystem::Job			job;
+	JobSystem::JobCounter*	counter;
+};
+
+std::vector<std::thread>	GlobalWorkers;
+std::deque<QueuedJob>		GlobalJobQueue;
+std::mutex					GlobalJobMutex;
+std::condition_variable		GlobalJobSignal;
+bool						GlobalWorkersRunning = false;
+
+void JobSystem::Init(u32 threadCount)
+{
+	if (threadCount == 0)
+	{
+		u32 hardwareThreads = std::thread::hardware_concurrency();
+		threadCount			= (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+	}
+
+	GlobalWorkersRunning = true;
+	for (u32 i = 0; i < threadCount; ++i)
+	{
+		GlobalWorkers.push_back(std::thread(Utils::WorkerLoop));
+	}
+}
+
+void JobSystem::CleanUp()
+{
+	{
+		std::lock_guard<std::mutex> lock(GlobalJobMutex);
+		GlobalWorkersRunning = false;
+	}
+
+	GlobalJobSignal.notify_all();
+
+	for (u32 i = 0; i < GlobalWorkers.size(); ++i)
+	{
+		GlobalWorkers[i].join();
+	}
+
+	GlobalWorkers.clear();
+	GlobalJobQueue.clear();
+}
+
+void JobSystem::Submit(const Job& job, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->pending.fetch_add(1);
+	}
+
+	if (GlobalWorkers.empty())																	// No workers (e.g. not initialized): run inline.
+	{
+		job();
+		if (counter != nullptr) { counter->pending.fetch_sub(1); }
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(GlobalJobMutex);
+		GlobalJobQueue.push_back({ job, counter });
+	}
+
+	GlobalJobSignal.notify_one();
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	while (counter->pending.load() > 0)
+	{
+		if (!Utils::RunNextJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::IsDone(const JobCounter* counter)
+{
+	return (counter->pending.load() == 0);
+}
+
+void JobSystem::ParallelFor(u32 count, u32 batchSize, const RangeJob& job)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	batchSize = (batchSize > 0) ? batchSize : 1;
+
+	JobCounter counter;
+	for (u32 begin = 0; begin < count; begin += batchSize)
+	{
+		u32 end = (begin + batchSize < count) ? begin + batchSize : count;
+		Submit([&job, begin, end]() { job(begin, end); }, &counter);
+	}
+
+	Wait(&counter);
+}
+
+u32 JobSystem::GetThreadCount()
+{
+	return (u32)GlobalWorkers.size();
+}
+
+// UTILS -------------------------------------------------------------------
+void JobSystem::Utils::WorkerLoop()
+{
+	while (true)
+	{
+		QueuedJob queuedJob = {};
+		{
+			std::unique_lock<std::mutex> lock(GlobalJobMutex);
+			GlobalJobSignal.wait(lock, []() { return !GlobalJobQueue.empty() || !GlobalWorkersRunning; });
+
+			if (!GlobalWorkersRunning && GlobalJobQueue.empty())
+			{
+				return;
+			}
+
+			queuedJob = GlobalJobQueue.front();
+			GlobalJobQueue.pop_front();
+		}
+
+		queuedJob.job();
+
+		if (queuedJob.counter != nullptr)
+		{
+			queuedJob.counter->pending.fetch_sub(1);
+		}
+	}
+}
+
+bool JobSystem::Utils::RunNextJob()
+{
+	QueuedJob queuedJob = {};
+	{
+		std::lock_guard<std::mutex> lock(GlobalJobMutex);
+		if (GlobalJobQueue.empty())
+		{
+			return false;
+		}
+
+		queuedJob = GlobalJobQueue.front();
+		GlobalJobQueue.pop_front();
+	}
+
+	queuedJob.job();
+
+	if (queuedJob.counter != nullptr)
+	{
+		queuedJob.counter->pending.fetch_sub(1);
+	}
+
+	return true;
+}
\ No newline at end of file
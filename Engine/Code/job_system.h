@@ -0,0 +1,42 @@
+#ifndef __JOB_SYSTEM_H__
+#define __JOB_SYSTEM_H__
+
+// job_system.h:
+// Fixed pool of worker threads fed from a shared queue. Waiting threads help executing pending jobs.
+
+#include <atomic>
+#include <functional>
+
+#include "base_types.h"
+
+namespace JobSystem
+{
+	typedef std::function<void()>					Job;
+	typedef std::function<void(u32 begin, u32 end)>	RangeJob;
+
+	struct JobCounter
+	{
+		JobCounter() : pending(0) {}
+
+		std::atomic<u32> pending;																// Jobs submitted with this counter that have not finished yet.
+	};
+
+	void Init			(u32 threadCount);														// 0 -> One worker per hardware thread minus the calling one.
+	void CleanUp		();
+
+	void Submit			(const Job& job, JobCounter* counter);									// counter can be nullptr for fire-and-forget jobs.
+	void Wait			(JobCounter* counter);													// Runs pending jobs until the counter reaches 0.
+	bool IsDone			(const JobCounter* counter);
+
+	void ParallelFor	(u32 count, u32 batchSize, const RangeJob& job);						// Splits [0, count) into batches and blocks until all are done.
+
+	u32	 GetThreadCount	();
+
+	namespace Utils
+	{
+		void WorkerLoop	();
+		bool RunNextJob	();																		// Returns false if the queue was empty.
+	}
+}
+
+#endif // !__JOB_SYSTEM_H__
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <float.h>
+
+#include "globals.h"
+#include "app.h"
+#include "buffer_manager.h"
+#include "job_system.h"
+
+#include "light_clusters.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CLUSTERS_USE_SSE 1
+#else
+#define CLUSTERS_USE_SSE 0
+#endif
+
+void LightClusters::Init(App* app)
+{
+	ClusterGrid& grid = app->clusterGrid;
+
+	grid.viewportSize = ivec2(0, 0);															// Forces the cluster bounds to be built on the first BinLights().
+
+	grid.minX.resize(CLUSTER_COUNT); grid.minY.resize(CLUSTER_COUNT); grid.minZ.resize(CLUSTER_COUNT);
+	grid.maxX.resize(CLUSTER_COUNT); grid.maxY.resize(CLUSTER_COUNT); grid.maxZ.resize(CLUSTER_COUNT);
+
+	grid.sliceCounts.resize(CLUSTER_COUNT);
+	grid.sliceIndices.resize(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+	grid.sliceDropped.resize(CLUSTER_GRID_Z);
+	grid.droppedLights = 0;
+	grid.clusters.resize(CLUSTER_COUNT * 2);
+
+	grid.lightBuffer		= BufferManager::CreateBuffer(sizeof(GpuLight) * 64,		GL_SHADER_STORAGE_BUFFER, GL_STREAM_DRAW);
+	grid.clusterBuffer		= BufferManager::CreateBuffer(CLUSTER_COUNT * 2 * sizeof(u32),	GL_SHADER_STORAGE_BUFFER, GL_STREAM_DRAW);
+	grid.lightIndexBuffer	= BufferManager::CreateBuffer(CLUSTER_COUNT * sizeof(u32),		GL_SHADER_STORAGE_BUFFER, GL_STREAM_DRAW);
+}
+
+void LightClusters::UpdateLightBuffer(App* app)
+{
+	ClusterGrid& grid = app->clusterGrid;
+	grid.gpuLights.clear();
+
+	for (u32 pass = 0; pass < 2; ++pass)														// Directional lights are not binned, so they go first.
+	{
+		LIGHT_TYPE passType = (pass == 0) ? LT_DIRECTIONAL : LT_POINT;
+
+		for (u32 i = 0; i < app->activeLights; ++i)
+		{
+			const Light& light = app->lights[i];
+			if (light.type != passType || !light.isVisible)
+			{
+				continue;
+			}
+
+			GpuLight gpuLight		= {};
+			gpuLight.positionRadius = vec4(light.position, light.radius);
+			gpuLight.colorType		= vec4(light.color, (f32)light.type);
+			gpuLight.direction		= vec4(light.direction, 0.0f);
+			gpuLight.attenuation	= vec4(light.attenuation, 0.0f);
+
+			grid.gpuLights.push_back(gpuLight);
+		}
+
+		if (pass == 0)
+		{
+			grid.directionalLightCount = (u32)grid.gpuLights.size();
+		}
+	}
+
+	u32 lightBufferSize = glm::max((u32)(grid.gpuLights.size() * sizeof(GpuLight)), (u32)sizeof(GpuLight));
+	BufferManager::UploadData(grid.lightBuffer, grid.gpuLights.data(), lightBufferSize);
+}
+
+void LightClusters::BinLights(App* app)
+{
+	ClusterGrid& grid = app->clusterGrid;
+
+	if (grid.projMatrix != app->camera.GetProjMatrix() || grid.viewportSize != app->displaySize)
+	{
+		Utils::BuildClusterBounds(app);
+	}
+
+	// VIEW-SPACE SPHERES & PER-SLICE CANDIDATES
+	const mat4	viewMatrix	= app->camera.GetViewMatrix();
+	const u32	pointLights = (u32)grid.gpuLights.size() - grid.directionalLightCount;
+
+	std::vector<std::vector<u32>> sliceCandidates(CLUSTER_GRID_Z);
+
+	grid.viewSpheres.resize(pointLights);
+	for (u32 i = 0; i < pointLights; ++i)
+	{
+		const vec4& positionRadius	= grid.gpuLights[grid.directionalLightCount + i].positionRadius;
+		vec3 viewCenter				= vec3(viewMatrix * vec4(vec3(positionRadius), 1.0f));
+		grid.viewSpheres[i]			= vec4(viewCenter, positionRadius.w);
+
+		f32 viewDepth = -viewCenter.z;
+		if (viewDepth + positionRadius.w < grid.nearPlane || viewDepth - positionRadius.w > grid.farPlane)
+		{
+			continue;
+		}
+
+		u32 firstSlice	= Utils::GetSliceFromDepth(grid, viewDepth - positionRadius.w);
+		u32 lastSlice	= Utils::GetSliceFromDepth(grid, viewDepth + positionRadius.w);
+		for (u32 slice = firstSlice; slice <= lastSlice; ++slice)
+		{
+			sliceCandidates[slice].push_back(i);
+		}
+	}
+
+	// BINNING (one job per depth slice)
+	JobSystem::ParallelFor(CLUSTER_GRID_Z, 1, [&grid, &sliceCandidates](u32 begin, u32 end)
+	{
+		for (u32 slice = begin; slice < end; ++slice)
+		{
+			Utils::BinSlice(grid, slice, sliceCandidates[slice]);
+		}
+	});
+
+	u32 droppedLights = 0;
+	for (u32 slice = 0; slice < CLUSTER_GRID_Z; ++slice)
+	{
+		droppedLights += grid.sliceDropped[slice];
+	}
+
+	if (droppedLights > 0 && grid.droppedLights == 0)
+	{
+		ELOG("Light clusters overflowed: %u light / cluster overlaps past the %u lights per cluster were dropped", droppedLights, MAX_LIGHTS_PER_CLUSTER);
+	}
+	grid.droppedLights = droppedLights;
+
+	// COMPACTION
+	grid.lightIndices.clear();
+	for (u32 cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+	{
+		const u32  count	= grid.sliceCounts[cluster];
+		const u32* indices	= &grid.sliceIndices[cluster * MAX_LIGHTS_PER_CLUSTER];
+
+		grid.clusters[cluster * 2 + 0] = (u32)grid.lightIndices.size();
+		grid.clusters[cluster * 2 + 1] = count;
+		grid.lightIndices.insert(grid.lightIndices.end(), indices, indices + count);
+	}
+
+	u32 lightIndicesSize = glm::max((u32)(grid.lightIndices.size() * sizeof(u32)), (u32)sizeof(u32));
+	BufferManager::UploadData(grid.clusterBuffer,		grid.clusters.data(),		(u32)(grid.clusters.size() * sizeof(u32)));
+	BufferManager::UploadData(grid.lightIndexBuffer,	grid.lightIndices.data(),	lightIndicesSize);
+}
+
+void LightClusters::PushClusterParams(App* app)
+{
+	const ClusterGrid& grid = app->clusterGrid;
+
+	const f32 logDepthRange = logf(grid.farPlane / grid.nearPlane);
+	const f32 sliceScale	= (f32)CLUSTER_GRID_Z / logDepthRange;
+	const f32 sliceBias		= -(f32)CLUSTER_GRID_Z * logf(grid.nearPlane) / logDepthRange;
+
+	BufferManager::AlignHead(app->cbuffer, app->uniformBlockAlignment);
+	app->clusterParamsOffset = app->cbuffer.head;
+
+	PushMat4(app->cbuffer, app->camera.GetViewMatrix());
+	PushUInt(app->cbuffer, CLUSTER_GRID_X);
+	PushUInt(app->cbuffer, CLUSTER_GRID_Y);
+	PushUInt(app->cbuffer, CLUSTER_GRID_Z);
+	PushUInt(app->cbuffer, grid.directionalLightCount);
+	PushVec4(app->cbuffer, vec4(sliceScale, sliceBias, (f32)app->displaySize.x, (f32)app->displaySize.y));
+	PushUInt(app->cbuffer, (u32)grid.gpuLights.size());
+
+	app->clusterParamsSize = app->cbuffer.head - app->clusterParamsOffset;
+}
+
+void LightClusters::BindBuffers(App* app)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING,		app->clusterGrid.lightBuffer.handle);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BUFFER_BINDING,		app->clusterGrid.clusterBuffer.handle);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING,	app->clusterGrid.lightIndexBuffer.handle);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(CLUSTER_PARAMS_BINDING), app->cbuffer.handle, app->clusterParamsOffset, app->clusterParamsSize);
+}
+
+// UTILS -------------------------------------------------------------------
+void LightClusters::Utils::BuildClusterBounds(App* app)
+{
+	ClusterGrid& grid = app->clusterGrid;
+
+	grid.projMatrix		= app->camera.GetProjMatrix();
+	grid.viewportSize	= app->displaySize;
+	grid.nearPlane		= app->camera.GetNearPlane();
+	grid.farPlane		= app->camera.GetFarPlane();
+
+	const mat4 invProjMatrix = glm::inverse(grid.projMatrix);
+
+	for (u32 z = 0; z < CLUSTER_GRID_Z; ++z)
+	{
+		const f32 sliceNear = GetSliceNearDepth(grid, z);
+		const f32 sliceFar	= GetSliceNearDepth(grid, z + 1);
+
+		for (u32 y = 0; y < CLUSTER_GRID_Y; ++y)
+		{
+			for (u32 x = 0; x < CLUSTER_GRID_X; ++x)
+			{
+				vec3 aabbMin = vec3( FLT_MAX);
+				vec3 aabbMax = vec3(-FLT_MAX);
+
+				for (u32 corner = 0; corner < 4; ++corner)
+				{
+					f32 ndcX		= -1.0f + 2.0f * (f32)(x + (corner & 1))		/ (f32)CLUSTER_GRID_X;
+					f32 ndcY		= -1.0f + 2.0f * (f32)(y + ((corner >> 1) & 1))	/ (f32)CLUSTER_GRID_Y;
+					vec4 nearPoint	= invProjMatrix * vec4(ndcX, ndcY, -1.0f, 1.0f);
+					vec3 viewRay	= vec3(nearPoint) / nearPoint.w;								// Point on the near plane, z == -nearPlane.
+
+					vec3 pointNear	= viewRay * (sliceNear / -viewRay.z);
+					vec3 pointFar	= viewRay * (sliceFar  / -viewRay.z);
+
+					aabbMin = glm::min(aabbMin, glm::min(pointNear, pointFar));
+					aabbMax = glm::max(aabbMax, glm::max(pointNear, pointFar));
+				}
+
+				u32 cluster = x + y * CLUSTER_GRID_X + z * CLUSTER_SLICE_SIZE;
+				grid.minX[cluster] = aabbMin.x; grid.minY[cluster] = aabbMin.y; grid.minZ[cluster] = aabbMin.z;
+				grid.maxX[cluster] = aabbMax.x; grid.maxY[cluster] = aabbMax.y; grid.maxZ[cluster] = aabbMax.z;
+			}
+		}
+	}
+}
+
+// Tests every candidate sphere against the clusters of one depth slice, four clusters at a time.
+void LightClusters::Utils::BinSlice(ClusterGrid& grid, u32 slice, const std::vector<u32>& candidates)
+{
+	const u32 firstCluster = slice * CLUSTER_SLICE_SIZE;
+
+	for (u32 i = 0; i < CLUSTER_SLICE_SIZE; ++i)
+	{
+		grid.sliceCounts[firstCluster + i] = 0;
+	}
+	grid.sliceDropped[slice] = 0;
+
+	for (u32 group = 0; group < CLUSTER_SLICE_SIZE; group += 4)
+	{
+		const u32 cluster = firstCluster + group;
+
+	#if CLUSTERS_USE_SSE
+		const __m128 zero	= _mm_setzero_ps();
+		const __m128 minX	= _mm_loadu_ps(&grid.minX[cluster]);
+		const __m128 minY	= _mm_loadu_ps(&grid.minY[cluster]);
+		const __m128 minZ	= _mm_loadu_ps(&grid.minZ[cluster]);
+		const __m128 maxX	= _mm_loadu_ps(&grid.maxX[cluster]);
+		const __m128 maxY	= _mm_loadu_ps(&grid.maxY[cluster]);
+		const __m128 maxZ	= _mm_loadu_ps(&grid.maxZ[cluster]);
+	#endif
+
+		for (u32 c = 0; c < candidates.size(); ++c)
+		{
+			const vec4& sphere = grid.viewSpheres[candidates[c]];
+			u32 mask = 0;
+
+		#if CLUSTERS_USE_SSE
+			const __m128 centerX	= _mm_set1_ps(sphere.x);
+			const __m128 centerY	= _mm_set1_ps(sphere.y);
+			const __m128 centerZ	= _mm_set1_ps(sphere.z);
+			const __m128 radiusSq	= _mm_set1_ps(sphere.w * sphere.w);
+
+			__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minX, centerX), zero), _mm_max_ps(_mm_sub_ps(centerX, maxX), zero));		// Distance from the
+			__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minY, centerY), zero), _mm_max_ps(_mm_sub_ps(centerY, maxY), zero));		// sphere center to
+			__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minZ, centerZ), zero), _mm_max_ps(_mm_sub_ps(centerZ, maxZ), zero));		// each AABB.
+
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			mask = (u32)_mm_movemask_ps(_mm_cmple_ps(distSq, radiusSq));
+		#else
+			for (u32 k = 0; k < 4; ++k)
+			{
+				f32 dx = glm::max(grid.minX[cluster + k] - sphere.x, 0.0f) + glm::max(sphere.x - grid.maxX[cluster + k], 0.0f);
+				f32 dy = glm::max(grid.minY[cluster + k] - sphere.y, 0.0f) + glm::max(sphere.y - grid.maxY[cluster + k], 0.0f);
+				f32 dz = glm::max(grid.minZ[cluster + k] - sphere.z, 0.0f) + glm::max(sphere.z - grid.maxZ[cluster + k], 0.0f);
+				mask  |= ((dx * dx + dy * dy + dz * dz) <= sphere.w * sphere.w) ? (1u << k) : 0u;
+			}
+		#endif
+
+			for (u32 k = 0; k < 4; ++k)
+			{
+				u32& count = grid.sliceCounts[cluster + k];
+				if (!(mask & (1u << k)))
+				{
+					continue;
+				}
+
+				if (count < MAX_LIGHTS_PER_CLUSTER)
+				{
+					grid.sliceIndices[(cluster + k) * MAX_LIGHTS_PER_CLUSTER + count] = grid.directionalLightCount + candidates[c];
+					++count;
+				}
+				else
+				{
+					++grid.sliceDropped[slice];
+				}
+			}
+		}
+	}
+}
+
+u32 LightClusters::Utils::GetSliceFromDepth(const ClusterGrid& grid, f32 viewDepth)
+{
+	if (viewDepth <= grid.nearPlane)
+	{
+		return 0;
+	}
+
+	i32 slice = (i32)floorf(logf(viewDepth / grid.nearPlane) / logf(grid.farPlane / grid.nearPlane) * (f32)CLUSTER_GRID_Z);
+	return (u32)glm::clamp(slice, 0, CLUSTER_GRID_Z - 1);
+}
+
+f32 LightClusters::Utils::GetSliceNearDepth(const ClusterGrid& grid, u32 slice)
+{
+	return grid.nearPlane * powf(grid.farPlane / grid.nearPlane, (f32)slice / (f32)CLUSTER_GRID_Z);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef __LIGHT_CLUSTERS_H__
+#define __LIGHT_CLUSTERS_H__
+
+// light_clusters.h:
+// Clustered (froxel) light binning. The view frustum is split in CLUSTER_GRID_X * CLUSTER_GRID_Y screen tiles and
+// CLUSTER_GRID_Z exponential depth slices. Point lights are binned into the clusters their sphere overlaps, and the
+// result is uploaded as SSBOs so both the forward and the deferred shaders only loop over the lights of their cluster.
+// A cluster keeps its first MAX_LIGHTS_PER_CLUSTER lights: the ones past it are counted (shown in the GUI) and logged
+// when the overflow starts.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+struct App;
+
+#define CLUSTER_GRID_X				16
+#define CLUSTER_GRID_Y				9
+#define CLUSTER_GRID_Z				24
+#define CLUSTER_COUNT				(CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+#define CLUSTER_SLICE_SIZE			(CLUSTER_GRID_X * CLUSTER_GRID_Y)
+#define MAX_LIGHTS_PER_CLUSTER		128
+
+#define LIGHT_BUFFER_BINDING		3																// SSBO bindings shared with shader_final.glsl.
+#define CLUSTER_BUFFER_BINDING		4
+#define LIGHT_INDEX_BUFFER_BINDING	5
+#define CLUSTER_PARAMS_BINDING		3																// UBO binding.
+
+struct ClusterGrid
+{
+	mat4					projMatrix;																// Projection and viewport the cluster AABBs were built for.
+	ivec2					viewportSize;
+	f32						nearPlane;
+	f32						farPlane;
+
+	std::vector<f32>		minX, minY, minZ;														// View-space AABBs in SoA form, so four clusters
+	std::vector<f32>		maxX, maxY, maxZ;														// can be tested against a light at once.
+
+	std::vector<GpuLight>	gpuLights;																// Directional lights first, then the visible point lights.
+	u32						directionalLightCount;
+
+	std::vector<vec4>		viewSpheres;															// View-space center and radius of each point light.
+	std::vector<u32>		sliceCounts;															// Per-cluster light counts, written by the binning jobs.
+	std::vector<u32>		sliceIndices;															// Per-cluster light lists (MAX_LIGHTS_PER_CLUSTER each).
+	std::vector<u32>		sliceDropped;															// Per-slice overlaps past MAX_LIGHTS_PER_CLUSTER.
+	u32						droppedLights;															// This frame's total, light / cluster overlaps.
+
+	std::vector<u32>		clusters;																// offset/count pairs uploaded to the GPU.
+	std::vector<u32>		lightIndices;															// Compacted light lists uploaded to the GPU.
+
+	Buffer					lightBuffer;
+	Buffer					clusterBuffer;
+	Buffer					lightIndexBuffer;
+};
+
+namespace LightClusters
+{
+	void Init				(App* app);
+
+	void UpdateLightBuffer	(App* app);																// Packs and uploads the visible lights.
+	void BinLights			(App* app);																// Assigns the point lights to clusters and uploads the lists.
+	void PushClusterParams	(App* app);																// Must be called while the cbuffer is mapped.
+	void BindBuffers		(App* app);
+
+	namespace Utils
+	{
+		void BuildClusterBounds	(App* app);
+		void BinSlice			(ClusterGrid& grid, u32 slice, const std::vector<u32>& candidates);
+		u32	 GetSliceFromDepth	(const ClusterGrid& grid, f32 viewDepth);
+		f32	 GetSliceNearDepth	(const ClusterGrid& grid, u32 slice);
+	}
+}
+
+#endif // !__LIGHT_CLUSTERS_H__
\ No newline at end of file
@@ -12,6 +12,7 @@ typedef glm::ivec2	ivec2;
 typedef glm::ivec3	ivec3;
 typedef glm::ivec4	ivec4;
 
+typedef glm::mat3	mat3;
 typedef glm::mat4	mat4;
 
 #endif // !__MATH_TYPES_H__
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "buffer_manager.h"
+#include "importer.h"
+#include "vertex_format.h"
+
+#include "mesh_cache.h"
+
+// Bounds-checked cursor over the mapped cache, so a truncated or corrupted file is rejected instead of read past.
+struct CacheReader
+{
+	const u8*	data;
+	u64			size;
+	u64			cursor;
+
+	bool Read(void* dest, u64 byteCount)
+	{
+		if (cursor + byteCount > size) { return false; }
+		memcpy(dest, data + cursor, (size_t)byteCount);
+		cursor += byteCount;
+		return true;
+	}
+
+	bool ReadString(std::string& string, bool& failedLoad)
+	{
+		u32 length = 0;
+		if (!Read(&length, sizeof(length))) { return false; }
+
+		failedLoad = (length == UINT32_MAX);
+		length	   = (failedLoad) ? 0 : length;
+		if (cursor + length > size) { return false; }
+
+		string.assign((const char*)data + cursor, length);
+		cursor += length;
+		return true;
+	}
+};
+
+static void PushBytes(std::vector<u8>& blob, const void* data, u64 byteCount)
+{
+	blob.insert(blob.end(), (const u8*)data, (const u8*)data + byteCount);
+}
+
+static void PushTextureSlot(std::vector<u8>& blob, const App* app, u32 texIdx)
+{
+	// 0 is what ProcessAssimpMaterial() leaves in the slots it does not load, UINT32_MAX a texture that failed to load.
+	const std::string path	= (texIdx != 0 && texIdx < app->textures.size()) ? StringTable::GetString(app->textures[texIdx].filepath) : "";
+	const u32 length		= (texIdx == UINT32_MAX) ? UINT32_MAX : (u32)path.size();
+
+	PushBytes(blob, &length, sizeof(length));
+	PushBytes(blob, path.data(), path.size());
+}
+
+bool MeshCache::Load(App* app, const char* sourcePath, u64 settingsHash, u32 modelIdx)
+{
+	MappedFile cacheFile = {};
+	if (!FileManager::MapFile(Utils::GetCachePath(sourcePath).c_str(), cacheFile))
+	{
+		return false;
+	}
+
+	CacheReader reader		= { cacheFile.data, cacheFile.size, 0 };
+	MeshCacheHeader header	= {};
+
+	bool valid = reader.Read(&header, sizeof(header))
+			  && header.magic			== MESH_CACHE_MAGIC
+			  && header.version			== MESH_CACHE_VERSION
+			  && header.settingsHash	== settingsHash
+			  && header.vertexBlobOffset + header.vertexBlobSize	<= cacheFile.size
+			  && header.indexBlobOffset + header.indexBlobSize		<= cacheFile.size
+			  && header.sourceVertexBlobOffset + header.sourceVertexBlobSize <= cacheFile.size
+			  && (REQUIRE_COOKED_ASSETS || FileManager::IsSourceUnchanged(sourcePath, header.sourceHash, header.sourceTimestamp));	// Cooked-only builds trust the cooker.
+
+	// MATERIALS
+	std::vector<Material> materials(valid ? header.materialCount : 0);
+	reader.cursor = header.materialsOffset;
+	for (u32 i = 0; i < materials.size() && valid; ++i)
+	{
+		Material& material = materials[i];
+		valid = reader.Read(&material.albedo, sizeof(vec3)) && reader.Read(&material.emissive, sizeof(vec3)) && reader.Read(&material.smoothness, sizeof(f32));
+
+		bool failedLoad = false;
+		std::string name;
+		valid			= valid && reader.ReadString(name, failedLoad);
+		material.name	= StringTable::Intern(name.c_str());
+
+		u32* slots[]				= { &material.albedoTexIdx, &material.emissiveTexIdx, &material.specularTexIdx, &material.normalTexIdx, &material.bumpTexIdx };
+		const TEXTURE_USAGE usages[]	= { TEXTURE_USAGE::COLOR, TEXTURE_USAGE::COLOR, TEXTURE_USAGE::COLOR, TEXTURE_USAGE::NORMAL, TEXTURE_USAGE::HEIGHT };
+		for (u32 s = 0; s < ARRAY_COUNT(slots) && valid; ++s)
+		{
+			std::string path;
+			valid		= reader.ReadString(path, failedLoad);
+			*slots[s]	= (failedLoad) ? UINT32_MAX : (path.empty() ? 0 : Importer::LoadTexture2D(app, path.c_str(), usages[s]));
+		}
+	}
+
+	// SUBMESH TABLE
+	std::vector<MeshCacheSubmesh> table(valid ? header.submeshCount : 0);
+	reader.cursor = header.submeshTableOffset;
+	valid = valid && reader.Read(table.data(), table.size() * sizeof(MeshCacheSubmesh));
+
+	std::vector<Submesh> submeshes(table.size());
+	for (u32 i = 0; i < table.size() && valid; ++i)
+	{
+		const MeshCacheSubmesh& entry	= table[i];
+		Submesh& submesh				= submeshes[i];
+
+		valid = entry.attributeCount <= MESH_CACHE_MAX_ATTRIBS && entry.packedAttributeCount <= MESH_CACHE_MAX_ATTRIBS && entry.materialIndex < header.materialCount
+			 && (entry.indexType == GL_UNSIGNED_SHORT || entry.indexType == GL_UNSIGNED_INT)
+			 && (u64)entry.vertexOffset + entry.vertexSize				<= header.vertexBlobSize
+			 && (u64)entry.indexOffset + entry.indexSize					<= header.indexBlobSize
+			 && (u64)entry.sourceVertexOffset + entry.sourceVertexSize	<= header.sourceVertexBlobSize
+			 && (u64)entry.lodOffset + (u64)entry.lodCount * sizeof(SubmeshLod)		<= cacheFile.size		// Before the tables are allocated.
+			 && (u64)entry.meshletOffset + (u64)entry.meshletCount * sizeof(Meshlet)	<= cacheFile.size;
+		if (!valid)
+		{
+			break;
+		}
+
+		submesh.VBL.attributes.assign(entry.attributes, entry.attributes + entry.attributeCount);
+		submesh.VBL.stride			= (u8)entry.vertexStride;
+		submesh.packedVBL.attributes.assign(entry.packedAttributes, entry.packedAttributes + entry.packedAttributeCount);
+		submesh.packedVBL.stride	= (u8)entry.packedStride;
+		submesh.positionOffset		= entry.positionOffset;
+		submesh.positionScale		= entry.positionScale;
+		submesh.vertexOffset		= entry.vertexOffset;
+		submesh.indexOffset			= entry.indexOffset;
+		submesh.indexType			= entry.indexType;
+
+		Utils::ReadSubmeshData(cacheFile, header, entry, submesh);
+
+		submesh.lods.resize(entry.lodCount);
+		submesh.meshlets.resize(entry.meshletCount);
+
+		reader.cursor = entry.lodOffset;
+		valid = reader.Read(submesh.lods.data(), submesh.lods.size() * sizeof(SubmeshLod)) && Utils::AreLodsValid(entry, submesh.lods);
+		reader.cursor = entry.meshletOffset;
+		valid = valid && reader.Read(submesh.meshlets.data(), submesh.meshlets.size() * sizeof(Meshlet));
+	}
+
+	if (!valid)
+	{
+		FileManager::UnmapFile(cacheFile);
+		return false;
+	}
+
+	// MODEL
+	const u32 firstMaterial = (u32)app->materials.size();
+	app->materials.insert(app->materials.end(), materials.begin(), materials.end());
+
+	Model& model	= app->models[modelIdx];
+	Mesh& mesh		= app->meshes[model.meshIdx];
+	for (u32 i = 0; i < table.size(); ++i)
+	{
+		model.materialIndices.push_back(firstMaterial + table[i].materialIndex);
+	}
+
+	mesh.submeshes.swap(submeshes);
+	mesh.boundsCenter = header.boundsCenter;
+	mesh.boundsRadius = header.boundsRadius;
+
+	Utils::UploadBlobs(cacheFile, header, mesh);
+
+	FileManager::UnmapFile(cacheFile);
+	return true;
+}
+
+// Brings back what the residency manager (residency.h) released from a mesh that went through the cache: the GPU
+// buffers, the CPU copies of the vertices and indices, or both. The source file is not hashed again, the mesh in memory
+// is the one this cache was loaded from or saved with, but the submesh table still has to match it.
+bool MeshCache::Reload(App* app, const char* sourcePath, u64 settingsHash, u32 meshIdx, bool gpuBuffers, bool cpuData)
+{
+	MappedFile cacheFile = {};
+	if (!FileManager::MapFile(Utils::GetCachePath(sourcePath).c_str(), cacheFile))
+	{
+		return false;
+	}
+
+	Mesh& mesh				= app->meshes[meshIdx];
+	CacheReader reader		= { cacheFile.data, cacheFile.size, 0 };
+	MeshCacheHeader header	= {};
+
+	bool valid = reader.Read(&header, sizeof(header))
+			  && header.magic			== MESH_CACHE_MAGIC
+			  && header.version			== MESH_CACHE_VERSION
+			  && header.settingsHash	== settingsHash
+			  && header.submeshCount	== (u32)mesh.submeshes.size()
+			  && header.vertexBlobOffset + header.vertexBlobSize	<= cacheFile.size
+			  && header.indexBlobOffset + header.indexBlobSize		<= cacheFile.size
+			  && header.sourceVertexBlobOffset + header.sourceVertexBlobSize <= cacheFile.size;
+
+	std::vector<MeshCacheSubmesh> table(valid ? header.submeshCount : 0);
+	reader.cursor = header.submeshTableOffset;
+	valid = valid && reader.Read(table.data(), table.size() * sizeof(MeshCacheSubmesh));
+
+	for (u32 i = 0; i < table.size() && valid; ++i)
+	{
+		const MeshCacheSubmesh& entry	= table[i];
+		const Submesh& submesh			= mesh.submeshes[i];
+
+		valid = entry.vertexOffset == submesh.vertexOffset && entry.indexOffset == submesh.indexOffset && entry.indexType == submesh.indexType
+			 && (u64)entry.indexOffset + entry.indexSize					<= header.indexBlobSize
+			 && (u64)entry.sourceVertexOffset + entry.sourceVertexSize	<= header.sourceVertexBlobSize
+			 && Utils::AreLodsValid(entry, submesh.lods);												// The LODs in memory draw from the reloaded indices.
+	}
+
+	if (!valid)
+	{
+		FileManager::UnmapFile(cacheFile);
+		return false;
+	}
+
+	for (u32 i = 0; i < table.size() && cpuData; ++i)
+	{
+		Utils::ReadSubmeshData(cacheFile, header, table[i], mesh.submeshes[i]);
+	}
+
+	if (gpuBuffers)
+	{
+		Utils::UploadBlobs(cacheFile, header, mesh);
+	}
+
+	FileManager::UnmapFile(cacheFile);
+	return true;
+}
+
+// Must be called once the mesh buffers are laid out (Importer::Utils::LayoutMeshBuffers()), so the submesh offsets are the final GPU ones.
+void MeshCache::Save(App* app, const char* sourcePath, u64 settingsHash, u32 modelIdx, u32 firstMaterial, u32 materialCount)
+{
+	const Model& model	= app->models[modelIdx];
+	const Mesh& mesh	= app->meshes[model.meshIdx];
+
+	MeshCacheHeader header	= {};
+	header.magic			= MESH_CACHE_MAGIC;
+	header.version			= MESH_CACHE_VERSION;
+	header.settingsHash		= settingsHash;
+	header.materialCount	= materialCount;
+	header.submeshCount		= (u32)mesh.submeshes.size();
+	header.boundsCenter		= mesh.boundsCenter;
+	header.boundsRadius		= mesh.boundsRadius;
+
+	header.sourceTimestamp	= FileManager::GetFileLastWriteTimestamp(sourcePath);
+	if (!FileManager::HashFile(sourcePath, header.sourceHash))
+	{
+		return;
+	}
+
+	std::vector<u8> blob(sizeof(MeshCacheHeader));
+
+	// MATERIALS
+	header.materialsOffset = blob.size();
+	for (u32 i = 0; i < materialCount; ++i)
+	{
+		const Material& material = app->materials[firstMaterial + i];
+		PushBytes(blob, &material.albedo,		sizeof(vec3));
+		PushBytes(blob, &material.emissive,		sizeof(vec3));
+		PushBytes(blob, &material.smoothness,	sizeof(f32));
+
+		const char* name		= StringTable::GetString(material.name);
+		const u32 nameLength	= (u32)strlen(name);
+		PushBytes(blob, &nameLength, sizeof(nameLength));
+		PushBytes(blob, name, nameLength);
+
+		PushTextureSlot(blob, app, material.albedoTexIdx);
+		PushTextureSlot(blob, app, material.emissiveTexIdx);
+		PushTextureSlot(blob, app, material.specularTexIdx);
+		PushTextureSlot(blob, app, material.normalTexIdx);
+		PushTextureSlot(blob, app, material.bumpTexIdx);
+	}
+
+	// SUBMESH TABLE (filled once the blob offsets are known)
+	blob.resize(BufferManager::Align((u32)blob.size(), 16));
+	header.submeshTableOffset = blob.size();
+	std::vector<MeshCacheSubmesh> table(mesh.submeshes.size());
+	blob.resize(blob.size() + table.size() * sizeof(MeshCacheSubmesh));
+
+	// VERTEX & INDEX BLOBS (same offsets as in the GPU buffers)
+	blob.resize(BufferManager::Align((u32)blob.size(), 16));
+	header.vertexBlobOffset = blob.size();
+	std::vector<u8> packedVertices;
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		const Submesh& submesh	= mesh.submeshes[i];
+		MeshCacheSubmesh& entry	= table[i];
+
+		entry.materialIndex			= model.materialIndices[i] - firstMaterial;
+		entry.vertexStride			= submesh.VBL.stride;
+		entry.attributeCount		= (u32)glm::min(submesh.VBL.attributes.size(), (size_t)MESH_CACHE_MAX_ATTRIBS);
+		memcpy(entry.attributes, submesh.VBL.attributes.data(), entry.attributeCount * sizeof(VertexBufferAttribute));
+		entry.packedStride			= submesh.packedVBL.stride;
+		entry.packedAttributeCount	= (u32)glm::min(submesh.packedVBL.attributes.size(), (size_t)MESH_CACHE_MAX_ATTRIBS);
+		memcpy(entry.packedAttributes, submesh.packedVBL.attributes.data(), entry.packedAttributeCount * sizeof(VertexBufferAttribute));
+		entry.positionOffset		= submesh.positionOffset;
+		entry.positionScale			= submesh.positionScale;
+
+		entry.vertexOffset	= submesh.vertexOffset;
+		if (entry.packedAttributeCount > 0)
+		{
+			VertexFormat::PackVertices(submesh, packedVertices);											// Same bytes CreateMeshBuffers() uploaded.
+			entry.vertexSize = (u32)packedVertices.size();
+			PushBytes(blob, packedVertices.data(), entry.vertexSize);
+		}
+		else
+		{
+			entry.vertexSize = (u32)(submesh.vertices.size() * sizeof(f32));
+			PushBytes(blob, submesh.vertices.data(), entry.vertexSize);
+		}
+	}
+	header.vertexBlobSize = blob.size() - header.vertexBlobOffset;
+
+	blob.resize(BufferManager::Align((u32)blob.size(), 16));
+	header.indexBlobOffset = blob.size();
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		const Submesh& submesh	= mesh.submeshes[i];
+		MeshCacheSubmesh& entry	= table[i];
+
+		entry.indexOffset	= submesh.indexOffset;
+		entry.indexType		= submesh.indexType;
+		entry.indexSize		= (u32)submesh.indices.size() * submesh.GetIndexSize();
+
+		blob.resize(header.indexBlobOffset + entry.indexOffset);										// Alignment padding, as in the GPU buffer.
+		if (submesh.indexType == GL_UNSIGNED_SHORT)
+		{
+			const std::vector<u16> shortIndices(submesh.indices.begin(), submesh.indices.end());
+			PushBytes(blob, shortIndices.data(), entry.indexSize);
+		}
+		else
+		{
+			PushBytes(blob, submesh.indices.data(), entry.indexSize);
+		}
+	}
+	header.indexBlobSize = blob.size() - header.indexBlobOffset;
+
+	blob.resize(BufferManager::Align((u32)blob.size(), 16));
+	header.sourceVertexBlobOffset = blob.size();
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		const Submesh& submesh	= mesh.submeshes[i];
+		MeshCacheSubmesh& entry	= table[i];
+
+		entry.sourceVertexOffset	= (u32)(blob.size() - header.sourceVertexBlobOffset);
+		entry.sourceVertexSize		= (u32)(submesh.vertices.size() * sizeof(f32));
+		PushBytes(blob, submesh.vertices.data(), entry.sourceVertexSize);
+	}
+	header.sourceVertexBlobSize = blob.size() - header.sourceVertexBlobOffset;
+
+	// LODS & MESHLETS
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		const Submesh& submesh	= mesh.submeshes[i];
+		MeshCacheSubmesh& entry	= table[i];
+
+		blob.resize(BufferManager::Align((u32)blob.size(), 16));
+		entry.lodCount		= (u32)submesh.lods.size();
+		entry.lodOffset		= blob.size();
+		PushBytes(blob, submesh.lods.data(), submesh.lods.size() * sizeof(SubmeshLod));
+
+		blob.resize(BufferManager::Align((u32)blob.size(), 16));
+		entry.meshletCount	= (u32)submesh.meshlets.size();
+		entry.meshletOffset	= blob.size();
+		PushBytes(blob, submesh.meshlets.data(), submesh.meshlets.size() * sizeof(Meshlet));
+	}
+
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + header.submeshTableOffset, table.data(), table.size() * sizeof(MeshCacheSubmesh));
+
+	FileManager::WriteBinaryFile(Utils::GetCachePath(sourcePath).c_str(), blob.data(), blob.size());
+}
+
+// UTILS -------------------------------------------------------------------
+std::string MeshCache::Utils::GetCachePath(const char* sourcePath)
+{
+	return std::string(sourcePath) + ".meshcache";
+}
+
+void MeshCache::Utils::ReadSubmeshData(const MappedFile& cacheFile, const MeshCacheHeader& header, const MeshCacheSubmesh& entry, Submesh& submesh)
+{
+	const f32* vertices	= (const f32*)(cacheFile.data + header.sourceVertexBlobOffset + entry.sourceVertexOffset);
+	const u8* indices	= cacheFile.data + header.indexBlobOffset + entry.indexOffset;
+	submesh.vertices.assign(vertices, vertices + entry.sourceVertexSize / sizeof(f32));
+	if (entry.indexType == GL_UNSIGNED_SHORT)
+	{
+		submesh.indices.assign((const u16*)indices, (const u16*)indices + entry.indexSize / sizeof(u16));		// Widened back for the CPU side.
+	}
+	else
+	{
+		submesh.indices.assign((const u32*)indices, (const u32*)indices + entry.indexSize / sizeof(u32));
+	}
+}
+
+// Every LOD must be whole triangles inside the submesh's indices, or drawing it would read past them.
+bool MeshCache::Utils::AreLodsValid(const MeshCacheSubmesh& entry, const std::vector<SubmeshLod>& lods)
+{
+	const u64 indexCount = entry.indexSize / ((entry.indexType == GL_UNSIGNED_SHORT) ? sizeof(u16) : sizeof(u32));
+	for (const SubmeshLod& lod : lods)
+	{
+		if ((u64)lod.firstIndex + lod.indexCount > indexCount || lod.indexCount % 3 != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// The blobs are already in GPU layout: one upload each, straight from the mapping.
+void MeshCache::Utils::UploadBlobs(const MappedFile& cacheFile, const MeshCacheHeader& header, Mesh& mesh)
+{
+	glGenBuffers(1, &mesh.vertexBufferHandle);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
+	glBufferData(GL_ARRAY_BUFFER, header.vertexBlobSize, cacheFile.data + header.vertexBlobOffset, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &mesh.indexBufferHandle);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, header.indexBlobSize, cacheFile.data + header.indexBlobOffset, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+// mesh_cache.h:
+// Binary cache of the processed models (<model file>.meshcache). It stores what LoadModel builds after Assimp: the
+// materials (as texture paths), a submesh table and the vertex/index blobs already laid out as they go in the GPU
+// buffers (quantized vertices included), followed by the float source vertices, the LODs and the meshlets. Loading
+// maps the file and uploads both GPU blobs in a single call each.
+// The cache is rebuilt whenever the source file content, the importer settings or MESH_CACHE_VERSION change. The source
+// is only hashed again when its timestamp moved, and not at all when it is missing or in REQUIRE_COOKED_ASSETS builds.
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+struct App;
+struct MappedFile;
+
+#define MESH_CACHE_MAGIC		0x4D504741															// "AGPM"
+#define MESH_CACHE_VERSION		4
+#define MESH_CACHE_MAX_ATTRIBS	8
+
+struct MeshCacheHeader
+{
+	u32		magic;
+	u32		version;
+	u64		sourceHash;																				// FNV-1a of the source model file.
+	u64		sourceTimestamp;																		// Its last write timestamp, see FileManager::IsSourceUnchanged().
+	u64		settingsHash;																			// Post-process flags, LOD and meshlet settings.
+
+	u32		materialCount;
+	u32		submeshCount;
+	vec3	boundsCenter;
+	f32		boundsRadius;
+
+	u64		materialsOffset;																		// Every offset is from the start of the file.
+	u64		submeshTableOffset;
+	u64		vertexBlobOffset;
+	u64		vertexBlobSize;
+	u64		indexBlobOffset;
+	u64		indexBlobSize;
+	u64		sourceVertexBlobOffset;																	// Submesh::vertices, kept for the CPU side.
+	u64		sourceVertexBlobSize;
+};
+
+struct MeshCacheSubmesh
+{
+	u32		materialIndex;																			// Relative to the model's first material.
+	u32		vertexStride;
+	u32		attributeCount;
+	VertexBufferAttribute attributes[MESH_CACHE_MAX_ATTRIBS];
+	u32		packedStride;																			// 0 when the GPU vertices are the floats.
+	u32		packedAttributeCount;
+	VertexBufferAttribute packedAttributes[MESH_CACHE_MAX_ATTRIBS];
+	vec3	positionOffset;
+	vec3	positionScale;
+
+	u32		vertexOffset;																			// Inside the vertex / index blobs (GPU layout).
+	u32		vertexSize;
+	u32		indexOffset;
+	u32		indexSize;
+	u32		indexType;																				// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+	u32		sourceVertexOffset;																		// Inside the source vertex blob.
+	u32		sourceVertexSize;
+
+	u32		lodCount;
+	u32		meshletCount;
+	u64		lodOffset;
+	u64		meshletOffset;
+};
+
+namespace MeshCache
+{
+	bool Load	(App* app, const char* sourcePath, u64 settingsHash, u32 modelIdx);						// False when missing or stale.
+	void Save	(App* app, const char* sourcePath, u64 settingsHash, u32 modelIdx, u32 firstMaterial, u32 materialCount);
+	bool Reload	(App* app, const char* sourcePath, u64 settingsHash, u32 meshIdx, bool gpuBuffers, bool cpuData);		// For the residency manager.
+
+	namespace Utils
+	{
+		std::string GetCachePath	(const char* sourcePath);
+		bool AreLodsValid			(const MeshCacheSubmesh& entry, const std::vector<SubmeshLod>& lods);
+
+		void ReadSubmeshData		(const MappedFile& cacheFile, const MeshCacheHeader& header, const MeshCacheSubmesh& entry, Submesh& submesh);
+		void UploadBlobs			(const MappedFile& cacheFile, const MeshCacheHeader& header, Mesh& mesh);
+	}
+}
+
+#endif // !__MESH_CACHE_H__
\ No newline at end of file
@@ -0,0 +1,588 @@
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+#include "globals.h"
+#include "shader_types.h"
+#include "vertex_format.h"
+
+#include "mesh_optimizer.h"
+
+void MeshOptimizer::OptimizeSubmesh(Submesh& submesh)
+{
+	const u32 vertexStride	= submesh.VBL.stride / sizeof(f32);
+	const u32 vertexCount	= (u32)submesh.vertices.size() / vertexStride;
+	if (submesh.indices.size() < 3 || vertexCount == 0)
+	{
+		return;
+	}
+
+	OptimizeVertexCache(submesh.indices, vertexCount);
+	OptimizeOverdraw(submesh.indices, submesh.vertices.data(), vertexStride);
+	OptimizeVertexFetch(submesh.vertices, vertexStride, submesh.indices);
+}
+
+// Meshlet building regroups the triangles, so the cache order is restored inside each meshlet. The triangle set of every
+// meshlet is untouched, so its bounds and normal cone stay valid.
+void MeshOptimizer::OptimizeMeshlets(Submesh& submesh)
+{
+	const u32 vertexCount = (u32)submesh.vertices.size() / (submesh.VBL.stride / sizeof(f32));
+
+	std::vector<u32> localIndex(vertexCount, UINT32_MAX);
+	std::vector<u32> globalIndex;
+	std::vector<u32> indices;
+	for (u32 m = 0; m < submesh.meshlets.size(); ++m)
+	{
+		u32* meshletIndices		= &submesh.indices[submesh.meshlets[m].firstIndex];
+		const u32 indexCount	= submesh.meshlets[m].indexCount;
+
+		globalIndex.clear();
+		indices.resize(indexCount);
+		for (u32 i = 0; i < indexCount; ++i)
+		{
+			u32& local = localIndex[meshletIndices[i]];
+			if (local == UINT32_MAX)
+			{
+				local = (u32)globalIndex.size();
+				globalIndex.push_back(meshletIndices[i]);
+			}
+
+			indices[i] = local;
+		}
+
+		OptimizeVertexCache(indices, (u32)globalIndex.size());
+
+		for (u32 i = 0; i < indexCount; ++i)
+		{
+			meshletIndices[i] = globalIndex[indices[i]];
+		}
+		for (u32 v = 0; v < globalIndex.size(); ++v)
+		{
+			localIndex[globalIndex[v]] = UINT32_MAX;
+		}
+	}
+}
+
+MeshOptimizerStats MeshOptimizer::AnalyzeSubmesh(const Submesh& submesh)
+{
+	const u32 vertexStride	= submesh.VBL.stride / sizeof(f32);
+	const u32 vertexCount	= (u32)submesh.vertices.size() / vertexStride;
+
+	MeshOptimizerStats stats = {};
+	if (submesh.indices.size() < 3 || vertexCount == 0)
+	{
+		return stats;
+	}
+
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	u32 timestamp		= OPTIMIZER_CACHE_SIZE + 1;
+	const u32 misses	= Utils::SimulateCache(submesh.indices.data(), (u32)submesh.indices.size(), cacheTimestamps, timestamp);
+
+	u32 usedVertices = 0;
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		usedVertices += (cacheTimestamps[i] != 0);
+	}
+
+	stats.acmr		= (f32)misses / (f32)(submesh.indices.size() / 3);
+	stats.atvr		= (f32)misses / (f32)usedVertices;
+	stats.overdraw	= Utils::ComputeOverdraw(submesh.indices, submesh.vertices.data(), vertexCount, vertexStride);
+	stats.overfetch	= Utils::ComputeOverfetch(submesh.indices, vertexCount, VertexFormat::GetGpuLayout(submesh).stride);		// What the GPU actually fetches.
+
+	return stats;
+}
+
+// Tipsify (Sander, Nehab & Barczak 2007). Fans around one vertex at a time and picks the next fanning vertex among the
+// ones just emitted, preferring those that will still be in the cache after their remaining triangles are emitted.
+void MeshOptimizer::OptimizeVertexCache(std::vector<u32>& indices, u32 vertexCount)
+{
+	const u32 triangleCount = (u32)indices.size() / 3;
+
+	// VERTEX -> TRIANGLE ADJACENCY
+	std::vector<u32> triangleOffsets(vertexCount + 1, 0);
+	std::vector<u32> triangleList(triangleCount * 3);
+	for (u32 i = 0; i < triangleCount * 3; ++i)
+	{
+		++triangleOffsets[indices[i] + 1];
+	}
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		triangleOffsets[i + 1] += triangleOffsets[i];
+	}
+
+	std::vector<u32> liveTriangles(vertexCount);
+	std::vector<u32> triangleFill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (u32 t = 0; t < triangleCount; ++t)
+	{
+		for (u32 k = 0; k < 3; ++k)
+		{
+			triangleList[triangleFill[indices[t * 3 + k]]++] = t;
+		}
+	}
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		liveTriangles[v] = triangleOffsets[v + 1] - triangleOffsets[v];
+	}
+
+	// FANNING
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	std::vector<u8>	 emitted(triangleCount, 0);
+	std::vector<u32> deadEnds;
+	std::vector<u32> candidates;
+	std::vector<u32> result;
+	result.reserve(triangleCount * 3);
+
+	u32 timestamp	= OPTIMIZER_CACHE_SIZE + 1;
+	u32 cursor		= 0;
+	u32 fanning		= 0;
+	while (fanning != UINT32_MAX)
+	{
+		candidates.clear();
+		for (u32 a = triangleOffsets[fanning]; a < triangleOffsets[fanning + 1]; ++a)
+		{
+			const u32 triangle = triangleList[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+
+			for (u32 k = 0; k < 3; ++k)
+			{
+				const u32 v = indices[triangle * 3 + k];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				--liveTriangles[v];
+
+				if (timestamp - cacheTimestamps[v] > OPTIMIZER_CACHE_SIZE)
+				{
+					cacheTimestamps[v] = timestamp++;
+				}
+			}
+
+			emitted[triangle] = 1;
+		}
+
+		// NEXT FANNING VERTEX
+		fanning		= UINT32_MAX;
+		i32 best	= -1;
+		for (u32 c = 0; c < candidates.size(); ++c)
+		{
+			const u32 v = candidates[c];
+			if (liveTriangles[v] == 0)
+			{
+				continue;
+			}
+
+			const i32 age		= (i32)(timestamp - cacheTimestamps[v]);
+			const i32 priority	= (age + 2 * (i32)liveTriangles[v] <= OPTIMIZER_CACHE_SIZE) ? age : 0;		// Stays in the cache once fanned.
+			if (priority > best)
+			{
+				best	= priority;
+				fanning	= v;
+			}
+		}
+
+		// DEAD END: most recent vertex that still has triangles, else the next unprocessed one.
+		while (fanning == UINT32_MAX && !deadEnds.empty())
+		{
+			const u32 v = deadEnds.back();
+			deadEnds.pop_back();
+			fanning = (liveTriangles[v] > 0) ? v : UINT32_MAX;
+		}
+		while (fanning == UINT32_MAX && cursor < vertexCount)
+		{
+			fanning = (liveTriangles[cursor] > 0) ? cursor : UINT32_MAX;
+			++cursor;
+		}
+	}
+
+	indices.swap(result);
+}
+
+// Sander et al. 2007: clusters are cut where the cache gets flushed (hard) and, inside them, wherever the running ACMR is
+// already within the threshold (soft). Sorting them by how much they face away from the mesh center approximates a
+// front-to-back order for most view directions.
+void MeshOptimizer::OptimizeOverdraw(std::vector<u32>& indices, const f32* vertices, u32 vertexStride)
+{
+	const u32 triangleCount = (u32)indices.size() / 3;
+
+	u32 vertexCount = 0;
+	for (u32 i = 0; i < indices.size(); ++i)
+	{
+		vertexCount = glm::max(vertexCount, indices[i] + 1);
+	}
+
+	std::vector<u32> hardClusters;
+	std::vector<u32> clusters;
+	Utils::BuildHardBoundaries(indices, vertexCount, hardClusters);
+	Utils::BuildSoftBoundaries(indices, vertexCount, hardClusters, clusters);
+	clusters.push_back(triangleCount);
+
+	// CLUSTER CENTROIDS & NORMALS (area weighted)
+	const u32 clusterCount = (u32)clusters.size() - 1u;
+	std::vector<vec3> centroids(clusterCount, vec3(0.0f));
+	std::vector<vec3> normals(clusterCount, vec3(0.0f));
+	std::vector<f32>  areas(clusterCount, 0.0f);
+
+	vec3 meshCentroid	= vec3(0.0f);
+	f32  meshArea		= 0.0f;
+	for (u32 c = 0; c < clusterCount; ++c)
+	{
+		for (u32 t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const f32* p0 = &vertices[indices[t * 3 + 0] * vertexStride];
+			const f32* p1 = &vertices[indices[t * 3 + 1] * vertexStride];
+			const f32* p2 = &vertices[indices[t * 3 + 2] * vertexStride];
+			const vec3 a = vec3(p0[0], p0[1], p0[2]);
+			const vec3 b = vec3(p1[0], p1[1], p1[2]);
+			const vec3 d = vec3(p2[0], p2[1], p2[2]);
+
+			const vec3 normal	= glm::cross(b - a, d - a);
+			const f32  area		= glm::length(normal);
+
+			centroids[c]	+= (a + b + d) * (area / 3.0f);
+			normals[c]		+= normal;
+			areas[c]		+= area;
+		}
+
+		meshCentroid	+= centroids[c];
+		meshArea		+= areas[c];
+		centroids[c]	/= (areas[c] > 0.0f) ? areas[c] : 1.0f;
+	}
+	meshCentroid /= (meshArea > 0.0f) ? meshArea : 1.0f;
+
+	std::vector<f32> sortKeys(clusterCount, 0.0f);
+	std::vector<u32> order(clusterCount);
+	for (u32 c = 0; c < clusterCount; ++c)
+	{
+		const f32 length	= glm::length(normals[c]);
+		sortKeys[c]			= (length > 0.0f) ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		order[c]			= c;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](u32 a, u32 b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<u32> result;
+	result.reserve(indices.size());
+	for (u32 o = 0; o < clusterCount; ++o)
+	{
+		const u32 c = order[o];
+		result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+
+	indices.swap(result);
+}
+
+// Vertices are renumbered in the order the index buffer first references them. Unreferenced vertices are dropped.
+void MeshOptimizer::OptimizeVertexFetch(std::vector<f32>& vertices, u32 vertexStride, std::vector<u32>& indices)
+{
+	const u32 vertexCount = (u32)vertices.size() / vertexStride;
+
+	std::vector<u32> remap(vertexCount, UINT32_MAX);
+	std::vector<f32> result;
+	result.reserve(vertices.size());
+
+	u32 nextVertex = 0;
+	for (u32 i = 0; i < indices.size(); ++i)
+	{
+		u32& newIndex = remap[indices[i]];
+		if (newIndex == UINT32_MAX)
+		{
+			newIndex = nextVertex++;
+			result.insert(result.end(), vertices.begin() + indices[i] * vertexStride, vertices.begin() + (indices[i] + 1) * vertexStride);
+		}
+
+		indices[i] = newIndex;
+	}
+
+	vertices.swap(result);
+}
+
+// A grid of OPTIMIZER_CHECK_GRID_SIZE^2 quads with its triangles shuffled by a fixed LCG, so the cache pass has work to do.
+bool MeshOptimizer::SelfCheck()
+{
+	const u32 side			= OPTIMIZER_CHECK_GRID_SIZE + 1;
+	const u32 vertexCount	= side * side;
+
+	std::vector<f32> vertices;
+	for (u32 z = 0; z < side; ++z)
+	{
+		for (u32 x = 0; x < side; ++x)
+		{
+			vertices.insert(vertices.end(), { (f32)x, 0.0f, (f32)z });
+		}
+	}
+
+	std::vector<u32> indices;
+	for (u32 z = 0; z < OPTIMIZER_CHECK_GRID_SIZE; ++z)
+	{
+		for (u32 x = 0; x < OPTIMIZER_CHECK_GRID_SIZE; ++x)
+		{
+			const u32 v = x + z * side;
+			indices.insert(indices.end(), { v, v + side, v + 1, v + 1, v + side, v + side + 1 });
+		}
+	}
+
+	u32 seed = 1;
+	for (u32 t = (u32)indices.size() / 3 - 1; t > 0; --t)
+	{
+		seed			= seed * 1664525u + 1013904223u;
+		const u32 other	= (seed >> 8) % (t + 1);
+		std::swap_ranges(indices.begin() + t * 3, indices.begin() + t * 3 + 3, indices.begin() + other * 3);
+	}
+
+	// VERTEX CACHE
+	std::vector<u32> cached		= indices;
+	std::vector<u32> cachedCopy	= indices;
+	OptimizeVertexCache(cached, vertexCount);
+	OptimizeVertexCache(cachedCopy, vertexCount);
+
+	const f32 sourceACMR = Utils::ComputeACMR(indices.data(), (u32)indices.size(), vertexCount);
+	const f32 cachedACMR = Utils::ComputeACMR(cached.data(), (u32)cached.size(), vertexCount);
+
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	u32 timestamp = 0;
+	Utils::ComputeACMR(indices.data(), (u32)indices.size(), cacheTimestamps, timestamp);						// Leaves the shared cache dirty.
+	const f32 reusedACMR = Utils::ComputeACMR(cached.data(), (u32)cached.size(), cacheTimestamps, timestamp);
+
+	// VERTEX FETCH
+	std::vector<f32> fetched			= vertices;
+	std::vector<u32> fetchedIndices		= cached;
+	std::vector<f32> fetchedCopy		= vertices;
+	std::vector<u32> fetchedCopyIndices	= cached;
+	OptimizeVertexFetch(fetched, 3, fetchedIndices);
+	OptimizeVertexFetch(fetchedCopy, 3, fetchedCopyIndices);
+
+	bool sameTriangles = (fetchedIndices.size() == cached.size());
+	for (u32 i = 0; i < cached.size() && sameTriangles; ++i)													// Same triangles, same order and winding.
+	{
+		sameTriangles = memcmp(&fetched[fetchedIndices[i] * 3], &vertices[cached[i] * 3], 3 * sizeof(f32)) == 0;
+	}
+
+	bool passed = true;
+	if (cached != cachedCopy || fetched != fetchedCopy || fetchedIndices != fetchedCopyIndices)
+	{
+		ELOG("MeshOptimizer check: the same input gave different buffers");
+		passed = false;
+	}
+	if (cachedACMR > sourceACMR || reusedACMR != cachedACMR)
+	{
+		ELOG("MeshOptimizer check: ACMR went from %f to %f (%f with a reused cache)", sourceACMR, cachedACMR, reusedACMR);
+		passed = false;
+	}
+	if (!sameTriangles)
+	{
+		ELOG("MeshOptimizer check: the vertex fetch pass changed the triangles");
+		passed = false;
+	}
+
+	return passed;
+}
+
+// UTILS -------------------------------------------------------------------
+// FIFO cache emulated with timestamps: a vertex is cached if it entered less than OPTIMIZER_CACHE_SIZE misses ago.
+u32 MeshOptimizer::Utils::SimulateCache(const u32* indices, u32 indexCount, std::vector<u32>& cacheTimestamps, u32& timestamp)
+{
+	u32 misses = 0;
+	for (u32 i = 0; i < indexCount; ++i)
+	{
+		if (timestamp - cacheTimestamps[indices[i]] > OPTIMIZER_CACHE_SIZE)
+		{
+			cacheTimestamps[indices[i]] = timestamp++;
+			++misses;
+		}
+	}
+
+	return misses;
+}
+
+f32 MeshOptimizer::Utils::ComputeACMR(const u32* indices, u32 indexCount, u32 vertexCount)
+{
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	u32 timestamp = 0;
+
+	return ComputeACMR(indices, indexCount, cacheTimestamps, timestamp);
+}
+
+f32 MeshOptimizer::Utils::ComputeACMR(const u32* indices, u32 indexCount, std::vector<u32>& cacheTimestamps, u32& timestamp)
+{
+	timestamp += OPTIMIZER_CACHE_SIZE + 1;																// Flush.
+
+	return (indexCount >= 3) ? (f32)SimulateCache(indices, indexCount, cacheTimestamps, timestamp) / (f32)(indexCount / 3) : 0.0f;
+}
+
+// A triangle whose 3 vertices all miss the cache starts a new cluster: reordering there costs nothing.
+void MeshOptimizer::Utils::BuildHardBoundaries(const std::vector<u32>& indices, u32 vertexCount, std::vector<u32>& clusters)
+{
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	u32 timestamp = OPTIMIZER_CACHE_SIZE + 1;
+
+	clusters.clear();
+	for (u32 t = 0; t < indices.size() / 3; ++t)
+	{
+		if (SimulateCache(&indices[t * 3], 3, cacheTimestamps, timestamp) == 3)
+		{
+			clusters.push_back(t);
+		}
+	}
+}
+
+void MeshOptimizer::Utils::BuildSoftBoundaries(const std::vector<u32>& indices, u32 vertexCount, const std::vector<u32>& hardClusters, std::vector<u32>& clusters)
+{
+	const u32 triangleCount = (u32)indices.size() / 3;
+
+	std::vector<u32> cacheTimestamps(vertexCount, 0);
+	u32 timestamp = OPTIMIZER_CACHE_SIZE + 1;
+
+	clusters.clear();
+	for (u32 h = 0; h < hardClusters.size(); ++h)
+	{
+		const u32 start = hardClusters[h];
+		const u32 end	= (h + 1 < hardClusters.size()) ? hardClusters[h + 1] : triangleCount;
+
+		const f32 threshold = ComputeACMR(&indices[start * 3], (end - start) * 3, cacheTimestamps, timestamp) * OPTIMIZER_OVERDRAW_THRESHOLD;	// One cache for every cluster.
+
+		timestamp		+= OPTIMIZER_CACHE_SIZE + 1;												// Flush.
+		u32 clusterStart = start;
+		u32 misses		 = 0;
+		clusters.push_back(start);
+
+		for (u32 t = start; t < end; ++t)
+		{
+			misses += SimulateCache(&indices[t * 3], 3, cacheTimestamps, timestamp);
+
+			if (t + 1 < end && (f32)misses / (f32)(t + 1 - clusterStart) <= threshold)
+			{
+				clusters.push_back(t + 1);
+				clusterStart	 = t + 1;
+				misses			 = 0;
+				timestamp		+= OPTIMIZER_CACHE_SIZE + 1;
+			}
+		}
+	}
+}
+
+// Software rasterizer over the 6 axis-aligned orthographic views of the bounding box, with back-face culling and a
+// depth test. Every depth test pass counts as a shaded pixel.
+f32 MeshOptimizer::Utils::ComputeOverdraw(const std::vector<u32>& indices, const f32* vertices, u32 vertexCount, u32 vertexStride)
+{
+	vec3 boundsMin = vec3( FLT_MAX);
+	vec3 boundsMax = vec3(-FLT_MAX);
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		const vec3 position = vec3(vertices[v * vertexStride + 0], vertices[v * vertexStride + 1], vertices[v * vertexStride + 2]);
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	const vec3 extent	= boundsMax - boundsMin;
+	const f32  scale	= glm::max(extent.x, glm::max(extent.y, extent.z));
+	if (scale <= 0.0f)
+	{
+		return 1.0f;
+	}
+
+	const i32 resolution = OPTIMIZER_OVERDRAW_RESOLUTION;
+	std::vector<f32> depthBuffer(resolution * resolution);
+
+	u64 shaded	= 0;
+	u64 covered	= 0;
+	for (u32 view = 0; view < 6; ++view)
+	{
+		const u32 axis		= view / 2;
+		const f32 sign		= (view & 1) ? -1.0f : 1.0f;												// Looking down +axis or -axis.
+		const u32 axisU		= (axis + 1) % 3;
+		const u32 axisV		= (axis + 2) % 3;
+
+		std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+		for (u32 t = 0; t < indices.size() / 3; ++t)
+		{
+			vec3 p[3];
+			for (u32 k = 0; k < 3; ++k)
+			{
+				const f32* vertex	= &vertices[indices[t * 3 + k] * vertexStride];
+				p[k]				= (vec3(vertex[0], vertex[1], vertex[2]) - boundsMin) / scale;
+			}
+
+			const vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+			if (normal[axis] * sign >= 0.0f)																// Back facing (or edge on).
+			{
+				continue;
+			}
+
+			vec3 s[3];
+			for (u32 k = 0; k < 3; ++k)
+			{
+				s[k] = vec3(p[k][axisU] * resolution, p[k][axisV] * resolution, (sign > 0.0f) ? p[k][axis] : 1.0f - p[k][axis]);
+			}
+
+			const f32 area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[1].y - s[0].y) * (s[2].x - s[0].x);
+			if (area == 0.0f)
+			{
+				continue;
+			}
+
+			const i32 minX = glm::max((i32)glm::floor(glm::min(s[0].x, glm::min(s[1].x, s[2].x))), 0);
+			const i32 minY = glm::max((i32)glm::floor(glm::min(s[0].y, glm::min(s[1].y, s[2].y))), 0);
+			const i32 maxX = glm::min((i32)glm::ceil(glm::max(s[0].x, glm::max(s[1].x, s[2].x))), resolution - 1);
+			const i32 maxY = glm::min((i32)glm::ceil(glm::max(s[0].y, glm::max(s[1].y, s[2].y))), resolution - 1);
+
+			for (i32 y = minY; y <= maxY; ++y)
+			{
+				for (i32 x = minX; x <= maxX; ++x)
+				{
+					const f32 px = x + 0.5f;
+					const f32 py = y + 0.5f;
+					const f32 w0 = ((s[2].x - s[1].x) * (py - s[1].y) - (s[2].y - s[1].y) * (px - s[1].x)) / area;
+					const f32 w1 = ((s[0].x - s[2].x) * (py - s[2].y) - (s[0].y - s[2].y) * (px - s[2].x)) / area;
+					const f32 w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+					{
+						continue;
+					}
+
+					const f32 depth = w0 * s[0].z + w1 * s[1].z + w2 * s[2].z;
+					f32& stored		= depthBuffer[y * resolution + x];
+					if (depth < stored)
+					{
+						stored = depth;
+						++shaded;
+					}
+				}
+			}
+		}
+
+		for (u32 i = 0; i < depthBuffer.size(); ++i)
+		{
+			covered += (depthBuffer[i] != FLT_MAX);
+		}
+	}
+
+	return (covered > 0) ? (f32)shaded / (f32)covered : 1.0f;
+}
+
+// Direct-mapped cache of OPTIMIZER_FETCH_LINE_COUNT lines standing in for the GPU's vertex fetch cache.
+f32 MeshOptimizer::Utils::ComputeOverfetch(const std::vector<u32>& indices, u32 vertexCount, u32 vertexStrideBytes)
+{
+	std::vector<u64> lines(OPTIMIZER_FETCH_LINE_COUNT, UINT64_MAX);
+
+	u64 fetched = 0;
+	for (u32 i = 0; i < indices.size(); ++i)
+	{
+		const u64 first	= (u64)indices[i] * vertexStrideBytes / OPTIMIZER_FETCH_LINE_SIZE;
+		const u64 last	= ((u64)indices[i] * vertexStrideBytes + vertexStrideBytes - 1) / OPTIMIZER_FETCH_LINE_SIZE;
+		for (u64 line = first; line <= last; ++line)
+		{
+			u64& slot = lines[line % OPTIMIZER_FETCH_LINE_COUNT];
+			if (slot != line)
+			{
+				slot	 = line;
+				fetched	+= OPTIMIZER_FETCH_LINE_SIZE;
+			}
+		}
+	}
+
+	return (f32)fetched / (f32)((u64)vertexCount * vertexStrideBytes);
+}
\ No newline at end of file
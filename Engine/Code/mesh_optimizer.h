@@ -0,0 +1,61 @@
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+// mesh_optimizer.h:
+// Post-import reordering of the submesh buffers, run before the meshlets are built. Triangles are first ordered for the
+// post-transform vertex cache (Tipsify), then split into clusters at cache flushes and sorted so the outward-facing
+// clusters are drawn first (view-independent overdraw reduction), without letting the cache efficiency drop more than
+// OPTIMIZER_OVERDRAW_THRESHOLD. Last, vertices are renumbered in first-use order so the vertex fetch walks the vertex
+// buffer sequentially. The LOD index ranges (importer.h) only get the vertex cache order: they share the vertices of
+// the source mesh. Everything is deterministic: the same input always gives the same buffers, which SelfCheck() checks
+// on a shuffled grid along with the ACMR gain and the triangles surviving the renumbering.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+
+struct Submesh;
+
+#define OPTIMIZER_VERSION				2																// Part of the import settings hash.
+#define OPTIMIZER_CACHE_SIZE			16																// FIFO post-transform cache that is simulated.
+#define OPTIMIZER_OVERDRAW_THRESHOLD	1.05f															// Max ACMR growth accepted to cut overdraw.
+#define OPTIMIZER_FETCH_LINE_SIZE		64																// Bytes per line of the vertex fetch cache.
+#define OPTIMIZER_FETCH_LINE_COUNT		64
+#define OPTIMIZER_OVERDRAW_RESOLUTION	128																// Texels per side of the overdraw rasterizer.
+#define OPTIMIZER_CHECK_GRID_SIZE		32																// Quads per side of the SelfCheck() mesh.
+
+struct MeshOptimizerStats
+{
+	f32 acmr;																						// Cache misses per triangle (0.5 is ideal for grids, 3 is the worst).
+	f32 atvr;																						// Cache misses per vertex (1 is ideal).
+	f32 overdraw;																					// Shaded / covered pixels, averaged over 6 axis views.
+	f32 overfetch;																					// Bytes fetched / vertex buffer size.
+};
+
+namespace MeshOptimizer
+{
+	void				OptimizeSubmesh		(Submesh& submesh);											// All three passes, in order.
+	void				OptimizeMeshlets	(Submesh& submesh);											// Cache order inside each meshlet, after Meshlets::BuildMeshlets().
+	MeshOptimizerStats	AnalyzeSubmesh		(const Submesh& submesh);
+	bool				SelfCheck			();															// Cooker -check. Logs what failed.
+
+	// vertexStride is in floats and the position must be the first 3 floats of each vertex.
+	void OptimizeVertexCache	(std::vector<u32>& indices, u32 vertexCount);
+	void OptimizeOverdraw		(std::vector<u32>& indices, const f32* vertices, u32 vertexStride);
+	void OptimizeVertexFetch	(std::vector<f32>& vertices, u32 vertexStride, std::vector<u32>& indices);
+
+	namespace Utils
+	{
+		u32  SimulateCache			(const u32* indices, u32 indexCount, std::vector<u32>& cacheTimestamps, u32& timestamp);	// Returns the misses.
+		f32	 ComputeACMR			(const u32* indices, u32 indexCount, u32 vertexCount);
+		f32	 ComputeACMR			(const u32* indices, u32 indexCount, std::vector<u32>& cacheTimestamps, u32& timestamp);	// Flushes and reuses the cache.
+		void BuildHardBoundaries	(const std::vector<u32>& indices, u32 vertexCount, std::vector<u32>& clusters);
+		void BuildSoftBoundaries	(const std::vector<u32>& indices, u32 vertexCount, const std::vector<u32>& hardClusters, std::vector<u32>& clusters);
+
+		f32	 ComputeOverdraw		(const std::vector<u32>& indices, const f32* vertices, u32 vertexCount, u32 vertexStride);
+		f32	 ComputeOverfetch		(const std::vector<u32>& indices, u32 vertexCount, u32 vertexStrideBytes);
+	}
+}
+
+#endif // !__MESH_OPTIMIZER_H__
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include "mesh_simplifier.h"
+
+struct CollapseCandidate
+{
+	u32 from;
+	u32 to;
+	f64 cost;
+};
+
+f32 MeshSimplifier::Simplify(const f32* vertices, u32 vertexCount, u32 vertexStride, const u32* indices, u32 indexCount, u32 targetIndexCount, f32 maxError, std::vector<u32>& result)
+{
+	result.assign(indices, indices + indexCount);
+
+	if (indexCount <= targetIndexCount)
+	{
+		return 0.0f;
+	}
+
+	std::vector<vec3> positions(vertexCount);
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		positions[i] = vec3(vertices[i * vertexStride + 0], vertices[i * vertexStride + 1], vertices[i * vertexStride + 2]);
+	}
+
+	std::vector<u32> remap;
+	std::vector<u8>	 locked;
+	Utils::BuildPositionRemap(positions, remap);
+	Utils::BuildLockedVertices(remap, result, locked);
+
+	// QUADRICS (one per position, shared by all the vertices of a seam)
+	std::vector<Utils::Quadric> quadrics(vertexCount, Utils::Quadric{});
+	for (u32 i = 0; i < indexCount; i += 3)
+	{
+		const vec3& p0 = positions[result[i + 0]];
+		const vec3& p1 = positions[result[i + 1]];
+		const vec3& p2 = positions[result[i + 2]];
+
+		Utils::AddPlane(quadrics[remap[result[i + 0]]], p0, p1, p2);
+		Utils::AddPlane(quadrics[remap[result[i + 1]]], p0, p1, p2);
+		Utils::AddPlane(quadrics[remap[result[i + 2]]], p0, p1, p2);
+	}
+
+	const f64 maxCost	= (f64)maxError * (f64)maxError;
+	f64 resultCost		= 0.0;
+
+	std::vector<u32>				triangleOffsets(vertexCount + 1);
+	std::vector<u32>				triangleFill(vertexCount);
+	std::vector<u32>				triangleList;
+	std::vector<u32>				collapseTo(vertexCount);
+	std::vector<u8>					touched(vertexCount);
+	std::vector<CollapseCandidate>	candidates;
+
+	while (result.size() > targetIndexCount)
+	{
+		const u32 triangleCount = (u32)result.size() / 3;
+
+		// VERTEX -> TRIANGLE ADJACENCY
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+		for (u32 i = 0; i < result.size(); ++i)
+		{
+			++triangleOffsets[result[i] + 1];
+		}
+		for (u32 i = 0; i < vertexCount; ++i)
+		{
+			triangleOffsets[i + 1] += triangleOffsets[i];
+		}
+
+		triangleList.resize(result.size());
+		std::copy(triangleOffsets.begin(), triangleOffsets.end() - 1, triangleFill.begin());
+		for (u32 t = 0; t < triangleCount; ++t)
+		{
+			triangleList[triangleFill[result[t * 3 + 0]]++] = t;
+			triangleList[triangleFill[result[t * 3 + 1]]++] = t;
+			triangleList[triangleFill[result[t * 3 + 2]]++] = t;
+		}
+
+		// COLLAPSE CANDIDATES (both directions of every edge)
+		candidates.clear();
+		for (u32 t = 0; t < triangleCount; ++t)
+		{
+			for (u32 k = 0; k < 3; ++k)
+			{
+				const u32 a = result[t * 3 + k];
+				const u32 b = result[t * 3 + (k + 1) % 3];
+
+				Utils::Quadric edgeQuadric = quadrics[remap[a]];
+				Utils::AddQuadric(edgeQuadric, quadrics[remap[b]]);
+
+				if (!locked[a]) { candidates.push_back({ a, b, Utils::EvaluateQuadric(edgeQuadric, positions[b]) }); }
+				if (!locked[b]) { candidates.push_back({ b, a, Utils::EvaluateQuadric(edgeQuadric, positions[a]) }); }
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const CollapseCandidate& lhs, const CollapseCandidate& rhs) { return lhs.cost < rhs.cost; });
+
+		// GREEDY COLLAPSES (each vertex neighbourhood is modified at most once per pass)
+		std::iota(collapseTo.begin(), collapseTo.end(), 0u);
+		std::fill(touched.begin(), touched.end(), (u8)0);
+
+		u32 remainingIndices	= (u32)result.size();
+		u32 collapses			= 0;
+		for (u32 c = 0; c < candidates.size() && remainingIndices > targetIndexCount; ++c)
+		{
+			const CollapseCandidate& candidate = candidates[c];
+			if (candidate.cost > maxCost)
+			{
+				break;
+			}
+
+			if (touched[candidate.from] || touched[candidate.to])
+			{
+				continue;
+			}
+
+			const u32* fromTriangles	= &triangleList[triangleOffsets[candidate.from]];
+			const u32  fromCount		= triangleOffsets[candidate.from + 1] - triangleOffsets[candidate.from];
+			if (Utils::CollapseFlipsTriangle(positions, remap, result, fromTriangles, fromCount, candidate.from, candidate.to))
+			{
+				continue;
+			}
+
+			collapseTo[candidate.from] = candidate.to;
+			Utils::AddQuadric(quadrics[remap[candidate.to]], quadrics[remap[candidate.from]]);
+			resultCost = std::max(resultCost, candidate.cost);
+			++collapses;
+
+			for (u32 i = 0; i < fromCount; ++i)
+			{
+				const u32* triangle = &result[fromTriangles[i] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+
+				if (remap[triangle[0]] == remap[candidate.to] || remap[triangle[1]] == remap[candidate.to] || remap[triangle[2]] == remap[candidate.to])
+				{
+					remainingIndices -= 3;
+				}
+			}
+		}
+
+		if (collapses == 0)
+		{
+			break;
+		}
+
+		// APPLY & DROP DEGENERATE TRIANGLES
+		u32 write = 0;
+		for (u32 t = 0; t < triangleCount; ++t)
+		{
+			const u32 a = collapseTo[result[t * 3 + 0]];
+			const u32 b = collapseTo[result[t * 3 + 1]];
+			const u32 c = collapseTo[result[t * 3 + 2]];
+
+			if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+			{
+				continue;
+			}
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	return (f32)sqrt(resultCost);
+}
+
+// UTILS -------------------------------------------------------------------
+void MeshSimplifier::Utils::AddPlane(Quadric& quadric, const vec3& p0, const vec3& p1, const vec3& p2)
+{
+	vec3 normal	= glm::cross(p1 - p0, p2 - p0);
+	f32 length	= glm::length(normal);
+	if (length == 0.0f)
+	{
+		return;
+	}
+
+	normal /= length;
+
+	const f64 a = normal.x;
+	const f64 b = normal.y;
+	const f64 c = normal.z;
+	const f64 d = -glm::dot(normal, p0);
+
+	quadric.a2 += a * a; quadric.ab += a * b; quadric.ac += a * c; quadric.ad += a * d;
+	quadric.b2 += b * b; quadric.bc += b * c; quadric.bd += b * d;
+	quadric.c2 += c * c; quadric.cd += c * d;
+	quadric.d2 += d * d;
+	quadric.weight += 1.0;
+}
+
+void MeshSimplifier::Utils::AddQuadric(Quadric& quadric, const Quadric& other)
+{
+	quadric.a2 += other.a2; quadric.ab += other.ab; quadric.ac += other.ac; quadric.ad += other.ad;
+	quadric.b2 += other.b2; quadric.bc += other.bc; quadric.bd += other.bd;
+	quadric.c2 += other.c2; quadric.cd += other.cd;
+	quadric.d2 += other.d2;
+	quadric.weight += other.weight;
+}
+
+// Mean squared distance from point to the planes accumulated in the quadric.
+f64 MeshSimplifier::Utils::EvaluateQuadric(const Quadric& q, const vec3& point)
+{
+	const f64 x = point.x;
+	const f64 y = point.y;
+	const f64 z = point.z;
+
+	f64 cost = q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+			 + q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+			 + q.c2 * z * z + 2.0 * q.cd * z
+			 + q.d2;
+
+	return (q.weight > 0.0) ? std::max(cost, 0.0) / q.weight : 0.0;
+}
+
+// remap[i] is the lowest index of the vertices that share the position of vertex i.
+void MeshSimplifier::Utils::BuildPositionRemap(const std::vector<vec3>& positions, std::vector<u32>& remap)
+{
+	std::vector<u32> order(positions.size());
+	std::iota(order.begin(), order.end(), 0u);
+
+	std::sort(order.begin(), order.end(), [&positions](u32 lhs, u32 rhs)
+	{
+		const vec3& a = positions[lhs];
+		const vec3& b = positions[rhs];
+		if (a.x != b.x) { return a.x < b.x; }
+		if (a.y != b.y) { return a.y < b.y; }
+		if (a.z != b.z) { return a.z < b.z; }
+		return lhs < rhs;
+	});
+
+	remap.resize(positions.size());
+	for (u32 i = 0; i < order.size(); ++i)
+	{
+		const bool sameAsPrevious = (i > 0 && positions[order[i]] == positions[order[i - 1]]);
+		remap[order[i]] = sameAsPrevious ? remap[order[i - 1]] : order[i];
+	}
+}
+
+// Locks the vertices on attribute seams and on open or non-manifold edges.
+void MeshSimplifier::Utils::BuildLockedVertices(const std::vector<u32>& remap, const std::vector<u32>& indices, std::vector<u8>& locked)
+{
+	const u32 vertexCount = (u32)remap.size();
+
+	std::vector<u8>	 used(vertexCount, 0);
+	std::vector<u32> groupSize(vertexCount, 0);
+	std::vector<u8>	 lockedGroup(vertexCount, 0);
+
+	for (u32 i = 0; i < indices.size(); ++i)
+	{
+		if (!used[indices[i]])
+		{
+			used[indices[i]] = 1;
+			++groupSize[remap[indices[i]]];
+		}
+	}
+
+	std::unordered_map<u64, u32> edgeCount;
+	edgeCount.reserve(indices.size());
+	for (u32 i = 0; i < indices.size(); ++i)
+	{
+		u32 a = remap[indices[i]];
+		u32 b = remap[indices[(i % 3 == 2) ? i - 2 : i + 1]];
+		++edgeCount[((u64)std::min(a, b) << 32) | (u64)std::max(a, b)];
+	}
+
+	for (const std::pair<const u64, u32>& edge : edgeCount)
+	{
+		if (edge.second != 2)
+		{
+			lockedGroup[(u32)(edge.first >> 32)]		= 1;
+			lockedGroup[(u32)(edge.first & 0xFFFFFFFF)]	= 1;
+		}
+	}
+
+	locked.resize(vertexCount);
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		locked[i] = (groupSize[remap[i]] > 1 || lockedGroup[remap[i]]) ? 1 : 0;
+	}
+}
+
+// Moving from onto to must not turn any of the remaining triangles around from upside down.
+bool MeshSimplifier::Utils::CollapseFlipsTriangle(const std::vector<vec3>& positions, const std::vector<u32>& remap, const std::vector<u32>& indices,
+												  const u32* triangles, u32 triangleCount, u32 from, u32 to)
+{
+	for (u32 i = 0; i < triangleCount; ++i)
+	{
+		const u32* triangle = &indices[triangles[i] * 3];
+
+		if (remap[triangle[0]] == remap[to] || remap[triangle[1]] == remap[to] || remap[triangle[2]] == remap[to])
+		{
+			continue;																			// Collapses into a degenerate triangle.
+		}
+
+		vec3 p[3]		= { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+		vec3 oldNormal	= glm::cross(p[1] - p[0], p[2] - p[0]);
+
+		for (u32 k = 0; k < 3; ++k)
+		{
+			if (triangle[k] == from)
+			{
+				p[k] = positions[to];
+			}
+		}
+
+		vec3 newNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+		if (glm::dot(oldNormal, newNormal) <= 0.0f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
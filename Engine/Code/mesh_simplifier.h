@@ -0,0 +1,43 @@
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+// mesh_simplifier.h:
+// Quadric error metric simplification through half-edge collapses. Vertices are never moved or created, so every LOD
+// is just a new index list over the original vertex buffer. Vertices on UV/normal seams (same position, different
+// attributes) and on open borders are locked, which keeps the seams and silhouettes of the source mesh intact.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+
+namespace MeshSimplifier
+{
+	// vertexStride is in floats and the position must be the first 3 floats of each vertex.
+	// Returns the geometric error (in model units) of the simplified index list written to result.
+	f32 Simplify(const f32* vertices, u32 vertexCount, u32 vertexStride, const u32* indices, u32 indexCount, u32 targetIndexCount, f32 maxError, std::vector<u32>& result);
+
+	namespace Utils
+	{
+		struct Quadric
+		{
+			f64 a2, ab, ac, ad;																	// Upper triangle of the symmetric 4x4 plane quadric.
+			f64 b2, bc, bd;
+			f64 c2, cd;
+			f64 d2;
+			f64 weight;																			// Planes accumulated, so the error is a mean.
+		};
+
+		void AddPlane				(Quadric& quadric, const vec3& p0, const vec3& p1, const vec3& p2);
+		void AddQuadric				(Quadric& quadric, const Quadric& other);
+		f64	 EvaluateQuadric		(const Quadric& quadric, const vec3& point);
+
+		void BuildPositionRemap		(const std::vector<vec3>& positions, std::vector<u32>& remap);
+		void BuildLockedVertices	(const std::vector<u32>& remap, const std::vector<u32>& indices, std::vector<u8>& locked);
+
+		bool CollapseFlipsTriangle	(const std::vector<vec3>& positions, const std::vector<u32>& remap, const std::vector<u32>& indices,
+									 const u32* triangles, u32 triangleCount, u32 from, u32 to);
+	}
+}
+
+#endif // !__MESH_SIMPLIFIER_H__
\ No newline at end of file
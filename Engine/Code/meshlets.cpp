@@ -0,0 +1,306 @@
+#include <float.h>
+
+#include "globals.h"
+#include "app.h"
+#include "buffer_manager.h"
+
+#include "meshlets.h"
+
+void Meshlets::Init(App* app)
+{
+	MeshletDrawList& drawList = app->meshletDraws;
+
+	drawList.totalMeshlets		= 0;
+	drawList.visibleMeshlets	= 0;
+	drawList.indirectBuffer		= BufferManager::CreateBuffer(sizeof(DrawElementsIndirectCommand) * 1024, GL_DRAW_INDIRECT_BUFFER, GL_STREAM_DRAW);
+}
+
+// Greedy partition: each meshlet grows from a seed triangle by adding the adjacent triangle that brings in the fewest
+// new vertices, until it runs out of vertices or triangles. The next seed is taken from the previous meshlet's border,
+// which keeps consecutive meshlets spatially close.
+void Meshlets::BuildMeshlets(Submesh& submesh)
+{
+	const u32 vertexStride	= submesh.VBL.stride / sizeof(float);
+	const u32 vertexCount	= (u32)submesh.vertices.size() / vertexStride;
+	const u32 triangleCount	= (u32)submesh.indices.size() / 3;
+
+	submesh.meshlets.clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	std::vector<vec3> positions(vertexCount);
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		positions[i] = vec3(submesh.vertices[i * vertexStride + 0], submesh.vertices[i * vertexStride + 1], submesh.vertices[i * vertexStride + 2]);
+	}
+
+	// VERTEX -> TRIANGLE ADJACENCY
+	std::vector<u32> triangleOffsets(vertexCount + 1, 0);
+	std::vector<u32> triangleList(triangleCount * 3);
+	for (u32 i = 0; i < submesh.indices.size(); ++i)
+	{
+		++triangleOffsets[submesh.indices[i] + 1];
+	}
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		triangleOffsets[i + 1] += triangleOffsets[i];
+	}
+
+	std::vector<u32> triangleFill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (u32 t = 0; t < triangleCount; ++t)
+	{
+		triangleList[triangleFill[submesh.indices[t * 3 + 0]]++] = t;
+		triangleList[triangleFill[submesh.indices[t * 3 + 1]]++] = t;
+		triangleList[triangleFill[submesh.indices[t * 3 + 2]]++] = t;
+	}
+
+	// PARTITION
+	std::vector<u32> vertexMeshlet(vertexCount, UINT32_MAX);										// Last meshlet that used each vertex.
+	std::vector<u8>	 emitted(triangleCount, 0);
+	std::vector<u32> candidates;
+	std::vector<u32> reordered;
+	reordered.reserve(submesh.indices.size());
+
+	u32 seedCursor = 0;
+	while (reordered.size() < submesh.indices.size())
+	{
+		const u32 meshletIdx = (u32)submesh.meshlets.size();
+
+		u32 seed = UINT32_MAX;
+		for (u32 c = 0; c < candidates.size() && seed == UINT32_MAX; ++c)
+		{
+			seed = (!emitted[candidates[c]]) ? candidates[c] : UINT32_MAX;
+		}
+		while (seed == UINT32_MAX)
+		{
+			seed = (!emitted[seedCursor]) ? seedCursor : UINT32_MAX;
+			++seedCursor;
+		}
+
+		Meshlet meshlet		= {};
+		meshlet.firstIndex	= (u32)reordered.size();
+
+		u32 meshletVertices	= 0;
+		candidates.clear();
+
+		for (u32 triangle = seed; triangle != UINT32_MAX; )
+		{
+			const u32* tri = &submesh.indices[triangle * 3];
+			for (u32 k = 0; k < 3; ++k)
+			{
+				if (vertexMeshlet[tri[k]] != meshletIdx)
+				{
+					vertexMeshlet[tri[k]] = meshletIdx;
+					++meshletVertices;
+
+					candidates.insert(candidates.end(), &triangleList[triangleOffsets[tri[k]]], &triangleList[triangleOffsets[tri[k] + 1]]);
+				}
+			}
+
+			reordered.insert(reordered.end(), tri, tri + 3);
+			emitted[triangle] = 1;
+			meshlet.indexCount += 3;
+
+			if (meshlet.indexCount == MESHLET_MAX_TRIANGLES * 3)
+			{
+				break;
+			}
+
+			// NEXT TRIANGLE (fewest new vertices, drops the emitted candidates along the way)
+			triangle		= UINT32_MAX;
+			u32 bestNew		= 4;
+			u32 write		= 0;
+			for (u32 c = 0; c < candidates.size(); ++c)
+			{
+				const u32 candidate = candidates[c];
+				if (emitted[candidate])
+				{
+					continue;
+				}
+
+				candidates[write++] = candidate;
+
+				const u32* candidateTri = &submesh.indices[candidate * 3];
+				const u32 newVertices	= (vertexMeshlet[candidateTri[0]] != meshletIdx) + (vertexMeshlet[candidateTri[1]] != meshletIdx) + (vertexMeshlet[candidateTri[2]] != meshletIdx);
+				if (newVertices < bestNew && meshletVertices + newVertices <= MESHLET_MAX_VERTICES)
+				{
+					bestNew		= newVertices;
+					triangle	= candidate;
+				}
+			}
+
+			candidates.resize(write);
+		}
+
+		Utils::ComputeMeshletBounds(positions, &reordered[meshlet.firstIndex], meshlet.indexCount, meshlet);
+		submesh.meshlets.push_back(meshlet);
+	}
+
+	submesh.indices.swap(reordered);
+}
+
+void Meshlets::CullMeshlets(App* app)
+{
+	MeshletDrawList& drawList = app->meshletDraws;
+	drawList.commands.clear();
+	drawList.ranges.clear();
+	drawList.entityFirstRange.clear();
+	drawList.totalMeshlets		= 0;
+	drawList.visibleMeshlets	= 0;
+
+	const vec3				cameraPos	= app->camera.GetPosition();
+	const Culling::Frustum	frustum		= Culling::ExtractFrustum(app->camera.GetProjMatrix() * app->camera.GetViewMatrix());
+
+	for (u32 i = 0; i < app->entities.size(); ++i)
+	{
+		const Entity& entity	= app->entities[i];
+		const Model& model		= app->models[entity.modelIndex];
+		const Mesh& mesh		= app->meshes[model.meshIdx];
+
+		const mat4& worldMatrix		= entity.worldMatrix;
+		const f32	worldScale		= glm::max(glm::length(vec3(worldMatrix[0])), glm::max(glm::length(vec3(worldMatrix[1])), glm::length(vec3(worldMatrix[2]))));
+		const vec3	modelCameraPos	= vec3(glm::inverse(worldMatrix) * vec4(cameraPos, 1.0f));
+
+		drawList.entityFirstRange.push_back((u32)drawList.ranges.size());
+		for (u32 s = 0; s < mesh.submeshes.size(); ++s)
+		{
+			const Submesh& submesh = mesh.submeshes[s];
+
+			MeshletDrawRange range	= {};
+			range.firstCommand		= (u32)drawList.commands.size();
+			range.culled			= (!entity.isHidden && !entity.isImpostor && entity.lodLevel == 0 && !submesh.meshlets.empty());
+
+			if (range.culled)
+			{
+				for (u32 m = 0; m < submesh.meshlets.size(); ++m)
+				{
+					const Meshlet& meshlet = submesh.meshlets[m];
+					if (!Utils::MeshletIsVisible(meshlet, worldMatrix, worldScale, modelCameraPos, frustum))
+					{
+						continue;
+					}
+
+					DrawElementsIndirectCommand command	= {};
+					command.count			= meshlet.indexCount;
+					command.instanceCount	= 1;
+					command.firstIndex		= submesh.indexOffset / submesh.GetIndexSize() + meshlet.firstIndex;
+					drawList.commands.push_back(command);
+
+					range.triangleCount += meshlet.indexCount / 3;
+				}
+
+				range.commandCount = (u32)drawList.commands.size() - range.firstCommand;
+
+				drawList.totalMeshlets		+= (u32)submesh.meshlets.size();
+				drawList.visibleMeshlets	+= range.commandCount;
+			}
+
+			drawList.ranges.push_back(range);
+		}
+	}
+
+	if (!drawList.commands.empty())
+	{
+		BufferManager::UploadData(drawList.indirectBuffer, drawList.commands.data(), (u32)(drawList.commands.size() * sizeof(DrawElementsIndirectCommand)));
+	}
+}
+
+const MeshletDrawRange& Meshlets::GetDrawRange(const App* app, u32 entityIdx, u32 submeshIdx)
+{
+	return app->meshletDraws.ranges[app->meshletDraws.entityFirstRange[entityIdx] + submeshIdx];
+}
+
+// UTILS -------------------------------------------------------------------
+// The cone apex is pushed back along the axis until every triangle lies in front of it, so the back-facing test
+// stays conservative for cameras close to the meshlet.
+void Meshlets::Utils::ComputeMeshletBounds(const std::vector<vec3>& positions, const u32* indices, u32 indexCount, Meshlet& meshlet)
+{
+	vec3 aabbMin = vec3( FLT_MAX);
+	vec3 aabbMax = vec3(-FLT_MAX);
+	vec3 normalSum = vec3(0.0f);
+
+	for (u32 i = 0; i < indexCount; i += 3)
+	{
+		const vec3& p0 = positions[indices[i + 0]];
+		const vec3& p1 = positions[indices[i + 1]];
+		const vec3& p2 = positions[indices[i + 2]];
+
+		aabbMin = glm::min(aabbMin, glm::min(p0, glm::min(p1, p2)));
+		aabbMax = glm::max(aabbMax, glm::max(p0, glm::max(p1, p2)));
+
+		vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		f32 length	= glm::length(normal);
+		normalSum  += (length > 0.0f) ? normal / length : vec3(0.0f);
+	}
+
+	meshlet.center = (aabbMin + aabbMax) * 0.5f;
+	meshlet.radius = 0.0f;
+	for (u32 i = 0; i < indexCount; ++i)
+	{
+		meshlet.radius = glm::max(meshlet.radius, glm::length(positions[indices[i]] - meshlet.center));
+	}
+
+	meshlet.coneApex	= meshlet.center;
+	meshlet.coneAxis	= vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff	= 1.0f;
+
+	f32 axisLength = glm::length(normalSum);
+	if (axisLength == 0.0f)
+	{
+		return;
+	}
+
+	const vec3 axis	= normalSum / axisLength;
+	f32 minDot		= 1.0f;
+	for (u32 i = 0; i < indexCount; i += 3)
+	{
+		const vec3& p0 = positions[indices[i + 0]];
+		vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+		f32 length	= glm::length(normal);
+		if (length > 0.0f)
+		{
+			minDot = glm::min(minDot, glm::dot(axis, normal / length));
+		}
+	}
+
+	if (minDot <= 0.1f)																				// Wider than ~84 degrees, never fully back-facing.
+	{
+		return;
+	}
+
+	f32 maxT = 0.0f;
+	for (u32 i = 0; i < indexCount; i += 3)
+	{
+		const vec3& p0 = positions[indices[i + 0]];
+		vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+		f32 length	= glm::length(normal);
+		if (length > 0.0f)
+		{
+			normal /= length;
+			maxT = glm::max(maxT, glm::dot(meshlet.center - p0, normal) / glm::dot(axis, normal));
+		}
+	}
+
+	meshlet.coneApex	= meshlet.center - axis * maxT;
+	meshlet.coneAxis	= axis;
+	meshlet.coneCutoff	= sqrtf(1.0f - minDot * minDot);
+}
+
+// The cone test runs in model space, which is exact for the uniformly scaled entities of the scene.
+bool Meshlets::Utils::MeshletIsVisible(const Meshlet& meshlet, const mat4& worldMatrix, f32 worldScale, const vec3& modelCameraPos, const Culling::Frustum& frustum)
+{
+	if (meshlet.coneCutoff < 1.0f)
+	{
+		vec3 toApex = meshlet.coneApex - modelCameraPos;
+		f32 length	= glm::length(toApex);
+		if (length > 0.0f && glm::dot(toApex / length, meshlet.coneAxis) >= meshlet.coneCutoff)
+		{
+			return false;
+		}
+	}
+
+	const vec3 worldCenter = vec3(worldMatrix * vec4(meshlet.center, 1.0f));
+	return Culling::SphereInFrustum(frustum, worldCenter, meshlet.radius * worldScale);
+}
\ No newline at end of file
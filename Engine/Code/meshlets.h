@@ -0,0 +1,57 @@
+#ifndef __MESHLETS_H__
+#define __MESHLETS_H__
+
+// meshlets.h:
+// Splits the full resolution submeshes in small triangle clusters with their own bounding sphere and normal cone, so
+// the geometry pass can reject off-screen and back-facing parts of a mesh instead of whole objects. The surviving
+// meshlets of every entity are emitted as indirect draw commands and drawn with glMultiDrawElementsIndirect().
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+#include "culling.h"
+
+struct App;
+
+#define MESHLET_MAX_VERTICES	64
+#define MESHLET_MAX_TRIANGLES	124
+
+struct MeshletDrawRange
+{
+	u32 firstCommand;
+	u32 commandCount;
+	u32 triangleCount;
+	bool culled;																					// False when the submesh is drawn without meshlets.
+};
+
+struct MeshletDrawList
+{
+	std::vector<DrawElementsIndirectCommand>	commands;
+	std::vector<MeshletDrawRange>				ranges;											// One per entity submesh.
+	std::vector<u32>							entityFirstRange;
+
+	u32											totalMeshlets;
+	u32											visibleMeshlets;
+
+	Buffer										indirectBuffer;
+};
+
+namespace Meshlets
+{
+	void Init				(App* app);
+
+	void BuildMeshlets		(Submesh& submesh);													// Reorders submesh.indices meshlet by meshlet.
+	void CullMeshlets		(App* app);															// Fills and uploads the indirect draws of the frame.
+
+	const MeshletDrawRange& GetDrawRange(const App* app, u32 entityIdx, u32 submeshIdx);
+
+	namespace Utils
+	{
+		void ComputeMeshletBounds	(const std::vector<vec3>& positions, const u32* indices, u32 indexCount, Meshlet& meshlet);
+		bool MeshletIsVisible		(const Meshlet& meshlet, const mat4& worldMatrix, f32 worldScale, const vec3& modelCameraPos, const Culling::Frustum& frustum);
+	}
+}
+
+#endif // !__MESHLETS_H__
\ No newline at end of file
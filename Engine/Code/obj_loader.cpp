@@ -0,0 +1,692 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#include "globals.h"
+#include "file_manager.h"
+#include "job_system.h"
+#include "vertex_format.h"
+
+#include "obj_loader.h"
+
+struct ObjVertexKey																						// A welded vertex: its global attribute indices.
+{
+	u32 position;
+	u32 texCoord;
+	u32 normal;
+
+	bool operator==(const ObjVertexKey& other) const { return position == other.position && texCoord == other.texCoord && normal == other.normal; }
+};
+
+struct ObjVertexKeyHash
+{
+	size_t operator()(const ObjVertexKey& key) const
+	{
+		u64 hash = (u64)key.position * 0x9E3779B97F4A7C15ull;
+		hash = (hash ^ key.texCoord) * 0xC2B2AE3D27D4EB4Full;
+		hash = (hash ^ key.normal) * 0x165667B19E3779F9ull;
+		return (size_t)(hash ^ (hash >> 32));
+	}
+};
+
+static bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* SkipSpaces(const char* cursor, const char* end)
+{
+	while (cursor < end && IsSpace(*cursor)) { ++cursor; }
+	return cursor;
+}
+
+static bool StartsWith(const char* cursor, const char* end, const char* statement)							// Followed by a space.
+{
+	const size_t length = strlen(statement);
+	return (size_t)(end - cursor) > length && memcmp(cursor, statement, length) == 0 && IsSpace(cursor[length]);
+}
+
+bool ObjLoader::Load(const char* filepath, ObjModel& model)
+{
+	model = {};
+
+	MappedFile file = {};
+	if (!FileManager::MapFile(filepath, file))
+	{
+		ELOG("Could not open OBJ file %s", filepath);
+		return false;
+	}
+
+	// CHUNKS
+	const char* data	= (const char*)file.data;
+	const char* fileEnd	= data + file.size;
+
+	std::vector<ObjChunk> chunks;
+	for (const char* cursor = data; cursor < fileEnd;)
+	{
+		const char* chunkEnd	= (fileEnd - cursor > OBJ_LOADER_CHUNK_SIZE) ? cursor + OBJ_LOADER_CHUNK_SIZE : fileEnd;
+		const char* lineBreak	= (const char*)memchr(chunkEnd, '\n', fileEnd - chunkEnd);
+		chunkEnd				= (lineBreak != nullptr) ? lineBreak + 1 : fileEnd;
+
+		chunks.emplace_back();
+		chunks.back().begin	= cursor;
+		chunks.back().end	= chunkEnd;
+		cursor				= chunkEnd;
+	}
+
+	JobSystem::ParallelFor((u32)chunks.size(), 1, [&chunks](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			Utils::ParseChunk(chunks[i]);
+		}
+	});
+
+	for (u32 i = 0; i < chunks.size(); ++i)
+	{
+		if (chunks[i].errorLine != 0)
+		{
+			u32 line = chunks[i].errorLine;
+			for (const char* cursor = data; cursor < chunks[i].begin; ++cursor) { line += (*cursor == '\n') ? 1 : 0; }
+
+			ELOG("Could not parse %s: line %u", filepath, line);
+			FileManager::UnmapFile(file);
+			return false;
+		}
+	}
+
+	// MERGE
+	ObjAttributes attributes;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.firstPosition	= (u32)attributes.positions.size();
+		chunk.firstTexCoord	= (u32)attributes.texCoords.size();
+		chunk.firstNormal	= (u32)attributes.normals.size();
+
+		attributes.positions.insert(attributes.positions.end(), chunk.positions.begin(), chunk.positions.end());
+		attributes.texCoords.insert(attributes.texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		attributes.normals.insert(attributes.normals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
+
+	// MATERIALS
+	const std::string path		= filepath;
+	const size_t separator		= path.find_last_of("/\\");
+	const std::string directory	= (separator != std::string::npos) ? path.substr(0, separator + 1) : std::string();
+
+	std::vector<std::string> libraries;
+	for (const ObjChunk& chunk : chunks)
+	{
+		for (const std::string& library : chunk.libraries)
+		{
+			if (std::find(libraries.begin(), libraries.end(), library) == libraries.end())
+			{
+				libraries.push_back(library);
+				Utils::LoadMaterials(directory + library, model.materials);
+			}
+		}
+	}
+
+	std::unordered_map<std::string, u32> materialLookup;
+	for (u32 i = 0; i < model.materials.size(); ++i)
+	{
+		materialLookup.emplace(model.materials[i].name, i);												// The first definition wins.
+	}
+
+	// FACES BY MATERIAL (the last slot is for the faces without one)
+	const u32 defaultMaterial = (u32)model.materials.size();
+	std::vector<std::vector<ObjFaceRange>> materialFaces(defaultMaterial + 1);
+
+	u32 currentMaterial = defaultMaterial;
+	for (u32 c = 0; c < chunks.size(); ++c)
+	{
+		const ObjChunk& chunk	= chunks[c];
+		const u32 faceCount		= (u32)chunk.faceCorners.size() - 1u;
+
+		u32 firstFace = 0;
+		for (const ObjMaterialRun& run : chunk.runs)
+		{
+			if (run.firstFace > firstFace)
+			{
+				materialFaces[currentMaterial].push_back({ c, firstFace, run.firstFace });
+			}
+
+			auto item		= materialLookup.find(run.material);
+			currentMaterial	= (item != materialLookup.end()) ? item->second : defaultMaterial;
+			firstFace		= run.firstFace;
+		}
+
+		if (faceCount > firstFace)
+		{
+			materialFaces[currentMaterial].push_back({ c, firstFace, faceCount });
+		}
+	}
+
+	if (!materialFaces[defaultMaterial].empty())
+	{
+		ObjMaterial material	= {};
+		material.name			= "DefaultMaterial";
+		material.diffuse		= vec3(0.6f);
+		model.materials.push_back(material);
+	}
+
+	// SUBMESHES
+	std::vector<u32> usedMaterials;
+	for (u32 i = 0; i < materialFaces.size(); ++i)
+	{
+		if (!materialFaces[i].empty())
+		{
+			usedMaterials.push_back(i);
+		}
+	}
+
+	std::vector<Submesh> submeshes(usedMaterials.size());
+	std::atomic<bool> failed(false);
+	JobSystem::ParallelFor((u32)usedMaterials.size(), 1, [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			if (!Utils::BuildSubmesh(attributes, chunks, materialFaces[usedMaterials[i]], submeshes[i]))
+			{
+				failed = true;
+			}
+		}
+	});
+
+	FileManager::UnmapFile(file);
+
+	if (failed)
+	{
+		ELOG("Could not load %s: a face references a vertex that does not exist", filepath);
+		return false;
+	}
+
+	for (u32 i = 0; i < submeshes.size(); ++i)
+	{
+		if (!submeshes[i].indices.empty())
+		{
+			model.submeshes.push_back(std::move(submeshes[i]));
+			model.submeshMaterials.push_back(usedMaterials[i]);
+		}
+	}
+
+	ILOG("Loaded %s: %u chunks, %u positions, %u submeshes", filepath, (u32)chunks.size(), (u32)attributes.positions.size(), (u32)model.submeshes.size());
+
+	return !model.submeshes.empty();
+}
+
+bool ObjLoader::IsObjFile(const char* filepath)
+{
+	const char* dot = strrchr(filepath, '.');
+	return dot != nullptr && (strcmp(dot, ".obj") == 0 || strcmp(dot, ".OBJ") == 0);
+}
+
+// UTILS -------------------------------------------------------------------
+void ObjLoader::Utils::ParseChunk(ObjChunk& chunk)
+{
+	chunk.faceCorners.push_back(0);
+	chunk.errorLine = 0;
+
+	u32 line = 0;
+	for (const char* cursor = chunk.begin; cursor < chunk.end;)
+	{
+		++line;
+		const char* lineEnd	= (const char*)memchr(cursor, '\n', chunk.end - cursor);
+		lineEnd				= (lineEnd != nullptr) ? lineEnd : chunk.end;
+		const char* c		= SkipSpaces(cursor, lineEnd);
+		cursor				= lineEnd + 1;
+
+		bool parsed = true;
+		if (StartsWith(c, lineEnd, "v"))
+		{
+			vec3 position = vec3(0.0f);
+			const char* next = c + 1;
+			for (u32 i = 0; i < 3 && next != nullptr; ++i) { next = ParseFloat(next, lineEnd, position[i]); }
+			parsed = (next != nullptr);
+			chunk.positions.push_back(position);
+		}
+		else if (StartsWith(c, lineEnd, "vt"))
+		{
+			vec2 texCoord		= vec2(0.0f);
+			const char* next	= ParseFloat(c + 2, lineEnd, texCoord.x);
+			parsed				= (next != nullptr);
+			if (parsed && SkipSpaces(next, lineEnd) < lineEnd)													// v is optional.
+			{
+				parsed = (ParseFloat(next, lineEnd, texCoord.y) != nullptr);
+			}
+			chunk.texCoords.push_back(texCoord);
+		}
+		else if (StartsWith(c, lineEnd, "vn"))
+		{
+			vec3 normal = vec3(0.0f);
+			const char* next = c + 2;
+			for (u32 i = 0; i < 3 && next != nullptr; ++i) { next = ParseFloat(next, lineEnd, normal[i]); }
+			parsed = (next != nullptr);
+			chunk.normals.push_back(normal);
+		}
+		else if (StartsWith(c, lineEnd, "f"))
+		{
+			const char* next = SkipSpaces(c + 1, lineEnd);
+			while (next != nullptr && next < lineEnd && *next != '#')
+			{
+				ObjCorner corner	= {};
+				next				= ParseCorner(next, lineEnd, chunk, corner);
+				if (next != nullptr && next < lineEnd && !IsSpace(*next))
+				{
+					next = nullptr;																			// Garbage after the corner.
+				}
+
+				if (next != nullptr)
+				{
+					chunk.corners.push_back(corner);
+					next = SkipSpaces(next, lineEnd);
+				}
+			}
+			parsed = (next != nullptr);
+			chunk.faceCorners.push_back((u32)chunk.corners.size());
+		}
+		else if (StartsWith(c, lineEnd, "usemtl"))
+		{
+			chunk.runs.push_back({ (u32)chunk.faceCorners.size() - 1u, ParseName(c + 6, lineEnd) });
+		}
+		else if (StartsWith(c, lineEnd, "mtllib"))
+		{
+			chunk.libraries.push_back(ParseName(c + 6, lineEnd));
+		}
+
+		if (!parsed)
+		{
+			chunk.errorLine = line;
+			return;
+		}
+	}
+}
+
+// A missing or broken library leaves its materials out, their faces get the default one.
+bool ObjLoader::Utils::LoadMaterials(const std::string& filepath, std::vector<ObjMaterial>& materials)
+{
+	MappedFile file = {};
+	if (!FileManager::MapFile(filepath.c_str(), file))
+	{
+		ELOG("Could not open material library %s", filepath.c_str());
+		return false;
+	}
+
+	auto ParseColor = [](const char* cursor, const char* end, vec3& color)
+	{
+		vec3 value = vec3(0.0f);
+		for (u32 i = 0; i < 3 && cursor != nullptr; ++i) { cursor = ParseFloat(cursor, end, value[i]); }
+		color = (cursor != nullptr) ? value : color;
+	};
+
+	auto ParseMap = [](const char* cursor, const char* end)												// The file is the last token, after the options.
+	{
+		const std::string line	= ParseName(cursor, end);
+		const size_t space		= line.find_last_of(" \t");
+		return (space != std::string::npos) ? line.substr(space + 1) : line;
+	};
+
+	const char* end = (const char*)file.data + file.size;
+	for (const char* cursor = (const char*)file.data; cursor < end;)
+	{
+		const char* lineEnd	= (const char*)memchr(cursor, '\n', end - cursor);
+		lineEnd				= (lineEnd != nullptr) ? lineEnd : end;
+		const char* c		= SkipSpaces(cursor, lineEnd);
+		cursor				= lineEnd + 1;
+
+		if (StartsWith(c, lineEnd, "newmtl"))
+		{
+			ObjMaterial material	= {};
+			material.name			= ParseName(c + 6, lineEnd);
+			material.diffuse		= vec3(0.6f);															// Same default as Assimp.
+			materials.push_back(material);
+			continue;
+		}
+
+		if (materials.empty())
+		{
+			continue;
+		}
+
+		ObjMaterial& material = materials.back();
+		if		(StartsWith(c, lineEnd, "Kd"))			{ ParseColor(c + 2, lineEnd, material.diffuse); }
+		else if (StartsWith(c, lineEnd, "Ke"))			{ ParseColor(c + 2, lineEnd, material.emissive); }
+		else if (StartsWith(c, lineEnd, "Ks"))			{ ParseColor(c + 2, lineEnd, material.specular); }
+		else if (StartsWith(c, lineEnd, "Ns"))			{ ParseFloat(c + 2, lineEnd, material.shininess); }
+		else if (StartsWith(c, lineEnd, "map_Kd"))		{ material.diffuseMap	= ParseMap(c + 6, lineEnd); }
+		else if (StartsWith(c, lineEnd, "map_Ke"))		{ material.emissiveMap	= ParseMap(c + 6, lineEnd); }
+		else if (StartsWith(c, lineEnd, "map_Ks"))		{ material.specularMap	= ParseMap(c + 6, lineEnd); }
+		else if (StartsWith(c, lineEnd, "norm"))		{ material.normalMap	= ParseMap(c + 4, lineEnd); }
+		else if (StartsWith(c, lineEnd, "map_Kn"))		{ material.normalMap	= ParseMap(c + 6, lineEnd); }
+		else if (StartsWith(c, lineEnd, "bump"))		{ material.bumpMap		= ParseMap(c + 4, lineEnd); }
+		else if (StartsWith(c, lineEnd, "map_bump"))	{ material.bumpMap		= ParseMap(c + 8, lineEnd); }
+		else if (StartsWith(c, lineEnd, "map_Bump"))	{ material.bumpMap		= ParseMap(c + 8, lineEnd); }
+	}
+
+	FileManager::UnmapFile(file);
+	return true;
+}
+
+// Welds the corners of the faces, then fills the normals (smoothed per position when the faces lack some) and the
+// tangent space the same way ProcessAssimpMesh() lays them out.
+bool ObjLoader::Utils::BuildSubmesh(const ObjAttributes& attributes, const std::vector<ObjChunk>& chunks, const std::vector<ObjFaceRange>& faces, Submesh& submesh)
+{
+	bool hasTexCoords	= false;
+	bool hasNormals		= true;
+	u32 cornerCount		= 0;
+	for (const ObjFaceRange& range : faces)
+	{
+		const ObjChunk& chunk = chunks[range.chunk];
+		for (u32 i = chunk.faceCorners[range.firstFace]; i < chunk.faceCorners[range.endFace]; ++i)
+		{
+			hasTexCoords	= hasTexCoords || chunk.corners[i].indices[1] != OBJ_LOADER_MISSING;
+			hasNormals		= hasNormals && chunk.corners[i].indices[2] != OBJ_LOADER_MISSING;
+		}
+		cornerCount += chunk.faceCorners[range.endFace] - chunk.faceCorners[range.firstFace];
+	}
+
+	// WELDING
+	std::unordered_map<ObjVertexKey, u32, ObjVertexKeyHash> vertexLookup;
+	vertexLookup.reserve(cornerCount);
+	std::vector<ObjVertexKey> vertices;
+	std::vector<u32> indices;
+	indices.reserve(cornerCount * 3);
+
+	for (const ObjFaceRange& range : faces)
+	{
+		const ObjChunk& chunk = chunks[range.chunk];
+		for (u32 f = range.firstFace; f < range.endFace; ++f)
+		{
+			const u32 first = chunk.faceCorners[f];
+			const u32 count = chunk.faceCorners[f + 1] - first;
+			if (count < 3)
+			{
+				continue;
+			}
+
+			u32 faceVertices[3] = {};
+			for (u32 k = 0; k < count; ++k)
+			{
+				const ObjCorner& corner	= chunk.corners[first + k];
+				ObjVertexKey key		= {};
+				key.position			= ResolveIndex(corner, 0, chunk.firstPosition, attributes.positions.size());
+				key.texCoord			= (corner.indices[1] != OBJ_LOADER_MISSING) ? ResolveIndex(corner, 1, chunk.firstTexCoord, attributes.texCoords.size()) : UINT32_MAX - 1;
+				key.normal				= (hasNormals) ? ResolveIndex(corner, 2, chunk.firstNormal, attributes.normals.size()) : UINT32_MAX - 1;
+				if (key.position == UINT32_MAX || key.texCoord == UINT32_MAX || key.normal == UINT32_MAX)
+				{
+					return false;
+				}
+
+				auto item = vertexLookup.emplace(key, (u32)vertices.size());
+				if (item.second)
+				{
+					vertices.push_back(key);
+				}
+
+				// Fan triangulation: (0, k - 1, k) for every corner past the second.
+				if (k < 2)
+				{
+					faceVertices[k] = item.first->second;
+					continue;
+				}
+				faceVertices[2] = item.first->second;
+				indices.insert(indices.end(), faceVertices, faceVertices + 3);
+				faceVertices[1] = faceVertices[2];
+			}
+		}
+	}
+
+	// NORMALS
+	const u32 vertexCount = (u32)vertices.size();
+	std::vector<vec3> normals(vertexCount, vec3(0.0f));
+	if (hasNormals)
+	{
+		for (u32 i = 0; i < vertexCount; ++i)
+		{
+			normals[i] = attributes.normals[vertices[i].normal];
+		}
+	}
+	else
+	{
+		std::unordered_map<u32, vec3> positionNormals;														// Area weighted, shared by the vertices of a position.
+		for (u32 i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const vec3& p0		= attributes.positions[vertices[indices[i + 0]].position];
+			const vec3& p1		= attributes.positions[vertices[indices[i + 1]].position];
+			const vec3& p2		= attributes.positions[vertices[indices[i + 2]].position];
+			const vec3 normal	= glm::cross(p1 - p0, p2 - p0);
+			for (u32 k = 0; k < 3; ++k)
+			{
+				positionNormals[vertices[indices[i + k]].position] += normal;
+			}
+		}
+
+		for (u32 i = 0; i < vertexCount; ++i)
+		{
+			normals[i] = positionNormals[vertices[i].position];
+		}
+	}
+
+	for (vec3& normal : normals)
+	{
+		const f32 length = glm::length(normal);
+		normal = (length > 1e-12f) ? normal / length : vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	// TANGENT SPACE
+	std::vector<vec3> tangents;
+	std::vector<vec3> bitangents;
+	auto GetTexCoord = [&](u32 vertexIdx) { return (vertices[vertexIdx].texCoord < attributes.texCoords.size()) ? attributes.texCoords[vertices[vertexIdx].texCoord] : vec2(0.0f); };
+	if (hasTexCoords)
+	{
+		tangents.assign(vertexCount, vec3(0.0f));
+		bitangents.assign(vertexCount, vec3(0.0f));
+		for (u32 i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const u32 v0 = indices[i + 0];
+			const u32 v1 = indices[i + 1];
+			const u32 v2 = indices[i + 2];
+
+			const vec3 edge1	= attributes.positions[vertices[v1].position] - attributes.positions[vertices[v0].position];
+			const vec3 edge2	= attributes.positions[vertices[v2].position] - attributes.positions[vertices[v0].position];
+			const vec2 delta1	= GetTexCoord(v1) - GetTexCoord(v0);
+			const vec2 delta2	= GetTexCoord(v2) - GetTexCoord(v0);
+			const f32 det		= delta1.x * delta2.y - delta2.x * delta1.y;
+			if (fabsf(det) < 1e-12f)
+			{
+				continue;																					// No UV area, no direction to give.
+			}
+
+			const vec3 tangent		= (edge1 * delta2.y - edge2 * delta1.y) / det;
+			const vec3 bitangent	= (edge2 * delta1.x - edge1 * delta2.x) / det;
+			for (u32 k = 0; k < 3; ++k)
+			{
+				tangents[indices[i + k]]	+= tangent;
+				bitangents[indices[i + k]]	+= bitangent;
+			}
+		}
+	}
+
+	// VERTICES
+	VertexBufferLayout vertexBufferLayout = {};
+	vertexBufferLayout.AddAttribute(0, 3, sizeof(float));
+	vertexBufferLayout.AddAttribute(1, 3, sizeof(float));
+	if (hasTexCoords)
+	{
+		vertexBufferLayout.AddAttribute(2, 2, sizeof(float));
+		vertexBufferLayout.AddAttribute(3, 4, sizeof(float));												// Tangent + bitangent sign.
+	}
+
+	std::vector<float>& floats = submesh.vertices;
+	floats.reserve(vertexCount * (vertexBufferLayout.stride / sizeof(float)));
+	for (u32 i = 0; i < vertexCount; ++i)
+	{
+		const vec3& position	= attributes.positions[vertices[i].position];
+		const vec3& normal		= normals[i];
+		floats.insert(floats.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z });
+
+		if (hasTexCoords)
+		{
+			vec3 tangent		= tangents[i] - normal * glm::dot(normal, tangents[i]);					// Gram-Schmidt against the normal.
+			const f32 length	= glm::length(tangent);
+			tangent				= (length > 1e-12f) ? tangent / length : glm::normalize(glm::cross(normal, (fabsf(normal.x) < 0.9f) ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f)));
+
+			const vec2 texCoord	= GetTexCoord(i);
+			const f32 sign		= VertexFormat::Utils::GetBitangentSign(normal, tangent, bitangents[i]);
+			floats.insert(floats.end(), { texCoord.x, texCoord.y, tangent.x, tangent.y, tangent.z, sign });
+		}
+	}
+
+	submesh.VBL = vertexBufferLayout;
+	submesh.indices.swap(indices);
+
+	return true;
+}
+
+u32 ObjLoader::Utils::ResolveIndex(const ObjCorner& corner, u32 attribute, u32 chunkFirst, u64 count)
+{
+	const bool isRelative	= (corner.relativeMask & (1u << attribute)) != 0;
+	const i64 index			= (i64)corner.indices[attribute] + ((isRelative) ? (i64)chunkFirst : 0);
+
+	return (index >= 0 && (u64)index < count) ? (u32)index : UINT32_MAX;
+}
+
+// Exact for up to 19 significant digits and 10^22, which covers what the exporters write. No inf / nan.
+const char* ObjLoader::Utils::ParseFloat(const char* cursor, const char* end, f32& value)
+{
+	static const f64 powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	cursor = SkipSpaces(cursor, end);
+
+	bool isNegative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+'))
+	{
+		isNegative = (*cursor == '-');
+		++cursor;
+	}
+
+	u64 mantissa	= 0;
+	i32 exponent	= 0;
+	u32 digits		= 0;
+	for (; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor, ++digits)
+	{
+		if (mantissa < 1000000000000000000ull)	{ mantissa = mantissa * 10 + (u64)(*cursor - '0'); }
+		else									{ ++exponent; }
+	}
+
+	if (cursor < end && *cursor == '.')
+	{
+		for (++cursor; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor, ++digits)
+		{
+			if (mantissa < 1000000000000000000ull)
+			{
+				mantissa = mantissa * 10 + (u64)(*cursor - '0');
+				--exponent;
+			}
+		}
+	}
+
+	if (digits == 0)
+	{
+		return nullptr;
+	}
+
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		i32 power = 0;
+		cursor = ParseInt(cursor + 1, end, power);
+		if (cursor == nullptr)
+		{
+			return nullptr;
+		}
+		exponent += power;
+	}
+
+	f64 result = (f64)mantissa;
+	if		(exponent > 0)	{ result = (exponent <= 22) ? result * powers[exponent] : result * pow(10.0, exponent); }
+	else if (exponent < 0)	{ result = (exponent >= -22) ? result / powers[-exponent] : result * pow(10.0, exponent); }
+
+	value = (f32)((isNegative) ? -result : result);
+	return cursor;
+}
+
+const char* ObjLoader::Utils::ParseInt(const char* cursor, const char* end, i32& value)
+{
+	bool isNegative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+'))
+	{
+		isNegative = (*cursor == '-');
+		++cursor;
+	}
+
+	i64 result = 0;
+	const char* first = cursor;
+	for (; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor)
+	{
+		result = (result < INT32_MAX) ? result * 10 + (*cursor - '0') : result;
+	}
+
+	if (cursor == first || result > INT32_MAX)
+	{
+		return nullptr;
+	}
+
+	value = (i32)((isNegative) ? -result : result);
+	return cursor;
+}
+
+// v, v/vt, v//vn or v/vt/vn. Negative indices count back from the last vertex parsed, here in this chunk.
+const char* ObjLoader::Utils::ParseCorner(const char* cursor, const char* end, const ObjChunk& chunk, ObjCorner& corner)
+{
+	const u32 counts[] = { (u32)chunk.positions.size(), (u32)chunk.texCoords.size(), (u32)chunk.normals.size() };
+
+	corner.indices[0]		= OBJ_LOADER_MISSING;
+	corner.indices[1]		= OBJ_LOADER_MISSING;
+	corner.indices[2]		= OBJ_LOADER_MISSING;
+	corner.relativeMask		= 0;
+
+	for (u32 attribute = 0; attribute < 3; ++attribute)
+	{
+		if (attribute > 0)
+		{
+			if (cursor >= end || *cursor != '/')
+			{
+				break;
+			}
+			++cursor;
+
+			if (attribute == 1 && cursor < end && *cursor == '/')											// v//vn
+			{
+				continue;
+			}
+		}
+
+		i32 index = 0;
+		cursor = ParseInt(cursor, end, index);
+		if (cursor == nullptr || index == 0)
+		{
+			return nullptr;
+		}
+
+		if (index > 0)
+		{
+			corner.indices[attribute] = index - 1;
+		}
+		else
+		{
+			corner.indices[attribute]	 = (i32)counts[attribute] + index;
+			corner.relativeMask			|= 1u << attribute;
+		}
+	}
+
+	return cursor;
+}
+
+std::string ObjLoader::Utils::ParseName(const char* cursor, const char* end)
+{
+	cursor = SkipSpaces(cursor, end);
+	while (end > cursor && IsSpace(end[-1])) { --end; }
+
+	return std::string(cursor, end - cursor);
+}
\ No newline at end of file
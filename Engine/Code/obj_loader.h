@@ -0,0 +1,115 @@
+#ifndef __OBJ_LOADER_H__
+#define __OBJ_LOADER_H__
+
+// obj_loader.h:
+// Native Wavefront OBJ / MTL loader, used by the importer instead of Assimp for .obj files. The file is memory mapped
+// and split into chunks of about OBJ_LOADER_CHUNK_SIZE that end on a line break, each parsed by a job into its own
+// arrays. Vertex references are 1-based and can be negative (relative to the last vertex so far): the relative ones
+// are kept local to their chunk and offset by the vertex counts of the previous chunks when the chunks are merged.
+// The faces are then grouped by material, one submesh each as aiProcess_OptimizeMeshes does, and every submesh is
+// triangulated (as a fan) and welded on its own job: a hash table maps each position / texcoord / normal triplet to
+// its vertex. The submeshes come out in the importer's float layout, positions, normals, UVs if the material's faces
+// have any and the tangent with its bitangent sign if so. Missing normals are smoothed per position and the tangents
+// accumulated per triangle, as aiProcess_GenSmoothNormals and aiProcess_CalcTangentSpace would.
+// Groups, objects, smoothing groups, lines, points and the other statements are ignored. A malformed vertex or face
+// makes Load() fail, and the importer falls back to Assimp.
+
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+#define OBJ_LOADER_VERSION			1																	// Part of the import settings hash.
+#define OBJ_LOADER_CHUNK_SIZE		MB(1)
+#define OBJ_LOADER_MISSING			INT32_MIN															// A corner without a texcoord / normal.
+
+struct ObjMaterial
+{
+	std::string	name;
+	vec3		diffuse;																				// Kd
+	vec3		emissive;																				// Ke
+	vec3		specular;																				// Ks
+	f32			shininess;																				// Ns
+
+	std::string	diffuseMap;																				// Relative to the .mtl file.
+	std::string	emissiveMap;
+	std::string	specularMap;
+	std::string	normalMap;																				// norm
+	std::string	bumpMap;																				// bump / map_bump, a height map.
+};
+
+struct ObjModel
+{
+	std::vector<ObjMaterial>	materials;
+	std::vector<Submesh>		submeshes;																// vertices, indices and VBL set.
+	std::vector<u32>			submeshMaterials;														// Per submesh, into materials.
+};
+
+struct ObjCorner
+{
+	i32		indices[3];																					// Position, texcoord, normal. 0-based.
+	u32		relativeMask;																				// Bit per index that is local to its chunk.
+};
+
+struct ObjMaterialRun
+{
+	u32			firstFace;																				// In its chunk.
+	std::string	material;
+};
+
+struct ObjFaceRange																					// Faces of a chunk that share a material.
+{
+	u32		chunk;
+	u32		firstFace;
+	u32		endFace;
+};
+
+struct ObjAttributes																					// Every chunk's, back to back.
+{
+	std::vector<vec3>	positions;
+	std::vector<vec2>	texCoords;
+	std::vector<vec3>	normals;
+};
+
+struct ObjChunk
+{
+	const char*					begin;
+	const char*					end;
+
+	std::vector<vec3>			positions;
+	std::vector<vec2>			texCoords;
+	std::vector<vec3>			normals;
+	std::vector<ObjCorner>		corners;
+	std::vector<u32>			faceCorners;															// First corner of each face, plus one past the last.
+	std::vector<ObjMaterialRun>	runs;																	// usemtl statements.
+	std::vector<std::string>	libraries;																// mtllib statements.
+
+	u32							firstPosition;															// Totals of the previous chunks, set on merge.
+	u32							firstTexCoord;
+	u32							firstNormal;
+
+	u32							errorLine;																// In the chunk, 0 if it parsed.
+};
+
+namespace ObjLoader
+{
+	bool Load		(const char* filepath, ObjModel& model);
+	bool IsObjFile	(const char* filepath);
+
+	namespace Utils
+	{
+		void ParseChunk			(ObjChunk& chunk);
+		bool LoadMaterials		(const std::string& filepath, std::vector<ObjMaterial>& materials);
+		bool BuildSubmesh		(const ObjAttributes& attributes, const std::vector<ObjChunk>& chunks, const std::vector<ObjFaceRange>& faces, Submesh& submesh);
+		u32  ResolveIndex		(const ObjCorner& corner, u32 attribute, u32 chunkFirst, u64 count);	// Global index, UINT32_MAX if out of range.
+
+		const char* ParseFloat	(const char* cursor, const char* end, f32& value);						// Returns nullptr if there is no number.
+		const char* ParseInt	(const char* cursor, const char* end, i32& value);
+		const char* ParseCorner	(const char* cursor, const char* end, const ObjChunk& chunk, ObjCorner& corner);
+		std::string	ParseName	(const char* cursor, const char* end);										// The rest of the line, trimmed.
+	}
+}
+
+#endif // !__OBJ_LOADER_H__
\ No newline at end of file
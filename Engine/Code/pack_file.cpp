@@ -0,0 +1,364 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+#include "globals.h"
+#include "file_manager.h"
+#include "job_system.h"
+#include "compression.h"
+
+#include "pack_file.h"
+
+MappedFile			GlobalPackMapping	= {};
+const PackHeader*	GlobalPackHeader	= nullptr;
+u64					GlobalPackTimestamp	= 0;
+
+bool PackFile::Mount(const char* filepath)
+{
+	Unmount();
+	if (!FileManager::Utils::MapLooseFile(filepath, GlobalPackMapping))
+	{
+		return false;
+	}
+
+	const PackHeader* header	= (const PackHeader*)GlobalPackMapping.data;
+	const u64 size				= GlobalPackMapping.size;
+	bool isValid				= size >= sizeof(PackHeader) && header->magic == PACK_FILE_MAGIC && header->version == PACK_FILE_VERSION
+								&& header->tocOffset + (u64)header->entryCount * sizeof(PackEntry) <= size
+								&& header->blocksOffset + (u64)header->blockCount * sizeof(u32) <= size && header->pathsOffset <= size;
+
+	// The paths are checked once here, Find() compares them without any test.
+	for (u32 i = 0; isValid && i < header->entryCount; ++i)
+	{
+		const PackEntry& entry = ((const PackEntry*)(GlobalPackMapping.data + header->tocOffset))[i];
+		isValid = (u64)entry.pathOffset + entry.pathLength <= size - header->pathsOffset;
+	}
+
+	if (!isValid)
+	{
+		ELOG("Pack file %s is invalid or from another version, it was not mounted", filepath);
+		FileManager::UnmapFile(GlobalPackMapping);
+		return false;
+	}
+
+	GlobalPackHeader	= header;
+	GlobalPackTimestamp	= FileManager::Utils::GetLooseFileTimestamp(filepath);
+	ILOG("Mounted pack file %s: %u entries, %llu MB", filepath, header->entryCount, size / MB(1));
+
+	return true;
+}
+
+void PackFile::Unmount()
+{
+	FileManager::UnmapFile(GlobalPackMapping);
+	GlobalPackHeader	= nullptr;
+	GlobalPackTimestamp	= 0;
+}
+
+const PackEntry* PackFile::Find(const char* filepath)
+{
+	return Utils::FindEntry(filepath, 0);
+}
+
+const PackEntry* PackFile::FindSource(const char* filepath)
+{
+	return Utils::FindEntry(filepath, PACK_ENTRY_SOURCE);
+}
+
+bool PackFile::Read(const PackEntry& entry, MappedFile& mappedFile)
+{
+	mappedFile = {};
+	if (entry.offset + entry.storedSize > GlobalPackMapping.size)
+	{
+		return false;
+	}
+
+	if (entry.blockCount == 0)
+	{
+		if (entry.size != entry.storedSize)
+		{
+			return false;
+		}
+
+		mappedFile.data			= GlobalPackMapping.data + entry.offset;
+		mappedFile.size			= entry.size;
+		mappedFile.isPackView	= true;
+		return true;
+	}
+
+	u8* data = (u8*)malloc((size_t)entry.size);
+	if (data == nullptr || !Utils::DecompressEntry(entry, data))
+	{
+		free(data);
+		return false;
+	}
+
+	mappedFile.data			= data;
+	mappedFile.size			= entry.size;
+	mappedFile.ownedData	= data;
+	return true;
+}
+
+u64 PackFile::GetTimestamp()
+{
+	return GlobalPackTimestamp;
+}
+
+// Layout: header, the entries sorted by path hash (each aligned), the TOC, the block sizes and the paths.
+// The source records only take a TOC entry and their path.
+bool PackFile::Build(const char* filepath, const std::vector<std::string>& files, const std::vector<PackSource>& sources)
+{
+	std::vector<std::string> paths(files.size() + sources.size());
+	std::vector<std::pair<u64, u32>> order;																// (Path hash, file or files.size() + source).
+	for (u32 i = 0; i < paths.size(); ++i)
+	{
+		paths[i] = Utils::NormalizePath((i < files.size()) ? files[i].c_str() : sources[i - files.size()].path.c_str());
+		order.push_back({ Utils::HashPath(paths[i]), i });
+	}
+	std::sort(order.begin(), order.end());
+
+	FILE* file = fopen(filepath, "wb");
+	if (!file)
+	{
+		ELOG("fopen() failed writing file %s", filepath);
+		return false;
+	}
+
+	PackHeader header	= {};
+	header.magic		= PACK_FILE_MAGIC;
+	header.version		= PACK_FILE_VERSION;
+
+	std::vector<PackEntry> entries;
+	std::vector<u32> blockSizes;
+	std::string pathBlob;
+	std::vector<u8> stored;
+	std::vector<u32> entryBlocks;
+	static const u8 padding[PACK_FILE_ALIGNMENT] = {};
+
+	bool written = (fwrite(&header, sizeof(header), 1, file) == 1);
+	u64 offset = sizeof(header);
+	for (u32 i = 0; i < order.size() && written; ++i)
+	{
+		const std::string& path = paths[order[i].second];
+		if (order[i].second >= files.size())
+		{
+			PackEntry record	= {};
+			record.pathHash		= order[i].first;
+			record.offset		= offset;
+			record.sourceHash	= sources[order[i].second - files.size()].hash;
+			record.pathOffset	= (u32)pathBlob.size();
+			record.pathLength	= (u32)path.size();
+			record.flags		= PACK_ENTRY_SOURCE;
+			pathBlob			+= path;
+			entries.push_back(record);
+			continue;
+		}
+
+		MappedFile source = {};
+		if (!FileManager::Utils::MapLooseFile(files[order[i].second].c_str(), source))					// The original case, for case-sensitive file systems.
+		{
+			ELOG("Could not read %s, it was left out of the pack", path.c_str());						// Empty files cannot be mapped either.
+			continue;
+		}
+
+		PackEntry entry		= {};
+		entry.pathHash		= order[i].first;
+		entry.size			= source.size;
+		entry.pathOffset	= (u32)pathBlob.size();
+		entry.pathLength	= (u32)path.size();
+		pathBlob			+= path;
+
+		const u64 aligned	= (offset + PACK_FILE_ALIGNMENT - 1) & ~(u64)(PACK_FILE_ALIGNMENT - 1);
+		written				= fwrite(padding, 1, (size_t)(aligned - offset), file) == (size_t)(aligned - offset);
+		entry.offset		= aligned;
+
+		const bool isCompressed = Utils::ShouldCompress(path) && Utils::CompressEntry(source.data, source.size, stored, entryBlocks);
+		if (isCompressed)
+		{
+			entry.storedSize	= stored.size();
+			entry.firstBlock	= (u32)blockSizes.size();
+			entry.blockCount	= (u32)entryBlocks.size();
+			blockSizes.insert(blockSizes.end(), entryBlocks.begin(), entryBlocks.end());
+			written = written && fwrite(stored.data(), 1, stored.size(), file) == stored.size();
+		}
+		else
+		{
+			entry.storedSize	= source.size;
+			written = written && fwrite(source.data, 1, (size_t)source.size, file) == (size_t)source.size;
+		}
+
+		offset = entry.offset + entry.storedSize;
+		entries.push_back(entry);
+		FileManager::UnmapFile(source);
+	}
+
+	header.entryCount	= (u32)entries.size();
+	header.blockCount	= (u32)blockSizes.size();
+	header.tocOffset	= offset;
+	header.blocksOffset	= header.tocOffset + entries.size() * sizeof(PackEntry);
+	header.pathsOffset	= header.blocksOffset + blockSizes.size() * sizeof(u32);
+
+	written = written && fwrite(entries.data(), sizeof(PackEntry), entries.size(), file) == entries.size();
+	written = written && fwrite(blockSizes.data(), sizeof(u32), blockSizes.size(), file) == blockSizes.size();
+	written = written && fwrite(pathBlob.data(), 1, pathBlob.size(), file) == pathBlob.size();
+	written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;		// Now with the offsets.
+	fclose(file);
+
+	if (!written)
+	{
+		remove(filepath);																				// A half-written pack would be mounted.
+	}
+
+	return written;
+}
+
+// UTILS -------------------------------------------------------------------
+std::string PackFile::Utils::NormalizePath(const char* filepath)
+{
+	while (filepath[0] == '.' && (filepath[1] == '/' || filepath[1] == '\\'))
+	{
+		filepath += 2;
+	}
+
+	std::string path = filepath;
+	for (u32 i = 0; i < path.size(); ++i)
+	{
+		path[i] = (path[i] == '\\') ? '/' : (char)tolower((unsigned char)path[i]);
+	}
+
+	return path;
+}
+
+u64 PackFile::Utils::HashPath(const std::string& normalizedPath)
+{
+	return FileManager::HashBytes(normalizedPath.data(), normalizedPath.size());
+}
+
+const PackEntry* PackFile::Utils::FindEntry(const char* filepath, u32 flags)
+{
+	if (GlobalPackHeader == nullptr)
+	{
+		return nullptr;
+	}
+
+	const std::string path	= NormalizePath(filepath);
+	const u64 hash			= HashPath(path);
+	const PackEntry* first	= (const PackEntry*)(GlobalPackMapping.data + GlobalPackHeader->tocOffset);
+	const PackEntry* last	= first + GlobalPackHeader->entryCount;
+	const char* paths		= (const char*)(GlobalPackMapping.data + GlobalPackHeader->pathsOffset);
+
+	const PackEntry* entry	= std::lower_bound(first, last, hash, [](const PackEntry& e, u64 h) { return e.pathHash < h; });
+	for ( ; entry != last && entry->pathHash == hash; ++entry)
+	{
+		if (entry->flags == flags && entry->pathLength == path.size() && memcmp(paths + entry->pathOffset, path.data(), path.size()) == 0)
+		{
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+// Not the cooked textures (mapped to read single mips) nor the already compressed images.
+bool PackFile::Utils::ShouldCompress(const std::string& normalizedPath)
+{
+	const size_t dot			= normalizedPath.find_last_of('.');
+	const std::string extension	= (dot != std::string::npos) ? normalizedPath.substr(dot + 1) : std::string();
+
+	return extension != "ctex" && extension != "png" && extension != "jpg" && extension != "jpeg";
+}
+
+bool PackFile::Utils::DecompressEntry(const PackEntry& entry, u8* dst)
+{
+	if (entry.firstBlock + entry.blockCount > GlobalPackHeader->blockCount)
+	{
+		return false;
+	}
+
+	const u32* blockSizes = (const u32*)(GlobalPackMapping.data + GlobalPackHeader->blocksOffset) + entry.firstBlock;
+	std::vector<u64> blockOffsets(entry.blockCount);
+	u64 storedOffset = entry.offset;
+	for (u32 i = 0; i < entry.blockCount; ++i)
+	{
+		blockOffsets[i]	= storedOffset;
+		storedOffset	+= blockSizes[i];
+	}
+	if (storedOffset != entry.offset + entry.storedSize || (entry.size + PACK_FILE_BLOCK_SIZE - 1) / PACK_FILE_BLOCK_SIZE != entry.blockCount)
+	{
+		return false;
+	}
+
+	std::atomic<bool> isValid(true);
+	auto DecompressBlocks = [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			const u64 rawOffset	= (u64)i * PACK_FILE_BLOCK_SIZE;
+			const u32 rawSize	= (u32)std::min<u64>(PACK_FILE_BLOCK_SIZE, entry.size - rawOffset);
+			const u8* stored	= GlobalPackMapping.data + blockOffsets[i];
+
+			if (blockSizes[i] == rawSize)																// Did not compress, stored as is.
+			{
+				memcpy(dst + rawOffset, stored, rawSize);
+			}
+			else if (!Compression::Decompress(stored, blockSizes[i], dst + rawOffset, rawSize))
+			{
+				isValid = false;
+			}
+		}
+	};
+
+	if (entry.blockCount == 1)
+	{
+		DecompressBlocks(0, 1);
+	}
+	else
+	{
+		JobSystem::ParallelFor(entry.blockCount, 1, DecompressBlocks);
+	}
+
+	return isValid;
+}
+
+bool PackFile::Utils::CompressEntry(const u8* data, u64 size, std::vector<u8>& stored, std::vector<u32>& blockSizes)
+{
+	const u32 blockCount = (u32)((size + PACK_FILE_BLOCK_SIZE - 1) / PACK_FILE_BLOCK_SIZE);
+	if (blockCount == 0)
+	{
+		return false;
+	}
+
+	std::vector<std::vector<u8>> blocks(blockCount);
+	JobSystem::ParallelFor(blockCount, 1, [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			const u64 rawOffset	= (u64)i * PACK_FILE_BLOCK_SIZE;
+			const u32 rawSize	= (u32)std::min<u64>(PACK_FILE_BLOCK_SIZE, size - rawOffset);
+
+			blocks[i].resize(Compression::GetMaxCompressedSize(rawSize));
+			const u32 compressedSize = Compression::Compress(data + rawOffset, rawSize, blocks[i].data());
+			if (compressedSize < rawSize)
+			{
+				blocks[i].resize(compressedSize);
+			}
+			else
+			{
+				blocks[i].assign(data + rawOffset, data + rawOffset + rawSize);								// Read back with a memcpy.
+			}
+		}
+	});
+
+	stored.clear();
+	blockSizes.clear();
+	for (u32 i = 0; i < blockCount; ++i)
+	{
+		stored.insert(stored.end(), blocks[i].begin(), blocks[i].end());
+		blockSizes.push_back((u32)blocks[i].size());
+	}
+
+	return stored.size() <= size - size / PACK_FILE_MIN_SAVING;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef __PACK_FILE_H__
+#define __PACK_FILE_H__
+
+// pack_file.h:
+// Read-only archive of the working directory (PACK_FILE_NAME), built by the cooker (cooker.h, -pack) and mounted at
+// startup with FileManager::MountPack(). The whole pack is a single mapping: a header, the entries' data, each one
+// aligned to PACK_FILE_ALIGNMENT, and a table of contents sorted by path hash, so a lookup is a binary search with no
+// syscall. Entries are stored as they are, and MapFile() returns a view straight into the mapping, or compressed with
+// LZ4 (compression.h) in independent PACK_FILE_BLOCK_SIZE blocks that decompress in parallel on the job system.
+// The cooked textures stay uncompressed: the streamer (texture_streaming.h) maps them to read a single mip.
+// The source assets are left out, only their cooked files are packed. Each source keeps a data-less record instead,
+// with the hash it was cooked from: a cooked file whose source is not on disk must carry that hash (see
+// FileManager::IsSourceUnchanged()), so a pack mixing files of different cooks is caught at load time.
+// Paths are matched case-insensitively, with '/' or '\' and without a leading "./".
+
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+
+struct MappedFile;
+
+#define PACK_FILE_NAME			"assets.pack"
+#define PACK_FILE_MAGIC			0x50504741																// "AGPP"
+#define PACK_FILE_VERSION		2
+#define PACK_FILE_ALIGNMENT		64																		// Entries start on a cache line, their headers can be cast in place.
+#define PACK_FILE_BLOCK_SIZE	(64 * 1024)																// Raw bytes per compressed block, the LZ4 window.
+#define PACK_FILE_MIN_SAVING	8																		// Compressed only if it saves at least 1/8 of the size.
+#define PACK_ENTRY_SOURCE		0x1																		// PackEntry flags: the record of a left out source, no data.
+
+struct PackHeader
+{
+	u32		magic;
+	u32		version;
+	u32		entryCount;
+	u32		blockCount;
+
+	u64		tocOffset;																				// PackEntry[entryCount], sorted by pathHash.
+	u64		blocksOffset;																			// u32[blockCount], the compressed size of every block.
+	u64		pathsOffset;																			// The normalized paths, back to back.
+};
+
+struct PackEntry
+{
+	u64		pathHash;
+	u64		offset;																					// From the start of the pack.
+	u64		storedSize;
+	u64		size;																					// Once decompressed.
+	u64		sourceHash;																				// PACK_ENTRY_SOURCE: what its cooked files were cooked from.
+	u32		pathOffset;																				// From pathsOffset.
+	u32		pathLength;
+	u32		firstBlock;
+	u32		blockCount;																				// 0 when stored uncompressed.
+	u32		flags;
+	u32		padding;
+};
+
+struct PackSource
+{
+	std::string	path;
+	u64			hash;
+};
+
+namespace PackFile
+{
+	bool Mount				(const char* filepath);
+	void Unmount			();
+
+	const PackEntry* Find	(const char* filepath);													// nullptr if not packed or nothing mounted.
+	const PackEntry* FindSource	(const char* filepath);												// The record of a left out source.
+	bool Read				(const PackEntry& entry, MappedFile& mappedFile);						// A view of the mapping, or a decompressed copy.
+	u64  GetTimestamp		();																		// Of the pack file, for every packed entry.
+
+	bool Build				(const char* filepath, const std::vector<std::string>& files, const std::vector<PackSource>& sources);	// Offline (cooker). Paths relative to the working directory.
+
+	namespace Utils
+	{
+		std::string NormalizePath		(const char* filepath);
+		u64			HashPath			(const std::string& normalizedPath);
+		const PackEntry* FindEntry		(const char* filepath, u32 flags);								// The entry with exactly these flags.
+		bool		ShouldCompress		(const std::string& normalizedPath);
+
+		bool		DecompressEntry		(const PackEntry& entry, u8* dst);
+		bool		CompressEntry		(const u8* data, u64 size, std::vector<u8>& stored, std::vector<u32>& blockSizes);	// False when it does not pay off.
+	}
+}
+
+#endif // !__PACK_FILE_H__
\ No newline at end of file
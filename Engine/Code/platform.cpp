@@ -6,6 +6,10 @@
 
 #include "globals.h"
 #include "file_manager.h"
+#include "pack_file.h"
+#include "job_system.h"
+#include "async_io.h"
+#include "string_table.h"
 #include "input.h"
 #include "engine.h"
 #include "app.h"
@@ -105,6 +109,10 @@ int Platform::Init()
     f64 lastFrameTime = glfwGetTime();
 
     FileManager::Init();
+    StringTable::Init();
+    JobSystem::Init(0);
+    AsyncIO::Init();
+    FileManager::MountPack(PACK_FILE_NAME);                                 // Optional, loose files are read when there is none.
 
     Engine::Init(&app);
 
@@ -169,6 +177,10 @@ int Platform::Init()
         FileManager::ResetFrameAllocator();
     }
 
+    AsyncIO::CleanUp();
+    FileManager::UnmountPack();
+    JobSystem::CleanUp();
+    StringTable::CleanUp();
     FileManager::CleanUp();
 
     ImGui_ImplOpenGL3_Shutdown();
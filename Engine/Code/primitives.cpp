@@ -1,5 +1,10 @@
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+
 #include "app.h"
 #include "globals.h"
+#include "importer.h"
 
 #include "primitives.h"
 
@@ -8,6 +13,7 @@ void Primitives::InitPrimitivesData(App* app)
 	Utils::InitPlaneData(app);
 	Utils::InitCubeData(app);
 	Utils::InitSphereData(app);
+	Utils::InitLightVolumes(app);
 }
 
 const u32 Primitives::GetPlaneIdx()
@@ -25,9 +31,124 @@ const u32 Primitives::GetSphereIdx()
 	return Utils::sphereIdx;
 }
 
-void Primitives::SetSphereIdx(u32 idx)
+const u32 Primitives::GetLightSphereIdx()
+{
+	return Utils::lightSphereIdx;
+}
+
+const u32 Primitives::GetLightConeIdx()
+{
+	return Utils::lightConeIdx;
+}
+
+const u32 Primitives::GetLightBoxIdx()
+{
+	return Utils::lightBoxIdx;
+}
+
+// Each subdivision splits every triangle in 4 through the midpoints of its edges, pushed back onto the sphere. The
+// midpoints are shared by the two triangles of an edge, so the mesh stays closed and indexed.
+void Primitives::GenerateIcosphere(u32 subdivisions, std::vector<float>& positions, std::vector<u32>& indices)
+{
+	const f32 t = (1.0f + sqrtf(5.0f)) * 0.5f;														// Golden ratio: the 12 vertices of the icosahedron.
+	const vec3 icosahedron[] =	{
+									vec3(-1.0f,  t, 0.0f), vec3( 1.0f,  t, 0.0f), vec3(-1.0f, -t, 0.0f), vec3( 1.0f, -t, 0.0f),
+									vec3(0.0f, -1.0f,  t), vec3(0.0f,  1.0f,  t), vec3(0.0f, -1.0f, -t), vec3(0.0f,  1.0f, -t),
+									vec3( t, 0.0f, -1.0f), vec3( t, 0.0f,  1.0f), vec3(-t, 0.0f, -1.0f), vec3(-t, 0.0f,  1.0f)
+								};
+
+	const u32 faces[] =	{
+							0, 11, 5,	0, 5, 1,	0, 1, 7,	0, 7, 10,	0, 10, 11,
+							1, 5, 9,	5, 11, 4,	11, 10, 2,	10, 7, 6,	7, 1, 8,
+							3, 9, 4,	3, 4, 2,	3, 2, 6,	3, 6, 8,	3, 8, 9,
+							4, 9, 5,	2, 4, 11,	6, 2, 10,	8, 6, 7,	9, 8, 1
+						};
+
+	std::vector<vec3> vertices;
+	for (u32 i = 0; i < ARRAY_COUNT(icosahedron); ++i)
+	{
+		vertices.push_back(glm::normalize(icosahedron[i]));
+	}
+	indices.assign(faces, faces + ARRAY_COUNT(faces));
+
+	for (u32 s = 0; s < subdivisions; ++s)
+	{
+		std::unordered_map<u64, u32> midpoints;															// (smaller index, larger index) -> vertex.
+		auto GetMidpoint = [&](u32 a, u32 b)
+		{
+			const u64 key	= ((u64)glm::min(a, b) << 32) | (u64)glm::max(a, b);
+			auto item		= midpoints.find(key);
+			if (item != midpoints.end())
+			{
+				return item->second;
+			}
+
+			vertices.push_back(glm::normalize(vertices[a] + vertices[b]));
+			midpoints[key] = (u32)vertices.size() - 1u;
+			return (u32)vertices.size() - 1u;
+		};
+
+		std::vector<u32> subdivided;
+		subdivided.reserve(indices.size() * 4);
+		for (u32 i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const u32 a		= indices[i + 0];
+			const u32 b		= indices[i + 1];
+			const u32 c		= indices[i + 2];
+			const u32 ab	= GetMidpoint(a, b);
+			const u32 bc	= GetMidpoint(b, c);
+			const u32 ca	= GetMidpoint(c, a);
+
+			const u32 triangles[] = { a, ab, ca,	b, bc, ab,	c, ca, bc,	ab, bc, ca };
+			subdivided.insert(subdivided.end(), triangles, triangles + ARRAY_COUNT(triangles));
+		}
+		indices.swap(subdivided);
+	}
+
+	positions.resize(vertices.size() * 3);
+	memcpy(positions.data(), vertices.data(), positions.size() * sizeof(float));
+}
+
+// The base polygon is circumscribed around the unit circle: its vertices are 1 / cos(PI / segments) away from the axis.
+void Primitives::GenerateCone(u32 segments, std::vector<float>& positions, std::vector<u32>& indices)
+{
+	const f32 baseRadius = 1.0f / cosf(PI / (f32)segments);
+
+	positions = { 0.0f, 0.0f, 0.0f,		0.0f, 0.0f, -1.0f };											// Apex and base center.
+	for (u32 i = 0; i < segments; ++i)
+	{
+		const f32 angle = 2.0f * PI * (f32)i / (f32)segments;
+		positions.push_back(cosf(angle) * baseRadius);
+		positions.push_back(sinf(angle) * baseRadius);
+		positions.push_back(-1.0f);
+	}
+
+	indices.clear();
+	for (u32 i = 0; i < segments; ++i)
+	{
+		const u32 current	= 2 + i;
+		const u32 next		= 2 + (i + 1) % segments;
+
+		const u32 triangles[] = { 0, current, next,		1, next, current };								// Side and base.
+		indices.insert(indices.end(), triangles, triangles + ARRAY_COUNT(triangles));
+	}
+}
+
+void Primitives::GenerateBox(std::vector<float>& positions, std::vector<u32>& indices)
 {
-	Utils::sphereIdx = idx;
+	positions = {
+					-1.0f, -1.0f, -1.0f,	 1.0f, -1.0f, -1.0f,	 1.0f,  1.0f, -1.0f,	-1.0f,  1.0f, -1.0f,		// Back  (z = -1)
+					-1.0f, -1.0f,  1.0f,	 1.0f, -1.0f,  1.0f,	 1.0f,  1.0f,  1.0f,	-1.0f,  1.0f,  1.0f			// Front (z =  1)
+				};
+
+	indices =	{
+					4, 5, 6,	4, 6, 7,																// +Z
+					1, 0, 3,	1, 3, 2,																// -Z
+					5, 1, 2,	5, 2, 6,																// +X
+					0, 4, 7,	0, 7, 3,																// -X
+					7, 6, 2,	7, 2, 3,																// +Y
+					0, 1, 5,	0, 5, 4																	// -Y
+				};
 }
 
 void Primitives::Utils::InitPlaneData(App* app)
@@ -44,6 +165,99 @@ void Primitives::Utils::InitPlaneData(App* app)
 								0, 2, 3
                             };
 
+	planeIdx = AddPrimitive(app, GetFullLayout(), std::vector<float>(vertices, vertices + ARRAY_COUNT(vertices)), std::vector<u32>(indices, indices + ARRAY_COUNT(indices)));
+}
+
+// 4 vertices per face, for flat normals and per-face UVs. The tangent follows U and the bitangent V.
+void Primitives::Utils::InitCubeData(App* app)
+{
+	const vec3 normals[]	= { vec3(1.0f, 0.0f, 0.0f), vec3(-1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f) };
+	const vec3 tangents[]	= { vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, 1.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(-1.0f, 0.0f, 0.0f) };
+	const vec2 uvs[]		= { vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(1.0f, 1.0f), vec2(0.0f, 1.0f) };
+
+	std::vector<float> vertices;
+	std::vector<u32> indices;
+	for (u32 face = 0; face < ARRAY_COUNT(normals); ++face)
+	{
+		const vec3 normal		= normals[face];
+		const vec3 tangent		= tangents[face];
+		const vec3 bitangent	= glm::cross(normal, tangent);												// tangent x bitangent = normal: counter-clockwise from outside.
+
+		const u32 first = (u32)vertices.size() / 14;
+		for (u32 i = 0; i < ARRAY_COUNT(uvs); ++i)
+		{
+			const vec3 position		= normal + tangent * (uvs[i].x * 2.0f - 1.0f) + bitangent * (uvs[i].y * 2.0f - 1.0f);
+			const float vertex[]	= { position.x, position.y, position.z, normal.x, normal.y, normal.z, uvs[i].x, uvs[i].y, tangent.x, tangent.y, tangent.z, bitangent.x, bitangent.y, bitangent.z };
+			vertices.insert(vertices.end(), vertex, vertex + ARRAY_COUNT(vertex));
+		}
+
+		const u32 quad[] = { first, first + 1, first + 2,	first, first + 2, first + 3 };
+		indices.insert(indices.end(), quad, quad + ARRAY_COUNT(quad));
+	}
+
+	cubeIdx = AddPrimitive(app, GetFullLayout(), vertices, indices);
+}
+
+// UV sphere of radius 1. The first and last columns share their positions, so the UVs wrap without a seam.
+void Primitives::Utils::InitSphereData(App* app)
+{
+	const u32 H = PRIMITIVES_SPHERE_SEGMENTS;
+	const u32 V = PRIMITIVES_SPHERE_RINGS;
+
+	// VERTICES
+	std::vector<float> vertices;
+	for (u32 h = 0; h < H + 1; ++h)
+	{
+		for (u32 v = 0; v < V + 1; ++v)
+		{
+			const f32 nh		= (f32)h / (f32)H;
+			const f32 nv		= (f32)v / (f32)V - 0.5f;
+			const f32 angleH	= 2.0f * PI * nh;
+			const f32 angleV	= -PI * nv;
+
+			const vec3 position		= vec3(sinf(angleH) * cosf(angleV), -sinf(angleV), cosf(angleH) * cosf(angleV));
+			const vec3 tangent		= vec3(cosf(angleH), 0.0f, -sinf(angleH));						// Along U, around the Y axis.
+			const vec3 bitangent	= glm::cross(position, tangent);
+			const float vertex[]	= { position.x, position.y, position.z, position.x, position.y, position.z, nh, (f32)v / (f32)V, tangent.x, tangent.y, tangent.z, bitangent.x, bitangent.y, bitangent.z };
+			vertices.insert(vertices.end(), vertex, vertex + ARRAY_COUNT(vertex));
+		}
+	}
+
+	// INDICES
+	std::vector<u32> indices;
+	for (u32 h = 0; h < H; ++h)
+	{
+		for (u32 v = 0; v < V; ++v)
+		{
+			const u32 quad[] =	{
+									h * (V + 1) + v,	(h + 1) * (V + 1) + v,			(h + 1) * (V + 1) + (v + 1),
+									h * (V + 1) + v,	(h + 1) * (V + 1) + (v + 1),	h * (V + 1) + (v + 1)
+								};
+			indices.insert(indices.end(), quad, quad + ARRAY_COUNT(quad));
+		}
+	}
+
+	sphereIdx = AddPrimitive(app, GetFullLayout(), vertices, indices);
+}
+
+void Primitives::Utils::InitLightVolumes(App* app)
+{
+	std::vector<float> positions;
+	std::vector<u32> indices;
+
+	GenerateIcosphere(PRIMITIVES_VOLUME_SUBDIVISIONS, positions, indices);
+	lightSphereIdx = AddPrimitive(app, GetPositionLayout(), positions, indices);
+
+	GenerateCone(PRIMITIVES_VOLUME_SEGMENTS, positions, indices);
+	lightConeIdx = AddPrimitive(app, GetPositionLayout(), positions, indices);
+
+	GenerateBox(positions, indices);
+	lightBoxIdx = AddPrimitive(app, GetPositionLayout(), positions, indices);
+}
+
+// A model with a single submesh drawn with the default material. No LODs, no meshlets: they are only a few hundred triangles.
+u32 Primitives::Utils::AddPrimitive(App* app, const VertexBufferLayout& layout, const std::vector<float>& vertices, const std::vector<u32>& indices)
+{
 	// MODEL DATA -------------------------------------------------------------
 	app->meshes.push_back(Mesh{});														// Mesh Creation: --------------------------------
 	Mesh& mesh		= app->meshes.back();												// Creating the Mesh that contains prmtve submesh.
@@ -54,171 +268,51 @@ void Primitives::Utils::InitPlaneData(App* app)
 	model.meshIdx	= meshIdx;															// Order: Model -> Mesh -> Submesh.
 	u32 modelIdx	= (u32)app->models.size() - 1u;										// -----------------------------------------------
 
-	model.materialIndices.push_back(app->defaultMaterialIdx);							// Material Creation: ----------------------------
-	//app->materials.push_back(Material{});												// Since its a primitive, it will use the Default.
-	//Material& material = app->materials.back();										// -----------------------------------------------
-
-	VertexBufferLayout VBL = {};														// Vertex Buffer Layout Creation: ----------------
-	VBL.AddAttribute(0, 3, sizeof(float));												// AddAtribute() increases the stride internally.
-	VBL.AddAttribute(1, 3, sizeof(float));												// This avoids having to pass the stride/offset.
-	VBL.AddAttribute(2, 2, sizeof(float));												// Should take into account when manipulating it.
-	VBL.AddAttribute(3, 3, sizeof(float));												// stride += ncomp * sizeof(var) (per addition).
-	VBL.AddAttribute(4, 3, sizeof(float));												// -----------------------------------------------
-
-	Submesh submesh = {};																// Submesh Creation: -----------------------------
-	submesh.VBL = VBL;																	// Adding the created VBL to the submesh.
+	model.materialIndices.push_back(app->defaultMaterialIdx);							// Since its a primitive, it will use the Default.
 
-	size_t verticesSize = ARRAY_COUNT(vertices);										// ---
-	submesh.vertices.resize(verticesSize);												// Adding the vertices to the submesh's container.
-	memcpy(&submesh.vertices[0], &vertices[0], verticesSize * sizeof(float));			// ---
-	
-	size_t indicesSize = ARRAY_COUNT(indices);											// ---
-	submesh.indices.resize(indicesSize);												// Adding the indices to the submesh's container.
-	memcpy(&submesh.indices[0], &indices[0], indicesSize * sizeof(u32));				// ---
+	Submesh submesh		= {};															// Submesh Creation: -----------------------------
+	submesh.VBL			= layout;
+	submesh.vertices	= vertices;
+	submesh.indices		= indices;
+	submesh.lods.push_back({ 0, (u32)indices.size(), 0.0f });							// Single LOD.
 
 	mesh.submeshes.push_back(submesh);													// -----------------------------------------------
+	Importer::Utils::ComputeMeshBounds(mesh);
 
 	// VERTEX, INDEX & VAO BUFFERS --------------------------------------------
-	u32 vertexBufferSize = 0;
-	u32 indexBufferSize  = 0;
-	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
-	{
-		vertexBufferSize += mesh.submeshes[i].vertices.size() * sizeof(float);
-		indexBufferSize  += mesh.submeshes[i].indices.size() * sizeof(u32);
-	}
-
 	glGenBuffers(1, &mesh.vertexBufferHandle);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-	glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	glGenBuffers(1, &mesh.indexBufferHandle);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u32), indices.data(), GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	mesh.submeshes[0].vertexOffset = 0;
 	mesh.submeshes[0].indexOffset  = 0;
+	mesh.submeshes[0].indexType    = GL_UNSIGNED_INT;
 
-	/*glGenBuffers(1, &mesh.vertexBufferHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-	glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
-
-	glGenBuffers(1, &mesh.indexBufferHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
-
-	u32 verticesOffset	= 0;
-	u32 indicesOffset	= 0;
-	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
-	{
-		const void* verticesData = mesh.submeshes[i].vertices.data();
-		const u32	verticesSize = mesh.submeshes[i].vertices.size();
-		glBufferSubData(GL_ARRAY_BUFFER, verticesOffset, verticesSize, verticesData);
-
-		const void* indicesData = mesh.submeshes[i].indices.data();
-		const u32	indicesSize = mesh.submeshes[i].indices.size();
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indicesOffset, indicesSize, indicesData);
-		
-		mesh.submeshes[i].vertexOffset = verticesOffset;
-		mesh.submeshes[i].indexOffset  = indicesOffset;
-		verticesOffset += verticesSize;
-		indicesOffset  += indicesSize;
-	}
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);*/
-
-	planeIdx = modelIdx;
+	return modelIdx;
 }
 
-void Primitives::Utils::InitCubeData(App* app)
+VertexBufferLayout Primitives::Utils::GetFullLayout()
 {
-	
+	VertexBufferLayout VBL = {};														// Vertex Buffer Layout Creation: ----------------
+	VBL.AddAttribute(0, 3, sizeof(float));												// AddAtribute() increases the stride internally.
+	VBL.AddAttribute(1, 3, sizeof(float));												// This avoids having to pass the stride/offset.
+	VBL.AddAttribute(2, 2, sizeof(float));												// Should take into account when manipulating it.
+	VBL.AddAttribute(3, 3, sizeof(float));												// stride += ncomp * sizeof(var) (per addition).
+	VBL.AddAttribute(4, 3, sizeof(float));												// -----------------------------------------------
+
+	return VBL;
 }
 
-void Primitives::Utils::InitSphereData(App* app)
+VertexBufferLayout Primitives::Utils::GetPositionLayout()
 {
-	/*i32 H = 32;
-	i32 V = 16;
-
-	// VERTICES
-	for (i32 h = 0; h < H; ++h)
-	{
-		for (i32 v = 0; v < V + 1; ++v)
-		{
-			f32 nh = (f32)h / (f32)H;
-			f32 nv = (f32)v / ((f32)V) - 0.5f;
-			f32 angleH = 2 * PI * nh;
-			f32 angleV = -PI * nv;
-
-			Vertex vertex;
-			vertex.pos.x	= (sinf(angleH) * cosf(angleV));
-			vertex.pos.y	= -sinf(angleV);
-			vertex.pos.z	= (cosf(angleH) * cosf(angleV));
-			vertex.norm		= vertex.pos;
-			vertex.uv.x		= 1.0f;
-			vertex.uv.y		= 0.0f;
-			
-			sphereMesh.vertices.push_back(vertex.pos.x);
-			sphereMesh.vertices.push_back(vertex.pos.y);
-			sphereMesh.vertices.push_back(vertex.pos.z);
-
-			sphereMesh.vertices.push_back(vertex.norm.x);
-			sphereMesh.vertices.push_back(vertex.norm.y);
-			sphereMesh.vertices.push_back(vertex.norm.z);
-
-			sphereMesh.vertices.push_back(vertex.uv.x);
-			sphereMesh.vertices.push_back(vertex.uv.y);
-		}
-	}
-
-	for (i32 h = 0; h < H; ++h)
-	{
-		for (i32 v = 0; v < V; ++v)
-		{
-			sphereMesh.indices.push_back(	h			* (V + 1) +  v);
-			sphereMesh.indices.push_back( ((h + 1) % H) * (V + 1) +  v);
-			sphereMesh.indices.push_back( ((h + 1) % H) * (V + 1) + (v + 1));
-			sphereMesh.indices.push_back(	h			* (V + 1) +  v);
-			sphereMesh.indices.push_back( ((h + 1) % H) * (V + 1) + (v + 1));
-			sphereMesh.indices.push_back(	h			* (V + 1) + (v + 1));
-		}
-	}
-
-	sphereMesh.VBL.attributes.push_back({ 0, 3, 0 });
-	sphereMesh.VBL.attributes.push_back({ 1, 3, sizeof(float) * 3 });
-	sphereMesh.VBL.attributes.push_back({ 2, 2, sizeof(float) * 6 });
-	sphereMesh.VBL.stride = sizeof(float) * 8;
-
-	sphereMesh.indexOffset	= 0;
-	sphereMesh.vertexOffset = sizeof(float) * 8;
-
-	VAO sphereVAO = {app->vaoQuad, app->texQuadProgramIdx};
-	sphereMesh.vaos.push_back(sphereVAO);
-
-	// VERTEX BUFFER
-	glGenBuffers(1, &app->embeddedVertices);
-	glBindBuffer(GL_ARRAY_BUFFER, app->embeddedVertices);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * sphereMesh.vertices.size(), &sphereMesh.vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// INDEX BUFFER
-	glGenBuffers(1, &app->embeddedElements);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, app->embeddedElements);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(float) * sphereMesh.vertices.size(), &sphereMesh.vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	// VAO
-	glGenVertexArrays(1, &app->vaoQuad);
-	glBindVertexArray(app->vaoQuad);
-
-	glBindBuffer(GL_ARRAY_BUFFER, app->embeddedVertices);                                                       // --------------------------------------
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);                                  // Quads do not take into account normals
-	glEnableVertexAttribArray(0);                                                                               // 
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)24);                                 // Therefore they will not be added to
-	glEnableVertexAttribArray(1);                                                                               // the buffer
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, app->embeddedElements);                                               // --------------------------------------
+	VertexBufferLayout VBL = {};
+	VBL.AddAttribute(0, 3, sizeof(float));												// The light passes only read aPosition.
 
-	glBindVertexArray(0);*/
+	return VBL;
 }
\ No newline at end of file
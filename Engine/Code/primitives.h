@@ -1,29 +1,57 @@
 #ifndef __PRIMITIVES_H__
 #define __PRIMITIVES_H__
 
+// primitives.h:
+// Generated meshes. The plane, cube and sphere are entity primitives (@plane / @cube / @sphere in the scenes) with the
+// full vertex layout. The light volumes only have positions, which is all the lighting and stencil passes read: an
+// icosphere (subdivided icosahedron), a cone and a box. The icosphere has its vertices on the unit sphere, its faces
+// dip inside it by 1.8% with 2 subdivisions, which LIGHT_VOLUME_SCALE (engine.cpp) covers. The tessellation is set by
+// the defines below, the Generate functions take it as a parameter for other uses.
+
+#include <vector>
+
 #include "shader_types.h"
 
 struct App;
 
+#define PRIMITIVES_SPHERE_SEGMENTS			32												// Entity sphere, around the Y axis.
+#define PRIMITIVES_SPHERE_RINGS				16												// From pole to pole.
+#define PRIMITIVES_VOLUME_SUBDIVISIONS		2												// Light sphere: 20 * 4^n triangles.
+#define PRIMITIVES_VOLUME_SEGMENTS			16												// Light cone sides.
+
 namespace Primitives
 {
 	void InitPrimitivesData	(App* app);
 
-	const u32 GetPlaneIdx	();
-	const u32 GetCubeIdx	();
-	const u32 GetSphereIdx	();
+	const u32 GetPlaneIdx		();
+	const u32 GetCubeIdx		();
+	const u32 GetSphereIdx		();
+	const u32 GetLightSphereIdx	();															// Position-only light volumes.
+	const u32 GetLightConeIdx	();
+	const u32 GetLightBoxIdx	();
 
-	void SetSphereIdx(u32 idx);
+	// Positions are x, y, z triplets. The triangles are counter-clockwise seen from outside.
+	void GenerateIcosphere	(u32 subdivisions, std::vector<float>& positions, std::vector<u32>& indices);	// Vertices on the unit sphere.
+	void GenerateCone		(u32 segments, std::vector<float>& positions, std::vector<u32>& indices);		// Apex at the origin, base enclosing the unit circle at z = -1.
+	void GenerateBox		(std::vector<float>& positions, std::vector<u32>& indices);						// [-1, 1] on every axis.
 
 	namespace Utils
 	{
-		void InitPlaneData	(App* app);
-		void InitCubeData	(App* app);
-		void InitSphereData	(App* app);
+		void InitPlaneData		(App* app);
+		void InitCubeData		(App* app);
+		void InitSphereData		(App* app);
+		void InitLightVolumes	(App* app);
+
+		u32  AddPrimitive		(App* app, const VertexBufferLayout& layout, const std::vector<float>& vertices, const std::vector<u32>& indices);
+		VertexBufferLayout GetFullLayout	();												// Positions, normals, UVs, tangents and bitangents.
+		VertexBufferLayout GetPositionLayout();
 
 		static u32 planeIdx;
 		static u32 cubeIdx;
 		static u32 sphereIdx;
+		static u32 lightSphereIdx;
+		static u32 lightConeIdx;
+		static u32 lightBoxIdx;
 	}
 }
 
@@ -0,0 +1,303 @@
+#include <algorithm>
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "importer.h"
+#include "mesh_cache.h"
+
+#include "residency.h"
+
+void Residency::Init(App* app)
+{
+	ResidencyManager& manager = app->residency;
+	manager.meshes.clear();
+	manager.ramUsed		= 0;
+	manager.vramUsed	= 0;
+	manager.frame		= 0;
+	manager.evictions	= 0;
+	manager.reloads		= 0;
+
+	std::vector<StringId> sourcePaths(app->meshes.size(), INVALID_STRING_ID);
+	for (u32 i = 0; i < app->models.size(); ++i)
+	{
+		const StringId sourcePath = Utils::GetSourcePath(app->models[i]);
+		if (sourcePath != INVALID_STRING_ID)
+		{
+			sourcePaths[app->models[i].meshIdx] = sourcePath;
+		}
+	}
+
+	for (u32 i = 0; i < app->meshes.size(); ++i)
+	{
+		Utils::AddMesh(app, sourcePaths[i]);
+	}
+
+	for (u32 i = 0; i < app->meshes.size(); ++i)
+	{
+		SetPolicy(app, i, (sourcePaths[i] != INVALID_STRING_ID) ? RESIDENCY_POLICY::EVICTABLE : RESIDENCY_POLICY::GPU_ONLY);
+	}
+}
+
+void Residency::Update(App* app)
+{
+	ResidencyManager& manager = app->residency;
+	++manager.frame;
+
+	for (u32 i = 0; i < app->entities.size(); ++i)
+	{
+		const Entity& entity = app->entities[i];
+		const u32 meshIdx	 = app->models[entity.modelIndex].meshIdx;
+		if (entity.isHidden || entity.isImpostor || meshIdx >= manager.meshes.size())
+		{
+			continue;
+		}
+
+		MeshResidency& residency = manager.meshes[meshIdx];
+		residency.lastUsedFrame	 = manager.frame;
+		if (!residency.isGpuResident)
+		{
+			Utils::Reload(app, meshIdx, true, false);
+		}
+	}
+
+	Utils::EnforceBudgets(app);
+}
+
+// The models loaded after Init(), by the world streamer. Their meshes are evictable like the ones of the scene.
+void Residency::AddModel(App* app, u32 modelIdx)
+{
+	ResidencyManager& manager	= app->residency;
+	const Model& model			= app->models[modelIdx];
+	if (model.meshIdx < manager.meshes.size())
+	{
+		return;																									// Already managed, or a variant of a managed model.
+	}
+
+	const StringId sourcePath = Utils::GetSourcePath(model);
+	while (manager.meshes.size() < model.meshIdx)
+	{
+		Utils::AddMesh(app, INVALID_STRING_ID);
+	}
+	Utils::AddMesh(app, sourcePath);
+
+	SetPolicy(app, model.meshIdx, (sourcePath != INVALID_STRING_ID) ? RESIDENCY_POLICY::EVICTABLE : RESIDENCY_POLICY::GPU_ONLY);
+}
+
+void Residency::SetPolicy(App* app, u32 meshIdx, RESIDENCY_POLICY policy)
+{
+	ResidencyManager& manager = app->residency;
+	while (manager.meshes.size() <= meshIdx)																	// Meshes created after Init().
+	{
+		Utils::AddMesh(app, INVALID_STRING_ID);
+	}
+
+	MeshResidency& residency = manager.meshes[meshIdx];
+	if (policy == RESIDENCY_POLICY::EVICTABLE && residency.sourcePath == INVALID_STRING_ID)
+	{
+		policy = RESIDENCY_POLICY::GPU_ONLY;																	// Nothing to reload it from.
+	}
+	residency.policy = policy;
+
+	if (policy != RESIDENCY_POLICY::CPU_RETAINED && residency.isCpuResident)
+	{
+		Utils::ReleaseCpuData(app, meshIdx);
+	}
+
+	const bool needsGpuBuffers	= (policy != RESIDENCY_POLICY::EVICTABLE && !residency.isGpuResident);
+	const bool needsCpuData		= (policy == RESIDENCY_POLICY::CPU_RETAINED && !residency.isCpuResident);
+	if (needsGpuBuffers || needsCpuData)
+	{
+		Utils::Reload(app, meshIdx, needsGpuBuffers, needsCpuData);
+	}
+}
+
+bool Residency::IsResident(const App* app, u32 meshIdx)
+{
+	return (meshIdx >= app->residency.meshes.size()) || app->residency.meshes[meshIdx].isGpuResident;
+}
+
+bool Residency::RequestCpuData(App* app, u32 meshIdx)
+{
+	ResidencyManager& manager = app->residency;
+	if (meshIdx >= manager.meshes.size())
+	{
+		return true;
+	}
+
+	MeshResidency& residency = manager.meshes[meshIdx];
+	residency.lastUsedFrame	 = manager.frame;																// Kept at least until the next budget check.
+
+	return residency.isCpuResident || Utils::Reload(app, meshIdx, false, true);
+}
+
+// UTILS -------------------------------------------------------------------
+// Starts out CPU_RETAINED, as every mesh is right after its load.
+void Residency::Utils::AddMesh(App* app, StringId sourcePath)
+{
+	ResidencyManager& manager	= app->residency;
+	const Mesh& mesh			= app->meshes[manager.meshes.size()];
+
+	MeshResidency residency	= { RESIDENCY_POLICY::CPU_RETAINED, sourcePath, manager.frame, GetCpuBytes(mesh), GetGpuBytes(mesh), true, true };
+	manager.ramUsed			+= residency.cpuBytes;
+	manager.vramUsed		+= residency.gpuBytes;
+	manager.meshes.push_back(residency);
+}
+
+StringId Residency::Utils::GetSourcePath(const Model& model)
+{
+	const char* sourcePath = StringTable::GetString(model.fileName);
+	const bool isCached = model.fileName != INVALID_STRING_ID && FileManager::GetFileLastWriteTimestamp(MeshCache::Utils::GetCachePath(sourcePath).c_str()) != 0;
+
+	return (isCached) ? model.fileName : INVALID_STRING_ID;
+}
+
+u64 Residency::Utils::GetCpuBytes(const Mesh& mesh)
+{
+	u64 bytes = 0;
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		bytes += mesh.submeshes[i].vertices.capacity() * sizeof(f32) + mesh.submeshes[i].indices.capacity() * sizeof(u32);
+	}
+
+	return bytes;
+}
+
+u64 Residency::Utils::GetGpuBytes(const Mesh& mesh)
+{
+	GLint vertexBytes	= 0;
+	GLint indexBytes	= 0;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBufferHandle);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBufferHandle);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &indexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	return (u64)vertexBytes + (u64)indexBytes;
+}
+
+void Residency::Utils::ReleaseCpuData(App* app, u32 meshIdx)
+{
+	Mesh& mesh					= app->meshes[meshIdx];
+	MeshResidency& residency	= app->residency.meshes[meshIdx];
+
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		std::vector<f32>().swap(mesh.submeshes[i].vertices);													// clear() would keep the capacity.
+		std::vector<u32>().swap(mesh.submeshes[i].indices);
+	}
+
+	app->residency.ramUsed	-= residency.cpuBytes;
+	residency.cpuBytes		= 0;
+	residency.isCpuResident	= false;
+}
+
+void Residency::Utils::EvictGpuBuffers(App* app, u32 meshIdx)
+{
+	Mesh& mesh					= app->meshes[meshIdx];
+	MeshResidency& residency	= app->residency.meshes[meshIdx];
+
+	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	{
+		std::vector<VAO>& vaos = mesh.submeshes[i].vaos;														// FindVAO() rebuilds them after a reload.
+		for (u32 v = 0; v < vaos.size(); ++v)
+		{
+			glDeleteVertexArrays(1, &vaos[v].handle);
+		}
+		vaos.clear();
+	}
+
+	glDeleteBuffers(1, &mesh.vertexBufferHandle);
+	glDeleteBuffers(1, &mesh.indexBufferHandle);
+	mesh.vertexBufferHandle	= 0;
+	mesh.indexBufferHandle	= 0;
+
+	app->residency.vramUsed	-= residency.gpuBytes;
+	residency.gpuBytes		= 0;
+	residency.isGpuResident	= false;
+	++app->residency.evictions;
+}
+
+bool Residency::Utils::Reload(App* app, u32 meshIdx, bool gpuBuffers, bool cpuData)
+{
+	ResidencyManager& manager	= app->residency;
+	MeshResidency& residency	= manager.meshes[meshIdx];
+	Mesh& mesh					= app->meshes[meshIdx];
+
+	gpuBuffers	= gpuBuffers && !residency.isGpuResident;
+	cpuData		= cpuData && !residency.isCpuResident;
+	if (!gpuBuffers && !cpuData)
+	{
+		return true;
+	}
+
+	const char* sourcePath = StringTable::GetString(residency.sourcePath);
+	if (residency.sourcePath == INVALID_STRING_ID || !MeshCache::Reload(app, sourcePath, Importer::Utils::GetImportSettingsHash(), meshIdx, gpuBuffers, cpuData))
+	{
+		if (residency.sourcePath != INVALID_STRING_ID)
+		{
+			ELOG("Could not reload mesh %s from its cache, it will not be reloaded again", sourcePath);
+			residency.sourcePath = INVALID_STRING_ID;
+		}
+		return false;
+	}
+
+	if (gpuBuffers)
+	{
+		residency.gpuBytes		= GetGpuBytes(mesh);
+		residency.isGpuResident	= true;
+		manager.vramUsed		+= residency.gpuBytes;
+	}
+	if (cpuData)
+	{
+		residency.cpuBytes		= GetCpuBytes(mesh);
+		residency.isCpuResident	= true;
+		manager.ramUsed			+= residency.cpuBytes;
+	}
+
+	++manager.reloads;
+	return true;
+}
+
+// Least recently used first. Whatever was used this frame stays, even if the budget cannot be met without it.
+void Residency::Utils::EnforceBudgets(App* app)
+{
+	ResidencyManager& manager = app->residency;
+
+	std::vector<u32> candidates;
+	auto LeastRecentlyUsed = [&](u32 a, u32 b) { return manager.meshes[a].lastUsedFrame < manager.meshes[b].lastUsedFrame; };
+
+	// VRAM
+	for (u32 i = 0; i < manager.meshes.size() && manager.vramUsed > manager.vramBudget; ++i)
+	{
+		const MeshResidency& residency = manager.meshes[i];
+		if (residency.policy == RESIDENCY_POLICY::EVICTABLE && residency.isGpuResident && residency.lastUsedFrame < manager.frame)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), LeastRecentlyUsed);
+	for (u32 i = 0; i < candidates.size() && manager.vramUsed > manager.vramBudget; ++i)
+	{
+		EvictGpuBuffers(app, candidates[i]);
+	}
+
+	// RAM (the CPU_RETAINED copies are never dropped)
+	candidates.clear();
+	for (u32 i = 0; i < manager.meshes.size() && manager.ramUsed > manager.ramBudget; ++i)
+	{
+		const MeshResidency& residency = manager.meshes[i];
+		if (residency.policy != RESIDENCY_POLICY::CPU_RETAINED && residency.isCpuResident && residency.lastUsedFrame < manager.frame)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), LeastRecentlyUsed);
+	for (u32 i = 0; i < candidates.size() && manager.ramUsed > manager.ramBudget; ++i)
+	{
+		ReleaseCpuData(app, candidates[i]);
+	}
+}
\ No newline at end of file
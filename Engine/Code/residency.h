@@ -0,0 +1,82 @@
+#ifndef __RESIDENCY_H__
+#define __RESIDENCY_H__
+
+// residency.h:
+// Keeps the mesh memory within a RAM and a VRAM budget. Once the scene is built every mesh gets a policy:
+//  - GPU_ONLY:		the CPU copy (Submesh::vertices and indices) is freed, the GPU buffers stay for good.
+//  - CPU_RETAINED:	both are kept, for code that reads the vertices (picking, collision).
+//  - EVICTABLE:		the CPU copy is freed and, when the VRAM budget is exceeded, the GPU buffers of the least recently
+//					drawn meshes are released. They are reloaded from the mesh cache (mesh_cache.h) the next time an
+//					entity draws them. RequestCpuData() brings the CPU copy back the same way, within the RAM budget.
+// The LODs, meshlets and bounds are small and always stay, so the LOD selection and the culling keep working on the
+// evicted meshes. Only the meshes loaded through the cache can be evicted, the generated ones fall back to GPU_ONLY.
+
+#include <vector>
+
+#include "base_types.h"
+#include "string_table.h"
+
+struct App;
+struct Mesh;
+struct Model;
+
+#define RESIDENCY_DEFAULT_RAM_BUDGET	MB(64)
+#define RESIDENCY_DEFAULT_VRAM_BUDGET	MB(256)
+
+enum class RESIDENCY_POLICY
+{
+	GPU_ONLY,
+	CPU_RETAINED,
+	EVICTABLE
+};
+
+struct MeshResidency
+{
+	RESIDENCY_POLICY	policy;
+	StringId			sourcePath;																	// Model file of the cache, INVALID_STRING_ID if none.
+	u64					lastUsedFrame;																// Last frame it was drawn or its CPU copy requested.
+	u64					cpuBytes;																	// 0 when the CPU copy is released.
+	u64					gpuBytes;																	// 0 when the GPU buffers are evicted.
+	bool				isCpuResident;
+	bool				isGpuResident;
+};
+
+struct ResidencyManager
+{
+	std::vector<MeshResidency>	meshes;																// Same indices as App::meshes, the ones past the end are not managed.
+
+	u64							ramBudget;
+	u64							vramBudget;
+	u64							ramUsed;
+	u64							vramUsed;
+
+	u64							frame;
+	u32							evictions;																// Totals, for the GUI.
+	u32							reloads;
+};
+
+namespace Residency
+{
+	void Init				(App* app);																// Once the scene is built, the HLOD and impostor bakes read the CPU copies.
+	void Update				(App* app);																// After the HLOD and impostor selection: touches, reloads and evicts.
+
+	void AddModel			(App* app, u32 modelIdx);												// Loaded after Init(): EVICTABLE if it has a mesh cache.
+	void SetPolicy			(App* app, u32 meshIdx, RESIDENCY_POLICY policy);
+	bool IsResident			(const App* app, u32 meshIdx);											// GPU buffers ready to be drawn.
+	bool RequestCpuData		(App* app, u32 meshIdx);												// False when the CPU copy is gone for good.
+
+	namespace Utils
+	{
+		void AddMesh			(App* app, StringId sourcePath);
+		StringId GetSourcePath	(const Model& model);											// Model file with a mesh cache, else INVALID_STRING_ID.
+		u64  GetCpuBytes		(const Mesh& mesh);
+		u64  GetGpuBytes		(const Mesh& mesh);
+
+		void ReleaseCpuData		(App* app, u32 meshIdx);
+		void EvictGpuBuffers	(App* app, u32 meshIdx);
+		bool Reload				(App* app, u32 meshIdx, bool gpuBuffers, bool cpuData);
+		void EnforceBudgets		(App* app);
+	}
+}
+
+#endif // !__RESIDENCY_H__
\ No newline at end of file
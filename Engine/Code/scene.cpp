@@ -0,0 +1,176 @@
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "string_table.h"
+#include "job_system.h"
+#include "importer.h"
+#include "primitives.h"
+#include "transform.h"
+#include "engine.h"
+
+#include "scene.h"
+
+bool Scene::Load(App* app, const char* filepath, LoadedScene& scene)
+{
+	scene = {};
+
+	MappedFile cookedFile = {};
+	if (!Utils::MapCookedFile(filepath, cookedFile))
+	{
+		return false;
+	}
+
+	Utils::Instantiate(app, cookedFile.data, scene);
+	FileManager::UnmapFile(cookedFile);
+
+	return true;
+}
+
+// UTILS -------------------------------------------------------------------
+// A stale or missing .cscene is cooked and written first: the world streamer (world_streaming.h) reads it from disk.
+bool Scene::Utils::MapCookedFile(const char* filepath, MappedFile& cookedFile)
+{
+	const char* sourcePath			= (REQUIRE_COOKED_ASSETS) ? nullptr : filepath;						// Cooked-only builds trust the cooker.
+	const std::string cookedPath	= SceneCooker::Utils::GetCookedPath(filepath);
+	if (FileManager::MapFile(cookedPath.c_str(), cookedFile) && SceneCooker::Utils::IsUpToDate(cookedFile.data, cookedFile.size, sourcePath))
+	{
+		return true;
+	}
+	FileManager::UnmapFile(cookedFile);
+
+#if REQUIRE_COOKED_ASSETS
+	ELOG("Scene %s is not cooked or its .cscene is stale, run the cooker", filepath);
+	return false;
+#else
+	if (!SceneCooker::CookFile(filepath))
+	{
+		ELOG("Could not cook scene %s", filepath);
+		return false;
+	}
+
+	if (FileManager::MapFile(cookedPath.c_str(), cookedFile) && SceneCooker::Utils::IsUpToDate(cookedFile.data, cookedFile.size, nullptr))
+	{
+		return true;
+	}
+	FileManager::UnmapFile(cookedFile);
+
+	return false;
+#endif
+}
+
+void Scene::Utils::Instantiate(App* app, const u8* cookedFile, LoadedScene& scene)
+{
+	const CookedSceneHeader* header	= (const CookedSceneHeader*)cookedFile;
+	const SceneAsset* assets		= (const SceneAsset*)(cookedFile + header->assetsOffset);
+	const SceneMaterial* materials	= (const SceneMaterial*)(cookedFile + header->materialsOffset);
+	const SceneModel* models		= (const SceneModel*)(cookedFile + header->modelsOffset);
+	const SceneEntity* entities		= (const SceneEntity*)(cookedFile + header->entitiesOffset);
+	const SceneLight* lights		= (const SceneLight*)(cookedFile + header->lightsOffset);
+	const char* strings				= (const char*)(cookedFile + header->stringsOffset);
+
+	// ASSETS
+	for (u32 i = 0; i < header->assetCount; ++i)
+	{
+		const std::string path	= std::string(strings + assets[i].path.offset, assets[i].path.length);
+		const u32 modelIdx		= LoadAsset(app, path.c_str());
+		scene.modelIndices.push_back(modelIdx);
+
+		if (modelIdx != UINT32_MAX && (assets[i].flags & COOKED_SCENE_IMPOSTOR))
+		{
+			scene.impostorModels.push_back(modelIdx);
+		}
+	}
+
+	// MATERIALS & MODELS
+	std::vector<u32> materialIndices(header->materialCount);
+	for (u32 i = 0; i < header->materialCount; ++i)
+	{
+		materialIndices[i] = AddMaterial(app, materials[i], strings);
+	}
+
+	std::vector<u32> modelIndices(header->modelCount);
+	bool hasFailedModels = false;
+	for (u32 i = 0; i < header->modelCount; ++i)
+	{
+		const u32 modelIdx	= scene.modelIndices[models[i].assetIdx];
+		const bool isPlain	= (modelIdx == UINT32_MAX || models[i].materialIdx == COOKED_SCENE_NO_MATERIAL);
+		modelIndices[i]		= (isPlain) ? modelIdx : AddModelVariant(app, modelIdx, materialIndices[models[i].materialIdx]);
+		hasFailedModels		= hasFailedModels || modelIdx == UINT32_MAX;
+	}
+
+	// ENTITIES
+	scene.firstEntity = (u32)app->entities.size();
+	app->entities.resize(app->entities.size() + header->entityCount);
+	Entity* firstEntity = app->entities.data() + scene.firstEntity;
+
+	JobSystem::ParallelFor(header->entityCount, SCENE_ENTITY_BATCH, [&](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			const SceneEntity& source	= entities[i];
+			Entity& entity				= firstEntity[i];
+			entity.worldMatrix			= source.worldMatrix;
+			entity.modelIndex			= modelIndices[source.modelIdx];
+
+			if (source.name.length > 0)																	// The grid entities have none.
+			{
+				entity.name = StringTable::Intern(std::string(strings + source.name.offset, source.name.length).c_str());
+			}
+		}
+	});
+
+	if (hasFailedModels)
+	{
+		auto first = app->entities.begin() + scene.firstEntity;
+		app->entities.erase(std::remove_if(first, app->entities.end(), [](const Entity& entity) { return entity.modelIndex == UINT32_MAX; }), app->entities.end());
+	}
+	scene.entityCount = (u32)app->entities.size() - scene.firstEntity;
+
+	// LIGHTS
+	for (u32 i = 0; i < header->lightCount; ++i)
+	{
+		const SceneLight& light = lights[i];
+		Engine::Lights::AddLight(app, (LIGHT_TYPE)light.type, light.color, light.direction, light.position, light.attenuation, Transform::PositionScale(light.position, Transform::defaultScale));
+	}
+}
+
+u32 Scene::Utils::LoadAsset(App* app, const char* path)
+{
+	if (strcmp(path, "@plane") == 0)	{ return Primitives::GetPlaneIdx(); }
+	if (strcmp(path, "@cube") == 0)		{ return Primitives::GetCubeIdx(); }
+	if (strcmp(path, "@sphere") == 0)	{ return Primitives::GetSphereIdx(); }
+
+	return Importer::LoadModel(app, path);
+}
+
+u32 Scene::Utils::AddMaterial(App* app, const SceneMaterial& sceneMaterial, const char* strings)
+{
+	Material material	= app->materials[app->defaultMaterialIdx];											// The texture slots the scene does not set.
+	material.name		= StringTable::Intern(std::string(strings + sceneMaterial.name.offset, sceneMaterial.name.length).c_str());
+	material.albedo		= sceneMaterial.albedo;
+	material.emissive	= sceneMaterial.emissive;
+	material.smoothness	= sceneMaterial.smoothness;
+
+	if (sceneMaterial.albedoTexture.length > 0)
+	{
+		const std::string texturePath	= std::string(strings + sceneMaterial.albedoTexture.offset, sceneMaterial.albedoTexture.length);
+		material.albedoTexIdx			= Importer::LoadTexture2D(app, texturePath.c_str());
+	}
+
+	app->materials.push_back(material);
+	return (u32)app->materials.size() - 1u;
+}
+
+// Not in App::modelIdMap: loading the file again returns the original model.
+u32 Scene::Utils::AddModelVariant(App* app, u32 modelIdx, u32 materialIdx)
+{
+	Model variant = app->models[modelIdx];
+	std::fill(variant.materialIndices.begin(), variant.materialIndices.end(), materialIdx);
+
+	app->models.push_back(variant);
+	return (u32)app->models.size() - 1u;
+}
\ No newline at end of file
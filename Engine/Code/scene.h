@@ -0,0 +1,45 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+// scene.h:
+// Loads the compiled scenes (scene_cooker.h) into the app. The few assets, materials and (model, material) pairs are
+// resolved first: the models go through Importer::LoadModel(), a material override becomes a copy of the model that
+// shares its mesh. The entities are then one resize of App::entities and a ParallelFor that copies their world matrix
+// and remaps their model, so the load time is the copy of the array. A stale or missing .cscene is cooked again
+// from the text, unless the engine is built with REQUIRE_COOKED_ASSETS. The cells of a scene (if any) are ignored
+// here, it is loaded whole: world_streaming.h loads them around the camera instead.
+
+#include <vector>
+
+#include "base_types.h"
+#include "scene_cooker.h"
+
+struct App;
+struct MappedFile;
+
+#define SCENE_DEFAULT_FILE		"default.scene"
+#define SCENE_ENTITY_BATCH		4096																		// Entities per ParallelFor job.
+
+struct LoadedScene
+{
+	std::vector<u32>	modelIndices;																	// SceneAsset -> App::models, UINT32_MAX if it failed.
+	std::vector<u32>	impostorModels;																	// The models flagged COOKED_SCENE_IMPOSTOR.
+	u32					firstEntity;
+	u32					entityCount;
+};
+
+namespace Scene
+{
+	bool Load					(App* app, const char* filepath, LoadedScene& scene);					// Appends to the app, the entities of a failed model are dropped.
+
+	namespace Utils
+	{
+		bool MapCookedFile		(const char* filepath, MappedFile& cookedFile);							// Up to date and validated.
+		void Instantiate		(App* app, const u8* cookedFile, LoadedScene& scene);					// cookedFile passed SceneCooker::Utils::IsUpToDate().
+		u32  LoadAsset			(App* app, const char* path);											// Files and @plane / @cube / @sphere.
+		u32  AddMaterial		(App* app, const SceneMaterial& material, const char* strings);
+		u32  AddModelVariant	(App* app, u32 modelIdx, u32 materialIdx);								// The model drawn with a single material.
+	}
+}
+
+#endif // !__SCENE_H__
\ No newline at end of file
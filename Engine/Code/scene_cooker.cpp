@@ -0,0 +1,420 @@
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+#include "globals.h"
+#include "file_manager.h"
+#include "shader_types.h"
+#include "transform.h"
+#include "engine.h"
+
+#include "scene_cooker.h"
+
+struct SceneOptions																					// Keywords of a statement, with their defaults.
+{
+	vec3		position;
+	vec3		rotation;
+	vec3		scale;
+	std::string	material;
+
+	vec3		albedo;
+	vec3		emissive;
+	f32			smoothness;
+	std::string	texture;
+
+	vec3		color;
+	vec3		direction;
+	vec3		attenuation;
+	bool		isImpostor;
+};
+
+static bool ParseFloat(const std::string& token, f32& value)
+{
+	char* end	= nullptr;
+	value		= strtof(token.c_str(), &end);
+	return end != token.c_str() && *end == '\0';
+}
+
+static bool ParseVec3(const std::vector<std::string>& tokens, u32& cursor, vec3& value)
+{
+	const bool parsed = cursor + 3 <= tokens.size() && ParseFloat(tokens[cursor], value.x) && ParseFloat(tokens[cursor + 1], value.y) && ParseFloat(tokens[cursor + 2], value.z);
+	cursor += 3;
+	return parsed;
+}
+
+// Every keyword is accepted by every statement, the ones a statement does not use are ignored.
+static bool ParseOptions(const std::vector<std::string>& tokens, u32 cursor, SceneOptions& options)
+{
+	options				= {};
+	options.scale		= Transform::defaultScale;
+	options.albedo		= vec3(1.0f);
+	options.smoothness	= 1.0f;
+	options.color		= vec3(1.0f);
+	options.attenuation	= Engine::Lights::defaultAttenuation;
+
+	bool parsed = true;
+	while (cursor < tokens.size() && parsed)
+	{
+		const std::string& keyword	= tokens[cursor++];
+		const bool hasValue			= cursor < tokens.size();
+
+		if		(keyword == "position")		{ parsed = ParseVec3(tokens, cursor, options.position); }
+		else if (keyword == "rotation")		{ parsed = ParseVec3(tokens, cursor, options.rotation); }
+		else if (keyword == "albedo")		{ parsed = ParseVec3(tokens, cursor, options.albedo); }
+		else if (keyword == "emissive")		{ parsed = ParseVec3(tokens, cursor, options.emissive); }
+		else if (keyword == "color")		{ parsed = ParseVec3(tokens, cursor, options.color); }
+		else if (keyword == "direction")	{ parsed = ParseVec3(tokens, cursor, options.direction); }
+		else if (keyword == "attenuation")	{ parsed = ParseVec3(tokens, cursor, options.attenuation); }
+		else if (keyword == "smoothness")	{ parsed = hasValue && ParseFloat(tokens[cursor++], options.smoothness); }
+		else if (keyword == "material")		{ parsed = hasValue; options.material = (hasValue) ? tokens[cursor++] : ""; }
+		else if (keyword == "texture")		{ parsed = hasValue; options.texture = (hasValue) ? tokens[cursor++] : ""; }
+		else if (keyword == "impostor")		{ options.isImpostor = true; }
+		else if (keyword == "scale")
+		{
+			f32 uniform	= 0.0f;
+			u32 xyz		= cursor;
+			if (ParseVec3(tokens, xyz, options.scale))	{ cursor = xyz; }
+			else										{ parsed = hasValue && ParseFloat(tokens[cursor++], uniform); options.scale = vec3(uniform); }
+		}
+		else
+		{
+			parsed = false;
+		}
+	}
+
+	return parsed;
+}
+
+static mat4 BuildWorldMatrix(const vec3& position, const vec3& rotation, const vec3& scale)
+{
+	const mat4 rotationMatrix = Transform::Rotation(glm::radians(rotation.z), Transform::forwardVector)
+							  * Transform::Rotation(glm::radians(rotation.y), Transform::upVector)
+							  * Transform::Rotation(glm::radians(rotation.x), Transform::rightVector);
+
+	return Transform::Position(position) * rotationMatrix * Transform::Scale(scale);
+}
+
+bool SceneCooker::Cook(const char* filepath, u64 sourceHash, u64 sourceTimestamp, std::vector<u8>& cookedFile)
+{
+	MappedFile source = {};
+	if (!FileManager::MapFile(filepath, source))
+	{
+		ELOG("Could not read scene %s", filepath);
+		return false;
+	}
+
+	std::vector<SceneAsset>				assets;
+	std::vector<SceneMaterial>			materials;
+	std::vector<SceneModel>				models;
+	std::vector<SceneEntity>			entities;
+	std::vector<SceneLight>				lights;
+	std::string							strings;
+	f32									cellSize = 0.0f;
+	std::map<std::string, u32>			assetAliases;
+	std::map<std::string, u32>			materialAliases;
+	std::map<std::pair<u32, u32>, u32>	modelIndices;														// (Asset, material) -> SceneModel.
+
+	auto AddString = [&strings](const std::string& string) -> SceneString
+	{
+		SceneString added	= { (u32)strings.size(), (u32)string.size() };
+		strings				+= string;
+		return added;
+	};
+
+	auto FindModel = [&](const std::string& assetAlias, const std::string& materialAlias, u32& modelIdx) -> bool
+	{
+		auto asset		= assetAliases.find(assetAlias);
+		auto material	= materialAliases.find(materialAlias);
+		if (asset == assetAliases.end() || (!materialAlias.empty() && material == materialAliases.end()))
+		{
+			return false;
+		}
+
+		const std::pair<u32, u32> key = { asset->second, (materialAlias.empty()) ? COOKED_SCENE_NO_MATERIAL : material->second };
+		auto found = modelIndices.find(key);
+		if (found == modelIndices.end())
+		{
+			found = modelIndices.insert({ key, (u32)models.size() }).first;
+			models.push_back({ key.first, key.second });
+		}
+		modelIdx = found->second;
+		return true;
+	};
+
+	const char* text	= (const char*)source.data;
+	const char* end		= text + source.size;
+	u32 lineNumber		= 0;
+	bool isValid		= true;
+	std::vector<std::string> tokens;
+	while (text < end && isValid)
+	{
+		const char* lineEnd = (const char*)memchr(text, '\n', end - text);
+		lineEnd = (lineEnd != nullptr) ? lineEnd : end;
+		++lineNumber;
+
+		tokens.clear();
+		for (const char* c = text; c < lineEnd && *c != '#'; )
+		{
+			while (c < lineEnd && (*c == ' ' || *c == '\t' || *c == '\r')) { ++c; }
+			const char* tokenStart = c;
+			while (c < lineEnd && *c != ' ' && *c != '\t' && *c != '\r' && *c != '#') { ++c; }
+			if (c > tokenStart) { tokens.push_back(std::string(tokenStart, c)); }
+		}
+		text = lineEnd + 1;
+
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		SceneOptions options		= {};
+		const std::string& keyword	= tokens[0];
+		if (keyword == "model")
+		{
+			isValid = tokens.size() >= 3 && ParseOptions(tokens, 3, options) && assetAliases.count(tokens[1]) == 0;
+			if (isValid)
+			{
+				assetAliases[tokens[1]] = (u32)assets.size();
+				assets.push_back({ AddString(tokens[2]), (options.isImpostor) ? (u32)COOKED_SCENE_IMPOSTOR : 0u });
+			}
+		}
+		else if (keyword == "material")
+		{
+			isValid = tokens.size() >= 2 && ParseOptions(tokens, 2, options) && materialAliases.count(tokens[1]) == 0;
+			if (isValid)
+			{
+				SceneMaterial material	= {};
+				material.name			= AddString(tokens[1]);
+				material.albedoTexture	= AddString(options.texture);
+				material.albedo			= options.albedo;
+				material.emissive		= options.emissive;
+				material.smoothness		= options.smoothness;
+
+				materialAliases[tokens[1]] = (u32)materials.size();
+				materials.push_back(material);
+			}
+		}
+		else if (keyword == "entity")
+		{
+			SceneEntity entity = {};
+			isValid = tokens.size() >= 3 && ParseOptions(tokens, 3, options) && FindModel(tokens[2], options.material, entity.modelIdx);
+			if (isValid)
+			{
+				entity.worldMatrix	= BuildWorldMatrix(options.position, options.rotation, options.scale);
+				entity.name			= AddString(tokens[1]);
+				entities.push_back(entity);
+			}
+		}
+		else if (keyword == "grid")
+		{
+			u32 modelIdx	= 0;
+			vec3 counts		= vec3(0.0f);
+			vec3 spacing	= vec3(0.0f);
+			u32 cursor		= 2;
+			isValid = tokens.size() >= 2 && ParseVec3(tokens, cursor, counts) && ParseVec3(tokens, cursor, spacing) && ParseOptions(tokens, cursor, options)
+				   && FindModel(tokens[1], options.material, modelIdx) && glm::all(glm::greaterThanEqual(counts, vec3(0.0f)))
+				   && (f64)counts.x * counts.y * counts.z + entities.size() < (f64)(UINT32_MAX / 2);
+			if (isValid)
+			{
+				const u32 countX = (u32)counts.x;
+				const u32 countY = (u32)counts.y;
+				const u32 countZ = (u32)counts.z;
+				entities.reserve(entities.size() + (size_t)countX * countY * countZ);
+				for (u32 z = 0; z < countZ; ++z)
+				{
+					for (u32 y = 0; y < countY; ++y)
+					{
+						for (u32 x = 0; x < countX; ++x)
+						{
+							SceneEntity entity	= {};
+							entity.worldMatrix	= BuildWorldMatrix(options.position + spacing * vec3(x, y, z), options.rotation, options.scale);
+							entity.modelIdx		= modelIdx;
+							entities.push_back(entity);
+						}
+					}
+				}
+			}
+		}
+		else if (keyword == "light")
+		{
+			isValid = tokens.size() >= 2 && (tokens[1] == "directional" || tokens[1] == "point") && ParseOptions(tokens, 2, options);
+			if (isValid)
+			{
+				SceneLight light	= {};
+				light.type			= (tokens[1] == "point") ? LT_POINT : LT_DIRECTIONAL;
+				light.color			= options.color;
+				light.direction		= options.direction;
+				light.position		= options.position;
+				light.attenuation	= options.attenuation;
+				lights.push_back(light);
+			}
+		}
+		else if (keyword == "cells")
+		{
+			isValid = tokens.size() == 2 && cellSize == 0.0f && ParseFloat(tokens[1], cellSize) && cellSize > 0.0f;
+		}
+		else
+		{
+			isValid = false;
+		}
+
+		if (!isValid)
+		{
+			ELOG("%s(%u): invalid %s statement", filepath, lineNumber, keyword.c_str());
+		}
+	}
+
+	FileManager::UnmapFile(source);
+	if (!isValid)
+	{
+		return false;
+	}
+
+	std::vector<SceneCell> cells;
+	std::vector<u32> cellModels;
+	if (cellSize > 0.0f)
+	{
+		Utils::BuildCells(entities, cellSize, cells, cellModels);
+	}
+
+	// LAYOUT
+	CookedSceneHeader header	= {};
+	header.magic				= COOKED_SCENE_MAGIC;
+	header.version				= COOKED_SCENE_VERSION;
+	header.sourceHash			= sourceHash;
+	header.sourceTimestamp		= sourceTimestamp;
+	header.assetCount			= (u32)assets.size();
+	header.materialCount		= (u32)materials.size();
+	header.modelCount			= (u32)models.size();
+	header.entityCount			= (u32)entities.size();
+	header.lightCount			= (u32)lights.size();
+	header.stringsSize			= (u32)strings.size();
+	header.cellCount			= (u32)cells.size();
+	header.cellModelCount		= (u32)cellModels.size();
+	header.cellSize				= cellSize;
+
+	cookedFile.assign(sizeof(header), 0);
+	auto Append = [&cookedFile](const void* data, size_t size) -> u64
+	{
+		const u64 offset = (cookedFile.size() + COOKED_SCENE_ALIGNMENT - 1) & ~(u64)(COOKED_SCENE_ALIGNMENT - 1);
+		cookedFile.resize((size_t)offset + size);
+		if (size > 0)
+		{
+			memcpy(cookedFile.data() + offset, data, size);
+		}
+		return offset;
+	};
+
+	header.assetsOffset			= Append(assets.data(), assets.size() * sizeof(SceneAsset));
+	header.materialsOffset		= Append(materials.data(), materials.size() * sizeof(SceneMaterial));
+	header.modelsOffset			= Append(models.data(), models.size() * sizeof(SceneModel));
+	header.entitiesOffset		= Append(entities.data(), entities.size() * sizeof(SceneEntity));
+	header.lightsOffset			= Append(lights.data(), lights.size() * sizeof(SceneLight));
+	header.stringsOffset		= Append(strings.data(), strings.size());
+	header.cellsOffset			= Append(cells.data(), cells.size() * sizeof(SceneCell));
+	header.cellModelsOffset		= Append(cellModels.data(), cellModels.size() * sizeof(u32));
+	memcpy(cookedFile.data(), &header, sizeof(header));
+
+	return true;
+}
+
+bool SceneCooker::CookFile(const char* filepath)
+{
+	u64 sourceHash				= 0;
+	const u64 sourceTimestamp	= FileManager::GetFileLastWriteTimestamp(filepath);
+	std::vector<u8> cookedFile;
+
+	return FileManager::HashFile(filepath, sourceHash) && Cook(filepath, sourceHash, sourceTimestamp, cookedFile)
+		&& FileManager::WriteBinaryFile(Utils::GetCookedPath(filepath).c_str(), cookedFile.data(), cookedFile.size());
+}
+
+// UTILS -------------------------------------------------------------------
+std::string SceneCooker::Utils::GetCookedPath(const char* sourcePath)
+{
+	return std::string(sourcePath) + ".cscene";
+}
+
+// Every index and string is checked here once, so the load can copy the arrays without any test.
+bool SceneCooker::Utils::IsUpToDate(const u8* cookedFile, u64 size, const char* sourcePath)
+{
+	const CookedSceneHeader* header = (const CookedSceneHeader*)cookedFile;
+	if (size < sizeof(CookedSceneHeader) || header->magic != COOKED_SCENE_MAGIC || header->version != COOKED_SCENE_VERSION
+	 || (sourcePath != nullptr && !FileManager::IsSourceUnchanged(sourcePath, header->sourceHash, header->sourceTimestamp)))
+	{
+		return false;
+	}
+
+	const bool fits = header->assetsOffset + (u64)header->assetCount * sizeof(SceneAsset) <= size
+				   && header->materialsOffset + (u64)header->materialCount * sizeof(SceneMaterial) <= size
+				   && header->modelsOffset + (u64)header->modelCount * sizeof(SceneModel) <= size
+				   && header->entitiesOffset + (u64)header->entityCount * sizeof(SceneEntity) <= size
+				   && header->lightsOffset + (u64)header->lightCount * sizeof(SceneLight) <= size
+				   && header->stringsOffset + header->stringsSize <= size
+				   && header->cellsOffset + (u64)header->cellCount * sizeof(SceneCell) <= size
+				   && header->cellModelsOffset + (u64)header->cellModelCount * sizeof(u32) <= size;
+	if (!fits)
+	{
+		return false;
+	}
+
+	auto IsInStrings = [header](const SceneString& string) { return (u64)string.offset + string.length <= header->stringsSize; };
+
+	const SceneAsset* assets		= (const SceneAsset*)(cookedFile + header->assetsOffset);
+	const SceneMaterial* materials	= (const SceneMaterial*)(cookedFile + header->materialsOffset);
+	const SceneModel* models		= (const SceneModel*)(cookedFile + header->modelsOffset);
+	const SceneEntity* entities		= (const SceneEntity*)(cookedFile + header->entitiesOffset);
+	const SceneCell* cells			= (const SceneCell*)(cookedFile + header->cellsOffset);
+	const u32* cellModels			= (const u32*)(cookedFile + header->cellModelsOffset);
+
+	bool isValid = true;
+	for (u32 i = 0; i < header->assetCount; ++i)	{ isValid = isValid && IsInStrings(assets[i].path); }
+	for (u32 i = 0; i < header->materialCount; ++i)	{ isValid = isValid && IsInStrings(materials[i].name) && IsInStrings(materials[i].albedoTexture); }
+	for (u32 i = 0; i < header->modelCount; ++i)	{ isValid = isValid && models[i].assetIdx < header->assetCount && (models[i].materialIdx < header->materialCount || models[i].materialIdx == COOKED_SCENE_NO_MATERIAL); }
+	for (u32 i = 0; i < header->entityCount; ++i)	{ isValid = isValid && entities[i].modelIdx < header->modelCount && IsInStrings(entities[i].name); }
+	for (u32 i = 0; i < header->cellCount; ++i)		{ isValid = isValid && (u64)cells[i].firstEntity + cells[i].entityCount <= header->entityCount && (u64)cells[i].firstModel + cells[i].modelCount <= header->cellModelCount; }
+	for (u32 i = 0; i < header->cellModelCount; ++i){ isValid = isValid && cellModels[i] < header->modelCount; }
+
+	return isValid;
+}
+
+// Stable, so the entities of a cell keep the order of the text.
+void SceneCooker::Utils::BuildCells(std::vector<SceneEntity>& entities, f32 cellSize, std::vector<SceneCell>& cells, std::vector<u32>& cellModels)
+{
+	std::vector<std::pair<std::pair<i32, i32>, u32>> order(entities.size());								// ((x, z), entity).
+	for (u32 i = 0; i < entities.size(); ++i)
+	{
+		const vec3 position	= vec3(entities[i].worldMatrix[3]);
+		order[i]			= { { (i32)floorf(position.x / cellSize), (i32)floorf(position.z / cellSize) }, i };
+	}
+	std::stable_sort(order.begin(), order.end(), [](const std::pair<std::pair<i32, i32>, u32>& a, const std::pair<std::pair<i32, i32>, u32>& b) { return a.first < b.first; });
+
+	std::vector<SceneEntity> sorted(entities.size());
+	std::vector<u32> models;
+	for (u32 i = 0; i < order.size(); ++i)
+	{
+		sorted[i] = entities[order[i].second];
+		if (i == 0 || order[i].first != order[i - 1].first)
+		{
+			SceneCell cell		= {};
+			cell.x				= order[i].first.first;
+			cell.z				= order[i].first.second;
+			cell.firstEntity	= i;
+			cells.push_back(cell);
+			models.clear();
+		}
+
+		SceneCell& cell = cells.back();
+		++cell.entityCount;
+		if (std::find(models.begin(), models.end(), sorted[i].modelIdx) == models.end())
+		{
+			models.push_back(sorted[i].modelIdx);
+			cellModels.push_back(sorted[i].modelIdx);
+			cell.firstModel	= (u32)cellModels.size() - cell.modelCount - 1u;
+			++cell.modelCount;
+		}
+	}
+
+	entities.swap(sorted);
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef __SCENE_COOKER_H__
+#define __SCENE_COOKER_H__
+
+// scene_cooker.h:
+// Compiled scenes (<scene file>.cscene). Scenes are authored as text (.scene), one statement per line, '#' comments:
+//	model		<alias> <path> [impostor]														(a file, or @plane / @cube / @sphere)
+//	material	<alias> [albedo r g b] [emissive r g b] [smoothness s] [texture <path>]
+//	entity		<name> <model alias> [position x y z] [rotation x y z] [scale x y z | s] [material <alias>]
+//	grid		<model alias> <count x> <count y> <count z> <spacing x y z> [position ...] [rotation ...] [scale ...] [material ...]
+//	light		directional | point [color r g b] [direction x y z] [position x y z] [attenuation c l q]
+//	cells		<size>
+// Rotations are in degrees, applied as Z * Y * X. A grid places count x * y * z unnamed entities from its position.
+// With cells, the entities are sorted by the XZ cell of their position and a table gives the range of every cell and
+// the models it uses, so the world streamer (world_streaming.h) reads each cell with a single read.
+// Paths cannot hold spaces. The compiled file is flat arrays: the asset paths, the materials, the (model, material)
+// pairs the entities use, the entities with their world matrix already built, and the lights. Loading it
+// (scene.h) resolves the few assets and pairs and then fills the entities in bulk, with no parsing at all.
+// The file is rebuilt when the source text changes, by the cooker (cooker.h) or at load time. A missing source keeps the
+// compiled file as it is.
+
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+
+#define COOKED_SCENE_MAGIC			0x53504741															// "AGPS"
+#define COOKED_SCENE_VERSION		3
+#define COOKED_SCENE_ALIGNMENT		16
+#define COOKED_SCENE_NO_MATERIAL	UINT32_MAX																// The model keeps its own materials.
+#define COOKED_SCENE_IMPOSTOR		0x1																		// SceneAsset flags: bake an impostor of the model.
+
+struct CookedSceneHeader
+{
+	u32		magic;
+	u32		version;
+	u64		sourceHash;																				// FNV-1a of the .scene file.
+	u64		sourceTimestamp;																		// Its last write timestamp, see FileManager::IsSourceUnchanged().
+
+	u32		assetCount;
+	u32		materialCount;
+	u32		modelCount;
+	u32		entityCount;
+	u32		lightCount;
+	u32		stringsSize;
+	u32		cellCount;																				// 0 without a cells statement.
+	u32		cellModelCount;
+	f32		cellSize;
+
+	u64		assetsOffset;																			// Every offset is from the start of the file.
+	u64		materialsOffset;
+	u64		modelsOffset;
+	u64		entitiesOffset;
+	u64		lightsOffset;
+	u64		stringsOffset;																			// Paths and names, back to back, not terminated.
+	u64		cellsOffset;
+	u64		cellModelsOffset;																		// u32[cellModelCount], SceneModel indices.
+};
+
+struct SceneString
+{
+	u32		offset;																					// From stringsOffset.
+	u32		length;																					// 0 for none.
+};
+
+struct SceneAsset
+{
+	SceneString	path;
+	u32			flags;
+};
+
+struct SceneMaterial
+{
+	SceneString	name;
+	SceneString	albedoTexture;
+	vec3		albedo;
+	vec3		emissive;
+	f32			smoothness;
+};
+
+struct SceneModel																					// What an entity draws: an asset and its material override.
+{
+	u32		assetIdx;
+	u32		materialIdx;																			// COOKED_SCENE_NO_MATERIAL or a SceneMaterial.
+};
+
+struct SceneEntity
+{
+	mat4		worldMatrix;
+	u32			modelIdx;																			// SceneModel.
+	SceneString	name;																				// Empty for the grid entities.
+};
+
+struct SceneLight
+{
+	u32		type;																					// LIGHT_TYPE.
+	vec3	color;
+	vec3	direction;
+	vec3	position;
+	vec3	attenuation;
+};
+
+struct SceneCell
+{
+	i32		x;																						// Covers [x, x + 1) * cellSize, same for z.
+	i32		z;
+	u32		firstEntity;
+	u32		entityCount;
+	u32		firstModel;																				// In the cell models, the SceneModels its entities use.
+	u32		modelCount;
+};
+
+namespace SceneCooker
+{
+	bool Cook		(const char* filepath, u64 sourceHash, u64 sourceTimestamp, std::vector<u8>& cookedFile);	// Parses the .scene file. Whole .cscene file in memory.
+	bool CookFile	(const char* filepath);																	// Cook() and write it next to the source.
+
+	namespace Utils
+	{
+		std::string GetCookedPath		(const char* sourcePath);
+		bool		IsUpToDate			(const u8* cookedFile, u64 size, const char* sourcePath);			// Also validates the arrays. nullptr skips the source.
+		void		BuildCells			(std::vector<SceneEntity>& entities, f32 cellSize, std::vector<SceneCell>& cells, std::vector<u32>& cellModels);	// Sorts the entities.
+	}
+}
+
+#endif // !__SCENE_COOKER_H__
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "base_types.h"
 #include "math_types.h"
+#include "string_table.h"
 
 // RENDER MODE
 enum class RENDER_MODE          // FORWARD, DEFERRED, ALBEDO, NORMAL, DEPTH, POSITION
@@ -26,6 +27,20 @@ enum class RENDER_LAYER
     DEFAULT                     // ERROR CATCHING
 };
 
+enum class LIGHTING_MODE        // Deferred lighting technique.
+{
+    LIGHT_VOLUMES,
+    CLUSTERED,
+    TILED_COMPUTE
+};
+
+enum class LIGHT_VOLUME_MODE    // How LIGHT_VOLUMES submits its point-light spheres.
+{
+    SCISSOR,
+    INSTANCED,
+    STENCIL
+};
+
 // SHADER MODE
 enum class SHADER_MODE
 {
@@ -34,6 +49,13 @@ enum class SHADER_MODE
     ENTITIES
 };
 
+enum class TEXTURE_USAGE        // Decides the mip filter and the block compression a texture is cooked with.
+{
+    COLOR,                      // sRGB-encoded albedo / emissive / specular.       BC1 or BC7 (BC3 without BC7).
+    NORMAL,                     // Tangent-space normal map, Z rebuilt in shader.   BC5.
+    HEIGHT                      // Single channel height / relief.                  BC4.
+};
+
 // BUFFERS
 struct Buffer
 {
@@ -53,9 +75,11 @@ struct VAO
 
 struct VertexBufferAttribute
 {
-    u8 location;
-    u8 componentCount;
-    u8 offset;
+    u8  location;
+    u8  componentCount;
+    u8  offset;
+    u8  normalized;                             // GL_TRUE for the quantized integer formats.
+    u16 type;                                   // GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_SHORT, GL_INT_2_10_10_10_REV...
 };
 
 struct VertexBufferLayout
@@ -64,9 +88,15 @@ struct VertexBufferLayout
     
     void AddAttribute(u8 loc, u8 ncomp, size_t varSize) 
     { 
-        attributes.push_back({ loc, ncomp, stride }); 
+        attributes.push_back({ loc, ncomp, stride, GL_FALSE, GL_FLOAT }); 
         stride += ncomp * varSize; 
     }
+
+    void AddPackedAttribute(u8 loc, u8 ncomp, u16 type, u8 normalized, size_t byteSize)
+    {
+        attributes.push_back({ loc, ncomp, stride, normalized, type });
+        stride += byteSize;
+    }
     
     std::vector<VertexBufferAttribute>  attributes;
     u8                                  stride;
@@ -95,12 +125,12 @@ struct Image
 struct Texture
 {
     GLuint      handle;
-    std::string filepath;
+    StringId    filepath;
 };
 
 struct Material
 {
-    std::string name;
+    StringId    name;
     vec3        albedo;
     vec3        emissive;
     f32         smoothness;
@@ -111,15 +141,50 @@ struct Material
     u32         bumpTexIdx;
 };
 
+struct SubmeshLod
+{
+    u32                 firstIndex;             // Relative to the submesh's indexOffset.
+    u32                 indexCount;
+    f32                 error;                  // Geometric error in model units (0 for the source mesh).
+};
+
+struct Meshlet
+{
+    vec3                center;                 // Model-space bounding sphere.
+    f32                 radius;
+    vec3                coneApex;               // Normal cone: the meshlet is back-facing when
+    vec3                coneAxis;               // dot(normalize(coneApex - camera), coneAxis) >= coneCutoff.
+    f32                 coneCutoff;             // 1 when the normals are too spread to ever be culled.
+    u32                 firstIndex;             // Relative to the submesh's indexOffset.
+    u32                 indexCount;
+};
+
+struct DrawElementsIndirectCommand              // Layout fixed by glMultiDrawElementsIndirect().
+{
+    u32                 count;
+    u32                 instanceCount;
+    u32                 firstIndex;
+    u32                 baseVertex;
+    u32                 baseInstance;
+};
+
 struct Submesh
 {
     std::vector<float>  vertices;               // Create Vertex struct?
-    std::vector<u32>    indices;
+    std::vector<u32>    indices;                // Every LOD, one after the other. Narrowed to indexType on upload.
+    std::vector<SubmeshLod> lods;               // lods[0] is the full resolution submesh.
+    std::vector<Meshlet> meshlets;              // Partition of lods[0], which is stored meshlet by meshlet.
     u32                 vertexOffset;
     u32                 indexOffset;
+    GLenum              indexType;              // GPU index format, GL_UNSIGNED_SHORT when every vertex fits in 16 bits.
 
-    VertexBufferLayout  VBL;                    // Vertex Buffer Layout
+    VertexBufferLayout  VBL;                    // Vertex Buffer Layout (of vertices, always floats).
+    VertexBufferLayout  packedVBL;              // Quantized layout of the GPU buffer. Empty when it holds the floats as they are.
+    vec3                positionOffset;         // Dequantization: position = packed * positionScale + positionOffset.
+    vec3                positionScale;
     std::vector<VAO>    vaos;
+
+    u32 GetIndexSize() const { return (indexType == GL_UNSIGNED_SHORT) ? sizeof(u16) : sizeof(u32); }
 };
 
 struct Mesh
@@ -127,23 +192,29 @@ struct Mesh
     std::vector<Submesh> submeshes;
     GLuint               vertexBufferHandle;
     GLuint               indexBufferHandle;
+
+    vec3                 boundsCenter;          // Model-space bounding sphere.
+    f32                  boundsRadius;
 };
 
 struct Model
 {
     u32              meshIdx;
     std::vector<u32> materialIndices;
-    std::string      fileName;
+    StringId         fileName;
 };
 
 struct Entity
 {
-    std::string name;
+    StringId name;
     
     mat4 worldMatrix;
     u32  modelIndex;
     u32  localParamsOffset;
     u32  localParamsSize;
+    u32  lodLevel;                              // LOD selected this frame, kept for the hysteresis.
+    bool isHidden;                              // Replaced by an HLOD proxy (or a proxy not in use).
+    bool isImpostor;                            // Drawn by the impostor pass this frame.
 };
 
 struct Program
@@ -152,6 +223,7 @@ struct Program
     std::string        filepath;
     std::string        programName;
     u64                lastWriteTimestamp;  // Hot-reloading check.
+    bool               isCompute;           // Built from a single COMPUTE stage.
 
     VertexBufferLayout VIL;                 // Vertex Input Layout.
 };
@@ -177,9 +249,23 @@ struct Light
     vec3        color;
     vec3        direction;
     vec3        position;
+    vec3        attenuation;                // Constant, linear and quadratic attenuation factors.
+    f32         radius;                     // Influence radius derived from the attenuation.
     mat4        worldMatrix;
     u32         localParamsOffset;
     u32         localParamsSize;
+
+    bool        isVisible;                  // ---
+    ivec4       scissorRect;                // Per-frame culling results (x, y, width, height in pixels).
+    vec2        depthBounds;                // Min/Max view-space depth covered by the light volume.
+};
+
+struct GpuLight                             // std430 mirror of GpuLight in shader_final.glsl.
+{
+    vec4        positionRadius;             // xyz: Position,   w: Radius.
+    vec4        colorType;                  // rgb: Color,      a: LIGHT_TYPE.
+    vec4        direction;                  // xyz: Direction.
+    vec4        attenuation;                // xyz: Constant, Linear, Quadratic.
 };
 
 #endif // !__SHADER_TYPES_H__
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+#include "globals.h"
+
+#include "string_table.h"
+
+#define STRING_TABLE_CHUNK_SIZE	KB(64)
+#define STRING_TABLE_MIN_SLOTS	1024
+#define ID_MAP_MIN_SLOTS		16
+
+std::mutex					GlobalStringMutex;
+std::vector<char*>			GlobalStringChunks;														// Never reallocated, so the pointers stay valid.
+u32							GlobalStringChunkHead		= 0;
+u32							GlobalStringChunkCapacity	= 0;
+std::vector<const char*>	GlobalStrings;															// Indexed by StringId.
+std::vector<u32>			GlobalStringHashes;
+std::vector<StringId>		GlobalStringSlots;														// Power of two, kept at most half full.
+
+static void SetUpTable()
+{
+	GlobalStrings.push_back("");
+	GlobalStringHashes.push_back(StringTable::Utils::HashString("", 0));
+	GlobalStringSlots.assign(STRING_TABLE_MIN_SLOTS, INVALID_STRING_ID);
+}
+
+void StringTable::Init()
+{
+	std::lock_guard<std::mutex> lock(GlobalStringMutex);
+	if (GlobalStringSlots.empty())
+	{
+		SetUpTable();
+	}
+}
+
+void StringTable::CleanUp()
+{
+	std::lock_guard<std::mutex> lock(GlobalStringMutex);
+	for (u32 i = 0; i < GlobalStringChunks.size(); ++i)
+	{
+		free(GlobalStringChunks[i]);
+	}
+
+	GlobalStringChunks.clear();
+	GlobalStrings.clear();
+	GlobalStringHashes.clear();
+	GlobalStringSlots.clear();
+	GlobalStringChunkHead		= 0;
+	GlobalStringChunkCapacity	= 0;
+}
+
+StringId StringTable::Intern(const char* string)
+{
+	if (string == nullptr || string[0] == '\0')
+	{
+		return INVALID_STRING_ID;
+	}
+
+	std::lock_guard<std::mutex> lock(GlobalStringMutex);
+	if (GlobalStringSlots.empty())
+	{
+		SetUpTable();
+	}
+
+	const u32 length	= (u32)strlen(string);
+	const u32 hash		= Utils::HashString(string, length);
+	const u32 mask		= (u32)GlobalStringSlots.size() - 1u;
+
+	u32 slot = hash & mask;
+	for (; GlobalStringSlots[slot] != INVALID_STRING_ID; slot = (slot + 1) & mask)
+	{
+		const StringId id = GlobalStringSlots[slot];
+		if (GlobalStringHashes[id] == hash && strcmp(GlobalStrings[id], string) == 0)
+		{
+			return id;
+		}
+	}
+
+	if (GlobalStringChunks.empty() || GlobalStringChunkHead + length + 1 > GlobalStringChunkCapacity)
+	{
+		GlobalStringChunkCapacity	= (length + 1 > STRING_TABLE_CHUNK_SIZE) ? length + 1 : STRING_TABLE_CHUNK_SIZE;
+		GlobalStringChunkHead		= 0;
+		GlobalStringChunks.push_back((char*)malloc(GlobalStringChunkCapacity));
+	}
+
+	char* storage = GlobalStringChunks.back() + GlobalStringChunkHead;
+	memcpy(storage, string, length + 1);
+	GlobalStringChunkHead += length + 1;
+
+	const StringId id = (StringId)GlobalStrings.size();
+	GlobalStrings.push_back(storage);
+	GlobalStringHashes.push_back(hash);
+	GlobalStringSlots[slot] = id;
+
+	if (GlobalStrings.size() * 2 > GlobalStringSlots.size())
+	{
+		Utils::GrowTable();
+	}
+
+	return id;
+}
+
+const char* StringTable::GetString(StringId id)
+{
+	std::lock_guard<std::mutex> lock(GlobalStringMutex);
+	return (id < GlobalStrings.size()) ? GlobalStrings[id] : "";
+}
+
+void StringTable::MapInsert(IdMap& map, StringId key, u32 value)
+{
+	if ((map.count + 1) * 2 > map.keys.size())
+	{
+		Utils::GrowMap(map);
+	}
+
+	const u32 mask = (u32)map.keys.size() - 1u;
+	for (u32 slot = Utils::HashId(key) & mask; ; slot = (slot + 1) & mask)
+	{
+		if (map.keys[slot] == key)
+		{
+			map.values[slot] = value;
+			return;
+		}
+
+		if (map.keys[slot] == INVALID_STRING_ID)
+		{
+			map.keys[slot]		= key;
+			map.values[slot]	= value;
+			++map.count;
+			return;
+		}
+	}
+}
+
+u32 StringTable::MapFind(const IdMap& map, StringId key)
+{
+	if (map.keys.empty() || key == INVALID_STRING_ID)
+	{
+		return UINT32_MAX;
+	}
+
+	const u32 mask = (u32)map.keys.size() - 1u;
+	for (u32 slot = Utils::HashId(key) & mask; map.keys[slot] != INVALID_STRING_ID; slot = (slot + 1) & mask)
+	{
+		if (map.keys[slot] == key)
+		{
+			return map.values[slot];
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+// UTILS -------------------------------------------------------------------
+u32 StringTable::Utils::HashString(const char* string, u32 length)
+{
+	u32 hash = 2166136261u;																			// 32-bit FNV-1a.
+	for (u32 i = 0; i < length; ++i)
+	{
+		hash = (hash ^ (u8)string[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+u32 StringTable::Utils::HashId(StringId id)
+{
+	return id * 2654435761u;																		// Ids are sequential, spread them over the slots.
+}
+
+// Called with GlobalStringMutex held.
+void StringTable::Utils::GrowTable()
+{
+	std::vector<StringId> slots(GlobalStringSlots.size() * 2, INVALID_STRING_ID);
+	const u32 mask = (u32)slots.size() - 1u;
+
+	for (StringId id = 1; id < GlobalStrings.size(); ++id)
+	{
+		u32 slot = GlobalStringHashes[id] & mask;
+		while (slots[slot] != INVALID_STRING_ID)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		slots[slot] = id;
+	}
+
+	GlobalStringSlots.swap(slots);
+}
+
+void StringTable::Utils::GrowMap(IdMap& map)
+{
+	IdMap grown		= {};
+	const u32 size	= (map.keys.empty()) ? ID_MAP_MIN_SLOTS : (u32)map.keys.size() * 2;
+	grown.keys.assign(size, INVALID_STRING_ID);
+	grown.values.assign(size, 0);
+
+	for (u32 slot = 0; slot < map.keys.size(); ++slot)
+	{
+		if (map.keys[slot] != INVALID_STRING_ID)
+		{
+			MapInsert(grown, map.keys[slot], map.values[slot]);
+		}
+	}
+
+	map.keys.swap(grown.keys);
+	map.values.swap(grown.values);
+	map.count = grown.count;
+}
\ No newline at end of file
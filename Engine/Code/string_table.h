@@ -0,0 +1,44 @@
+#ifndef __STRING_TABLE_H__
+#define __STRING_TABLE_H__
+
+// string_table.h:
+// Global string interning. Every distinct path or name is stored once and referred to by a 32-bit StringId, so assets
+// carry 4 bytes instead of a heap allocated std::string and comparing two names is comparing two integers. IdMap is an
+// open-addressing (linear probing) map from StringId to an asset index, used for the O(1) load-time deduplication.
+
+#include <vector>
+
+#include "base_types.h"
+
+typedef u32 StringId;
+
+#define INVALID_STRING_ID	0																		// Also the id of "".
+
+struct IdMap
+{
+	std::vector<StringId>	keys;																	// INVALID_STRING_ID marks an empty slot.
+	std::vector<u32>		values;
+	u32						count;
+};
+
+namespace StringTable
+{
+	void		Init		();
+	void		CleanUp		();
+
+	StringId	Intern		(const char* string);													// Thread safe.
+	const char*	GetString	(StringId id);															// Stays valid until CleanUp().
+
+	void		MapInsert	(IdMap& map, StringId key, u32 value);
+	u32			MapFind		(const IdMap& map, StringId key);										// UINT32_MAX when missing.
+
+	namespace Utils
+	{
+		u32		HashString	(const char* string, u32 length);
+		u32		HashId		(StringId id);
+		void	GrowTable	();
+		void	GrowMap		(IdMap& map);
+	}
+}
+
+#endif // !__STRING_TABLE_H__
\ No newline at end of file
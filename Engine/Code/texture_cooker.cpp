@@ -0,0 +1,521 @@
+#include <float.h>
+#include <string.h>
+
+#include "globals.h"
+#include "file_manager.h"
+
+#include "texture_cooker.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define COOKER_USE_SSE 1
+#else
+#define COOKER_USE_SSE 0
+#endif
+
+static const u32 BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Filter space: linear light for color, unit vectors in [-1, 1] for normals, raw [0, 1] for heights.
+static vec4 FetchSourceTexel(const Image& image, i32 x, i32 y, TEXTURE_USAGE usage)
+{
+	const u8* pixel		= (const u8*)image.pixels + y * image.stride + x * image.nchannels;
+	const i32 channels	= image.nchannels;
+
+	vec4 texel;
+	texel.r = pixel[0] / 255.0f;
+	texel.g = (channels >= 3) ? pixel[1] / 255.0f : texel.r;
+	texel.b = (channels >= 3) ? pixel[2] / 255.0f : texel.r;
+	texel.a = (channels == 2) ? pixel[1] / 255.0f : ((channels == 4) ? pixel[3] / 255.0f : 1.0f);
+
+	switch (usage)
+	{
+	case TEXTURE_USAGE::COLOR:
+		texel.r = TextureCooker::Utils::SrgbToLinear(texel.r);
+		texel.g = TextureCooker::Utils::SrgbToLinear(texel.g);
+		texel.b = TextureCooker::Utils::SrgbToLinear(texel.b);
+		break;
+
+	case TEXTURE_USAGE::NORMAL:
+	{
+		vec3 normal		= vec3(texel) * 2.0f - 1.0f;
+		f32 length		= glm::length(normal);
+		texel			= vec4((length > 0.0f) ? normal / length : vec3(0.0f, 0.0f, 1.0f), 1.0f);
+	}	break;
+
+	case TEXTURE_USAGE::HEIGHT:
+		break;
+	}
+
+	return texel;
+}
+
+// Back to the [0, 255] values the block encoders quantize.
+static vec4 ToEncodeSpace(const vec4& texel, TEXTURE_USAGE usage)
+{
+	vec4 encoded = texel;
+	switch (usage)
+	{
+	case TEXTURE_USAGE::COLOR:
+		encoded = vec4(TextureCooker::Utils::LinearToSrgb(texel.r), TextureCooker::Utils::LinearToSrgb(texel.g), TextureCooker::Utils::LinearToSrgb(texel.b), texel.a);
+		break;
+
+	case TEXTURE_USAGE::NORMAL:
+		encoded = vec4(vec3(texel) * 0.5f + 0.5f, 1.0f);
+		break;
+
+	case TEXTURE_USAGE::HEIGHT:
+		break;
+	}
+
+	return glm::clamp(encoded * 255.0f, vec4(0.0f), vec4(255.0f));
+}
+
+// Principal axis of a block by power iteration. Falls back to the diagonal for flat blocks.
+static vec4 PrincipalAxis(const mat4& covariance, u32 components)
+{
+	vec4 axis = (components == 3) ? vec4(1.0f, 1.0f, 1.0f, 0.0f) : vec4(1.0f);
+	for (u32 i = 0; i < 8; ++i)
+	{
+		vec4 next	= covariance * axis;
+		f32 length	= glm::length(next);
+		if (length < 1e-6f)
+		{
+			break;
+		}
+
+		axis = next / length;
+	}
+
+	return glm::normalize(axis);
+}
+
+static void FitEndpoints(const vec4 texels[16], u32 components, vec4& endpoint0, vec4& endpoint1)
+{
+	const vec4 mask = (components == 3) ? vec4(1.0f, 1.0f, 1.0f, 0.0f) : vec4(1.0f);
+
+	vec4 mean = vec4(0.0f);
+	for (u32 i = 0; i < 16; ++i)
+	{
+		mean += texels[i] * mask;
+	}
+	mean /= 16.0f;
+
+	mat4 covariance = mat4(0.0f);
+	for (u32 i = 0; i < 16; ++i)
+	{
+		vec4 d = texels[i] * mask - mean;
+		covariance += glm::outerProduct(d, d);
+	}
+
+	const vec4 axis = PrincipalAxis(covariance, components);
+
+	f32 minT = FLT_MAX;
+	f32 maxT = -FLT_MAX;
+	for (u32 i = 0; i < 16; ++i)
+	{
+		f32 t = glm::dot(texels[i] * mask - mean, axis);
+		minT = glm::min(minT, t);
+		maxT = glm::max(maxT, t);
+	}
+
+	endpoint0 = glm::clamp(mean + axis * maxT, vec4(0.0f), vec4(255.0f));
+	endpoint1 = glm::clamp(mean + axis * minT, vec4(0.0f), vec4(255.0f));
+}
+
+static u16 Pack565(const vec4& color)
+{
+	const u32 r = (u32)(color.r * 31.0f / 255.0f + 0.5f);
+	const u32 g = (u32)(color.g * 63.0f / 255.0f + 0.5f);
+	const u32 b = (u32)(color.b * 31.0f / 255.0f + 0.5f);
+
+	return (u16)((r << 11) | (g << 5) | b);
+}
+
+static vec4 Unpack565(u16 packed)
+{
+	const u32 r = (packed >> 11) & 31;
+	const u32 g = (packed >> 5) & 63;
+	const u32 b = packed & 31;
+
+	return vec4((f32)((r << 3) | (r >> 2)), (f32)((g << 2) | (g >> 4)), (f32)((b << 3) | (b >> 2)), 255.0f);
+}
+
+static void WriteBits(u8* block, u32& bitCursor, u32 value, u32 bitCount)
+{
+	for (u32 b = 0; b < bitCount; ++b, ++bitCursor)
+	{
+		block[bitCursor >> 3] |= (u8)(((value >> b) & 1u) << (bitCursor & 7u));
+	}
+}
+
+static f32 DistanceSq(const vec4& a, const vec4& b)
+{
+	vec4 d = a - b;
+	return glm::dot(d, d);
+}
+
+bool TextureCooker::Cook(const Image& image, TEXTURE_USAGE usage, u64 sourceHash, u64 sourceTimestamp, std::vector<u8>& cookedFile)
+{
+	if (!image.pixels || image.size.x <= 0 || image.size.y <= 0)
+	{
+		return false;
+	}
+
+	std::vector<std::vector<vec4>> mips;
+	std::vector<ivec2> sizes;
+	Utils::BuildMipChain(image, usage, mips, sizes);
+
+	CookedTextureHeader header	= {};
+	header.magic				= COOKED_TEXTURE_MAGIC;
+	header.version				= COOKED_TEXTURE_VERSION;
+	header.sourceHash			= sourceHash;
+	header.sourceTimestamp		= sourceTimestamp;
+	header.usage				= (u32)usage;
+	header.width				= (u32)image.size.x;
+	header.height				= (u32)image.size.y;
+	header.mipCount				= (u32)mips.size();
+
+	switch (usage)
+	{
+	case TEXTURE_USAGE::COLOR:
+	{
+		bool hasAlpha = false;
+		for (u32 i = 0; i < mips[0].size() && !hasAlpha; ++i)
+		{
+			hasAlpha = (mips[0][i].a < 254.5f / 255.0f);
+		}
+
+		header.glFormat = (!hasAlpha) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : (COOKED_TEXTURE_USE_BC7 ? GL_COMPRESSED_RGBA_BPTC_UNORM : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	}	break;
+
+	case TEXTURE_USAGE::NORMAL:	{ header.glFormat = GL_COMPRESSED_RG_RGTC2; }	break;
+	case TEXTURE_USAGE::HEIGHT:	{ header.glFormat = GL_COMPRESSED_RED_RGTC1; }	break;
+	}
+
+	header.blockSize = (header.glFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || header.glFormat == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+
+	cookedFile.assign(sizeof(CookedTextureHeader), 0);
+	for (u32 level = 0; level < mips.size(); ++level)
+	{
+		const ivec2 size		= sizes[level];
+		const u32	blocksX		= (size.x + 3) / 4;
+		const u32	blocksY		= (size.y + 3) / 4;
+
+		header.mipOffsets[level]	= cookedFile.size();
+		header.mipSizes[level]		= blocksX * blocksY * header.blockSize;
+		cookedFile.resize(cookedFile.size() + header.mipSizes[level], 0);
+
+		u8* block = cookedFile.data() + header.mipOffsets[level];
+		for (u32 by = 0; by < blocksY; ++by)
+		{
+			for (u32 bx = 0; bx < blocksX; ++bx, block += header.blockSize)
+			{
+				vec4 texels[16];
+				f32 channelA[16];
+				f32 channelB[16];
+				for (u32 i = 0; i < 16; ++i)
+				{
+					const i32 x	= glm::min((i32)(bx * 4 + (i & 3)), size.x - 1);					// Edge texels repeat on partial blocks.
+					const i32 y	= glm::min((i32)(by * 4 + (i >> 2)), size.y - 1);
+
+					texels[i]	= ToEncodeSpace(mips[level][y * size.x + x], usage);
+					channelA[i]	= (header.glFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? texels[i].a : texels[i].r;
+					channelB[i]	= texels[i].g;
+				}
+
+				switch (header.glFormat)
+				{
+				case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:	{ Utils::EncodeBC1Block(texels, block); }									break;
+				case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:	{ Utils::EncodeBC4Block(channelA, block); Utils::EncodeBC1Block(texels, block + 8); }	break;
+				case GL_COMPRESSED_RGBA_BPTC_UNORM:		{ Utils::EncodeBC7Block(texels, block); }									break;
+				case GL_COMPRESSED_RED_RGTC1:			{ Utils::EncodeBC4Block(channelA, block); }								break;
+				case GL_COMPRESSED_RG_RGTC2:			{ Utils::EncodeBC4Block(channelA, block); Utils::EncodeBC4Block(channelB, block + 8); }	break;
+				}
+			}
+		}
+	}
+
+	memcpy(cookedFile.data(), &header, sizeof(header));
+	return true;
+}
+
+// Levels below firstMip are left undefined and clamped out with GL_TEXTURE_BASE_LEVEL, the streamer (texture_streaming.h)
+// adds them later.
+GLuint TextureCooker::Upload(const u8* cookedFile, u64 size, u32 firstMip)
+{
+	if (size < sizeof(CookedTextureHeader))
+	{
+		return 0;
+	}
+
+	CookedTextureHeader header = {};
+	memcpy(&header, cookedFile, sizeof(header));
+
+	bool valid = (header.magic == COOKED_TEXTURE_MAGIC && header.version == COOKED_TEXTURE_VERSION && header.mipCount > 0 && header.mipCount <= COOKED_TEXTURE_MAX_MIPS);
+	firstMip   = glm::min(firstMip, header.mipCount - 1);
+	for (u32 level = firstMip; level < header.mipCount && valid; ++level)
+	{
+		valid = (header.mipOffsets[level] + header.mipSizes[level] <= size);
+	}
+
+	if (!valid)
+	{
+		return 0;
+	}
+
+	GLuint texHandle;
+	glGenTextures(1, &texHandle);
+	glBindTexture(GL_TEXTURE_2D, texHandle);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstMip);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.mipCount - 1);
+
+	for (u32 level = firstMip; level < header.mipCount; ++level)
+	{
+		const GLsizei width		= glm::max(1u, header.width >> level);
+		const GLsizei height	= glm::max(1u, header.height >> level);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, header.glFormat, width, height, 0, header.mipSizes[level], cookedFile + header.mipOffsets[level]);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texHandle;
+}
+
+// UTILS -------------------------------------------------------------------
+std::string TextureCooker::Utils::GetCookedPath(const char* sourcePath)
+{
+	return std::string(sourcePath) + ".ctex";
+}
+
+void TextureCooker::Utils::BuildMipChain(const Image& image, TEXTURE_USAGE usage, std::vector<std::vector<vec4>>& mips, std::vector<ivec2>& sizes)
+{
+	mips.clear();
+	sizes.clear();
+
+	mips.push_back(std::vector<vec4>((size_t)image.size.x * image.size.y));
+	sizes.push_back(image.size);
+	for (i32 y = 0; y < image.size.y; ++y)
+	{
+		for (i32 x = 0; x < image.size.x; ++x)
+		{
+			mips[0][y * image.size.x + x] = FetchSourceTexel(image, x, y, usage);
+		}
+	}
+
+	while ((sizes.back().x > 1 || sizes.back().y > 1) && mips.size() < COOKED_TEXTURE_MAX_MIPS)
+	{
+		const ivec2 srcSize = sizes.back();
+		const ivec2 dstSize = glm::max(srcSize / 2, ivec2(1));
+
+		mips.push_back(std::vector<vec4>());
+		sizes.push_back(dstSize);
+		Downsample(mips[mips.size() - 2], srcSize, usage, mips.back(), dstSize);
+	}
+}
+
+// 2x2 box filter. Odd sizes drop their last row / column, like the GPU's glGenerateMipmap() typically does.
+void TextureCooker::Utils::Downsample(const std::vector<vec4>& src, ivec2 srcSize, TEXTURE_USAGE usage, std::vector<vec4>& dst, ivec2 dstSize)
+{
+	dst.resize((size_t)dstSize.x * dstSize.y);
+
+#if COOKER_USE_SSE
+	const __m128 quarter = _mm_set1_ps(0.25f);
+#endif
+
+	for (i32 y = 0; y < dstSize.y; ++y)
+	{
+		const vec4* row0 = &src[glm::min(y * 2 + 0, srcSize.y - 1) * srcSize.x];
+		const vec4* row1 = &src[glm::min(y * 2 + 1, srcSize.y - 1) * srcSize.x];
+
+		for (i32 x = 0; x < dstSize.x; ++x)
+		{
+			const i32 x0 = glm::min(x * 2 + 0, srcSize.x - 1);
+			const i32 x1 = glm::min(x * 2 + 1, srcSize.x - 1);
+			vec4& texel	 = dst[y * dstSize.x + x];
+
+#if COOKER_USE_SSE
+			__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&row0[x0].x), _mm_loadu_ps(&row0[x1].x)), _mm_add_ps(_mm_loadu_ps(&row1[x0].x), _mm_loadu_ps(&row1[x1].x)));
+			_mm_storeu_ps(&texel.x, _mm_mul_ps(sum, quarter));
+#else
+			texel = (row0[x0] + row0[x1] + row1[x0] + row1[x1]) * 0.25f;
+#endif
+
+			if (usage == TEXTURE_USAGE::NORMAL)
+			{
+				f32 length	= glm::length(vec3(texel));
+				texel		= vec4((length > 0.0f) ? vec3(texel) / length : vec3(0.0f, 0.0f, 1.0f), 1.0f);
+			}
+		}
+	}
+}
+
+void TextureCooker::Utils::EncodeBC1Block(const vec4 texels[16], u8* block)
+{
+	vec4 endpoint0, endpoint1;
+	FitEndpoints(texels, 3, endpoint0, endpoint1);
+
+	u16 color0 = Pack565(endpoint0);
+	u16 color1 = Pack565(endpoint1);
+	if (color0 < color1)																			// color0 > color1 selects the 4 color mode.
+	{
+		u16 swap = color0; color0 = color1; color1 = swap;
+	}
+
+	u32 indices = 0;
+	if (color0 != color1)
+	{
+		vec4 palette[4];
+		palette[0] = Unpack565(color0);
+		palette[1] = Unpack565(color1);
+		palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+		palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			const vec4 color	= vec4(vec3(texels[i]), 255.0f);
+			u32 best			= 0;
+			for (u32 p = 1; p < 4; ++p)
+			{
+				best = (DistanceSq(color, palette[p]) < DistanceSq(color, palette[best])) ? p : best;
+			}
+
+			indices |= best << (i * 2);
+		}
+	}
+
+	block[0] = (u8)(color0 & 0xFF);		block[1] = (u8)(color0 >> 8);
+	block[2] = (u8)(color1 & 0xFF);		block[3] = (u8)(color1 >> 8);
+	memcpy(block + 4, &indices, sizeof(indices));
+}
+
+void TextureCooker::Utils::EncodeBC4Block(const f32 values[16], u8* block)
+{
+	f32 minValue = 255.0f;
+	f32 maxValue = 0.0f;
+	for (u32 i = 0; i < 16; ++i)
+	{
+		minValue = glm::min(minValue, values[i]);
+		maxValue = glm::max(maxValue, values[i]);
+	}
+
+	const u32 value0 = (u32)(maxValue + 0.5f);
+	const u32 value1 = (u32)(minValue + 0.5f);
+	block[0] = (u8)value0;
+	block[1] = (u8)value1;
+
+	u64 indices = 0;
+	if (value0 > value1)																			// 8 value mode: both ends + 6 interpolated.
+	{
+		f32 palette[8];
+		palette[0] = (f32)value0;
+		palette[1] = (f32)value1;
+		for (u32 p = 2; p < 8; ++p)
+		{
+			palette[p] = ((8 - p) * value0 + (p - 1) * value1) / 7.0f;
+		}
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			u32 best = 0;
+			for (u32 p = 1; p < 8; ++p)
+			{
+				best = (glm::abs(values[i] - palette[p]) < glm::abs(values[i] - palette[best])) ? p : best;
+			}
+
+			indices |= (u64)best << (i * 3);
+		}
+	}
+
+	for (u32 b = 0; b < 6; ++b)
+	{
+		block[2 + b] = (u8)(indices >> (b * 8));
+	}
+}
+
+// Mode 6 only: one subset, 7 bit RGBA endpoints with a p-bit each and 4 bit indices. It covers most albedo blocks well,
+// the multi-subset modes would only pay off on sharp color edges.
+void TextureCooker::Utils::EncodeBC7Block(const vec4 texels[16], u8* block)
+{
+	vec4 endpoints[2];
+	FitEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+	ivec4 quantized[2];
+	u32 pbits[2];
+	vec4 reconstructed[2];
+	for (u32 e = 0; e < 2; ++e)
+	{
+		f32 bestError = FLT_MAX;
+		for (u32 p = 0; p < 2; ++p)
+		{
+			ivec4 q		= glm::clamp(ivec4(glm::round((endpoints[e] - (f32)p) * 0.5f)), ivec4(0), ivec4(127));
+			vec4 value	= vec4(q * 2 + ivec4(p));
+			f32 error	= DistanceSq(value, endpoints[e]);
+			if (error < bestError)
+			{
+				bestError			= error;
+				quantized[e]		= q;
+				pbits[e]			= p;
+				reconstructed[e]	= value;
+			}
+		}
+	}
+
+	vec4 palette[16];
+	for (u32 p = 0; p < 16; ++p)
+	{
+		const ivec4 e0 = ivec4(reconstructed[0]);
+		const ivec4 e1 = ivec4(reconstructed[1]);
+		palette[p] = vec4((e0 * (i32)(64 - BC7_WEIGHTS_4[p]) + e1 * (i32)BC7_WEIGHTS_4[p] + 32) >> 6);
+	}
+
+	u32 indices[16];
+	for (u32 i = 0; i < 16; ++i)
+	{
+		indices[i] = 0;
+		for (u32 p = 1; p < 16; ++p)
+		{
+			indices[i] = (DistanceSq(texels[i], palette[p]) < DistanceSq(texels[i], palette[indices[i]])) ? p : indices[i];
+		}
+	}
+
+	if (indices[0] & 8)																				// The anchor index is stored without its top bit.
+	{
+		ivec4 swapQ = quantized[0];	quantized[0] = quantized[1];	quantized[1] = swapQ;
+		u32 swapP	= pbits[0];		pbits[0] = pbits[1];			pbits[1] = swapP;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	memset(block, 0, 16);
+	u32 bitCursor = 0;
+	WriteBits(block, bitCursor, 1u << 6, 7);														// Mode 6.
+	for (u32 c = 0; c < 4; ++c)
+	{
+		WriteBits(block, bitCursor, quantized[0][c], 7);
+		WriteBits(block, bitCursor, quantized[1][c], 7);
+	}
+	WriteBits(block, bitCursor, pbits[0], 1);
+	WriteBits(block, bitCursor, pbits[1], 1);
+
+	WriteBits(block, bitCursor, indices[0], 3);
+	for (u32 i = 1; i < 16; ++i)
+	{
+		WriteBits(block, bitCursor, indices[i], 4);
+	}
+}
+
+f32 TextureCooker::Utils::SrgbToLinear(f32 value)
+{
+	return (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+f32 TextureCooker::Utils::LinearToSrgb(f32 value)
+{
+	return (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
\ No newline at end of file
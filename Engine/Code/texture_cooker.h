@@ -0,0 +1,70 @@
+#ifndef __TEXTURE_COOKER_H__
+#define __TEXTURE_COOKER_H__
+
+// texture_cooker.h:
+// Cooked textures (<image file>.ctex). A small KTX2-like container with the whole mip chain already block compressed:
+// a header with the GL format, the size and a table of mip offsets, followed by the mips. The chain is filtered on the
+// CPU in the space each TEXTURE_USAGE needs (linear light for color, renormalized vectors for normals) and encoded as
+// BC1 / BC7 (BC3) for color, BC5 for normal maps and BC4 for heights. The loader (texture_loader.h) maps the file and
+// hands every mip to glCompressedTexImage2D() straight from the mapping. Files are rebuilt when the source changes, which
+// is only hashed again when its timestamp moved.
+
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+#define COOKED_TEXTURE_MAGIC		0x54504741															// "AGPT"
+#define COOKED_TEXTURE_VERSION		2
+#define COOKED_TEXTURE_MAX_MIPS		16
+#define COOKED_TEXTURE_USE_BC7		1																	// Color with alpha as BC7 (mode 6), else BC3.
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT																	// EXT_texture_compression_s3tc, not in glad.
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT		0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT	0x83F3
+#endif
+
+struct CookedTextureHeader
+{
+	u32		magic;
+	u32		version;
+	u64		sourceHash;																				// FNV-1a of the source image file.
+	u64		sourceTimestamp;																		// Its last write timestamp, see FileManager::IsSourceUnchanged().
+
+	u32		usage;																					// TEXTURE_USAGE it was cooked for.
+	u32		glFormat;																				// Compressed internal format of every mip.
+	u32		width;
+	u32		height;
+	u32		mipCount;
+	u32		blockSize;																				// Bytes per 4x4 block (8 or 16).
+
+	u64		mipOffsets[COOKED_TEXTURE_MAX_MIPS];													// From the start of the file.
+	u32		mipSizes[COOKED_TEXTURE_MAX_MIPS];
+};
+
+namespace TextureCooker
+{
+	bool	Cook	(const Image& image, TEXTURE_USAGE usage, u64 sourceHash, u64 sourceTimestamp, std::vector<u8>& cookedFile);	// Whole .ctex file in memory.
+	GLuint	Upload	(const u8* cookedFile, u64 size, u32 firstMip = 0);										// 0 when the file is malformed.
+
+	namespace Utils
+	{
+		std::string GetCookedPath		(const char* sourcePath);
+
+		void	BuildMipChain			(const Image& image, TEXTURE_USAGE usage, std::vector<std::vector<vec4>>& mips, std::vector<ivec2>& sizes);
+		void	Downsample				(const std::vector<vec4>& src, ivec2 srcSize, TEXTURE_USAGE usage, std::vector<vec4>& dst, ivec2 dstSize);
+
+		void	EncodeBC1Block			(const vec4 texels[16], u8* block);								// Texels in [0, 255].
+		void	EncodeBC4Block			(const f32 values[16], u8* block);
+		void	EncodeBC7Block			(const vec4 texels[16], u8* block);
+
+		f32		SrgbToLinear			(f32 value);
+		f32		LinearToSrgb			(f32 value);
+	}
+}
+
+#endif // !__TEXTURE_COOKER_H__
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include <string.h>
+
+#include "globals.h"
+#include "app.h"
+#include "importer.h"
+#include "texture_cooker.h"
+#include "texture_streaming.h"
+
+#include "texture_loader.h"
+
+void TextureLoader::Request(App* app, u32 texIdx, TEXTURE_USAGE usage)
+{
+	TextureLoadQueue& queue = app->textureLoads;
+
+	queue.loads.emplace_back();
+	TextureLoad* load	= &queue.loads.back();
+	load->texIdx		= texIdx;
+	load->usage			= usage;
+	load->filepath		= StringTable::GetString(app->textures[texIdx].filepath);						// Workers keep their own copy.
+	load->cookedMapping	= {};
+	load->isCookedOnDisk	= false;
+
+	if (app->isHeadless)																				// The cooker only collects the textures of the models, see cooker.h.
+	{
+		return;
+	}
+
+	JobSystem::Submit([load]() { Utils::DecodeTexture(load); }, &load->counter);
+}
+
+void TextureLoader::ProcessUploads(App* app)
+{
+	TextureLoadQueue& queue = app->textureLoads;
+
+	for (auto load = queue.loads.begin(); load != queue.loads.end(); )
+	{
+		if (!JobSystem::IsDone(&load->counter))
+		{
+			++load;
+			continue;
+		}
+
+		const bool isMapped	= (load->cookedMapping.data != nullptr);
+		const u8* cookedData	= (isMapped) ? load->cookedMapping.data : load->cookedFile.data();
+		const u64 cookedSize	= (isMapped) ? load->cookedMapping.size : load->cookedFile.size();
+
+		// Only the low mips go up front when the streamer can fetch the rest. The placeholders themselves are not streamed.
+		CookedTextureHeader header	= {};
+		u32 initialMip				= 0;
+		if (load->isCookedOnDisk && queue.placeholdersReady && cookedSize >= sizeof(header))
+		{
+			memcpy(&header, cookedData, sizeof(header));
+			initialMip = TextureStreaming::GetInitialMip(header);
+		}
+
+		const GLuint texHandle = (cookedSize > 0) ? TextureCooker::Upload(cookedData, cookedSize, initialMip) : 0;
+		if (isMapped)
+		{
+			FileManager::UnmapFile(load->cookedMapping);
+		}
+
+		Texture& texture = app->textures[load->texIdx];
+		if (texHandle != 0)
+		{
+			texture.handle = texHandle;
+			if (initialMip > 0)
+			{
+				TextureStreaming::Register(app, load->texIdx, header, initialMip);
+			}
+		}
+		else
+		{
+			ELOG("Could not load texture %s", load->filepath.c_str());
+			texture.handle = (load->usage == TEXTURE_USAGE::COLOR && queue.placeholdersReady) ? app->textures[app->magentaTexIdx].handle : texture.handle;
+		}
+
+		load = queue.loads.erase(load);
+	}
+}
+
+void TextureLoader::WaitAll(App* app)
+{
+	for (TextureLoad& load : app->textureLoads.loads)
+	{
+		JobSystem::Wait(&load.counter);
+	}
+
+	ProcessUploads(app);
+}
+
+// Neutral stand-ins while loading: white albedo, flat normal and zero height. 0 while the base textures themselves load.
+GLuint TextureLoader::GetPlaceholder(const App* app, TEXTURE_USAGE usage)
+{
+	if (!app->textureLoads.placeholdersReady)
+	{
+		return 0;
+	}
+
+	switch (usage)
+	{
+	case TEXTURE_USAGE::COLOR:	{ return app->textures[app->whiteTexIdx].handle; }
+	case TEXTURE_USAGE::NORMAL:	{ return app->textures[app->normalTexIdx].handle; }
+	case TEXTURE_USAGE::HEIGHT:	{ return app->textures[app->blackTexIdx].handle; }
+	}
+
+	return 0;
+}
+
+// UTILS -------------------------------------------------------------------
+void TextureLoader::Utils::DecodeTexture(TextureLoad* load)
+{
+	const std::string cookedPath = TextureCooker::Utils::GetCookedPath(load->filepath.c_str());
+	if (FileManager::MapFile(cookedPath.c_str(), load->cookedMapping))
+	{
+		const CookedTextureHeader* header = (const CookedTextureHeader*)load->cookedMapping.data;
+		if (load->cookedMapping.size >= sizeof(CookedTextureHeader) && header->magic == COOKED_TEXTURE_MAGIC && header->version == COOKED_TEXTURE_VERSION
+		 && header->usage == (u32)load->usage
+		 && (REQUIRE_COOKED_ASSETS || FileManager::IsSourceUnchanged(load->filepath.c_str(), header->sourceHash, header->sourceTimestamp)))	// Cooked-only builds trust the cooker.
+		{
+			load->isCookedOnDisk = true;
+			return;
+		}
+
+		FileManager::UnmapFile(load->cookedMapping);
+	}
+
+#if REQUIRE_COOKED_ASSETS
+	ELOG("Texture %s is not cooked or its cooked file is stale, run the cooker", load->filepath.c_str());
+#else
+	u64 sourceHash				= 0;
+	const u64 sourceTimestamp	= FileManager::GetFileLastWriteTimestamp(load->filepath.c_str());
+	if (!FileManager::HashFile(load->filepath.c_str(), sourceHash))
+	{
+		return;
+	}
+
+	Image image = Importer::Utils::LoadImage(load->filepath.c_str());
+	if (!image.pixels)
+	{
+		return;
+	}
+
+	if (TextureCooker::Cook(image, load->usage, sourceHash, sourceTimestamp, load->cookedFile))
+	{
+		load->isCookedOnDisk = FileManager::WriteBinaryFile(cookedPath.c_str(), load->cookedFile.data(), load->cookedFile.size());
+	}
+
+	Importer::Utils::FreeImage(image);
+#endif
+}
\ No newline at end of file
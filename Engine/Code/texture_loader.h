@@ -0,0 +1,53 @@
+#ifndef __TEXTURE_LOADER_H__
+#define __TEXTURE_LOADER_H__
+
+// texture_loader.h:
+// Asynchronous texture loading. Importer::LoadTexture2D() reserves the texture slot right away with a placeholder handle
+// and queues a job that hashes the source, maps its cooked file or decodes and cooks the image on a worker thread. The
+// render thread uploads the finished loads in ProcessUploads() and swaps the real handle into the same slot, so every
+// material keeps its texture index and picks up the final texture on the next frame.
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "shader_types.h"
+#include "file_manager.h"
+#include "job_system.h"
+
+struct App;
+
+struct TextureLoad
+{
+	u32						texIdx;
+	TEXTURE_USAGE			usage;
+	std::string				filepath;
+
+	MappedFile				cookedMapping;															// An up to date cooked file found on disk...
+	std::vector<u8>			cookedFile;																// ...or the one cooked from the decoded image.
+	bool					isCookedOnDisk;															// The streamer can read the missing mips back.
+	JobSystem::JobCounter	counter;
+};
+
+struct TextureLoadQueue
+{
+	std::list<TextureLoad>	loads;																	// std::list: the jobs hold pointers to their load.
+	bool					placeholdersReady;														// Base textures loaded, see GetPlaceholder().
+};
+
+namespace TextureLoader
+{
+	void	Request			(App* app, u32 texIdx, TEXTURE_USAGE usage);
+	void	ProcessUploads	(App* app);																// Render thread. Uploads every finished load.
+	void	WaitAll			(App* app);																// Helps with the pending jobs, then uploads.
+
+	GLuint	GetPlaceholder	(const App* app, TEXTURE_USAGE usage);
+
+	namespace Utils
+	{
+		void	DecodeTexture	(TextureLoad* load);												// Worker thread. No GL calls.
+	}
+}
+
+#endif // !__TEXTURE_LOADER_H__
\ No newline at end of file
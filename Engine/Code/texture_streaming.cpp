@@ -0,0 +1,308 @@
+#include <math.h>
+#include <string.h>
+#include <queue>
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "async_io.h"
+
+#include "texture_streaming.h"
+
+void TextureStreaming::Register(App* app, u32 texIdx, const CookedTextureHeader& header, u32 initialMip)
+{
+	TextureStreamer& streamer = app->textureStreamer;
+
+	StreamedTexture texture	= {};
+	texture.texIdx			= texIdx;
+	texture.sourceHash		= header.sourceHash;
+	texture.glFormat		= header.glFormat;
+	texture.width			= header.width;
+	texture.height			= header.height;
+	texture.mipCount		= header.mipCount;
+	memcpy(texture.mipOffsets, header.mipOffsets, sizeof(texture.mipOffsets));
+	memcpy(texture.mipSizes, header.mipSizes, sizeof(texture.mipSizes));
+
+	texture.initialMip		= initialMip;
+	texture.residentMip		= initialMip;
+	texture.requiredMip		= initialMip;
+	texture.targetMip		= initialMip;
+
+	if (streamer.streamIndices.size() <= texIdx)
+	{
+		streamer.streamIndices.resize(texIdx + 1, UINT32_MAX);
+	}
+	streamer.streamIndices[texIdx] = (u32)streamer.textures.size();
+	streamer.textures.push_back(texture);
+
+	streamer.residentBytes += Utils::GetResidentBytes(texture, initialMip);
+}
+
+void TextureStreaming::Update(App* app)
+{
+	TextureStreamer& streamer = app->textureStreamer;
+
+	Utils::ProcessLoads(app);
+	Utils::ComputeRequiredMips(app);
+	Utils::FitTargetsInBudget(app);
+
+	for (u32 i = 0; i < streamer.textures.size(); ++i)
+	{
+		StreamedTexture& texture = streamer.textures[i];
+		if (texture.residentMip > texture.targetMip)
+		{
+			texture.idleFrames = 0;
+			if (!texture.isLoading && !texture.readFailed && streamer.loads.size() < TEXTURE_STREAMING_MAX_LOADS)
+			{
+				Utils::RequestMip(app, i, texture.residentMip - 1);											// One level at a time, the coarser ones are cheaper.
+			}
+		}
+		else if (texture.residentMip < texture.targetMip)
+		{
+			++texture.idleFrames;
+			if (streamer.residentBytes > streamer.budget || texture.idleFrames > TEXTURE_STREAMING_KEEP_FRAMES)
+			{
+				Utils::ReleaseMip(app, i);
+			}
+		}
+		else
+		{
+			texture.idleFrames = 0;
+		}
+	}
+
+	AsyncIO::Submit();																						// This frame's requests in one batch.
+}
+
+// The first level that fits in TEXTURE_STREAMING_INITIAL_SIZE. 0 for the small textures, which are not streamed.
+u32 TextureStreaming::GetInitialMip(const CookedTextureHeader& header)
+{
+	u32 level = 0;
+	while (level + 1 < header.mipCount && (glm::max(header.width, header.height) >> level) > TEXTURE_STREAMING_INITIAL_SIZE)
+	{
+		++level;
+	}
+
+	return level;
+}
+
+// UTILS -------------------------------------------------------------------
+// One texel per pixel: the mip whose size matches the projected diameter of the entity bounds, assuming its UVs cover
+// the texture once. Only the entity mode has the coverage, the other modes ask for every mip.
+void TextureStreaming::Utils::ComputeRequiredMips(App* app)
+{
+	TextureStreamer& streamer	= app->textureStreamer;
+	const bool hasCoverage		= (app->shaderMode == SHADER_MODE::ENTITIES);
+
+	for (u32 i = 0; i < streamer.textures.size(); ++i)
+	{
+		streamer.textures[i].requiredMip = (hasCoverage) ? streamer.textures[i].initialMip : 0;				// Not on screen: back to the initial mips.
+	}
+
+	if (!hasCoverage)
+	{
+		return;
+	}
+
+	const mat4 viewMatrix		= app->camera.GetViewMatrix();
+	const f32  pixelsPerUnitAt1	= app->camera.GetProjMatrix()[1][1] * 0.5f * (f32)app->displaySize.y;
+
+	for (u32 i = 0; i < app->entities.size(); ++i)
+	{
+		const Entity& entity = app->entities[i];
+		if (entity.isHidden || entity.isImpostor)															// Drawn with the proxy / impostor atlases.
+		{
+			continue;
+		}
+
+		const Model& model		= app->models[entity.modelIndex];
+		const Mesh& mesh		= app->meshes[model.meshIdx];
+		const f32 worldScale	= glm::max(glm::length(vec3(entity.worldMatrix[0])), glm::max(glm::length(vec3(entity.worldMatrix[1])), glm::length(vec3(entity.worldMatrix[2]))));
+		const vec3 viewCenter	= vec3(viewMatrix * entity.worldMatrix * vec4(mesh.boundsCenter, 1.0f));
+		const f32 distance		= glm::max(glm::length(viewCenter) - mesh.boundsRadius * worldScale, app->camera.GetNearPlane());
+		const f32 pixels		= glm::max(2.0f * mesh.boundsRadius * worldScale * pixelsPerUnitAt1 / distance, 1.0f);
+
+		for (u32 m = 0; m < model.materialIndices.size(); ++m)
+		{
+			const Material& material	= app->materials[model.materialIndices[m]];
+			const u32 texIndices[]		= { material.albedoTexIdx, material.emissiveTexIdx, material.specularTexIdx, material.normalTexIdx, material.bumpTexIdx };
+			for (u32 t = 0; t < ARRAY_COUNT(texIndices); ++t)
+			{
+				const u32 streamIdx = (texIndices[t] < streamer.streamIndices.size()) ? streamer.streamIndices[texIndices[t]] : UINT32_MAX;
+				if (streamIdx == UINT32_MAX)
+				{
+					continue;
+				}
+
+				StreamedTexture& texture	= streamer.textures[streamIdx];
+				const f32 texels			= (f32)glm::max(texture.width, texture.height);
+				const f32 mip				= glm::clamp(floorf(log2f(texels / pixels) + streamer.mipBias), 0.0f, (f32)texture.initialMip);
+				texture.requiredMip			= glm::min(texture.requiredMip, (u32)mip);
+			}
+		}
+	}
+}
+
+// Coarsens the targets until they fit, always dropping the largest mip left. Mips are 4x their next level, so this
+// spreads the loss over the biggest textures first.
+void TextureStreaming::Utils::FitTargetsInBudget(App* app)
+{
+	TextureStreamer& streamer = app->textureStreamer;
+
+	u64 targetBytes = 0;
+	std::priority_queue<std::pair<u32, u32>> finestMips;													// (Size of the finest target mip, texture).
+	for (u32 i = 0; i < streamer.textures.size(); ++i)
+	{
+		StreamedTexture& texture = streamer.textures[i];
+		texture.targetMip		 = texture.requiredMip;
+		targetBytes				+= GetResidentBytes(texture, texture.targetMip);
+
+		if (texture.targetMip < texture.initialMip)
+		{
+			finestMips.push({ texture.mipSizes[texture.targetMip], i });
+		}
+	}
+
+	while (targetBytes > streamer.budget && !finestMips.empty())
+	{
+		const u32 streamIdx		 = finestMips.top().second;
+		StreamedTexture& texture = streamer.textures[streamIdx];
+		targetBytes				-= finestMips.top().first;
+		finestMips.pop();
+
+		++texture.targetMip;
+		if (texture.targetMip < texture.initialMip)
+		{
+			finestMips.push({ texture.mipSizes[texture.targetMip], streamIdx });
+		}
+	}
+}
+
+void TextureStreaming::Utils::ProcessLoads(App* app)
+{
+	TextureStreamer& streamer = app->textureStreamer;
+
+	for (auto load = streamer.loads.begin(); load != streamer.loads.end(); )
+	{
+		if (!load->isDone)
+		{
+			++load;
+			continue;
+		}
+
+		StreamedTexture& texture	= streamer.textures[load->streamIdx];
+		texture.isLoading			= false;
+
+		if (load->data.empty())
+		{
+			ELOG("Could not stream mip %u of %s, the texture stays at mip %u", load->level, load->cookedPath.c_str(), texture.residentMip);
+			texture.readFailed = true;
+		}
+		else if (load->level + 1 == texture.residentMip && load->level >= texture.targetMip)				// Still wanted, and nothing was released meanwhile.
+		{
+			const GLsizei width		= glm::max(1u, texture.width >> load->level);
+			const GLsizei height	= glm::max(1u, texture.height >> load->level);
+
+			glBindTexture(GL_TEXTURE_2D, app->textures[texture.texIdx].handle);
+			glCompressedTexImage2D(GL_TEXTURE_2D, load->level, texture.glFormat, width, height, 0, texture.mipSizes[load->level], load->data.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, load->level);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			texture.residentMip		 = load->level;
+			streamer.residentBytes	+= texture.mipSizes[load->level];
+			++streamer.streamedIn;
+		}
+
+		if (!load->data.empty())																			// The header matched for this file.
+		{
+			texture.isHeaderChecked		= true;
+			texture.checkedTimestamp	= load->cookedTimestamp;
+		}
+
+		load = streamer.loads.erase(load);
+	}
+}
+
+void TextureStreaming::Utils::RequestMip(App* app, u32 streamIdx, u32 level)
+{
+	TextureStreamer& streamer	= app->textureStreamer;
+	StreamedTexture& texture	= streamer.textures[streamIdx];
+
+	streamer.loads.emplace_back();
+	MipLoad* load		= &streamer.loads.back();
+	load->streamIdx			= streamIdx;
+	load->level				= level;
+	load->isDone			= false;
+	load->cookedPath		= TextureCooker::Utils::GetCookedPath(StringTable::GetString(app->textures[texture.texIdx].filepath));
+	load->cookedTimestamp	= FileManager::GetFileLastWriteTimestamp(load->cookedPath.c_str());
+	texture.isLoading		= true;
+
+	const u64 offset		= texture.mipOffsets[level];
+	const u32 size			= texture.mipSizes[level];
+	const u64 sourceHash	= texture.sourceHash;
+	const bool checkHeader	= !texture.isHeaderChecked || texture.checkedTimestamp != load->cookedTimestamp;
+	ReadMip(load, offset, size, sourceHash, checkHeader);
+}
+
+void TextureStreaming::Utils::ReleaseMip(App* app, u32 streamIdx)
+{
+	TextureStreamer& streamer	= app->textureStreamer;
+	StreamedTexture& texture	= streamer.textures[streamIdx];
+	const u32 level				= texture.residentMip;
+
+	glBindTexture(GL_TEXTURE_2D, app->textures[texture.texIdx].handle);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.glFormat, 0, 0, 0, 0, nullptr);					// A zero-sized image frees the level.
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	texture.residentMip		 = level + 1;
+	streamer.residentBytes	-= texture.mipSizes[level];
+	++streamer.streamedOut;
+}
+
+// Two chained reads: the header, then the mip. Neither blocks a worker while the disk works. The header is only read
+// again when the .ctex timestamp moved since it last matched, so the other mips of a texture take a single read.
+void TextureStreaming::Utils::ReadMip(MipLoad* load, u64 offset, u32 size, u64 sourceHash, bool checkHeader)
+{
+	auto readMip = [load, offset, size]()
+	{
+		AsyncIO::Read(load->cookedPath.c_str(), offset, size, [load](const u8* data, u32 size)
+		{
+			if (data != nullptr)
+			{
+				load->data.assign(data, data + size);
+			}
+			load->isDone = true;
+		});
+	};
+
+	if (!checkHeader)
+	{
+		readMip();
+		return;
+	}
+
+	AsyncIO::Read(load->cookedPath.c_str(), 0, sizeof(CookedTextureHeader), [load, sourceHash, readMip](const u8* data, u32)
+	{
+		// A file cooked again since the upload has other offsets, and its mips would not match the resident ones.
+		const CookedTextureHeader* header = (const CookedTextureHeader*)data;
+		if (header == nullptr || header->sourceHash != sourceHash)
+		{
+			load->isDone = true;
+			return;
+		}
+
+		readMip();
+	});
+}
+
+u64 TextureStreaming::Utils::GetResidentBytes(const StreamedTexture& texture, u32 firstMip)
+{
+	u64 bytes = 0;
+	for (u32 level = firstMip; level < texture.mipCount; ++level)
+	{
+		bytes += texture.mipSizes[level];
+	}
+
+	return bytes;
+}
\ No newline at end of file
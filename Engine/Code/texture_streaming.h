@@ -0,0 +1,97 @@
+#ifndef __TEXTURE_STREAMING_H__
+#define __TEXTURE_STREAMING_H__
+
+// texture_streaming.h:
+// Mip streaming of the cooked textures (texture_cooker.h). The loader uploads only the mips up to
+// TEXTURE_STREAMING_INITIAL_SIZE texels and registers the texture here. Every frame, the projected size of the visible
+// entities gives the finest mip each of their materials needs. The targets are then coarsened, largest mips first,
+// until they fit in the VRAM budget. Missing mips are read from the .ctex file with async reads (async_io.h), one level
+// at a time, and defined on the render thread before GL_TEXTURE_BASE_LEVEL is lowered to them. The mips no longer needed are
+// clamped out with GL_TEXTURE_BASE_LEVEL and their storage released. The initial mips always stay, so what the
+// streamed textures take is the budget plus a few KB per texture, however many materials the scene holds.
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "base_types.h"
+#include "string_table.h"
+#include "texture_cooker.h"
+#include "job_system.h"
+
+struct App;
+
+#define TEXTURE_STREAMING_INITIAL_SIZE		128																// Texels of the largest mip uploaded at load time (the impostor frame size).
+#define TEXTURE_STREAMING_DEFAULT_BUDGET	MB(128)
+#define TEXTURE_STREAMING_MAX_LOADS			4																// Mip reads in flight.
+#define TEXTURE_STREAMING_KEEP_FRAMES		120																// Frames an unneeded mip stays while under budget.
+
+struct StreamedTexture
+{
+	u32			texIdx;
+	u64			sourceHash;																				// Cooked file the mips were uploaded from.
+	u32			glFormat;
+	u32			width;
+	u32			height;
+	u32			mipCount;
+	u64			mipOffsets[COOKED_TEXTURE_MAX_MIPS];
+	u32			mipSizes[COOKED_TEXTURE_MAX_MIPS];
+
+	u32			initialMip;																				// Never streamed out.
+	u32			residentMip;																			// GL_TEXTURE_BASE_LEVEL.
+	u32			requiredMip;																			// From the screen coverage of this frame.
+	u32			targetMip;																				// requiredMip, fitted in the budget.
+	u32			idleFrames;																				// Frames spent finer than targetMip.
+	bool		isLoading;
+	bool		readFailed;																				// Stays at residentMip from then on.
+
+	bool		isHeaderChecked;																		// The .ctex header matched sourceHash while
+	u64			checkedTimestamp;																		// the file had this timestamp.
+};
+
+struct MipLoad
+{
+	u32						streamIdx;
+	u32						level;
+	std::string				cookedPath;
+	u64						cookedTimestamp;															// When the load was requested, 0 if packed.
+	std::vector<u8>			data;																		// Empty if the read failed.
+	std::atomic<bool>		isDone;																		// Set by the last read callback.
+};
+
+struct TextureStreamer
+{
+	std::vector<StreamedTexture>	textures;
+	std::vector<u32>				streamIndices;														// App::textures index -> textures index, UINT32_MAX if not streamed.
+	std::list<MipLoad>				loads;																// std::list: the read callbacks hold pointers to their load.
+
+	u64								budget;
+	u64								residentBytes;														// Every resident mip of the streamed textures.
+	f32								mipBias;															// Added to the required mip, > 0 trades sharpness for memory.
+
+	u32								streamedIn;															// Totals, for the GUI.
+	u32								streamedOut;
+};
+
+namespace TextureStreaming
+{
+	void Register			(App* app, u32 texIdx, const CookedTextureHeader& header, u32 initialMip);		// Right after TextureCooker::Upload(firstMip = initialMip).
+	void Update				(App* app);																	// After the HLOD and impostor selection.
+
+	u32  GetInitialMip		(const CookedTextureHeader& header);
+
+	namespace Utils
+	{
+		void ComputeRequiredMips	(App* app);
+		void FitTargetsInBudget		(App* app);
+		void ProcessLoads			(App* app);															// Defines the mips read since the last frame.
+		void RequestMip				(App* app, u32 streamIdx, u32 level);
+		void ReleaseMip				(App* app, u32 streamIdx);											// Drops residentMip.
+		void ReadMip				(MipLoad* load, u64 offset, u32 size, u64 sourceHash, bool checkHeader);	// Queues the reads (async_io.h). No GL calls in the callbacks.
+
+		u64  GetResidentBytes		(const StreamedTexture& texture, u32 firstMip);
+	}
+}
+
+#endif // !__TEXTURE_STREAMING_H__
\ No newline at end of file
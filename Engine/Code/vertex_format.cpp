@@ -0,0 +1,196 @@
+#include <float.h>
+#include <string.h>
+
+#include "vertex_format.h"
+
+VertexBufferLayout VertexFormat::GetQuantizedLayout(const VertexBufferLayout& source)
+{
+	VertexBufferLayout layout = {};
+	for (u32 a = 0; a < source.attributes.size(); ++a)
+	{
+		switch (source.attributes[a].location)
+		{
+		case VERTEX_LOCATION_POSITION:	{ layout.AddPackedAttribute(VERTEX_LOCATION_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(u16)); }	break;	// Padded to 8 bytes.
+		case VERTEX_LOCATION_NORMAL:	{ layout.AddPackedAttribute(VERTEX_LOCATION_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(u32)); }		break;
+		case VERTEX_LOCATION_TEXCOORD:	{ layout.AddPackedAttribute(VERTEX_LOCATION_TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, 2 * sizeof(u16)); }		break;
+		case VERTEX_LOCATION_TANGENT:	{ layout.AddPackedAttribute(VERTEX_LOCATION_TANGENT, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(u32)); }		break;
+		}
+	}
+
+	return layout;
+}
+
+const VertexBufferLayout& VertexFormat::GetGpuLayout(const Submesh& submesh)
+{
+	return (submesh.packedVBL.attributes.empty()) ? submesh.VBL : submesh.packedVBL;
+}
+
+void VertexFormat::ComputeDequantization(Submesh& submesh)
+{
+	const u32 sourceStride	= submesh.VBL.stride / sizeof(f32);
+	const u32 vertexCount	= (u32)submesh.vertices.size() / sourceStride;
+	const u32 position		= submesh.VBL.attributes[Utils::FindAttribute(submesh.VBL, VERTEX_LOCATION_POSITION)].offset / sizeof(f32);
+
+	vec3 boundsMin = vec3( FLT_MAX);
+	vec3 boundsMax = vec3(-FLT_MAX);
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		const f32* p = &submesh.vertices[v * sourceStride + position];
+		boundsMin = glm::min(boundsMin, vec3(p[0], p[1], p[2]));
+		boundsMax = glm::max(boundsMax, vec3(p[0], p[1], p[2]));
+	}
+
+	submesh.positionOffset	= (vertexCount > 0) ? boundsMin : vec3(0.0f);
+	submesh.positionScale	= (vertexCount > 0) ? boundsMax - boundsMin : vec3(1.0f);
+}
+
+void VertexFormat::PackVertices(const Submesh& submesh, std::vector<u8>& packed)
+{
+	const VertexBufferLayout& source	= submesh.VBL;
+	const VertexBufferLayout& layout	= submesh.packedVBL;
+	const u32 sourceStride				= source.stride / sizeof(f32);
+	const u32 vertexCount				= (u32)submesh.vertices.size() / sourceStride;
+
+	const i32 position	= Utils::FindAttribute(source, VERTEX_LOCATION_POSITION);
+	const i32 normal	= Utils::FindAttribute(source, VERTEX_LOCATION_NORMAL);
+	const i32 texCoord	= Utils::FindAttribute(source, VERTEX_LOCATION_TEXCOORD);
+	const i32 tangent	= Utils::FindAttribute(source, VERTEX_LOCATION_TANGENT);
+	const i32 bitangent	= Utils::FindAttribute(source, VERTEX_LOCATION_BITANGENT);
+
+	const vec3 inverseScale = vec3((submesh.positionScale.x > 0.0f) ? 1.0f / submesh.positionScale.x : 0.0f,
+								   (submesh.positionScale.y > 0.0f) ? 1.0f / submesh.positionScale.y : 0.0f,
+								   (submesh.positionScale.z > 0.0f) ? 1.0f / submesh.positionScale.z : 0.0f);
+
+	// PACKING
+	packed.assign((size_t)vertexCount * layout.stride, 0);
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		const f32* vertex	= &submesh.vertices[v * sourceStride];
+		u8* destination		= &packed[(size_t)v * layout.stride];
+		auto ReadVec3		= [&](i32 attribute) { const f32* f = vertex + source.attributes[attribute].offset / sizeof(f32); return vec3(f[0], f[1], f[2]); };
+
+		for (u32 a = 0; a < layout.attributes.size(); ++a)
+		{
+			const VertexBufferAttribute& attribute = layout.attributes[a];
+			u8* field = destination + attribute.offset;
+
+			switch (attribute.location)
+			{
+			case VERTEX_LOCATION_POSITION:
+			{
+				const vec3 p		= (ReadVec3(position) - submesh.positionOffset) * inverseScale;
+				const u16 xyzw[4]	= { Utils::QuantizeUnorm16(p.x), Utils::QuantizeUnorm16(p.y), Utils::QuantizeUnorm16(p.z), 0 };
+				memcpy(field, xyzw, sizeof(xyzw));
+			}
+			break;
+
+			case VERTEX_LOCATION_NORMAL:
+			{
+				const u32 n = Utils::PackSnorm1010102(vec4(ReadVec3(normal), 0.0f));
+				memcpy(field, &n, sizeof(n));
+			}
+			break;
+
+			case VERTEX_LOCATION_TEXCOORD:
+			{
+				const f32* uv		= vertex + source.attributes[texCoord].offset / sizeof(f32);
+				const u16 halfs[2]	= { Utils::FloatToHalf(uv[0]), Utils::FloatToHalf(uv[1]) };
+				memcpy(field, halfs, sizeof(halfs));
+			}
+			break;
+
+			case VERTEX_LOCATION_TANGENT:
+			{
+				const vec3 t	= ReadVec3(tangent);
+				f32 sign		= 1.0f;
+				if (source.attributes[tangent].componentCount == 4)
+				{
+					sign = vertex[source.attributes[tangent].offset / sizeof(f32) + 3];
+				}
+				else if (bitangent >= 0 && normal >= 0)
+				{
+					sign = Utils::GetBitangentSign(ReadVec3(normal), t, ReadVec3(bitangent));
+				}
+
+				const u32 packedTangent = Utils::PackSnorm1010102(vec4(t, (sign < 0.0f) ? -1.0f : 1.0f));
+				memcpy(field, &packedTangent, sizeof(packedTangent));
+			}
+			break;
+			}
+		}
+	}
+}
+
+// UTILS -------------------------------------------------------------------
+i32 VertexFormat::Utils::FindAttribute(const VertexBufferLayout& layout, u8 location)
+{
+	for (u32 a = 0; a < layout.attributes.size(); ++a)
+	{
+		if (layout.attributes[a].location == location)
+		{
+			return (i32)a;
+		}
+	}
+
+	return -1;
+}
+
+// The shaders rebuild the bitangent as cross(normal, tangent) * sign.
+f32 VertexFormat::Utils::GetBitangentSign(const vec3& normal, const vec3& tangent, const vec3& bitangent)
+{
+	return (glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f;
+}
+
+// Round to nearest even, overflows to infinity and flushes the values below the half denormals to zero.
+u16 VertexFormat::Utils::FloatToHalf(f32 value)
+{
+	u32 bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const u32 sign		= (bits >> 16) & 0x8000u;
+	const u32 absolute	= bits & 0x7FFFFFFFu;
+
+	if (absolute >= 0x7F800000u)																	// Inf / NaN.
+	{
+		return (u16)(sign | 0x7C00u | ((absolute > 0x7F800000u) ? 0x200u : 0u));
+	}
+	if (absolute >= 0x477FF000u)																	// Rounds above 65504.
+	{
+		return (u16)(sign | 0x7C00u);
+	}
+	if (absolute < 0x33000000u)																		// Below half the smallest denormal.
+	{
+		return (u16)sign;
+	}
+	if (absolute < 0x38800000u)																		// Denormal half.
+	{
+		const u32 shift		= 113u - (absolute >> 23);
+		const u32 mantissa	= (absolute & 0x7FFFFFu) | 0x800000u;
+		u32 half			= mantissa >> (shift + 13u);
+		const u32 remainder	= mantissa & ((1u << (shift + 13u)) - 1u);
+		const u32 halfway	= 1u << (shift + 12u);
+		half += (remainder > halfway || (remainder == halfway && (half & 1u))) ? 1u : 0u;
+		return (u16)(sign | half);
+	}
+
+	u32 half = (absolute - 0x38000000u) >> 13;													// Rebias the exponent (127 -> 15).
+	const u32 remainder = absolute & 0x1FFFu;
+	half += (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ? 1u : 0u;
+	return (u16)(sign | half);
+}
+
+u16 VertexFormat::Utils::QuantizeUnorm16(f32 value)
+{
+	return (u16)(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+// Signed normalized, decoded by GL as max(c / 511, -1) for xyz and max(w, -1) for the 2-bit w.
+u32 VertexFormat::Utils::PackSnorm1010102(const vec4& value)
+{
+	const i32 x = (i32)glm::round(glm::clamp(value.x, -1.0f, 1.0f) * 511.0f);
+	const i32 y = (i32)glm::round(glm::clamp(value.y, -1.0f, 1.0f) * 511.0f);
+	const i32 z = (i32)glm::round(glm::clamp(value.z, -1.0f, 1.0f) * 511.0f);
+	const i32 w = (i32)glm::round(glm::clamp(value.w, -1.0f, 1.0f));
+
+	return ((u32)x & 0x3FFu) | (((u32)y & 0x3FFu) << 10) | (((u32)z & 0x3FFu) << 20) | (((u32)w & 0x3u) << 30);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __VERTEX_FORMAT_H__
+#define __VERTEX_FORMAT_H__
+
+// vertex_format.h:
+// Quantized GPU vertex layout. The submeshes keep their float vertices on the CPU (LODs, meshlets, HLOD merging and the
+// mesh cache work on them) and CreateMeshBuffers() packs them on upload: positions as 16-bit UNORM relative to the
+// submesh AABB, normals and tangents as GL_INT_2_10_10_10_REV and UVs as half floats. The bitangent is not stored, the
+// shaders rebuild it as cross(normal, tangent.xyz) * tangent.w. A full vertex goes from 56 to 20 bytes.
+
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "shader_types.h"
+
+#define VERTEX_LOCATION_POSITION	0
+#define VERTEX_LOCATION_NORMAL		1
+#define VERTEX_LOCATION_TEXCOORD	2
+#define VERTEX_LOCATION_TANGENT		3																// xyz + bitangent sign in w.
+#define VERTEX_LOCATION_BITANGENT	4																// Only in the float layouts that still carry it.
+
+namespace VertexFormat
+{
+	VertexBufferLayout			GetQuantizedLayout		(const VertexBufferLayout& source);						// Same locations, minus the bitangent.
+	const VertexBufferLayout&	GetGpuLayout			(const Submesh& submesh);
+
+	void						ComputeDequantization	(Submesh& submesh);										// Position scale & offset from the AABB.
+	void						PackVertices			(const Submesh& submesh, std::vector<u8>& packed);		// Needs ComputeDequantization() first.
+
+	namespace Utils
+	{
+		i32	FindAttribute		(const VertexBufferLayout& layout, u8 location);						// -1 when missing.
+		f32	GetBitangentSign	(const vec3& normal, const vec3& tangent, const vec3& bitangent);
+
+		u16	FloatToHalf			(f32 value);
+		u16	QuantizeUnorm16		(f32 value);
+		u32	PackSnorm1010102	(const vec4& value);
+	}
+}
+
+#endif // !__VERTEX_FORMAT_H__
\ No newline at end of file
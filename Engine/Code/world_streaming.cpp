@@ -0,0 +1,351 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "globals.h"
+#include "app.h"
+#include "file_manager.h"
+#include "string_table.h"
+#include "async_io.h"
+#include "transform.h"
+#include "engine.h"
+#include "scene.h"
+
+#include "world_streaming.h"
+
+bool WorldStreaming::Load(App* app, const char* filepath)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+
+	MappedFile cookedFile = {};
+	if (!Scene::Utils::MapCookedFile(filepath, cookedFile))
+	{
+		return false;
+	}
+
+	const u8* data					= cookedFile.data;
+	const CookedSceneHeader* header	= (const CookedSceneHeader*)data;
+	if (header->cellCount == 0)
+	{
+		ELOG("World %s has no cells statement, load it with Scene::Load()", filepath);
+		FileManager::UnmapFile(cookedFile);
+		return false;
+	}
+
+	streamer.cookedPath		= SceneCooker::Utils::GetCookedPath(filepath);
+	streamer.entitiesOffset	= header->entitiesOffset;
+	streamer.cellSize		= header->cellSize;
+
+	const SceneCell* cells = (const SceneCell*)(data + header->cellsOffset);
+	streamer.cells.assign(cells, cells + header->cellCount);
+
+	const u32* cellModels = (const u32*)(data + header->cellModelsOffset);
+	streamer.cellModels.assign(cellModels, cellModels + header->cellModelCount);
+
+	const SceneAsset* assets = (const SceneAsset*)(data + header->assetsOffset);
+	streamer.assets.assign(assets, assets + header->assetCount);
+
+	const SceneMaterial* materials = (const SceneMaterial*)(data + header->materialsOffset);
+	streamer.materials.assign(materials, materials + header->materialCount);
+
+	const SceneModel* models = (const SceneModel*)(data + header->modelsOffset);
+	streamer.models.assign(models, models + header->modelCount);
+
+	streamer.strings.assign((const char*)(data + header->stringsOffset), header->stringsSize);
+
+	streamer.assetIndices.assign(header->assetCount, WORLD_STREAMING_UNRESOLVED);
+	streamer.materialIndices.assign(header->materialCount, WORLD_STREAMING_UNRESOLVED);
+	streamer.modelIndices.assign(header->modelCount, WORLD_STREAMING_UNRESOLVED);
+
+	streamer.cellLookup.clear();
+	for (u32 i = 0; i < streamer.cells.size(); ++i)
+	{
+		streamer.cellLookup[Utils::GetCellKey(streamer.cells[i].x, streamer.cells[i].z)] = i;
+	}
+	streamer.isCellActive.assign(streamer.cells.size(), false);
+
+	// The lights light the whole world, they are not streamed.
+	const SceneLight* lights = (const SceneLight*)(data + header->lightsOffset);
+	for (u32 i = 0; i < header->lightCount; ++i)
+	{
+		const SceneLight& light = lights[i];
+		Engine::Lights::AddLight(app, (LIGHT_TYPE)light.type, light.color, light.direction, light.position, light.attenuation, Transform::PositionScale(light.position, Transform::defaultScale));
+	}
+
+	ILOG("World %s: %u cells of %.1f, %u entities", filepath, header->cellCount, header->cellSize, header->entityCount);
+
+	FileManager::UnmapFile(cookedFile);
+	return true;
+}
+
+void WorldStreaming::Update(App* app)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+	if (streamer.cells.empty())
+	{
+		return;
+	}
+
+	const vec3 cameraPos		= app->camera.position;
+	const f32 unloadDistance	= streamer.loadDistance + streamer.unloadMargin;
+
+	auto cell = streamer.activeCells.begin();
+	while (cell != streamer.activeCells.end())
+	{
+		if (cell->state == CELL_STATE::READING)
+		{
+			if (!cell->isRead.load(std::memory_order_acquire))
+			{
+				++cell;																							// Its callback still has to write to it.
+				continue;
+			}
+			cell->state = CELL_STATE::READ;
+		}
+
+		cell->distance = Utils::GetCellDistance(streamer, streamer.cells[cell->cellIdx], cameraPos);
+		cell = (cell->distance > unloadDistance) ? Utils::UnloadCell(app, cell) : std::next(cell);
+	}
+
+	Utils::RequestCells(app);
+	Utils::PlaceCells(app);
+}
+
+u32 WorldStreaming::GetStreamedEntityCount(const App* app)
+{
+	u32 count = 0;
+	for (const StreamedCell& cell : app->worldStreamer.activeCells)
+	{
+		count += (cell.state == CELL_STATE::PLACING || cell.state == CELL_STATE::RESIDENT) ? cell.entityCount : 0;
+	}
+
+	return count;
+}
+
+// UTILS -------------------------------------------------------------------
+// The cells around the camera cell that lie within loadDistance. A world far larger than the view is never scanned whole.
+void WorldStreaming::Utils::RequestCells(App* app)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+
+	u32 readsInFlight = 0;
+	for (const StreamedCell& cell : streamer.activeCells)
+	{
+		readsInFlight += (cell.state == CELL_STATE::READING) ? 1 : 0;
+	}
+	if (readsInFlight >= WORLD_STREAMING_MAX_READS)
+	{
+		return;
+	}
+
+	const vec3 cameraPos	= app->camera.position;
+	const i32 cameraX		= (i32)floorf(cameraPos.x / streamer.cellSize);
+	const i32 cameraZ		= (i32)floorf(cameraPos.z / streamer.cellSize);
+	const i32 reach			= (i32)ceilf(streamer.loadDistance / streamer.cellSize);
+
+	std::vector<std::pair<f32, u32>> candidates;																// (distance, cells index)
+	for (i32 z = cameraZ - reach; z <= cameraZ + reach; ++z)
+	{
+		for (i32 x = cameraX - reach; x <= cameraX + reach; ++x)
+		{
+			auto item = streamer.cellLookup.find(GetCellKey(x, z));
+			if (item == streamer.cellLookup.end() || streamer.isCellActive[item->second])
+			{
+				continue;
+			}
+
+			const f32 distance = GetCellDistance(streamer, streamer.cells[item->second], cameraPos);
+			if (distance <= streamer.loadDistance)
+			{
+				candidates.push_back({ distance, item->second });
+			}
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	for (u32 i = 0; i < candidates.size() && readsInFlight < WORLD_STREAMING_MAX_READS; ++i, ++readsInFlight)
+	{
+		const u32 cellIdx			= candidates[i].second;
+		const SceneCell& sceneCell	= streamer.cells[cellIdx];
+
+		streamer.activeCells.emplace_back();
+		StreamedCell* cell		= &streamer.activeCells.back();
+		cell->cellIdx			= cellIdx;
+		cell->state				= CELL_STATE::READING;
+		cell->isRead			= false;
+		cell->distance			= candidates[i].first;
+		cell->firstEntity		= 0;
+		cell->entityCount		= 0;
+		cell->revealedCount		= 0;
+		streamer.isCellActive[cellIdx] = true;
+
+		const u64 offset	= streamer.entitiesOffset + (u64)sceneCell.firstEntity * sizeof(SceneEntity);
+		const u32 size		= sceneCell.entityCount * (u32)sizeof(SceneEntity);
+		AsyncIO::Read(streamer.cookedPath.c_str(), offset, size, [cell, size](const u8* data, u32 readSize)
+		{
+			if (data != nullptr && readSize == size)
+			{
+				cell->entities.resize(size / sizeof(SceneEntity));
+				memcpy(cell->entities.data(), data, size);
+			}
+			cell->isRead.store(true, std::memory_order_release);
+		});
+	}
+
+	AsyncIO::Submit();																						// This frame's requests in one batch.
+}
+
+// The nearest cells first: a cell that starts placing this frame may only get what the closer ones left of the budget.
+void WorldStreaming::Utils::PlaceCells(App* app)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+
+	std::vector<StreamedCell*> pending;
+	for (StreamedCell& cell : streamer.activeCells)
+	{
+		if (cell.state == CELL_STATE::READ || cell.state == CELL_STATE::PLACING)
+		{
+			pending.push_back(&cell);
+		}
+	}
+	std::sort(pending.begin(), pending.end(), [](const StreamedCell* a, const StreamedCell* b) { return a->distance < b->distance; });
+
+	u32 budget = streamer.maxInstances;
+	for (u32 i = 0; i < pending.size() && budget > 0; ++i)
+	{
+		StreamedCell& cell = *pending[i];
+		if (cell.state == CELL_STATE::READ)
+		{
+			BeginPlacing(app, cell);
+		}
+
+		const u32 count = std::min(budget, cell.entityCount - cell.revealedCount);
+		for (u32 e = 0; e < count; ++e)
+		{
+			app->entities[cell.firstEntity + cell.revealedCount + e].isHidden = false;
+		}
+		cell.revealedCount	+= count;
+		budget				-= count;
+
+		if (cell.revealedCount == cell.entityCount)
+		{
+			cell.state = CELL_STATE::RESIDENT;
+			++streamer.cellsLoaded;
+		}
+	}
+}
+
+// The entities go in hidden: Residency::Update() and the renderer skip them until PlaceCells() reveals them.
+void WorldStreaming::Utils::BeginPlacing(App* app, StreamedCell& cell)
+{
+	WorldStreamer& streamer		= app->worldStreamer;
+	const SceneCell& sceneCell	= streamer.cells[cell.cellIdx];
+
+	for (u32 i = 0; i < sceneCell.modelCount; ++i)
+	{
+		ResolveModel(app, streamer.cellModels[sceneCell.firstModel + i]);
+	}
+
+	cell.firstEntity = (u32)app->entities.size();
+	for (const SceneEntity& source : cell.entities)
+	{
+		const u32 modelIdx = streamer.modelIndices[source.modelIdx];
+		if (modelIdx == UINT32_MAX)
+		{
+			continue;
+		}
+
+		Entity entity		= {};
+		entity.worldMatrix	= source.worldMatrix;
+		entity.modelIndex	= modelIdx;
+		entity.isHidden		= true;
+		if (source.name.length > 0)
+		{
+			entity.name = StringTable::Intern(streamer.strings.substr(source.name.offset, source.name.length).c_str());
+		}
+		app->entities.push_back(entity);
+	}
+
+	cell.entityCount	= (u32)app->entities.size() - cell.firstEntity;
+	cell.revealedCount	= 0;
+	cell.state			= CELL_STATE::PLACING;
+	std::vector<SceneEntity>().swap(cell.entities);
+}
+
+// Erases the cell's range of App::entities, the cells placed after it move down.
+std::list<StreamedCell>::iterator WorldStreaming::Utils::UnloadCell(App* app, std::list<StreamedCell>::iterator cell)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+
+	if (cell->state == CELL_STATE::PLACING || cell->state == CELL_STATE::RESIDENT)
+	{
+		auto first = app->entities.begin() + cell->firstEntity;
+		app->entities.erase(first, first + cell->entityCount);
+
+		for (StreamedCell& other : streamer.activeCells)
+		{
+			const bool isPlaced = (other.state == CELL_STATE::PLACING || other.state == CELL_STATE::RESIDENT);
+			if (isPlaced && other.firstEntity > cell->firstEntity)
+			{
+				other.firstEntity -= cell->entityCount;
+			}
+		}
+
+		++streamer.cellsUnloaded;
+	}
+
+	streamer.isCellActive[cell->cellIdx] = false;
+	return streamer.activeCells.erase(cell);
+}
+
+// The first cell to use a model loads its asset and material. Later cells reuse them, and so does a cell loaded again.
+u32 WorldStreaming::Utils::ResolveModel(App* app, u32 modelIdx)
+{
+	WorldStreamer& streamer = app->worldStreamer;
+	if (streamer.modelIndices[modelIdx] != WORLD_STREAMING_UNRESOLVED)
+	{
+		return streamer.modelIndices[modelIdx];
+	}
+
+	const SceneModel& model = streamer.models[modelIdx];
+	u32& assetIdx			= streamer.assetIndices[model.assetIdx];
+	if (assetIdx == WORLD_STREAMING_UNRESOLVED)
+	{
+		const SceneString& path = streamer.assets[model.assetIdx].path;
+		assetIdx				= Scene::Utils::LoadAsset(app, streamer.strings.substr(path.offset, path.length).c_str());
+		if (assetIdx != UINT32_MAX)
+		{
+			Residency::AddModel(app, assetIdx);
+		}
+	}
+
+	u32 resolvedIdx = assetIdx;
+	if (assetIdx != UINT32_MAX && model.materialIdx != COOKED_SCENE_NO_MATERIAL)
+	{
+		u32& materialIdx = streamer.materialIndices[model.materialIdx];
+		if (materialIdx == WORLD_STREAMING_UNRESOLVED)
+		{
+			materialIdx = Scene::Utils::AddMaterial(app, streamer.materials[model.materialIdx], streamer.strings.c_str());
+		}
+		resolvedIdx = Scene::Utils::AddModelVariant(app, assetIdx, materialIdx);
+	}
+
+	streamer.modelIndices[modelIdx] = resolvedIdx;
+	return resolvedIdx;
+}
+
+// From the position to the cell's rectangle on the XZ plane, 0 inside it.
+f32 WorldStreaming::Utils::GetCellDistance(const WorldStreamer& streamer, const SceneCell& cell, const vec3& position)
+{
+	const f32 minX	= (f32)cell.x * streamer.cellSize;
+	const f32 minZ	= (f32)cell.z * streamer.cellSize;
+	const f32 dx	= std::max(std::max(minX - position.x, position.x - (minX + streamer.cellSize)), 0.0f);
+	const f32 dz	= std::max(std::max(minZ - position.z, position.z - (minZ + streamer.cellSize)), 0.0f);
+
+	return sqrtf(dx * dx + dz * dz);
+}
+
+u64 WorldStreaming::Utils::GetCellKey(i32 x, i32 z)
+{
+	return ((u64)(u32)x << 32) | (u64)(u32)z;
+}
\ No newline at end of file
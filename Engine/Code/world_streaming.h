@@ -0,0 +1,105 @@
+#ifndef __WORLD_STREAMING_H__
+#define __WORLD_STREAMING_H__
+
+// world_streaming.h:
+// Streams the cells of a world (a scene with a cells statement, scene_cooker.h) around the camera. Load() only keeps
+// the small tables of the .cscene: the cells, the assets, the materials and the lights, which are added at once. Every
+// frame the cells within loadDistance of the camera (on the XZ plane) are requested, the nearest first and at most
+// WORLD_STREAMING_MAX_READS at a time. Each one is a single async read of its entity range (async_io.h). A read cell
+// resolves its models, the first cell to use a model loads it, and appends its entities hidden at the end of
+// App::entities. They are then revealed, nearest cells first, at most maxInstances per frame, which spreads the mesh
+// reloads (residency.h) of a new area over several frames. Cells farther than loadDistance + unloadMargin are erased,
+// the margin keeps a camera moving along a border from loading and unloading the same cells. The streamed entities
+// and their reads are bounded by the view distance, whatever the size of the world. The loaded models stay, their
+// memory is left to the mesh residency budgets.
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base_types.h"
+#include "math_types.h"
+#include "scene_cooker.h"
+
+struct App;
+
+#define WORLD_STREAMING_DEFAULT_FILE	"world.scene"
+#define WORLD_STREAMING_LOAD_DISTANCE	150.0f																// From the camera to the cell rectangle.
+#define WORLD_STREAMING_UNLOAD_MARGIN	50.0f
+#define WORLD_STREAMING_MAX_READS		4																	// Cell reads in flight.
+#define WORLD_STREAMING_MAX_INSTANCES	1024																// Entities revealed per frame.
+#define WORLD_STREAMING_UNRESOLVED		(UINT32_MAX - 1)													// Asset / material / model no cell used yet.
+
+enum class CELL_STATE
+{
+	READING,
+	READ,
+	PLACING,																								// In App::entities, partly revealed.
+	RESIDENT
+};
+
+struct StreamedCell
+{
+	u32							cellIdx;
+	CELL_STATE					state;
+	std::atomic<bool>			isRead;																		// Set by the read callback.
+	std::vector<SceneEntity>	entities;																	// Empty if the read failed. Released once placed.
+	f32							distance;																	// This frame.
+
+	u32							firstEntity;																// In App::entities, from PLACING on.
+	u32							entityCount;
+	u32							revealedCount;
+};
+
+struct WorldStreamer
+{
+	std::string						cookedPath;																// The .cscene the cells are read from.
+	u64								entitiesOffset;
+	f32								cellSize;
+
+	std::vector<SceneCell>			cells;
+	std::vector<u32>				cellModels;
+	std::vector<SceneAsset>			assets;
+	std::vector<SceneMaterial>		materials;
+	std::vector<SceneModel>			models;
+	std::string						strings;
+
+	std::vector<u32>				assetIndices;															// -> App::models, WORLD_STREAMING_UNRESOLVED or UINT32_MAX (failed).
+	std::vector<u32>				materialIndices;														// -> App::materials.
+	std::vector<u32>				modelIndices;															// SceneModel -> App::models.
+
+	std::unordered_map<u64, u32>	cellLookup;																// (x, z) -> cells index.
+	std::vector<bool>				isCellActive;															// In activeCells.
+	std::list<StreamedCell>			activeCells;															// std::list: the read callbacks hold pointers to their cell.
+
+	f32								loadDistance;
+	f32								unloadMargin;
+	u32								maxInstances;
+
+	u32								cellsLoaded;															// Totals, for the GUI.
+	u32								cellsUnloaded;
+};
+
+namespace WorldStreaming
+{
+	bool Load					(App* app, const char* filepath);										// After the static scene.
+	void Update					(App* app);																// Before the HLOD and impostor selection.
+
+	u32  GetStreamedEntityCount	(const App* app);
+
+	namespace Utils
+	{
+		void RequestCells		(App* app);																// The nearest missing cells first.
+		void PlaceCells			(App* app);
+		void BeginPlacing		(App* app, StreamedCell& cell);											// Appends the entities, hidden.
+		std::list<StreamedCell>::iterator UnloadCell	(App* app, std::list<StreamedCell>::iterator cell);
+
+		u32  ResolveModel		(App* app, u32 modelIdx);												// SceneModel -> App::models, UINT32_MAX if it failed.
+		f32  GetCellDistance	(const WorldStreamer& streamer, const SceneCell& cell, const vec3& position);
+		u64  GetCellKey			(i32 x, i32 z);
+	}
+}
+
+#endif // !__WORLD_STREAMING_H__
\ No newline at end of file
@@ -47,8 +47,10 @@ void main()
 layout(location = 0) in vec3 aPosition;
 //layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
-//layout(location = 3) in vec3 aTangent;
-//layout(location = 4) in vec3 aBitangent;
+//layout(location = 3) in vec4 aTangent;
+
+uniform vec3 uPositionScale;			// Dequantization of the packed positions.
+uniform vec3 uPositionOffset;
 
 out vec2 vTexCoord;
 
@@ -56,7 +58,7 @@ void main()
 {
 	vTexCoord			= aTexCoord;
 	float clippingScale = 5.0;
-	gl_Position			= vec4(aPosition, clippingScale);
+	gl_Position			= vec4(aPosition * uPositionScale + uPositionOffset, clippingScale);
 	gl_Position.z		= -gl_Position.z;
 }
 
@@ -1,19 +1,107 @@
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
-#ifdef FORWARD_RENDERING
+#if defined(FORWARD_RENDERING) || defined(CLUSTERED_LIGHTING) || defined(TILED_LIGHTING) || defined(INSTANCED_LIGHTING_PASS)
 
-struct Light
+struct GpuLight
 {
-	unsigned int type;
-	vec3		 color;
-	vec3		 direction;
-	vec3		 position;
+	vec4 positionRadius;		// xyz: Position,	w: Radius.
+	vec4 colorType;				// rgb: Color,		a: Light type.
+	vec4 direction;
+	vec4 attenuation;			// Constant, Linear, Quadratic.
 };
 
 #define LT_DIRECTIONAL	0
 #define LT_POINT		1
 
+layout(binding = 3, std430) readonly buffer LightBuffer
+{
+	GpuLight uLights[];			// Directional lights first, then the point lights.
+};
+
+layout(binding = 4, std430) readonly buffer ClusterBuffer
+{
+	uvec2 uClusters[];			// x: Offset into uLightIndices, y: Light count.
+};
+
+layout(binding = 5, std430) readonly buffer LightIndexBuffer
+{
+	uint uLightIndices[];
+};
+
+layout(binding = 3, std140) uniform ClusterParams
+{
+	mat4  uViewMatrix;
+	uvec4 uClusterDims;			// xyz: Grid size,	w: Directional light count.
+	vec4  uClusterScaleBias;	// x: Slice scale,	y: Slice bias,	zw: Viewport size.
+	uint  uLightCount;			// Directional and point lights in uLights.
+};
+
+#if defined(FRAGMENT) || defined(COMPUTE)
+
+uint GetClusterIndex(in vec3 worldPos, in vec2 fragCoord)
+{
+	float viewDepth = -(uViewMatrix * vec4(worldPos, 1.0)).z;
+	uint  slice		= uint(max(floor(log(max(viewDepth, 1e-4)) * uClusterScaleBias.x + uClusterScaleBias.y), 0.0));
+	uvec2 tile		= uvec2(fragCoord * vec2(uClusterDims.xy) / uClusterScaleBias.zw);
+
+	slice	= min(slice, uClusterDims.z - 1);
+	tile	= min(tile, uClusterDims.xy - uvec2(1));
+
+	return tile.x + tile.y * uClusterDims.x + slice * uClusterDims.x * uClusterDims.y;
+}
+
+vec3 ShadeLight(in GpuLight light, in vec3 pos, in vec3 N, in vec3 V, in vec3 albedo)
+{
+	vec3  L				= normalize(light.direction.xyz);
+	float attenuation	= 1.0;
+
+	if (uint(light.colorType.a) == LT_POINT)
+	{
+		float dist		= length(light.positionRadius.xyz - pos);
+		float window	= clamp(1.0 - pow(dist / light.positionRadius.w, 4.0), 0.0, 1.0);
+		attenuation		= (window * window) / (light.attenuation.x + light.attenuation.y * dist + light.attenuation.z * (dist * dist));
+		L				= normalize(light.positionRadius.xyz - pos);
+	}
+
+	vec3  R	 = reflect(-L, N);
+	float d0 = max(dot(N, L), 0.0);
+	float s0 = pow(max(dot(V, R), 0.0), 120.0);
+
+	vec3 ambient	= (uint(light.colorType.a) == LT_DIRECTIONAL) ? albedo * 0.5 : vec3(0.0);
+	vec3 diffuse	= light.colorType.rgb * albedo * d0 * 0.65;
+	vec3 specular	= light.colorType.rgb * albedo * s0 * 0.05;
+
+	return ambient + (diffuse + specular) * attenuation;
+}
+
+vec3 ShadeClustered(in vec3 pos, in vec3 N, in vec3 V, in vec3 albedo, in vec2 fragCoord)
+{
+	vec3 outputColor = vec3(0.0);
+
+	for (uint i = 0; i < uClusterDims.w; ++i)
+	{
+		outputColor += ShadeLight(uLights[i], pos, N, V, albedo);
+	}
+
+	uvec2 cluster = uClusters[GetClusterIndex(pos, fragCoord)];
+	for (uint i = 0; i < cluster.y; ++i)
+	{
+		outputColor += ShadeLight(uLights[uLightIndices[cluster.x + i]], pos, N, V, albedo);
+	}
+
+	return outputColor;
+}
+
+#endif
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef FORWARD_RENDERING
+
 #define RL_SHADED		0
 #define RL_ALBEDO		1
 #define RL_NORMAL		2
@@ -24,8 +112,6 @@ layout(binding = 0, std140) uniform GlobalParams
 {
 	vec3			uCameraPosition;
 	unsigned int	uRenderLayer;
-	unsigned int	uLightCount;
-	Light			uLight[16];
 };
 
 #if defined(VERTEX)			// ----------------------------------------
@@ -33,8 +119,7 @@ layout(binding = 0, std140) uniform GlobalParams
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
-layout(location = 3) in vec3 aTangent;
-layout(location = 4) in vec3 aBitangent;
+layout(location = 3) in vec4 aTangent;		// w: bitangent sign.
 
 layout(binding = 1, std140) uniform LocalParams
 {
@@ -42,6 +127,9 @@ layout(binding = 1, std140) uniform LocalParams
 	mat4 uWorldViewProjectionMatrix;
 };
 
+uniform vec3 uPositionScale;				// Dequantization of the packed positions (1 and 0 for float vertices).
+uniform vec3 uPositionOffset;
+
 out vec2 vTexCoord;
 out vec3 vPosition;		// In Worldspace
 out vec3 vNormal;		// In Worldspace
@@ -49,11 +137,13 @@ out vec3 vViewDir;		// In WorldSpace
 
 void main()
 {
+	vec3 position = aPosition * uPositionScale + uPositionOffset;
+
 	vTexCoord	= aTexCoord;
-	vPosition	= vec3(uWorldMatrix * vec4(aPosition, 1.0));
+	vPosition	= vec3(uWorldMatrix * vec4(position, 1.0));
 	vNormal		= vec3(uWorldMatrix * vec4(aNormal, 0.0));
 	vViewDir	= uCameraPosition - vPosition;
-	gl_Position = uWorldViewProjectionMatrix * vec4(aPosition.x, aPosition.y, aPosition.z, 1.0);
+	gl_Position = uWorldViewProjectionMatrix * vec4(position, 1.0);
 }
 
 #elif defined(FRAGMENT)		// ----------------------------------------
@@ -72,41 +162,7 @@ float far	= 100.0;
 
 vec3 ShadedRender(in vec4 texColor)
 {
-	vec3 outputColor = vec3(0.0, 0.0, 0.0);
-	
-	for (unsigned int i = 0; i < uLightCount; ++i)
-	{
-		Light light			= uLight[i];
-		vec3  normDir		= vec3(0.0, 0.0, 0.0);
-		float attenuation	= 1.0;
-		
-		if (light.type == LT_DIRECTIONAL)
-		{ 
-			normDir = normalize(light.direction); 
-		}
-		else if (light.type == LT_POINT)
-		{ 
-			vec3 distVec = (light.position - vPosition);
-			
-			normDir		= normalize(distVec); 
-			float dist	= length(distVec);
-
-			attenuation = 1.0 / (1.0 + 0.09 * dist + 0.032 * (dist * dist));
-		}
-
-		vec3 rfltDir	= reflect(-normDir, normalize(vNormal));
-
-		float dVal		= max(dot(normalize(vNormal), normDir), 0.0);
-		float sVal		= pow(max(dot(vViewDir, rfltDir), 0.0), 0.8);
-		
-		vec3 diffuse	= dVal * light.color * texColor.xyz * 0.65;					// 
-		vec3 ambient	= light.color * texColor.xyz * 0.15;						// 0.05 less on all to avoid overexposure.
-		vec3 specular	= sVal * light.color * texColor.xyz * 0.05;					// 
-
-		outputColor += (specular + diffuse + ambient) * attenuation;
-	}
-	
-	return outputColor;
+	return ShadeClustered(vPosition, normalize(vNormal), normalize(vViewDir), texColor.xyz, gl_FragCoord.xy);
 }
 
 float LinearizeDepth(in float depth)
@@ -155,8 +211,7 @@ layout(binding = 0, std140) uniform GlobalParams
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
-layout(location = 3) in vec3 aTangent;
-layout(location = 4) in vec3 aBitangent;
+layout(location = 3) in vec4 aTangent;		// w: bitangent sign (1 when the layout has no w).
 
 layout(binding = 1, std140) uniform LocalParams
 {
@@ -165,6 +220,9 @@ layout(binding = 1, std140) uniform LocalParams
 	unsigned int isCube;
 };
 
+uniform vec3 uPositionScale;				// Dequantization of the packed positions (1 and 0 for float vertices).
+uniform vec3 uPositionOffset;
+
 out vec2 vTexCoord;			
 out vec3 vPosition;			// ---
 out vec3 vNormal;			//
@@ -174,14 +232,17 @@ out vec3 vBitangent;		// ---
 
 void main()
 {
+	vec3 position	= aPosition * uPositionScale + uPositionOffset;
+	vec3 bitangent	= cross(aNormal, aTangent.xyz) * aTangent.w;
+
 	vTexCoord	= aTexCoord;
-	vPosition	= vec3(uWorldMatrix * vec4(aPosition, 1.0));
+	vPosition	= vec3(uWorldMatrix * vec4(position, 1.0));
 	vNormal		= vec3(uWorldMatrix * vec4(aNormal, 0.0));
 	vViewDir	= uCameraPosition - vPosition;
-	vTangent	= normalize(vec3(uWorldMatrix * vec4(aTangent, 0.0)));
-	vBitangent	= normalize(vec3(uWorldMatrix * vec4(aBitangent, 0.0)));
+	vTangent	= normalize(vec3(uWorldMatrix * vec4(aTangent.xyz, 0.0)));
+	vBitangent	= normalize(vec3(uWorldMatrix * vec4(bitangent, 0.0)));
 
-	gl_Position = uWorldViewProjectionMatrix * vec4(aPosition, 1.0);
+	gl_Position = uWorldViewProjectionMatrix * vec4(position, 1.0);
 }
 
 #elif defined(FRAGMENT)		// ----------------------------------------
@@ -262,7 +323,9 @@ void main()
 	{
 		texCoords = ReliefMapping(vTexCoord, TBN);
 
-		vec3 tangentSpaceNormal = texture(uNormalMap, texCoords).xyz * 2.0 - vec3(1.0);
+		vec3 tangentSpaceNormal;																	// Normal maps are cooked as BC5 (RG only),
+		tangentSpaceNormal.xy	= texture(uNormalMap, texCoords).xy * 2.0 - vec2(1.0);				// Z is rebuilt from the unit length.
+		tangentSpaceNormal.z	= sqrt(max(1.0 - dot(tangentSpaceNormal.xy, tangentSpaceNormal.xy), 0.0));
 		N = TBN * tangentSpaceNormal;
 		N = normalize(uWorldMatrix * vec4(N, 0.0)).xyz;
 	}
@@ -289,6 +352,8 @@ struct Light
 	vec3		 color;
 	vec3		 direction;
 	vec3		 position;
+	float		 radius;
+	vec3		 attenuation;		// Constant, Linear, Quadratic.
 };
 
 #define LT_DIRECTIONAL	0
@@ -298,6 +363,7 @@ layout(binding = 0, std140) uniform GlobalParams
 {
 	vec3			uCameraPosition;
 	unsigned int	uRenderLayer;
+	vec3			uCameraForward;
 };
 
 layout(binding = 2, std140) uniform LightParams
@@ -305,37 +371,30 @@ layout(binding = 2, std140) uniform LightParams
 	mat4  uWorldMatrix;
 	mat4  uWorldViewProjectionMatrix;
 	Light light;
+	vec2  uDepthBounds;				// Min/Max view-space depth covered by the light volume.
 };
 
 #if defined (VERTEX)		// ----------------------------------------
 
 layout(location = 0) in vec3 aPosition;
-layout(location = 1) in vec2 aTexCoord;
 
-out vec2 vTexCoord;
+uniform vec3 uPositionScale;				// Dequantization of the sphere positions.
+uniform vec3 uPositionOffset;
 
 void main()
 {
-	if (light.type == LT_DIRECTIONAL)
-	{
-		vTexCoord	= aTexCoord;
-		gl_Position = vec4(aPosition, 1.0);
-	}
-	else if (light.type == LT_POINT)
+	if (light.type == LT_POINT)
 	{
-		gl_Position = uWorldViewProjectionMatrix * vec4(aPosition, 1.0);
+		gl_Position = uWorldViewProjectionMatrix * vec4(aPosition * uPositionScale + uPositionOffset, 1.0);
 	}
 	else
 	{
-		vTexCoord	= aTexCoord;
 		gl_Position = vec4(aPosition, 1.0);
 	}
 }
 
 #elif defined(FRAGMENT)		// ----------------------------------------
 
-in vec2 vTexCoord;
-
 uniform sampler2D oAlbedo;
 uniform sampler2D oNormals;
 uniform sampler2D oDepth;
@@ -355,9 +414,8 @@ vec3 GetLightDir(in Light light, in vec3 pos, out float attenuation)
 	else if (light.type == LT_POINT)
 	{
 		float dist		= length(light.position - pos);
-		float linear	= 0.05; // 0.09
-		float quadratic = 0.01;	// 0.032
-		attenuation		= 1.0 / (1.0 + linear * dist + quadratic * (dist * dist));
+		float window	= clamp(1.0 - pow(dist / light.radius, 4.0), 0.0, 1.0);		// Fades to 0 at the radius so the volume edge is not visible.
+		attenuation		= (window * window) / (light.attenuation.x + light.attenuation.y * dist + light.attenuation.z * (dist * dist));
 		dir				= normalize(light.position - pos);
 	}
 
@@ -366,10 +424,25 @@ vec3 GetLightDir(in Light light, in vec3 pos, out float attenuation)
 
 void main()
 {
-	vec2 texCoords = vTexCoord;
+	vec2 texCoords = gl_FragCoord.xy / vec2(textureSize(oPosition, 0));
 	
-	vec3 vPosition	= texture(oPosition, texCoords).rgb;
+	vec3 vPosition	= texture(oPosition, texCoords).rgb;				// World position, the target is GL_RGBA32F.
 	vec3 vNormal	= texture(oNormals,  texCoords).rgb;
+
+	if (dot(vNormal, vNormal) == 0.0)								// Nothing was rendered in this pixel.
+	{
+		discard;
+	}
+
+	if (light.type == LT_POINT)										// Depth bounds rejection before any shading work.
+	{
+		float viewDepth = dot(vPosition - uCameraPosition, uCameraForward);
+		if (viewDepth < uDepthBounds.x || viewDepth > uDepthBounds.y)
+		{
+			discard;
+		}
+	}
+
 	vec3 vAlbedo	= texture(oAlbedo,	 texCoords).rgb;
 	vec3 vViewDir	= normalize((uCameraPosition - vPosition));
 
@@ -383,11 +456,540 @@ void main()
 	float d0 = max(dot(N, L), 0.0);									// DIFFUSE INTENSITY
 	float s0 = pow(max(dot(vViewDir, R), 0.0), shininess);			// SPECULAR INTENSITY
 
-	vec3 ambient	= vAlbedo.xyz * 0.5;							// 0.05 less on all to avoid overexposure.
+	vec3 ambient	= (light.type == LT_DIRECTIONAL) ? vAlbedo.xyz * 0.5 : vec3(0.0);	// Point lights only add their attenuated contribution.
 	vec3 diffuse	= light.color * vAlbedo.xyz * d0 * 0.65;		// 
 	vec3 specular	= light.color * vAlbedo.xyz * s0 * 0.05;		// 
 
-	oColor = vec4((ambient + diffuse + specular), 1.0);
+	oColor = vec4(ambient + (diffuse + specular) * attenuation, 1.0);
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef LIGHT_STENCIL_PASS
+
+layout(binding = 2, std140) uniform LightParams		// Same leading members as LIGHTING_PASS.
+{
+	mat4 uWorldMatrix;
+	mat4 uWorldViewProjectionMatrix;
+};
+
+#if defined (VERTEX)		// ----------------------------------------
+
+layout(location = 0) in vec3 aPosition;
+
+uniform vec3 uPositionScale;				// Dequantization of the sphere positions.
+uniform vec3 uPositionOffset;
+
+void main()
+{
+	gl_Position = uWorldViewProjectionMatrix * vec4(aPosition * uPositionScale + uPositionOffset, 1.0);
+}
+
+#elif defined(FRAGMENT)		// ----------------------------------------
+
+void main()
+{
+	// Only the stencil is written.
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef INSTANCED_LIGHTING_PASS
+
+#define VOLUME_SCALE	1.05		// Same as LIGHT_VOLUME_SCALE in engine.cpp.
+
+layout(binding = 0, std140) uniform GlobalParams
+{
+	vec3			uCameraPosition;
+	unsigned int	uRenderLayer;
+	vec3			uCameraForward;
+};
+
+uniform bool uDirectionalPass;		// Full-screen quad looping over every directional light.
+
+#if defined (VERTEX)		// ----------------------------------------
+
+layout(location = 0) in vec3 aPosition;
+layout(location = 5) in vec4 aPositionRadius;		// Per-instance, read from the light buffer.
+layout(location = 6) in vec4 aColorType;
+layout(location = 7) in vec4 aAttenuation;
+
+uniform mat4 uViewProjectionMatrix;
+uniform vec3 uPositionScale;				// Dequantization of the sphere positions.
+uniform vec3 uPositionOffset;
+
+flat out vec4 vPositionRadius;
+flat out vec3 vColor;
+flat out vec3 vAttenuation;
+flat out vec2 vDepthBounds;
+
+void main()
+{
+	if (uDirectionalPass)
+	{
+		gl_Position = vec4(aPosition, 1.0);
+		return;
+	}
+
+	vec3  localPosition	= aPosition * uPositionScale + uPositionOffset;
+	vec3  worldPosition	= aPositionRadius.xyz + localPosition * aPositionRadius.w * VOLUME_SCALE;
+	float viewDepth		= dot(aPositionRadius.xyz - uCameraPosition, uCameraForward);
+
+	vPositionRadius	= aPositionRadius;
+	vColor			= aColorType.rgb;
+	vAttenuation	= aAttenuation.xyz;
+	vDepthBounds	= vec2(viewDepth - aPositionRadius.w, viewDepth + aPositionRadius.w);
+
+	gl_Position = uViewProjectionMatrix * vec4(worldPosition, 1.0);
+}
+
+#elif defined(FRAGMENT)		// ----------------------------------------
+
+uniform sampler2D oAlbedo;
+uniform sampler2D oNormals;
+uniform sampler2D oDepth;
+uniform sampler2D oPosition;
+
+flat in vec4 vPositionRadius;
+flat in vec3 vColor;
+flat in vec3 vAttenuation;
+flat in vec2 vDepthBounds;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+	vec2 texCoords = gl_FragCoord.xy / vec2(textureSize(oPosition, 0));
+
+	vec3 vPosition	= texture(oPosition, texCoords).rgb;				// World position (GL_RGBA32F), tested against the instance depth bounds.
+	vec3 vNormal	= texture(oNormals,  texCoords).rgb;
+
+	if (dot(vNormal, vNormal) == 0.0)								// Nothing was rendered in this pixel.
+	{
+		discard;
+	}
+
+	vec3 vAlbedo	= texture(oAlbedo, texCoords).rgb;
+	vec3 N			= normalize(vNormal);
+	vec3 V			= normalize(uCameraPosition - vPosition);
+
+	vec3 outputColor = vec3(0.0);
+
+	if (uDirectionalPass)
+	{
+		for (uint i = 0; i < uClusterDims.w; ++i)
+		{
+			outputColor += ShadeLight(uLights[i], vPosition, N, V, vAlbedo);
+		}
+	}
+	else
+	{
+		float viewDepth = dot(vPosition - uCameraPosition, uCameraForward);
+		if (viewDepth < vDepthBounds.x || viewDepth > vDepthBounds.y)	// Depth bounds rejection before any shading work.
+		{
+			discard;
+		}
+
+		GpuLight light;
+		light.positionRadius	= vPositionRadius;
+		light.colorType			= vec4(vColor, float(LT_POINT));
+		light.direction			= vec4(0.0);
+		light.attenuation		= vec4(vAttenuation, 0.0);
+
+		outputColor = ShadeLight(light, vPosition, N, V, vAlbedo);
+	}
+
+	oColor = vec4(outputColor, 1.0);
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef CLUSTERED_LIGHTING
+
+layout(binding = 0, std140) uniform GlobalParams
+{
+	vec3			uCameraPosition;
+	unsigned int	uRenderLayer;
+};
+
+#if defined(VERTEX)			// ----------------------------------------
+
+layout(location = 0) in vec3 aPosition;
+
+void main()
+{
+	gl_Position = vec4(aPosition, 1.0);
+}
+
+#elif defined(FRAGMENT)		// ----------------------------------------
+
+uniform sampler2D oAlbedo;
+uniform sampler2D oNormals;
+uniform sampler2D oDepth;
+uniform sampler2D oPosition;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+	vec2 texCoords = gl_FragCoord.xy / vec2(textureSize(oPosition, 0));
+
+	vec3 vPosition	= texture(oPosition, texCoords).rgb;				// World position (GL_RGBA32F), its view depth picks the cluster slice.
+	vec3 vNormal	= texture(oNormals,  texCoords).rgb;
+
+	if (dot(vNormal, vNormal) == 0.0)								// Nothing was rendered in this pixel.
+	{
+		discard;
+	}
+
+	vec3 vAlbedo	= texture(oAlbedo, texCoords).rgb;
+	vec3 vViewDir	= normalize(uCameraPosition - vPosition);
+
+	oColor = vec4(ShadeClustered(vPosition, normalize(vNormal), vViewDir, vAlbedo, gl_FragCoord.xy), 1.0);
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef TILED_LIGHTING
+
+#define TILE_SIZE				16
+#define MAX_LIGHTS_PER_TILE		256
+
+layout(binding = 0, std140) uniform GlobalParams
+{
+	vec3			uCameraPosition;
+	unsigned int	uRenderLayer;
+};
+
+#if defined(COMPUTE)		// ----------------------------------------
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout(binding = 0, rgba8) uniform writeonly image2D uShadedImage;
+
+uniform sampler2D oAlbedo;
+uniform sampler2D oNormals;
+uniform sampler2D uDepthBuffer;
+
+uniform mat4 uInvViewProjMatrix;
+uniform vec2 uProjScale;						// Projection matrix [0][0] and [1][1].
+
+shared uint sMinDepth;
+shared uint sMaxDepth;
+shared uint sLightCount;
+shared uint sLightIndices[MAX_LIGHTS_PER_TILE];
+
+void main()
+{
+	ivec2 pixel		= ivec2(gl_GlobalInvocationID.xy);
+	ivec2 viewport	= ivec2(uClusterScaleBias.zw);
+	bool  inside	= (pixel.x < viewport.x && pixel.y < viewport.y);
+
+	if (gl_LocalInvocationIndex == 0)
+	{
+		sMinDepth	= 0xFFFFFFFFu;
+		sMaxDepth	= 0u;
+		sLightCount	= 0u;
+	}
+
+	barrier();
+
+	// TILE DEPTH RANGE
+	float depth			= inside ? texelFetch(uDepthBuffer, pixel, 0).r : 1.0;
+	bool  hasGeometry	= inside && (depth < 1.0);
+
+	vec4 ndc		= vec4((vec2(pixel) + 0.5) / vec2(viewport) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 worldPos	= uInvViewProjMatrix * ndc;
+	worldPos		/= worldPos.w;
+	float viewDepth	= -(uViewMatrix * worldPos).z;
+
+	if (hasGeometry)
+	{
+		atomicMin(sMinDepth, floatBitsToUint(viewDepth));		// Positive floats keep their order as uints.
+		atomicMax(sMaxDepth, floatBitsToUint(viewDepth));
+	}
+
+	barrier();
+
+	// LIGHT CULLING
+	float minDepth = uintBitsToFloat(sMinDepth);
+	float maxDepth = uintBitsToFloat(sMaxDepth);
+
+	vec2 tileMin = vec2(gl_WorkGroupID.xy * TILE_SIZE) / vec2(viewport) * 2.0 - 1.0;			// Tile bounds in NDC.
+	vec2 tileMax = vec2((gl_WorkGroupID.xy + 1) * TILE_SIZE) / vec2(viewport) * 2.0 - 1.0;
+
+	vec3 planes[4];																			// View-space side planes through the origin.
+	planes[0] = normalize(vec3( uProjScale.x, 0.0,  tileMin.x));
+	planes[1] = normalize(vec3(-uProjScale.x, 0.0, -tileMax.x));
+	planes[2] = normalize(vec3(0.0,  uProjScale.y,  tileMin.y));
+	planes[3] = normalize(vec3(0.0, -uProjScale.y, -tileMax.y));
+
+	for (uint i = uClusterDims.w + gl_LocalInvocationIndex; i < uLightCount && sMinDepth <= sMaxDepth; i += TILE_SIZE * TILE_SIZE)
+	{
+		vec3  center = (uViewMatrix * vec4(uLights[i].positionRadius.xyz, 1.0)).xyz;
+		float radius = uLights[i].positionRadius.w;
+
+		bool visible = (-center.z + radius >= minDepth) && (-center.z - radius <= maxDepth);
+		for (int p = 0; p < 4 && visible; ++p)
+		{
+			visible = (dot(planes[p], center) >= -radius);
+		}
+
+		if (visible)
+		{
+			uint slot = atomicAdd(sLightCount, 1u);
+			if (slot < MAX_LIGHTS_PER_TILE)
+			{
+				sLightIndices[slot] = i;
+			}
+		}
+	}
+
+	barrier();
+
+	// SHADING
+	if (!inside)
+	{
+		return;
+	}
+
+	vec3 vNormal = texelFetch(oNormals, pixel, 0).rgb;
+	if (!hasGeometry || dot(vNormal, vNormal) == 0.0)
+	{
+		imageStore(uShadedImage, pixel, vec4(0.0, 0.0, 0.0, 1.0));
+		return;
+	}
+
+	vec3 vAlbedo	= texelFetch(oAlbedo, pixel, 0).rgb;
+	vec3 N			= normalize(vNormal);
+	vec3 V			= normalize(uCameraPosition - worldPos.xyz);
+
+	vec3 outputColor = vec3(0.0);
+	for (uint i = 0; i < uClusterDims.w; ++i)
+	{
+		outputColor += ShadeLight(uLights[i], worldPos.xyz, N, V, vAlbedo);
+	}
+
+	uint tileLights = min(sLightCount, uint(MAX_LIGHTS_PER_TILE));
+	for (uint i = 0; i < tileLights; ++i)
+	{
+		outputColor += ShadeLight(uLights[sLightIndices[i]], worldPos.xyz, N, V, vAlbedo);
+	}
+
+	imageStore(uShadedImage, pixel, vec4(outputColor, 1.0));
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef IMPOSTOR_BAKE
+
+#if defined(VERTEX)			// ----------------------------------------
+
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+
+uniform mat4 uViewProjectionMatrix;			// Orthographic view of one atlas frame, in model space.
+uniform vec3 uPositionScale;
+uniform vec3 uPositionOffset;
+
+out vec2 vTexCoord;
+out vec3 vNormal;
+
+void main()
+{
+	vTexCoord	= aTexCoord;
+	vNormal		= aNormal;
+
+	gl_Position = uViewProjectionMatrix * vec4(aPosition * uPositionScale + uPositionOffset, 1.0);
+}
+
+#elif defined(FRAGMENT)		// ----------------------------------------
+
+in vec2 vTexCoord;
+in vec3 vNormal;
+
+uniform sampler2D uTexture;
+
+layout(location = 0) out vec4 oAlbedo;
+layout(location = 1) out vec4 oNormalDepth;
+
+void main()
+{
+	oAlbedo			= vec4(texture(uTexture, vTexCoord).rgb, 1.0);
+	oNormalDepth	= vec4(normalize(vNormal) * 0.5 + 0.5, gl_FragCoord.z);		// Ortho depth is already linear.
+}
+
+#endif						// ----------------------------------------
+
+#endif
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#ifdef IMPOSTOR_PASS
+
+layout(binding = 0, std140) uniform GlobalParams
+{
+	vec3			uCameraPosition;
+	unsigned int	uRenderLayer;
+};
+
+layout(binding = 6, std430) readonly buffer ImpostorInstances
+{
+	vec4 uInstances[];						// World-space center (xyz) and radius (w).
+};
+
+uniform mat4			uViewProjectionMatrix;
+uniform unsigned int	uFirstInstance;
+uniform int				uFrames;
+
+void BuildViewBasis(in vec3 direction, out vec3 right, out vec3 up)		// Same as Impostors::Utils::BuildViewBasis().
+{
+	vec3 reference = (abs(direction.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+
+	right	= normalize(cross(reference, direction));
+	up		= cross(direction, right);
+}
+
+#if defined(VERTEX)			// ----------------------------------------
+
+out vec3		vWorldPosition;
+out vec3		vViewDir;					// Towards the camera, clamped to the baked hemisphere.
+flat out vec4	vInstance;
+
+void main()
+{
+	vInstance = uInstances[uFirstInstance + gl_InstanceID];
+
+	vec3 toCamera	= normalize(uCameraPosition - vInstance.xyz);
+	vViewDir		= normalize(vec3(toCamera.x, max(toCamera.y, 0.0), toCamera.z) + vec3(0.0, 1e-4, 0.0));
+
+	vec3 right, up;
+	BuildViewBasis(vViewDir, right, up);
+
+	vec2 corner		= vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;		// Triangle strip quad.
+	vWorldPosition	= vInstance.xyz + (right * corner.x + up * corner.y) * vInstance.w;
+
+	gl_Position = uViewProjectionMatrix * vec4(vWorldPosition, 1.0);
+}
+
+#elif defined(FRAGMENT)		// ----------------------------------------
+
+in vec3			vWorldPosition;
+in vec3			vViewDir;
+flat in vec4	vInstance;
+
+uniform sampler2D uAlbedoAtlas;
+uniform sampler2D uNormalDepthAtlas;
+
+layout(location = 0) out vec4 oColor;
+layout(location = 1) out vec4 oAlbedo;
+layout(location = 2) out vec4 oNormals;
+layout(location = 3) out vec4 oDepth;
+layout(location = 4) out vec4 oPosition;
+
+float near	= 0.1;							// Same as GEOMETRY_PASS.
+float far	= 1000.0;
+
+vec2 EncodeHemiOctahedral(in vec3 direction)
+{
+	vec2 p = direction.xz / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+	return vec2(p.x + p.y, p.x - p.y);
+}
+
+vec3 DecodeHemiOctahedral(in vec2 encoded)
+{
+	float x = (encoded.x + encoded.y) * 0.5;
+	float z = (encoded.x - encoded.y) * 0.5;
+
+	return normalize(vec3(x, 1.0 - abs(x) - abs(z), z));
+}
+
+// Projects this fragment's quad point onto the plane of the given frame and samples it.
+void SampleFrame(in ivec2 frame, in float weight, inout vec4 albedo, inout vec4 normalDepth)
+{
+	frame = clamp(frame, ivec2(0), ivec2(uFrames - 1));
+
+	vec3 frameDir = DecodeHemiOctahedral(vec2(frame) / float(uFrames - 1) * 2.0 - 1.0);
+	vec3 right, up;
+	BuildViewBasis(frameDir, right, up);
+
+	vec3 offset		= (vWorldPosition - vInstance.xyz) / vInstance.w;
+	vec2 frameUV	= clamp(vec2(dot(offset, right), dot(offset, up)) * 0.5 + 0.5, 0.0, 1.0);
+	vec2 atlasUV	= (vec2(frame) + frameUV) / float(uFrames);
+
+	albedo		+= texture(uAlbedoAtlas, atlasUV) * weight;
+	normalDepth	+= texture(uNormalDepthAtlas, atlasUV) * weight;
+}
+
+void main()
+{
+	vec2 gridPos	= (EncodeHemiOctahedral(vViewDir) * 0.5 + 0.5) * float(uFrames - 1);
+	ivec2 cell		= ivec2(floor(gridPos));
+	vec2 f			= gridPos - vec2(cell);
+
+	vec4 albedo			= vec4(0.0);
+	vec4 normalDepth	= vec4(0.0);
+	if (f.x + f.y < 1.0)													// Lower triangle of the grid cell.
+	{
+		SampleFrame(cell,					1.0 - f.x - f.y,	albedo, normalDepth);
+		SampleFrame(cell + ivec2(1, 0),		f.x,				albedo, normalDepth);
+		SampleFrame(cell + ivec2(0, 1),		f.y,				albedo, normalDepth);
+	}
+	else
+	{
+		SampleFrame(cell + ivec2(1, 1),		f.x + f.y - 1.0,	albedo, normalDepth);
+		SampleFrame(cell + ivec2(0, 1),		1.0 - f.x,			albedo, normalDepth);
+		SampleFrame(cell + ivec2(1, 0),		1.0 - f.y,			albedo, normalDepth);
+	}
+
+	if (albedo.a < 0.5)
+	{
+		discard;
+	}
+
+	albedo.rgb		/= albedo.a;											// Undo the blend with the empty texels.
+	normalDepth		/= albedo.a;
+
+	// Baked depth is linear between r and 3r from a camera at 2r, so 0.5 is the plane through the center.
+	float toCamera		= (1.0 - 2.0 * normalDepth.a) * vInstance.w;
+	vec3 worldPosition	= vWorldPosition + normalize(uCameraPosition - vWorldPosition) * toCamera;
+	vec4 clipPosition	= uViewProjectionMatrix * vec4(worldPosition, 1.0);
+	gl_FragDepth		= (clipPosition.z / clipPosition.w) * 0.5 + 0.5;
+
+	float z			= gl_FragDepth * 2.0 - 1.0;
+	float linDepth	= (2.0 * near * far) / (far + near - z * (far - near));
+
+	oAlbedo		= vec4(albedo.rgb, 1.0);
+	oNormals	= vec4(normalize(normalDepth.rgb * 2.0 - 1.0), 1.0);
+	oDepth		= vec4(vec3(linDepth / far), 1.0);
+	oPosition	= vec4(worldPosition, 1.0);
 }
 
 #endif						// ----------------------------------------